@@ -0,0 +1,69 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_BENCH_H
+#define MDTRA_BENCH_H
+
+//Helpers shared by the benchmarks: a wall clock and best/mean timing of
+//repeated passes. Every benchmark is a single translation unit, so these
+//are static.
+
+typedef struct stBench_Timing
+{
+	int		passes;
+	double	best;			//seconds
+	double	total;			//seconds, all passes
+} Bench_Timing;
+
+static double Bench_Seconds( void )
+{
+#if defined(WIN32)
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency( &freq );
+	QueryPerformanceCounter( &count );
+	return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+	struct timeval tp;
+	gettimeofday( &tp, NULL );
+	return (double)tp.tv_sec + (double)tp.tv_usec * 1e-6;
+#endif
+}
+
+static inline void Bench_TimingReset( Bench_Timing *pTiming )
+{
+	pTiming->passes = 0;
+	pTiming->best = 1e30;
+	pTiming->total = 0;
+}
+
+static inline void Bench_TimingAdd( Bench_Timing *pTiming, double seconds )
+{
+	pTiming->passes++;
+	pTiming->total += seconds;
+	if (seconds < pTiming->best)
+		pTiming->best = seconds;
+}
+
+static inline double Bench_TimingMean( const Bench_Timing *pTiming )
+{
+	return pTiming->passes ? (pTiming->total / pTiming->passes) : 0.0;
+}
+
+#endif //MDTRA_BENCH_H
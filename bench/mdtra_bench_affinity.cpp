@@ -0,0 +1,155 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Worker pinning benchmark
+//
+//	Runs a synthetic distance search (every atom pair of every frame is
+//	accumulated into a per-thread table, as f_DistanceSearch does) twice:
+//	with free-floating workers whose tables were zeroed by the main thread,
+//	and with workers pinned by AffinityPinCurrentThread that zero their own
+//	tables first. Reports frames per second for both.
+//	Usage: mdtra_bench_affinity [numAtoms] [numFrames] [numThreads] [numPasses]
+
+#include "mdtra_main.h"
+#include "mdtra_dispatch.h"
+#include "mdtra_affinity.h"
+#include "mdtra_bench.h"
+
+#define BENCH_DEFAULT_ATOMS		600
+#define BENCH_DEFAULT_FRAMES	2000
+#define BENCH_DEFAULT_PASSES	3
+#define BENCH_MAX_THREADS		64
+
+static int s_numAtoms;
+static int s_numPairs;
+static int s_numThreads;
+static bool s_pinned;
+static float *s_pCoords = NULL;
+static float *s_pResults[BENCH_MAX_THREADS];
+static MDTRA_WorkDispatch s_workdispatch;
+
+//frame N is the reference structure shifted a little per atom
+static void Bench_DistanceFrame( int frame, float *pResults )
+{
+	float shift = (float)(frame % 17) * 0.01f;
+	int k = 0;
+
+	for (int i = 0; i < s_numAtoms; i++) {
+		const float *pA = s_pCoords + i*3;
+		float ax = pA[0] + shift, ay = pA[1], az = pA[2] - shift;
+		for (int j = i + 1; j < s_numAtoms; j++, k++) {
+			const float *pB = s_pCoords + j*3;
+			float dx = ax - pB[0];
+			float dy = ay - pB[1];
+			float dz = az - pB[2];
+			pResults[k] += sqrtf( dx*dx + dy*dy + dz*dz );
+		}
+	}
+}
+
+static void* Bench_Worker( void *pParam )
+{
+	int threadnum = (int)(size_t)pParam;
+	int work, count;
+
+	if (s_pinned) {
+		AffinityPinCurrentThread( threadnum );
+		memset( s_pResults[threadnum], 0, sizeof(float) * s_numPairs );
+	}
+
+	while ((work = DispatchNext( &s_workdispatch, &count )) != -1) {
+		for (int i = 0; i < count; i++)
+			Bench_DistanceFrame( work + i, s_pResults[threadnum] );
+	}
+	return NULL;
+}
+
+static double Bench_Run( bool pinned, int numFrames, double *pSum )
+{
+	pthread_t threadhandle[BENCH_MAX_THREADS];
+
+	//fresh tables each run, so that first touch decides where they live
+	for (int i = 0; i < s_numThreads; i++) {
+		s_pResults[i] = (float*)malloc( sizeof(float) * s_numPairs );
+		if (!pinned)
+			memset( s_pResults[i], 0, sizeof(float) * s_numPairs );
+	}
+
+	s_pinned = pinned;
+	DispatchReset( &s_workdispatch, numFrames, s_numThreads, 1 );
+
+	double t0 = Bench_Seconds();
+	for (int i = 0; i < s_numThreads; i++)
+		pthread_create( &threadhandle[i], NULL, Bench_Worker, (void*)(size_t)i );
+	for (int i = 0; i < s_numThreads; i++)
+		pthread_join( threadhandle[i], NULL );
+	double t1 = Bench_Seconds();
+
+	*pSum = 0;
+	for (int i = 0; i < s_numThreads; i++) {
+		for (int j = 0; j < s_numPairs; j++)
+			*pSum += s_pResults[i][j];
+		free( s_pResults[i] );
+	}
+	return t1 - t0;
+}
+
+int main( int argc, char **argv )
+{
+	int numProcessors = AffinityCountProcessors();
+	s_numAtoms = (argc > 1) ? atoi( argv[1] ) : BENCH_DEFAULT_ATOMS;
+	int numFrames = (argc > 2) ? atoi( argv[2] ) : BENCH_DEFAULT_FRAMES;
+	s_numThreads = (argc > 3) ? atoi( argv[3] ) : numProcessors;
+	int numPasses = (argc > 4) ? atoi( argv[4] ) : BENCH_DEFAULT_PASSES;
+	if (s_numAtoms <= 1) s_numAtoms = BENCH_DEFAULT_ATOMS;
+	if (numFrames <= 0) numFrames = BENCH_DEFAULT_FRAMES;
+	if (numPasses <= 0) numPasses = BENCH_DEFAULT_PASSES;
+	s_numThreads = MDTRA_MAX( 1, MDTRA_MIN( s_numThreads, BENCH_MAX_THREADS ) );
+	s_numPairs = s_numAtoms * (s_numAtoms - 1) / 2;
+
+	s_pCoords = (float*)malloc( sizeof(float) * s_numAtoms * 3 );
+	srand( 1 );
+	for (int i = 0; i < s_numAtoms * 3; i++)
+		s_pCoords[i] = (float)(rand() % 10000) * 0.01f;
+
+	fprintf( stderr, "atoms: %d, frames: %d, threads: %d of %d processors, passes: %d (best time reported)\n",
+			 s_numAtoms, numFrames, s_numThreads, numProcessors, numPasses );
+
+	double bestA = 1e30, bestB = 1e30;
+	int mismatches = 0;
+
+	for (int i = 0; i < numPasses; i++) {
+		double sumA, sumB;
+		double timeA = Bench_Run( false, numFrames, &sumA );
+		double timeB = Bench_Run( true, numFrames, &sumB );
+		if (fabs( sumA - sumB ) > 1e-4 * fabs( sumA )) mismatches++;
+		bestA = MDTRA_MIN( bestA, timeA );
+		bestB = MDTRA_MIN( bestB, timeB );
+	}
+
+	fprintf( stderr, "unpinned: %10.1f frames/s\n", numFrames / bestA );
+	fprintf( stderr, "pinned:   %10.1f frames/s   %6.2fx\n", numFrames / bestB, bestA / bestB );
+	fprintf( stderr, "mismatches: %d\n", mismatches );
+
+	free( s_pCoords );
+	return mismatches ? 1 : 0;
+}
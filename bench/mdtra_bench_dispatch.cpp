@@ -0,0 +1,144 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Work dispatch overhead benchmark
+//
+//	Runs N near-empty work items on T threads through the previous
+//	mutex-per-item GetThreadWork and through the chunked lock-free
+//	dispatcher (mdtra_dispatch.h), and reports nanoseconds per item.
+//	Usage: mdtra_bench_dispatch [numItems] [numPasses]
+
+#include "mdtra_main.h"
+#include "mdtra_dispatch.h"
+#include "mdtra_bench.h"
+
+#define BENCH_DEFAULT_ITEMS		4000000
+#define BENCH_DEFAULT_PASSES	5
+#define BENCH_MAX_THREADS		64
+
+static const int s_benchThreads[] = { 1, 8, 32, 64 };
+
+//tiny work item: the sum is checked so that the compiler keeps the loop
+typedef struct {
+	volatile long long sum;
+	char padding[56];
+} BenchThreadSum_t;
+
+static BenchThreadSum_t s_threadSum[BENCH_MAX_THREADS];
+static int s_numThreads;
+
+//previous dispatcher: one index per ThreadLock
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int s_dispatch;
+static int s_workcount;
+
+static int Bench_GetWorkMutex( void )
+{
+	pthread_mutex_lock( &s_mutex );
+	if (s_dispatch >= s_workcount) {
+		pthread_mutex_unlock( &s_mutex );
+		return -1;
+	}
+	int r = s_dispatch++;
+	pthread_mutex_unlock( &s_mutex );
+	return r;
+}
+
+static void* Bench_WorkerMutex( void *pParam )
+{
+	int threadnum = (int)(size_t)pParam;
+	int work;
+	while ((work = Bench_GetWorkMutex()) != -1)
+		s_threadSum[threadnum].sum += work;
+	return NULL;
+}
+
+//chunked lock-free dispatcher
+static MDTRA_WorkDispatch s_workdispatch;
+
+static void* Bench_WorkerChunked( void *pParam )
+{
+	int threadnum = (int)(size_t)pParam;
+	int work, count;
+	while ((work = DispatchNext( &s_workdispatch, &count )) != -1) {
+		for (int i = 0; i < count && !s_workdispatch.interrupt; i++)
+			s_threadSum[threadnum].sum += work + i;
+	}
+	return NULL;
+}
+
+static double Bench_Run( void* (*pWorker)( void* ), int numItems, long long *pSum )
+{
+	pthread_t threadhandle[BENCH_MAX_THREADS];
+
+	memset( s_threadSum, 0, sizeof(s_threadSum) );
+	s_dispatch = 0;
+	s_workcount = numItems;
+	DispatchReset( &s_workdispatch, numItems, s_numThreads, MDTRA_DISPATCH_MAX_CHUNK );
+
+	double t0 = Bench_Seconds();
+	for (int i = 0; i < s_numThreads; i++)
+		pthread_create( &threadhandle[i], NULL, pWorker, (void*)(size_t)i );
+	for (int i = 0; i < s_numThreads; i++)
+		pthread_join( threadhandle[i], NULL );
+	double t1 = Bench_Seconds();
+
+	*pSum = 0;
+	for (int i = 0; i < s_numThreads; i++)
+		*pSum += s_threadSum[i].sum;
+	return t1 - t0;
+}
+
+int main( int argc, char **argv )
+{
+	int numItems = (argc > 1) ? atoi( argv[1] ) : BENCH_DEFAULT_ITEMS;
+	int numPasses = (argc > 2) ? atoi( argv[2] ) : BENCH_DEFAULT_PASSES;
+	if (numItems <= 0) numItems = BENCH_DEFAULT_ITEMS;
+	if (numPasses <= 0) numPasses = BENCH_DEFAULT_PASSES;
+
+	long long expected = (long long)numItems * (numItems - 1) / 2;
+	int mismatches = 0;
+
+	fprintf( stderr, "items: %d, passes: %d (best time reported)\n", numItems, numPasses );
+	fprintf( stderr, "threads   mutex ns/item   chunked ns/item   speedup\n" );
+
+	for (size_t t = 0; t < sizeof(s_benchThreads) / sizeof(s_benchThreads[0]); t++) {
+		s_numThreads = s_benchThreads[t];
+		double bestA = 1e30, bestB = 1e30;
+
+		for (int i = 0; i < numPasses; i++) {
+			long long sumA, sumB;
+			double timeA = Bench_Run( Bench_WorkerMutex, numItems, &sumA );
+			double timeB = Bench_Run( Bench_WorkerChunked, numItems, &sumB );
+			if (sumA != expected) mismatches++;
+			if (sumB != expected) mismatches++;
+			bestA = MDTRA_MIN( bestA, timeA );
+			bestB = MDTRA_MIN( bestB, timeB );
+		}
+
+		fprintf( stderr, "%7d   %13.2f   %15.2f   %6.1fx\n", s_numThreads,
+				 bestA * 1e9 / numItems, bestB * 1e9 / numItems, bestA / bestB );
+	}
+
+	fprintf( stderr, "mismatches: %d\n", mismatches );
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,506 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Alignment kernel benchmark
+//
+//	Times the per-frame geometric kernels of MDTRA_PDB_File on a synthetic
+//	system (protein residues of N H CA C O, four of them backbone, and
+//	waters) in three forms:
+//	  aos-scalar	the plain C loops over whole atoms with a flag test
+//	  aos-sse		the SSE_PDB_* macros (32-bit builds); 64-bit builds use
+//					an intrinsics transliteration of the same instructions
+//	  packed-avx2	the packed backbone block and the AVX2/FMA kernels
+//	Kernels: centroid (sum over backbone, shift of all atoms), R-matrix
+//	(backbone covariance), rotation of all atoms, backbone RMSD, and the
+//	gather of the packed block that a new frame pays once.
+//	Usage: mdtra_bench_kernels [numResidues] [numWaters] [numPasses]
+
+#include "mdtra_main.h"
+#include "mdtra_pdb_flags.h"
+#include "mdtra_pdb.h"
+#include "mdtra_sse.h"
+#include "mdtra_avx.h"
+#include "mdtra_bench.h"
+#include <xmmintrin.h>
+
+#define BENCH_DEFAULT_RESIDUES	1000
+#define BENCH_DEFAULT_WATERS	5000
+#define BENCH_DEFAULT_PASSES	5
+#define BENCH_ATOM_OPS			(40 * 1000 * 1000)	//atoms touched per pass
+
+static int s_numAtoms;
+static int s_numBackbone;
+static MDTRA_PDB_Atom *s_pAtoms = NULL;		//current frame
+static MDTRA_PDB_Atom *s_pRefAtoms = NULL;	//reference frame
+static MDTRA_PackedCoords s_packed;
+static MDTRA_PackedCoords s_refPacked;
+static float s_uMatrix[9];
+
+static unsigned int s_seed = 1;
+
+static float Bench_Random( float range )
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return ((float)((s_seed >> 8) & 0xFFFF) / 65535.0f - 0.5f) * range;
+}
+
+static void Bench_GenerateAtoms( MDTRA_PDB_Atom *pAtoms, int numResidues, int numWaters, float jitter )
+{
+	static const char *residueAtoms[5] = { "N", "H", "CA", "C", "O" };
+	MDTRA_PDB_Atom *pAt = pAtoms;
+	s_seed = 1;
+
+	for (int i = 0; i < numResidues; i++) {
+		float angle = i * 1.745f;
+		for (int j = 0; j < 5; j++, pAt++) {
+			memset( pAt, 0, sizeof(*pAt) );
+			strcpy( pAt->trimmed_title, residueAtoms[j] );
+			pAt->atomFlags = PDB_FLAG_PROTEIN | ((j != 1) ? PDB_FLAG_BACKBONE : 0);
+			pAt->xyz[0] = 2.3f * cosf( angle + j * 0.3f ) + Bench_Random( jitter );
+			pAt->xyz[1] = 2.3f * sinf( angle + j * 0.3f ) + Bench_Random( jitter );
+			pAt->xyz[2] = 1.5f * i + 0.3f * j + Bench_Random( jitter );
+		}
+	}
+	for (int i = 0; i < numWaters * 3; i++, pAt++) {
+		memset( pAt, 0, sizeof(*pAt) );
+		pAt->atomFlags = PDB_FLAG_WATER;
+		pAt->xyz[0] = Bench_Random( 80.0f );
+		pAt->xyz[1] = Bench_Random( 80.0f );
+		pAt->xyz[2] = Bench_Random( 80.0f ) + 0.75f * numResidues;
+	}
+}
+
+static void Bench_AllocPacked( MDTRA_PackedCoords *pPacked )
+{
+	pPacked->count = s_numBackbone;
+	pPacked->maxCount = (s_numBackbone + 7) & ~7;
+	pPacked->index = (int*)_mm_malloc( pPacked->maxCount * (sizeof(int) + 3 * sizeof(float)), 32 );
+	pPacked->x = (float*)(pPacked->index + pPacked->maxCount);
+	pPacked->y = pPacked->x + pPacked->maxCount;
+	pPacked->z = pPacked->y + pPacked->maxCount;
+	for (int i = 0, k = 0; i < s_numAtoms; i++) {
+		if (s_pAtoms[i].atomFlags & PDB_FLAG_BACKBONE)
+			pPacked->index[k++] = i;
+	}
+}
+
+static void Bench_Pack( MDTRA_PackedCoords *pPacked, const MDTRA_PDB_Atom *pAtoms )
+{
+	for (int i = 0; i < pPacked->count; i++) {
+		const MDTRA_PDB_Atom *pAt = pAtoms + pPacked->index[i];
+		pPacked->x[i] = pAt->xyz[0];
+		pPacked->y[i] = pAt->xyz[1];
+		pPacked->z[i] = pAt->xyz[2];
+	}
+	pPacked->valid = true;
+}
+
+//-------------------------------------------------------------------
+// aos-scalar: the loops of MDTRA_PDB_File without SSE
+
+static void Scalar_MoveToCentroid( float *pOut )
+{
+	float centroid_origin[3] = { 0, 0, 0 };
+	float inv_num_atoms = 1.0f / s_numBackbone;
+
+	for (int i = 0; i < s_numAtoms; i++) {
+		if (!(s_pAtoms[i].atomFlags & PDB_FLAG_BACKBONE))
+			continue;
+		centroid_origin[0] += s_pAtoms[i].xyz[0];
+		centroid_origin[1] += s_pAtoms[i].xyz[1];
+		centroid_origin[2] += s_pAtoms[i].xyz[2];
+	}
+
+	centroid_origin[0] *= inv_num_atoms;
+	centroid_origin[1] *= inv_num_atoms;
+	centroid_origin[2] *= inv_num_atoms;
+
+	for (int i = 0; i < s_numAtoms; i++) {
+		s_pAtoms[i].xyz[0] -= centroid_origin[0];
+		s_pAtoms[i].xyz[1] -= centroid_origin[1];
+		s_pAtoms[i].xyz[2] -= centroid_origin[2];
+	}
+	memcpy( pOut, centroid_origin, sizeof(centroid_origin) );
+}
+
+static void Scalar_RMatrix( float *rMatrix )
+{
+	memset( rMatrix, 0, sizeof(float) * 12 );
+	for (int k = 0; k < s_numAtoms; k++) {
+		if (!(s_pAtoms[k].atomFlags & PDB_FLAG_BACKBONE))
+			continue;
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				rMatrix[i*4+j] += s_pAtoms[k].xyz[i] * s_pRefAtoms[k].xyz[j];
+			}
+		}
+	}
+}
+
+static void Scalar_Transform( void )
+{
+	float oldCoord[3];
+	for (int i = 0; i < s_numAtoms; i++) {
+		oldCoord[0] = s_pAtoms[i].xyz[0];
+		oldCoord[1] = s_pAtoms[i].xyz[1];
+		oldCoord[2] = s_pAtoms[i].xyz[2];
+		s_pAtoms[i].xyz[0] = oldCoord[0] * s_uMatrix[0*3+0] + oldCoord[1] * s_uMatrix[1*3+0] + oldCoord[2] * s_uMatrix[2*3+0];
+		s_pAtoms[i].xyz[1] = oldCoord[0] * s_uMatrix[0*3+1] + oldCoord[1] * s_uMatrix[1*3+1] + oldCoord[2] * s_uMatrix[2*3+1];
+		s_pAtoms[i].xyz[2] = oldCoord[0] * s_uMatrix[0*3+2] + oldCoord[1] * s_uMatrix[1*3+2] + oldCoord[2] * s_uMatrix[2*3+2];
+	}
+}
+
+static float Scalar_RMSD( void )
+{
+	float flRMSD = 0.0f;
+	for (int i = 0; i < s_numAtoms; i++) {
+		if (!(s_pAtoms[i].atomFlags & PDB_FLAG_BACKBONE))
+			continue;
+		float dx = s_pAtoms[i].xyz[0] - s_pRefAtoms[i].xyz[0];
+		float dy = s_pAtoms[i].xyz[1] - s_pRefAtoms[i].xyz[1];
+		float dz = s_pAtoms[i].xyz[2] - s_pRefAtoms[i].xyz[2];
+		flRMSD += dx*dx + dy*dy + dz*dz;
+	}
+	return sqrtf( flRMSD / s_numBackbone );
+}
+
+//-------------------------------------------------------------------
+// aos-sse: SSE_PDB_* macros, or the same instruction sequence as intrinsics
+
+typedef struct stBench_PDB
+{
+	MDTRA_PDB_Atom *m_pAtoms;
+} Bench_PDB;
+
+static void SSE_MoveToCentroid( float *pOut )
+{
+	XMM_FLOAT centroid_origin[4];
+	XMM_FLOAT inv_num_atoms_vec[4];
+	float inv_num_atoms = 1.0f / s_numBackbone;
+	memset( centroid_origin, 0, sizeof(centroid_origin) );
+	inv_num_atoms_vec[0] = inv_num_atoms_vec[1] = inv_num_atoms_vec[2] = inv_num_atoms;
+	inv_num_atoms_vec[3] = 0.0f;
+
+#if defined(__i386__)
+	int m_iNumAtoms = s_numAtoms;
+	MDTRA_PDB_Atom *m_pAtoms = s_pAtoms;
+	int sizeof_pdb_atom = sizeof(MDTRA_PDB_Atom);
+	SSE_PDB_MOVE_TO_CENTROID(MDTRA_PDB_Atom, xyz, xyz, PDB_FLAG_BACKBONE);
+#else
+	__m128 sum = _mm_load_ps( centroid_origin );
+	for (int i = 0; i < s_numAtoms; i++) {
+		if (s_pAtoms[i].atomFlags & PDB_FLAG_BACKBONE)
+			sum = _mm_add_ps( sum, _mm_load_ps( s_pAtoms[i].xyz ) );
+	}
+	sum = _mm_mul_ps( sum, _mm_load_ps( inv_num_atoms_vec ) );
+	_mm_store_ps( centroid_origin, sum );
+	for (int i = 0; i < s_numAtoms; i++)
+		_mm_store_ps( s_pAtoms[i].xyz, _mm_sub_ps( _mm_load_ps( s_pAtoms[i].xyz ), sum ) );
+#endif
+	memcpy( pOut, centroid_origin, sizeof(float) * 3 );
+}
+
+static void SSE_RMatrix( float *pOut )
+{
+	XMM_FLOAT rMatrix[12];
+#if defined(__i386__)
+	XMM_FLOAT rtrMatrix[12];
+	int m_iNumAtoms = s_numAtoms;
+	MDTRA_PDB_Atom *m_pAtoms = s_pAtoms;
+	Bench_PDB other;
+	Bench_PDB *pOther = &other;
+	other.m_pAtoms = s_pRefAtoms;
+	int sizeof_pdb_atom = sizeof(MDTRA_PDB_Atom);
+	SSE_PDB_CALC_RTR_MATRIX(MDTRA_PDB_Atom, xyz, PDB_FLAG_BACKBONE);
+#else
+	__m128 r0 = _mm_setzero_ps();
+	__m128 r1 = _mm_setzero_ps();
+	__m128 r2 = _mm_setzero_ps();
+	for (int i = 0; i < s_numAtoms; i++) {
+		if (!(s_pAtoms[i].atomFlags & PDB_FLAG_BACKBONE))
+			continue;
+		__m128 a = _mm_load_ps( s_pAtoms[i].xyz );
+		__m128 b = _mm_load_ps( s_pRefAtoms[i].xyz );
+		r0 = _mm_add_ps( r0, _mm_mul_ps( _mm_shuffle_ps( a, a, 0x00 ), b ) );
+		r1 = _mm_add_ps( r1, _mm_mul_ps( _mm_shuffle_ps( a, a, 0x55 ), b ) );
+		r2 = _mm_add_ps( r2, _mm_mul_ps( _mm_shuffle_ps( a, a, 0xAA ), b ) );
+	}
+	_mm_store_ps( rMatrix + 0, r0 );
+	_mm_store_ps( rMatrix + 4, r1 );
+	_mm_store_ps( rMatrix + 8, r2 );
+#endif
+	memcpy( pOut, rMatrix, sizeof(rMatrix) );
+}
+
+//the transform loop of the WIN32 align_kabsch asm block
+static void SSE_Transform( void )
+{
+	__m128 r0 = _mm_setr_ps( s_uMatrix[0], s_uMatrix[1], s_uMatrix[2], 0.0f );
+	__m128 r1 = _mm_setr_ps( s_uMatrix[3], s_uMatrix[4], s_uMatrix[5], 0.0f );
+	__m128 r2 = _mm_setr_ps( s_uMatrix[6], s_uMatrix[7], s_uMatrix[8], 0.0f );
+	for (int i = 0; i < s_numAtoms; i++) {
+		__m128 v = _mm_load_ps( s_pAtoms[i].xyz );
+		__m128 x = _mm_mul_ps( _mm_shuffle_ps( v, v, 0x00 ), r0 );
+		__m128 y = _mm_mul_ps( _mm_shuffle_ps( v, v, 0x55 ), r1 );
+		__m128 z = _mm_mul_ps( _mm_shuffle_ps( v, v, 0xAA ), r2 );
+		_mm_store_ps( s_pAtoms[i].xyz, _mm_add_ps( _mm_add_ps( x, y ), z ) );
+	}
+}
+
+static float SSE_RMSD( void )
+{
+	XMM_FLOAT flRMSD[4];
+	XMM_FLOAT inv_num_atoms = 1.0f / s_numBackbone;
+#if defined(__i386__)
+	int m_iNumAtoms = s_numAtoms;
+	MDTRA_PDB_Atom *m_pAtoms = s_pAtoms;
+	Bench_PDB other;
+	Bench_PDB *pOther = &other;
+	other.m_pAtoms = s_pRefAtoms;
+	int sizeof_pdb_atom = sizeof(MDTRA_PDB_Atom);
+	SSE_PDB_CALC_RMSD(MDTRA_PDB_Atom, xyz, PDB_FLAG_BACKBONE);
+#else
+	__m128 sum = _mm_setzero_ps();
+	for (int i = 0; i < s_numAtoms; i++) {
+		if (!(s_pAtoms[i].atomFlags & PDB_FLAG_BACKBONE))
+			continue;
+		__m128 d = _mm_sub_ps( _mm_load_ps( s_pRefAtoms[i].xyz ), _mm_load_ps( s_pAtoms[i].xyz ) );
+		d = _mm_mul_ps( d, d );
+		d = _mm_add_ss( d, _mm_shuffle_ps( d, d, 0xE5 ) );
+		d = _mm_add_ss( d, _mm_shuffle_ps( d, d, 0xE6 ) );
+		sum = _mm_add_ps( sum, d );
+	}
+	sum = _mm_sqrt_ss( _mm_mul_ss( sum, _mm_set_ss( inv_num_atoms ) ) );
+	_mm_store_ps( flRMSD, sum );
+#endif
+	return flRMSD[0];
+}
+
+//-------------------------------------------------------------------
+// packed-avx2: what MDTRA_PDB_File does with a packed backbone block
+
+static void AVX2_MoveToCentroid( float *pOut )
+{
+	float inv_num_atoms = 1.0f / s_packed.count;
+	AVX_PackedSum( s_packed.x, s_packed.y, s_packed.z, s_packed.count, pOut );
+	pOut[0] *= inv_num_atoms;
+	pOut[1] *= inv_num_atoms;
+	pOut[2] *= inv_num_atoms;
+	AVX_AtomsTranslate( s_pAtoms->xyz, s_numAtoms, sizeof(MDTRA_PDB_Atom), pOut );
+	AVX_PackedTranslate( s_packed.x, s_packed.y, s_packed.z, s_packed.count, pOut );
+}
+
+static void AVX2_RMatrix( float *rMatrix )
+{
+	AVX_PackedCovariance( s_packed.x, s_packed.y, s_packed.z,
+						  s_refPacked.x, s_refPacked.y, s_refPacked.z, s_packed.count, rMatrix );
+}
+
+static void AVX2_Transform( void )
+{
+	AVX_AtomsTransform( s_pAtoms->xyz, s_numAtoms, sizeof(MDTRA_PDB_Atom), s_uMatrix );
+	AVX_PackedTransform( s_packed.x, s_packed.y, s_packed.z, s_packed.count, s_uMatrix );
+}
+
+static float AVX2_RMSD( void )
+{
+	return sqrtf( AVX_PackedSquaredDeviation( s_packed.x, s_packed.y, s_packed.z,
+											  s_refPacked.x, s_refPacked.y, s_refPacked.z, s_packed.count ) / s_packed.count );
+}
+
+//-------------------------------------------------------------------
+
+enum
+{
+	BENCH_KERNEL_CENTROID = 0,
+	BENCH_KERNEL_RMATRIX,
+	BENCH_KERNEL_TRANSFORM,
+	BENCH_KERNEL_RMSD,
+	BENCH_KERNEL_PACK,
+	BENCH_KERNEL_COUNT
+};
+
+enum
+{
+	BENCH_FORM_SCALAR = 0,
+	BENCH_FORM_SSE,
+	BENCH_FORM_AVX2,
+	BENCH_FORM_COUNT
+};
+
+static const char *s_kernelNames[BENCH_KERNEL_COUNT] = { "centroid", "r-matrix", "transform", "rmsd", "pack" };
+static const char *s_formNames[BENCH_FORM_COUNT] = { "aos-scalar", "aos-sse", "packed-avx2" };
+
+//one kernel call, the result goes to pOut (up to 12 floats)
+static bool Bench_Call( int kernel, int form, float *pOut )
+{
+	switch (kernel) {
+	case BENCH_KERNEL_CENTROID:
+		if (form == BENCH_FORM_SCALAR) Scalar_MoveToCentroid( pOut );
+		else if (form == BENCH_FORM_SSE) SSE_MoveToCentroid( pOut );
+		else AVX2_MoveToCentroid( pOut );
+		return true;
+	case BENCH_KERNEL_RMATRIX:
+		if (form == BENCH_FORM_SCALAR) Scalar_RMatrix( pOut );
+		else if (form == BENCH_FORM_SSE) SSE_RMatrix( pOut );
+		else AVX2_RMatrix( pOut );
+		return true;
+	case BENCH_KERNEL_TRANSFORM:
+		if (form == BENCH_FORM_SCALAR) Scalar_Transform();
+		else if (form == BENCH_FORM_SSE) SSE_Transform();
+		else AVX2_Transform();
+		return true;
+	case BENCH_KERNEL_RMSD:
+		if (form == BENCH_FORM_SCALAR) pOut[0] = Scalar_RMSD();
+		else if (form == BENCH_FORM_SSE) pOut[0] = SSE_RMSD();
+		else pOut[0] = AVX2_RMSD();
+		return true;
+	case BENCH_KERNEL_PACK:
+		if (form != BENCH_FORM_AVX2)
+			return false;
+		Bench_Pack( &s_packed, s_pAtoms );
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+static bool Bench_Compare( const float *pA, const float *pB, int count )
+{
+	for (int i = 0; i < count; i++) {
+		float tolerance = 1e-3f * MDTRA_MAX( 1.0f, fabsf( pA[i] ) );
+		if (fabsf( pA[i] - pB[i] ) > tolerance)
+			return false;
+	}
+	return true;
+}
+
+int main( int argc, char **argv )
+{
+	int numResidues = (argc > 1) ? atoi( argv[1] ) : BENCH_DEFAULT_RESIDUES;
+	int numWaters = (argc > 2) ? atoi( argv[2] ) : BENCH_DEFAULT_WATERS;
+	int numPasses = (argc > 3) ? atoi( argv[3] ) : BENCH_DEFAULT_PASSES;
+	if (numResidues <= 0) numResidues = BENCH_DEFAULT_RESIDUES;
+	if (numWaters < 0) numWaters = BENCH_DEFAULT_WATERS;
+	if (numPasses <= 0) numPasses = BENCH_DEFAULT_PASSES;
+
+	bool bAVX2 = __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" );
+
+	s_numAtoms = numResidues * 5 + numWaters * 3;
+	s_numBackbone = numResidues * 4;
+	s_pAtoms = (MDTRA_PDB_Atom*)_mm_malloc( s_numAtoms * sizeof(MDTRA_PDB_Atom), 16 );
+	s_pRefAtoms = (MDTRA_PDB_Atom*)_mm_malloc( s_numAtoms * sizeof(MDTRA_PDB_Atom), 16 );
+	Bench_GenerateAtoms( s_pAtoms, numResidues, numWaters, 0.3f );
+	Bench_GenerateAtoms( s_pRefAtoms, numResidues, numWaters, 0.0f );
+	Bench_AllocPacked( &s_packed );
+	Bench_AllocPacked( &s_refPacked );
+	Bench_Pack( &s_refPacked, s_pRefAtoms );
+
+	//a small rotation about z, applied over and over by the transform kernel
+	float c = cosf( 0.001f ), s = sinf( 0.001f );
+	memset( s_uMatrix, 0, sizeof(s_uMatrix) );
+	s_uMatrix[0] = c; s_uMatrix[1] = s;
+	s_uMatrix[3] = -s; s_uMatrix[4] = c;
+	s_uMatrix[8] = 1.0f;
+
+	int iterations = MDTRA_MAX( 1, BENCH_ATOM_OPS / s_numAtoms );
+
+	fprintf( stderr, "atoms: %d (%d backbone), atom size: %d bytes, passes: %d x %d calls (best time reported), avx2: %s, sse: %s\n",
+			 s_numAtoms, s_numBackbone, (int)sizeof(MDTRA_PDB_Atom), numPasses, iterations, bAVX2 ? "yes" : "no",
+#if defined(__i386__)
+			 "SSE_PDB_* macros"
+#else
+			 "intrinsics transliteration of SSE_PDB_*"
+#endif
+			 );
+	fprintf( stderr, "%-10s %-12s %12s %12s %10s\n", "kernel", "form", "us/call", "ns/atom", "vs sse" );
+
+	int mismatches = 0;
+	double frameTime[BENCH_FORM_COUNT];
+	memset( frameTime, 0, sizeof(frameTime) );
+
+	for (int kernel = 0; kernel < BENCH_KERNEL_COUNT; kernel++) {
+		double sseTime = 0.0;
+		bool bReference = false;
+		float reference[12];
+
+		for (int form = 0; form < BENCH_FORM_COUNT; form++) {
+			if (form == BENCH_FORM_AVX2 && !bAVX2)
+				continue;
+
+			float result[12];
+			memset( result, 0, sizeof(result) );
+
+			//every form starts from the same frame
+			Bench_GenerateAtoms( s_pAtoms, numResidues, numWaters, 0.3f );
+			Bench_Pack( &s_packed, s_pAtoms );
+			if (!Bench_Call( kernel, form, result ))
+				continue;
+
+			if (form == BENCH_FORM_SCALAR) {
+				memcpy( reference, result, sizeof(reference) );
+				bReference = true;
+			} else if (bReference && !Bench_Compare( reference, result, 12 )) {
+				fprintf( stderr, "%s/%s: result mismatch\n", s_kernelNames[kernel], s_formNames[form] );
+				mismatches++;
+			}
+
+			Bench_Timing timing;
+			Bench_TimingReset( &timing );
+			for (int pass = 0; pass < numPasses; pass++) {
+				double t0 = Bench_Seconds();
+				for (int i = 0; i < iterations; i++)
+					Bench_Call( kernel, form, result );
+				Bench_TimingAdd( &timing, Bench_Seconds() - t0 );
+			}
+
+			double perCall = timing.best / iterations;
+			frameTime[form] += perCall;
+			if (form == BENCH_FORM_SSE)
+				sseTime = perCall;
+
+			char speedup[32] = "";
+			if (form != BENCH_FORM_SSE && sseTime > 0.0)
+				sprintf( speedup, "%.2fx", sseTime / perCall );
+			fprintf( stderr, "%-10s %-12s %12.2f %12.3f %10s\n", s_kernelNames[kernel], s_formNames[form],
+					 perCall * 1e6, perCall * 1e9 / s_numAtoms, speedup );
+		}
+	}
+
+	//a new frame is packed, moved to its centroid, aligned and compared once
+	fprintf( stderr, "%-10s %-12s %12.2f %12.3f %10s\n", "frame", s_formNames[BENCH_FORM_SSE],
+			 frameTime[BENCH_FORM_SSE] * 1e6, frameTime[BENCH_FORM_SSE] * 1e9 / s_numAtoms, "" );
+	if (bAVX2) {
+		char speedup[32];
+		sprintf( speedup, "%.2fx", frameTime[BENCH_FORM_SSE] / frameTime[BENCH_FORM_AVX2] );
+		fprintf( stderr, "%-10s %-12s %12.2f %12.3f %10s\n", "frame", s_formNames[BENCH_FORM_AVX2],
+				 frameTime[BENCH_FORM_AVX2] * 1e6, frameTime[BENCH_FORM_AVX2] * 1e9 / s_numAtoms, speedup );
+	}
+	fprintf( stderr, "mismatches: %d\n", mismatches );
+
+	_mm_free( s_packed.index );
+	_mm_free( s_refPacked.index );
+	_mm_free( s_pAtoms );
+	_mm_free( s_pRefAtoms );
+	return mismatches ? 1 : 0;
+}
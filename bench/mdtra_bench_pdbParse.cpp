@@ -0,0 +1,245 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	PDB frame parse benchmark (line reader and fixed-column decoding)
+//
+//	Generates a 100k-atom frame and parses it with the previous stdio/strncpy
+//	path and with MDTRA_InputFile::getLine + UTIL_ParseFixedInt/Float.
+//	Usage: mdtra_bench_pdbParse [numAtoms] [numPasses]
+
+#include "mdtra_main.h"
+#include "mdtra_utils.h"
+#include "mdtra_inputFile.h"
+#include "mdtra_bench.h"
+
+#define BENCH_FILENAME			"mdtra_bench_frame.pdb"
+#define BENCH_DEFAULT_ATOMS		100000
+#define BENCH_DEFAULT_PASSES	10
+
+typedef struct {
+	int serialnumber;
+	int residuenumber;
+	char title[8];
+	char residue[8];
+	short chain;
+	float xyz[3];
+} BenchAtom_t;
+
+//the benchmark is linked without mdtra_utils.cpp (it depends on Qt)
+void* UTIL_AlignedMalloc( size_t size ) { return malloc( size ); }
+void UTIL_AlignedFree( void *baseptr ) { free( baseptr ); }
+
+//...and without mdtra_threads.cpp, everything runs in thread slot 0
+int CountThreadSlots( void ) { return 1; }
+
+int UTIL_Atoi( const char *str )
+{
+	int val, sign, c;
+	if (!str) return 0;
+	while (*str && (byte)(*str) <= 32) str++;
+	if (*str == '-') { sign = -1; str++; } else sign = 1;
+	val = 0;
+	if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+		str += 2;
+		while (1) {
+			c = *str++;
+			if (c >= '0' && c <= '9') val = (val<<4) + c - '0';
+			else if (c >= 'a' && c <= 'f') val = (val<<4) + c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') val = (val<<4) + c - 'A' + 10;
+			else return val*sign;
+		}
+	}
+	if (str[0] == '\'') return sign * str[1];
+	while (1) {
+		c = *str++;
+		if (c < '0' || c > '9') return val*sign;
+		val = val*10 + c - '0';
+	}
+}
+
+float UTIL_Atof( const char *str )
+{
+	double val;
+	int sign, c, decimal, total;
+	if (!str) return 0;
+	while (*str && (byte)(*str) <= 32) str++;
+	if (*str == '-') { sign = -1; str++; } else sign = 1;
+	val = 0;
+	if (str[0] == '\'') return (float)(sign * str[1]);
+	decimal = -1;
+	total = 0;
+	while (1) {
+		c = *str++;
+		if (c == '.') { decimal = total; continue; }
+		if (c < '0' || c > '9') break;
+		val = val*10 + c - '0';
+		total++;
+	}
+	if (decimal == -1) return (float)val*sign;
+	while (total > decimal) { val /= 10; total--; }
+	return (float)val*sign;
+}
+
+static bool Bench_WriteFrame( const char *filename, int numAtoms )
+{
+	static const char *s_Titles[4] = { " N  ", " CA ", " C  ", " O  " };
+	FILE *fp = fopen( filename, "w" );
+	if (!fp) return false;
+
+	fprintf( fp, "REMARK   MDTRA parse benchmark frame\n" );
+	srand( 1 );
+	for (int i = 0; i < numAtoms; i++) {
+		float x = (rand() % 200000) * 0.001f - 100.0f;
+		float y = (rand() % 200000) * 0.001f - 100.0f;
+		float z = (rand() % 200000) * 0.001f - 100.0f;
+		fprintf( fp, "ATOM  %5d %4s %3s %c%4d    %8.3f%8.3f%8.3f  1.00  0.00\n",
+				 (i % 99999) + 1, s_Titles[i & 3], "ALA", 'A' + (i / 10000) % 26, (i / 4) % 10000, x, y, z );
+		if ((i % 10000) == 9999) fprintf( fp, "TER\n" );
+	}
+	fprintf( fp, "END\n" );
+	fclose( fp );
+	return true;
+}
+
+//previous path: fgets into a line buffer, every field is copied before decoding
+static void Bench_CopyField( char *out, const char *linebuf, int start, int size )
+{
+	char localbuffer[81];
+	memset( localbuffer, 0, sizeof(localbuffer) );
+	strncpy_s( localbuffer, linebuf + start, size );
+	memcpy( out, localbuffer, size + 1 );
+}
+
+static int Bench_ParseBaseline( const char *filename, BenchAtom_t *pAtoms, int maxAtoms )
+{
+	FILE *fp = fopen( filename, "r" );
+	if (!fp) return 0;
+
+	char linebuf[82];
+	char field[81];
+	int numAtoms = 0;
+	while (!feof( fp )) {
+		linebuf[0] = 0;
+		if (!fgets( linebuf, 82, fp )) break;
+		if (!_strnicmp( linebuf, "ENDMDL", 6 )) break;
+		if (!_strnicmp( linebuf, "ATOM  ", 6 ) || !_strnicmp( linebuf, "HETATM", 6 )) {
+			if (numAtoms >= maxAtoms) break;
+			BenchAtom_t *pAt = pAtoms + numAtoms++;
+			Bench_CopyField( field, linebuf, 6, 5 ); pAt->serialnumber = UTIL_Atoi( field );
+			Bench_CopyField( field, linebuf, 22, 4 ); pAt->residuenumber = UTIL_Atoi( field );
+			Bench_CopyField( field, linebuf, 21, 1 ); pAt->chain = field[0];
+			Bench_CopyField( pAt->title, linebuf, 12, 4 );
+			Bench_CopyField( pAt->residue, linebuf, 17, 3 );
+			Bench_CopyField( field, linebuf, 30, 8 ); pAt->xyz[0] = UTIL_Atof( field );
+			Bench_CopyField( field, linebuf, 38, 8 ); pAt->xyz[1] = UTIL_Atof( field );
+			Bench_CopyField( field, linebuf, 46, 8 ); pAt->xyz[2] = UTIL_Atof( field );
+		} else if (!_strnicmp( linebuf, "TER", 3 )) {
+			continue;
+		} else {
+			printf( "%s", linebuf );
+		}
+	}
+	fclose( fp );
+	return numAtoms;
+}
+
+//current path: mapped lines, fields decoded in place
+static int Bench_ParseMapped( const char *filename, BenchAtom_t *pAtoms, int maxAtoms )
+{
+	MDTRA_InputFile file;
+	if (!file.open( 0, filename )) return 0;
+
+	const char *pLine;
+	int length;
+	int numAtoms = 0;
+	while ((pLine = file.getLine( &length )) != NULL) {
+		if (length >= 6 && (pLine[0] == 'E' || pLine[0] == 'e') && !_strnicmp( pLine, "ENDMDL", 6 )) break;
+		if (length < 6) continue;
+		if (((pLine[0] == 'A' || pLine[0] == 'a') && !_strnicmp( pLine, "ATOM  ", 6 )) ||
+			((pLine[0] == 'H' || pLine[0] == 'h') && !_strnicmp( pLine, "HETATM", 6 ))) {
+			if (numAtoms >= maxAtoms || length < 54) break;
+			BenchAtom_t *pAt = pAtoms + numAtoms++;
+			pAt->serialnumber = UTIL_ParseFixedInt( pLine + 6, 5 );
+			pAt->residuenumber = UTIL_ParseFixedInt( pLine + 22, 4 );
+			pAt->chain = pLine[21];
+			memcpy( pAt->title, pLine + 12, 4 ); pAt->title[4] = 0;
+			memcpy( pAt->residue, pLine + 17, 3 ); pAt->residue[3] = 0;
+			pAt->xyz[0] = UTIL_ParseFixedFloat( pLine + 30, 8 );
+			pAt->xyz[1] = UTIL_ParseFixedFloat( pLine + 38, 8 );
+			pAt->xyz[2] = UTIL_ParseFixedFloat( pLine + 46, 8 );
+		}
+	}
+	file.close();
+	return numAtoms;
+}
+
+int main( int argc, char **argv )
+{
+	int numAtoms = (argc > 1) ? atoi( argv[1] ) : BENCH_DEFAULT_ATOMS;
+	int numPasses = (argc > 2) ? atoi( argv[2] ) : BENCH_DEFAULT_PASSES;
+	if (numAtoms <= 0) numAtoms = BENCH_DEFAULT_ATOMS;
+	if (numPasses <= 0) numPasses = BENCH_DEFAULT_PASSES;
+
+	if (!Bench_WriteFrame( BENCH_FILENAME, numAtoms )) {
+		fprintf( stderr, "Failed to write %s\n", BENCH_FILENAME );
+		return 1;
+	}
+
+	BenchAtom_t *pAtomsA = (BenchAtom_t*)malloc( numAtoms * sizeof(BenchAtom_t) );
+	BenchAtom_t *pAtomsB = (BenchAtom_t*)malloc( numAtoms * sizeof(BenchAtom_t) );
+	int countA = 0, countB = 0;
+	double bestA = 1e30, bestB = 1e30;
+
+	//the baseline echoes non-atom records to stdout as the previous loader did
+	for (int i = 0; i < numPasses; i++) {
+		double t0 = Bench_Seconds();
+		countA = Bench_ParseBaseline( BENCH_FILENAME, pAtomsA, numAtoms );
+		double t1 = Bench_Seconds();
+		countB = Bench_ParseMapped( BENCH_FILENAME, pAtomsB, numAtoms );
+		double t2 = Bench_Seconds();
+		bestA = MDTRA_MIN( bestA, t1 - t0 );
+		bestB = MDTRA_MIN( bestB, t2 - t1 );
+	}
+
+	int mismatches = (countA != countB) ? 1 : 0;
+	for (int i = 0; i < countA && i < countB; i++) {
+		if (pAtomsA[i].serialnumber != pAtomsB[i].serialnumber ||
+			pAtomsA[i].residuenumber != pAtomsB[i].residuenumber ||
+			pAtomsA[i].chain != pAtomsB[i].chain ||
+			strcmp( pAtomsA[i].title, pAtomsB[i].title ) ||
+			strcmp( pAtomsA[i].residue, pAtomsB[i].residue ) ||
+			fabsf( pAtomsA[i].xyz[0] - pAtomsB[i].xyz[0] ) > 1e-5f ||
+			fabsf( pAtomsA[i].xyz[1] - pAtomsB[i].xyz[1] ) > 1e-5f ||
+			fabsf( pAtomsA[i].xyz[2] - pAtomsB[i].xyz[2] ) > 1e-5f)
+			mismatches++;
+	}
+
+	fprintf( stderr, "atoms: %d, passes: %d (best time reported)\n", countB, numPasses );
+	fprintf( stderr, "baseline (fgets + strncpy + UTIL_Atof): %8.2f ms\n", bestA * 1000.0 );
+	fprintf( stderr, "mapped   (getLine + UTIL_ParseFixed*):  %8.2f ms\n", bestB * 1000.0 );
+	fprintf( stderr, "speedup: %.2fx, mismatches: %d\n", bestA / bestB, mismatches );
+
+	free( pAtomsA );
+	free( pAtomsB );
+	remove( BENCH_FILENAME );
+	return mismatches ? 1 : 0;
+}
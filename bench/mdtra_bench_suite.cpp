@@ -0,0 +1,593 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Core path benchmark suite over a synthetic protein + water trajectory
+//
+//	Writes a deterministic trajectory (a bundle of helical residues in a
+//	water box, one PDB file per frame, every frame a rigid motion of the
+//	first plus thermal noise) and times the real code paths on it: frame
+//	load, move_to_centroid, align_kabsch, get_rmsd, MDTRA_CalculateSAS,
+//	HBCalcPair, distance search cells, PCA covariance and the 2D-RMSD matrix.
+//	Results are written as JSON, so runs can be compared over time.
+//
+//	Linked with the application objects (see linux/Makefile, "make mdtra_bench")
+//	and run headless, no display is needed.
+//	Usage: mdtra_bench [-residues N] [-waters N] [-frames N] [-passes N]
+//	                   [-threads N] [-nosse] [-dir path] [-out file.json] [-keep]
+
+#include "mdtra_main.h"
+#include "mdtra_project.h"
+#include "mdtra_pdb.h"
+#include "mdtra_pdb_flags.h"
+#include "mdtra_pdb_format.h"
+#include "mdtra_compact_pdb.h"
+#include "mdtra_prefetch.h"
+#include "mdtra_distanceSearch.h"
+#include "mdtra_pca.h"
+#include "mdtra_hbSearch.h"
+#include "mdtra_configFile.h"
+#include "mdtra_SAS.h"
+#include "mdtra_cpuid.h"
+#include "mdtra_cuda.h"
+#include "mdtra_batch.h"
+#include "mdtra_bench.h"
+
+#include <QtCore/QDir>
+#include <QtGui/QApplication>
+
+#define BENCH_DEFAULT_RESIDUES	300
+#define BENCH_DEFAULT_WATERS	3000
+#define BENCH_DEFAULT_FRAMES	20
+#define BENCH_DEFAULT_PASSES	5
+#define BENCH_HELIX_RESIDUES	18		//residues per helix of the bundle
+#define BENCH_MAX_ATOMS			99999	//PDB serial numbers must stay unique
+#define BENCH_HB_PAIR_DIST		4.5f	//donor-acceptor pairs taken from the first frame
+
+QApplication *g_pApp = NULL;
+
+typedef struct stBench_Config
+{
+	int			numResidues;
+	int			numWaters;
+	int			numAtoms;
+	int			numFrames;
+	int			numPasses;
+	int			numThreads;
+	bool		allowSSE;
+	bool		keepFiles;
+	QString		dataDir;
+	QString		outFile;
+} Bench_Config;
+
+typedef struct stBench_Atom
+{
+	const char*	title;
+	const char*	residue;
+	char		chain;
+	int			residuenumber;
+	float		xyz[3];
+} Bench_Atom;
+
+typedef struct stBench_Result
+{
+	const char*	name;
+	const char*	unit;
+	int			items;			//work items per pass
+	Bench_Timing timing;
+	double		checksum;
+} Bench_Result;
+
+static Bench_Config s_config;
+static QList<QByteArray> s_frameFiles;
+static MDTRA_PDB_File **s_ppFrames = NULL;
+static MDTRA_Compact_PDB_File **s_ppCompactFrames = NULL;
+static QVector<int> s_caIndices;			//one CA atom per residue
+static QVector<int> s_proteinIndices;
+static QVector<int> s_hbDonors;				//backbone N, paired with s_hbAcceptors
+static QVector<int> s_hbAcceptors;
+static QList<Bench_Result> s_results;
+
+//deterministic, so every run of a configuration sees the same coordinates
+static unsigned int s_seed = 1;
+
+static float Bench_Random( void )
+{
+	s_seed = s_seed * 1664525u + 1013904223u;
+	return (float)(s_seed >> 8) * (1.0f / 16777216.0f);
+}
+
+//////////////////////////////////////////////////////////////////////
+// synthetic trajectory
+
+static void Bench_BuildProtein( QVector<Bench_Atom> *pAtoms )
+{
+	static const char *s_residues[6] = { "ALA", "SER", "LEU", "GLU", "LYS", "THR" };
+	static const char *s_titles[5] = { " N  ", " H  ", " CA ", " C  ", " O  " };
+	static const float s_radius[5] = { 1.55f, 1.10f, 2.30f, 1.65f, 2.85f };
+	static const float s_phase[5] = { -28.0f, -40.0f, 0.0f, 28.0f, 36.0f };
+	static const float s_rise[5] = { -0.85f, -1.40f, 0.0f, 0.85f, 1.20f };
+
+	int numColumns = (int)ceilf( sqrtf( (float)(s_config.numResidues + BENCH_HELIX_RESIDUES - 1) / BENCH_HELIX_RESIDUES ) );
+
+	for (int r = 0; r < s_config.numResidues; r++) {
+		int helix = r / BENCH_HELIX_RESIDUES;
+		int turn = r % BENCH_HELIX_RESIDUES;
+		float cx = (helix % numColumns) * 10.0f;
+		float cy = (helix / numColumns) * 10.0f;
+
+		for (int k = 0; k < 5; k++) {
+			Bench_Atom at;
+			float angle = (turn * 100.0f + s_phase[k]) * (float)M_PI / 180.0f;
+			at.title = s_titles[k];
+			at.residue = s_residues[r % 6];
+			at.chain = 'A' + (char)(helix % 26);
+			at.residuenumber = r + 1;
+			at.xyz[0] = cx + s_radius[k] * cosf( angle );
+			at.xyz[1] = cy + s_radius[k] * sinf( angle );
+			at.xyz[2] = turn * 1.5f + s_rise[k];
+			pAtoms->append( at );
+		}
+	}
+}
+
+//waters on a cubic lattice around the bundle, away from protein atoms
+static void Bench_BuildWater( QVector<Bench_Atom> *pAtoms )
+{
+	float mins[3] = { 1e30f, 1e30f, 1e30f };
+	float maxs[3] = { -1e30f, -1e30f, -1e30f };
+	int numProtein = pAtoms->count();
+
+	for (int i = 0; i < numProtein; i++) {
+		for (int k = 0; k < 3; k++) {
+			mins[k] = MDTRA_MIN( mins[k], pAtoms->at(i).xyz[k] );
+			maxs[k] = MDTRA_MAX( maxs[k], pAtoms->at(i).xyz[k] );
+		}
+	}
+
+	const float spacing = 3.1f;
+	int placed = 0;
+	for (int shell = 0; placed < s_config.numWaters; shell++) {
+		//grow the box by one lattice step until all waters fit
+		float lo[3], hi[3];
+		int n[3];
+		for (int k = 0; k < 3; k++) {
+			lo[k] = mins[k] - 4.0f - shell * spacing;
+			hi[k] = maxs[k] + 4.0f + shell * spacing;
+			n[k] = (int)((hi[k] - lo[k]) / spacing) + 1;
+		}
+		pAtoms->resize( numProtein );
+		placed = 0;
+
+		for (int ix = 0; ix < n[0] && placed < s_config.numWaters; ix++) {
+			for (int iy = 0; iy < n[1] && placed < s_config.numWaters; iy++) {
+				for (int iz = 0; iz < n[2] && placed < s_config.numWaters; iz++) {
+					float o[3] = { lo[0] + ix * spacing, lo[1] + iy * spacing, lo[2] + iz * spacing };
+					bool clash = false;
+					for (int i = 0; i < numProtein && !clash; i++) {
+						const float *p = pAtoms->at(i).xyz;
+						float d2 = (o[0]-p[0])*(o[0]-p[0]) + (o[1]-p[1])*(o[1]-p[1]) + (o[2]-p[2])*(o[2]-p[2]);
+						clash = (d2 < 2.8f*2.8f);
+					}
+					if (clash)
+						continue;
+
+					static const char *s_titles[3] = { " O  ", " H1 ", " H2 " };
+					static const float s_offset[3][3] = { { 0, 0, 0 }, { 0.96f, 0, 0 }, { -0.24f, 0.93f, 0 } };
+					for (int k = 0; k < 3; k++) {
+						Bench_Atom at;
+						at.title = s_titles[k];
+						at.residue = "HOH";
+						at.chain = 'W';
+						at.residuenumber = placed + 1;
+						at.xyz[0] = o[0] + s_offset[k][0];
+						at.xyz[1] = o[1] + s_offset[k][1];
+						at.xyz[2] = o[2] + s_offset[k][2];
+						pAtoms->append( at );
+					}
+					placed++;
+				}
+			}
+		}
+	}
+}
+
+static bool Bench_WriteFrame( const char *filename, const QVector<Bench_Atom> &atoms, int frame )
+{
+	FILE *fp = fopen( filename, "w" );
+	if (!fp)
+		return false;
+
+	//rigid motion of the whole system plus per-atom noise
+	float angle = frame * 2.0f * (float)M_PI / 180.0f;
+	float c = cosf( angle ), s = sinf( angle );
+	float shift = frame * 0.1f;
+
+	fprintf( fp, "REMARK   MDTRA benchmark frame %d\n", frame + 1 );
+	for (int i = 0; i < atoms.count(); i++) {
+		const Bench_Atom *pAt = &atoms.at(i);
+		float x = pAt->xyz[0] + (Bench_Random() - 0.5f) * 0.6f;
+		float y = pAt->xyz[1] + (Bench_Random() - 0.5f) * 0.6f;
+		float z = pAt->xyz[2] + (Bench_Random() - 0.5f) * 0.6f;
+		fprintf( fp, "ATOM  %5d %4s %3s %c%4d    %8.3f%8.3f%8.3f  1.00  0.00\n",
+				 i + 1, pAt->title, pAt->residue, pAt->chain, pAt->residuenumber % 10000,
+				 c*x - s*y + shift, s*x + c*y, z - shift );
+	}
+	fprintf( fp, "END\n" );
+	fclose( fp );
+	return true;
+}
+
+static bool Bench_GenerateTrajectory( void )
+{
+	QVector<Bench_Atom> atoms;
+	Bench_BuildProtein( &atoms );
+	Bench_BuildWater( &atoms );
+	s_config.numAtoms = atoms.count();
+
+	if (!QDir().mkpath( s_config.dataDir )) {
+		fprintf( stderr, "Cannot create %s\n", s_config.dataDir.toLocal8Bit().constData() );
+		return false;
+	}
+
+	s_seed = 1;
+	for (int f = 0; f < s_config.numFrames; f++) {
+		QByteArray filename = QDir(s_config.dataDir).filePath( QString("frame%1.pdb").arg(f + 1, 4, 10, QChar('0')) ).toLocal8Bit();
+		if (!Bench_WriteFrame( filename.constData(), atoms, f )) {
+			fprintf( stderr, "Cannot write %s\n", filename.constData() );
+			return false;
+		}
+		s_frameFiles << filename;
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// measured paths, each returns a checksum so that the work cannot be dropped
+
+static double Bench_Load( void )
+{
+	double sum = 0;
+	for (int f = 0; f < s_config.numFrames; f++) {
+		s_ppFrames[f]->load( 0, PDB_GENERIC_FORMAT, s_frameFiles.at(f).constData(), 0 );
+		sum += s_ppFrames[f]->getAtomCount();
+	}
+	return sum;
+}
+
+static double Bench_MoveToCentroid( void )
+{
+	double sum = 0;
+	for (int f = 0; f < s_config.numFrames; f++) {
+		s_ppFrames[f]->move_to_centroid();
+		sum += s_ppFrames[f]->fetchAtomByIndex( 0 )->xyz[0];
+	}
+	return sum;
+}
+
+static double Bench_AlignKabsch( void )
+{
+	double sum = 0;
+	for (int f = 1; f < s_config.numFrames; f++) {
+		s_ppFrames[f]->align_kabsch( s_ppFrames[0] );
+		sum += s_ppFrames[f]->fetchAtomByIndex( 0 )->xyz[0];
+	}
+	return sum;
+}
+
+static double Bench_RMSD( void )
+{
+	double sum = 0;
+	for (int f = 1; f < s_config.numFrames; f++)
+		sum += s_ppFrames[f]->get_rmsd( s_ppFrames[0] );
+	return sum;
+}
+
+static double Bench_SAS( void )
+{
+	double sum = 0;
+	for (int f = 0; f < s_config.numFrames; f++)
+		sum += MDTRA_CalculateSAS( 0, s_ppFrames[f]->fetchAtomByIndex( 0 ), s_ppFrames[f]->getAtomCount() );
+	return sum;
+}
+
+static double Bench_HBonds( void )
+{
+	double sum = 0;
+	for (int f = 0; f < s_config.numFrames; f++) {
+		const MDTRA_PDB_File *pdb = s_ppFrames[f];
+		for (int i = 0; i < s_hbDonors.count(); i++)
+			sum += HBCalcPair( pdb, pdb->fetchAtomByIndex( s_hbDonors[i] ), pdb->fetchAtomByIndex( s_hbAcceptors[i] ) );
+	}
+	return sum;
+}
+
+static double Bench_DistanceCells( void )
+{
+	MDTRA_DistanceSearchData data;
+	memset( &data, 0, sizeof(data) );
+	data.ignoreSameResidue = true;
+	data.selectionSize = s_caIndices.count();
+	data.selectionData = s_caIndices.constData();
+	data.statParm = MDTRA_SP_ARITHMETIC_MEAN;
+
+	int numCells = data.selectionSize * (data.selectionSize - 1) / 2;
+	float *pCells = new float[numCells];
+	memset( pCells, 0, numCells * sizeof(float) );
+
+	for (int f = 0; f < s_config.numFrames; f++)
+		DistanceSearchCalculateCells( s_ppFrames[f], &data, 1, (f == 0), pCells );
+
+	double sum = 0;
+	for (int i = 0; i < numCells; i++)
+		sum += pCells[i];
+	delete [] pCells;
+	return sum;
+}
+
+static double Bench_PCACovariance( void )
+{
+	int selectionSize = s_caIndices.count();
+	size_t numCov = (size_t)selectionSize * selectionSize * 9;
+	float *pMeans = new float[selectionSize * 3];
+	float *pCovariance = new float[numCov];
+	memset( pMeans, 0, selectionSize * 3 * sizeof(float) );
+	memset( pCovariance, 0, numCov * sizeof(float) );
+
+	for (int f = 0; f < s_config.numFrames; f++) {
+		PCAAccumulateMeans( s_ppFrames[f], pMeans );
+		PCAAccumulateCovariance( s_ppFrames[f], selectionSize, pCovariance );
+	}
+
+	double sum = 0;
+	for (size_t i = 0; i < numCov; i += selectionSize * 3 + 1)
+		sum += pCovariance[i];
+	delete [] pMeans;
+	delete [] pCovariance;
+	return sum;
+}
+
+//same loop as MDTRA_2D_RMSD_Dialog::calc_rmsd
+static double Bench_RMSDMatrix( void )
+{
+	double sum = 0;
+	for (int i = 1; i < s_config.numFrames; i++) {
+		for (int j = 0; j < i; j++) {
+			s_ppCompactFrames[i]->align_kabsch( s_ppCompactFrames[j] );
+			sum += s_ppCompactFrames[i]->get_rmsd( s_ppCompactFrames[j] );
+		}
+	}
+	return sum;
+}
+
+static void Bench_Measure( const char *name, const char *unit, int items, double (*pfnPass)( void ) )
+{
+	Bench_Result result;
+	result.name = name;
+	result.unit = unit;
+	result.items = items;
+	result.checksum = 0;
+	Bench_TimingReset( &result.timing );
+
+	for (int i = 0; i < s_config.numPasses; i++) {
+		double t0 = Bench_Seconds();
+		result.checksum = pfnPass();
+		Bench_TimingAdd( &result.timing, Bench_Seconds() - t0 );
+	}
+
+	fprintf( stderr, "%-16s %10.3f ms best, %10.3f ms mean, %10.3f us/%s\n", name,
+			 result.timing.best * 1e3, Bench_TimingMean( &result.timing ) * 1e3,
+			 result.timing.best * 1e6 / MDTRA_MAX( 1, items ), unit );
+	s_results << result;
+}
+
+//////////////////////////////////////////////////////////////////////
+// setup and report
+
+static void Bench_Prepare( void )
+{
+	//selections come from the topology of the first frame
+	const MDTRA_PDB_File *pdb = s_ppFrames[0];
+	for (int i = 0; i < pdb->getAtomCount(); i++) {
+		const MDTRA_PDB_Atom *pAt = pdb->fetchAtomByIndex( i );
+		if (!(pAt->atomFlags & PDB_FLAG_PROTEIN))
+			continue;
+		s_proteinIndices << i;
+		if (!strcmp( pAt->trimmed_title, "CA" ))
+			s_caIndices << i;
+	}
+
+	for (int i = 0; i < pdb->getAtomCount(); i++) {
+		const MDTRA_PDB_Atom *pDonor = pdb->fetchAtomByIndex( i );
+		if (!(pDonor->atomFlags & PDB_FLAG_PROTEIN) || strcmp( pDonor->trimmed_title, "N" ))
+			continue;
+		for (int j = 0; j < pdb->getAtomCount(); j++) {
+			const MDTRA_PDB_Atom *pAcceptor = pdb->fetchAtomByIndex( j );
+			if (pAcceptor->trimmed_title[0] != 'O' || pAcceptor->residueserial == pDonor->residueserial)
+				continue;
+			float d[3] = { pAcceptor->xyz[0] - pDonor->xyz[0], pAcceptor->xyz[1] - pDonor->xyz[1], pAcceptor->xyz[2] - pDonor->xyz[2] };
+			if (d[0]*d[0] + d[1]*d[1] + d[2]*d[2] > BENCH_HB_PAIR_DIST*BENCH_HB_PAIR_DIST)
+				continue;
+			s_hbDonors << i;
+			s_hbAcceptors << j;
+		}
+	}
+
+	for (int f = 0; f < s_config.numFrames; f++) {
+		s_ppFrames[f]->set_flag( s_proteinIndices.count(), s_proteinIndices.constData(), PDB_FLAG_SAS );
+		s_ppFrames[f]->set_flag( s_caIndices.count(), s_caIndices.constData(), PDB_FLAG_PCA );
+
+		s_ppCompactFrames[f]->load( 0, PDB_GENERIC_FORMAT, s_frameFiles.at(f).constData(), 0 );
+		s_ppCompactFrames[f]->set_rmsd_flag( s_caIndices.count(), s_caIndices.constData() );
+		s_ppCompactFrames[f]->move_to_centroid();
+	}
+}
+
+static bool Bench_WriteJSON( FILE *fp )
+{
+	fprintf( fp, "{\n" );
+	fprintf( fp, "  \"suite\": \"mdtra_bench\",\n" );
+	fprintf( fp, "  \"version\": \"%s\",\n", APPLICATION_VERSION );
+	fprintf( fp, "  \"config\": {\n" );
+	fprintf( fp, "    \"residues\": %d,\n", s_config.numResidues );
+	fprintf( fp, "    \"waters\": %d,\n", s_config.numWaters );
+	fprintf( fp, "    \"atoms\": %d,\n", s_config.numAtoms );
+	fprintf( fp, "    \"frames\": %d,\n", s_config.numFrames );
+	fprintf( fp, "    \"passes\": %d,\n", s_config.numPasses );
+	fprintf( fp, "    \"threads\": %d,\n", CountThreads() );
+	fprintf( fp, "    \"sse\": %s,\n", g_bAllowSSE ? "true" : "false" );
+	fprintf( fp, "    \"avx2\": %s,\n", (g_bAllowSSE && g_bSupportsAVX2) ? "true" : "false" );
+	fprintf( fp, "    \"hb_pairs\": %d\n", s_hbDonors.count() );
+	fprintf( fp, "  },\n" );
+	fprintf( fp, "  \"results\": [\n" );
+	for (int i = 0; i < s_results.count(); i++) {
+		const Bench_Result *pResult = &s_results.at(i);
+		fprintf( fp, "    { \"name\": \"%s\", \"unit\": \"%s\", \"items\": %d, \"best_ms\": %.4f, \"mean_ms\": %.4f, \"per_item_us\": %.4f, \"checksum\": %.9g }%s\n",
+				 pResult->name, pResult->unit, pResult->items,
+				 pResult->timing.best * 1e3, Bench_TimingMean( &pResult->timing ) * 1e3,
+				 pResult->timing.best * 1e6 / MDTRA_MAX( 1, pResult->items ), pResult->checksum,
+				 (i + 1 < s_results.count()) ? "," : "" );
+	}
+	fprintf( fp, "  ]\n" );
+	fprintf( fp, "}\n" );
+	return !ferror( fp );
+}
+
+static bool Bench_ParseArgs( int argc, char *argv[] )
+{
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+
+		if (!_stricmp( arg, "-residues" ) && hasValue) s_config.numResidues = atoi( argv[++i] );
+		else if (!_stricmp( arg, "-waters" ) && hasValue) s_config.numWaters = atoi( argv[++i] );
+		else if (!_stricmp( arg, "-frames" ) && hasValue) s_config.numFrames = atoi( argv[++i] );
+		else if (!_stricmp( arg, "-passes" ) && hasValue) s_config.numPasses = atoi( argv[++i] );
+		else if (!_stricmp( arg, "-threads" ) && hasValue) s_config.numThreads = atoi( argv[++i] );
+		else if (!_stricmp( arg, "-dir" ) && hasValue) s_config.dataDir = QString::fromLocal8Bit( argv[++i] );
+		else if (!_stricmp( arg, "-out" ) && hasValue) s_config.outFile = QString::fromLocal8Bit( argv[++i] );
+		else if (!_stricmp( arg, "-nosse" )) s_config.allowSSE = false;
+		else if (!_stricmp( arg, "-keep" )) s_config.keepFiles = true;
+		else {
+			fprintf( stderr, "Usage: mdtra_bench [-residues N] [-waters N] [-frames N] [-passes N]\n"
+							 "                   [-threads N] [-nosse] [-dir path] [-out file.json] [-keep]\n" );
+			return false;
+		}
+	}
+
+	s_config.numResidues = MDTRA_MAX( 2, s_config.numResidues );
+	s_config.numWaters = MDTRA_MAX( 0, s_config.numWaters );
+	s_config.numFrames = MDTRA_MAX( 2, s_config.numFrames );
+	s_config.numPasses = MDTRA_MAX( 1, s_config.numPasses );
+	s_config.numThreads = MDTRA_MAX( 1, s_config.numThreads );
+
+	if (s_config.numResidues * 5 + s_config.numWaters * 3 > BENCH_MAX_ATOMS) {
+		fprintf( stderr, "Too many atoms, at most %d are supported\n", BENCH_MAX_ATOMS );
+		return false;
+	}
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	s_config.numResidues = BENCH_DEFAULT_RESIDUES;
+	s_config.numWaters = BENCH_DEFAULT_WATERS;
+	s_config.numFrames = BENCH_DEFAULT_FRAMES;
+	s_config.numPasses = BENCH_DEFAULT_PASSES;
+	s_config.numThreads = 1;
+	s_config.allowSSE = true;
+	s_config.keepFiles = false;
+	s_config.dataDir = "mdtra_bench_data";
+
+	CheckCPU();
+	g_pApp = new QApplication( argc, argv, false );
+	BatchSetHeadless( true );
+
+	if (!Bench_ParseArgs( argc, argv ))
+		return 1;
+
+#if defined(MDTRA_ALLOW_SSE)
+	g_bAllowSSE = g_bSupportsSSE && s_config.allowSSE;
+#endif
+	ThreadSetDefault( s_config.numThreads, 1 );
+	g_PDBFormatManager.loadFormats();
+	MDTRA_ScanAndLoadConfigs();
+	HBInitConfigData();
+	MDTRA_InitSAS();
+
+	if (!Bench_GenerateTrajectory())
+		return 1;
+
+	fprintf( stderr, "atoms: %d (%d residues, %d waters), frames: %d, passes: %d (best time reported), threads: %d, sse: %s, avx2: %s\n",
+			 s_config.numAtoms, s_config.numResidues, s_config.numWaters, s_config.numFrames, s_config.numPasses,
+			 CountThreads(), g_bAllowSSE ? "on" : "off", (g_bAllowSSE && g_bSupportsAVX2) ? "on" : "off" );
+
+	s_ppFrames = new MDTRA_PDB_File*[s_config.numFrames];
+	s_ppCompactFrames = new MDTRA_Compact_PDB_File*[s_config.numFrames];
+	for (int f = 0; f < s_config.numFrames; f++) {
+		s_ppFrames[f] = new MDTRA_PDB_File;
+		s_ppCompactFrames[f] = new MDTRA_Compact_PDB_File;
+	}
+
+	int numFrames = s_config.numFrames;
+	Bench_Measure( "load", "frame", numFrames, Bench_Load );
+	Bench_Prepare();
+	Bench_Measure( "move_to_centroid", "frame", numFrames, Bench_MoveToCentroid );
+	Bench_Measure( "align_kabsch", "frame", numFrames - 1, Bench_AlignKabsch );
+	Bench_Measure( "get_rmsd", "frame", numFrames - 1, Bench_RMSD );
+	Bench_Measure( "sas", "frame", numFrames, Bench_SAS );
+	Bench_Measure( "hbonds", "pair", numFrames * s_hbDonors.count(), Bench_HBonds );
+	Bench_Measure( "distance_cells", "frame", numFrames, Bench_DistanceCells );
+	Bench_Measure( "pca_covariance", "frame", numFrames, Bench_PCACovariance );
+	Bench_Measure( "rmsd_2d", "pair", numFrames * (numFrames - 1) / 2, Bench_RMSDMatrix );
+
+	bool written;
+	if (s_config.outFile.isEmpty()) {
+		written = Bench_WriteJSON( stdout );
+	} else {
+		FILE *fp = fopen( s_config.outFile.toLocal8Bit().constData(), "w" );
+		written = fp && Bench_WriteJSON( fp );
+		if (fp)
+			fclose( fp );
+	}
+
+	for (int f = 0; f < s_config.numFrames; f++) {
+		delete s_ppFrames[f];
+		delete s_ppCompactFrames[f];
+		if (!s_config.keepFiles)
+			_unlink( s_frameFiles.at(f).constData() );
+	}
+	delete [] s_ppFrames;
+	delete [] s_ppCompactFrames;
+	if (!s_config.keepFiles)
+		QDir().rmdir( s_config.dataDir );
+
+	MDTRA_ShutdownSAS();
+	HBFreeConfigData();
+	MDTRA_UnloadConfigs();
+	ThreadPoolShutdown();
+
+	if (!written) {
+		fprintf( stderr, "Cannot write the report\n" );
+		return 1;
+	}
+	return 0;
+}
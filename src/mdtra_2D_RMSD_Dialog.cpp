@@ -25,6 +25,7 @@
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb.h"
 #include "mdtra_compact_pdb.h"
@@ -32,9 +33,11 @@
 #include "mdtra_select.h"
 #include "mdtra_inputTextDialog.h"
 #include "mdtra_progressDialog.h"
+#include "mdtra_profiler.h"
 #include "mdtra_2D_RMSD_Dialog.h"
 #include "mdtra_2D_RMSD_Plot.h"
 
+#include <QtCore/QDir>
 #include <QtGui/QFileDialog>
 #include <QtGui/QImageWriter>
 #include <QtGui/QMessageBox>
@@ -95,7 +98,7 @@ MDTRA_2D_RMSD_Dialog :: MDTRA_2D_RMSD_Dialog( QWidget *parent )
 		MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStream( i );
 		if (pStream && pStream->pdb) {
 			sCombo->addItem( QIcon(":/png/16x16/stream.png"), 
-							 tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()),
+							 tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )),
 							 pStream->index );
 		}
 	}
@@ -104,6 +107,7 @@ MDTRA_2D_RMSD_Dialog :: MDTRA_2D_RMSD_Dialog( QWidget *parent )
 	m_cachedPDBStreamIndex = -1;
 	m_cachedPDBMinMax[0] = 0;
 	m_cachedPDBMinMax[1] = 0;
+	m_cachedPDBStride = 1;
 	exec_on_stream_change();
 
 	progressBar->setVisible( false );
@@ -185,9 +189,9 @@ int MDTRA_2D_RMSD_Dialog :: current_stream_index( void )
 void MDTRA_2D_RMSD_Dialog :: exec_on_stream_change( void )
 {
 	const MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStreamByIndex( current_stream_index() );
-	eIndex->setMaximum( pStream->files.count() );
+	eIndex->setMaximum( MDTRA_GetStreamFrameCount( pStream ) );
 	if (!trajectoryRange->isChecked())
-		eIndex->setValue( pStream->files.count() );
+		eIndex->setValue( MDTRA_GetStreamFrameCount( pStream ) );
 	m_cachedTitle.clear();
 }
 
@@ -346,11 +350,12 @@ static void fn_PostLoadPDBFiles( int threadnum, int num )
 	AdvanceProgressBar( num + 1 );
 }
 
-bool MDTRA_2D_RMSD_Dialog :: load_pdb_files( int trMin, int trMax, bool bSelectionChange )
+bool MDTRA_2D_RMSD_Dialog :: load_pdb_files( int trMin, int trMax, int trStride, bool bSelectionChange )
 {
 	if (m_cachedPDBStreamIndex == m_cachedStreamIndex && 
 		m_cachedPDBMinMax[0] == trMin && 
-		m_cachedPDBMinMax[1] == trMax) {
+		m_cachedPDBMinMax[1] == trMax &&
+		m_cachedPDBStride == trStride) {
 
 		if (!bSelectionChange)
 			return false;
@@ -361,7 +366,7 @@ bool MDTRA_2D_RMSD_Dialog :: load_pdb_files( int trMin, int trMax, bool bSelecti
 		s_selectionSize = m_iSelectionSize;
 		s_selectionData = m_pSelectionData;
 
-		InitProgressBar( progressBar, trMax-trMin+1, false );
+		InitProgressBar( progressBar, m_iNumPDBFiles, false );
 		RunThreadsOnIndividual( m_iNumPDBFiles, fn_PostLoadPDBFiles );
 		return true;
 	}
@@ -369,9 +374,10 @@ bool MDTRA_2D_RMSD_Dialog :: load_pdb_files( int trMin, int trMax, bool bSelecti
 	m_cachedPDBStreamIndex = m_cachedStreamIndex;
 	m_cachedPDBMinMax[0] = trMin;
 	m_cachedPDBMinMax[1] = trMax;
+	m_cachedPDBStride = trStride;
 
 	progressBarMsg->setText( tr("Loading PDB Files...") );
-	InitProgressBar( progressBar, trMax-trMin+1, true );
+	InitProgressBar( progressBar, (trMax-trMin)/trStride+1, true );
 
 	const MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStreamByIndex( current_stream_index() );
 
@@ -382,7 +388,7 @@ bool MDTRA_2D_RMSD_Dialog :: load_pdb_files( int trMin, int trMax, bool bSelecti
 	m_pPDBFiles = NULL;
 	m_pDataBuffer = NULL;
 	m_pTextureData = NULL;
-	m_iNumPDBFiles = trMax-trMin+1;
+	m_iNumPDBFiles = (trMax-trMin)/trStride+1;
 	m_iTextureSize = UTIL_BestPowerOf2( m_iNumPDBFiles, MAX_TEXTURE_SIZE );
 
 	m_pPDBFiles = new MDTRA_Compact_PDB_File*[m_iNumPDBFiles];
@@ -391,13 +397,28 @@ bool MDTRA_2D_RMSD_Dialog :: load_pdb_files( int trMin, int trMax, bool bSelecti
 	m_pDataBuffer = new float[DataCellSize(m_iNumPDBFiles)];
 	m_pTextureData = new byte[m_iTextureSize*m_iTextureSize*4];
 
+	//trajectory streams have a single topology file, coordinates are taken from the stream frames
+	MDTRA_PDB_File *pFramePDB = MDTRA_IsTrajectoryStream( pStream ) ? new MDTRA_PDB_File : NULL;
+
 	for (int i = 0; i < m_iNumPDBFiles; i++) {
+		int frame = trMin - 1 + i * trStride;
 		m_pPDBFiles[i] = new MDTRA_Compact_PDB_File();
-		m_pPDBFiles[i]->load( 0, pStream->format_identifier, pStream->files.at(trMin+i-1).toAscii(), pStream->flags );
+		if (pFramePDB) {
+			if (m_pPDBFiles[i]->load( 0, pStream->format_identifier, pStream->files.at(0).toAscii(), pStream->flags ) &&
+				(!MDTRA_LoadStreamFrame( 0, pStream, frame, pFramePDB ) || !m_pPDBFiles[i]->load_coords( pFramePDB )))
+				m_pPDBFiles[i]->reset();
+		} else {
+			m_pPDBFiles[i]->load( 0, pStream->format_identifier, pStream->files.at(frame).toAscii(), pStream->flags );
+		}
 		AdvanceProgressBar( i + 1 );
 		if (s_bCancelBuild) break;
 	}
 
+	if (pFramePDB) {
+		MDTRA_FinishStreamFrames( pStream );
+		delete pFramePDB;
+	}
+
 	if (s_bCancelBuild) {
 		m_cachedPDBMinMax[0] = -1;
 		m_cachedPDBMinMax[1] = -1;
@@ -409,7 +430,7 @@ bool MDTRA_2D_RMSD_Dialog :: load_pdb_files( int trMin, int trMax, bool bSelecti
 	pFileList = m_pPDBFiles;
 	s_selectionSize = m_iSelectionSize;
 	s_selectionData = m_pSelectionData;
-	InitProgressBar( progressBar, trMax-trMin+1, false );
+	InitProgressBar( progressBar, m_iNumPDBFiles, false );
 	RunThreadsOnIndividual( m_iNumPDBFiles, fn_PostLoadPDBFiles );
 
 	if (s_bCancelBuild) {
@@ -430,10 +451,15 @@ void MDTRA_2D_RMSD_Dialog :: profileStart( void )
 	gettimeofday(&tp, NULL);
 	m_profStart = tp.tv_sec*1000 + tp.tv_usec/1000;
 #endif
+	ProfilerStart();
+	ProfilerBegin( "2D-RMSD", MDTRA_PROF_BUILD );
 }
 
 void MDTRA_2D_RMSD_Dialog :: profileEnd( void )
 {
+	ProfilerEnd();
+	ProfilerStop();
+
 	dword totalTime;
 #if defined(WIN32)
 	totalTime = timeGetTime() - m_profStart;
@@ -442,12 +468,15 @@ void MDTRA_2D_RMSD_Dialog :: profileEnd( void )
 	gettimeofday(&tp, NULL);
 	totalTime = tp.tv_sec*1000 + tp.tv_usec/1000 - m_profStart;
 #endif
-	QMessageBox::information( this, tr("Profiler"), QString("2D-RMSD calculation time: %1 ms").arg(totalTime) );
+	QString profText = QString("2D-RMSD calculation time: %1 ms\n\n").arg(totalTime) + ProfilerSummary();
+	QString traceFile = ProfilerTraceFile();
+	if (ProfilerWriteTrace( traceFile ))
+		profText += QString("\nTrace written to %1").arg(QDir::toNativeSeparators( traceFile ));
+	QMessageBox::information( this, tr("Profiler"), profText );
 }
 
-void MDTRA_2D_RMSD_Dialog :: calc_rmsd( int trMin, int trMax )
+void MDTRA_2D_RMSD_Dialog :: calc_rmsd( int dataSize )
 {
-	int dataSize = trMax-trMin+1;
 	memset(m_pDataBuffer, 0, sizeof(float)*DataCellSize(dataSize));
 
 	progressBarMsg->setText( tr("Calculating RMSD...") );
@@ -462,6 +491,7 @@ void MDTRA_2D_RMSD_Dialog :: calc_rmsd( int trMin, int trMax )
 		for (int j = 0; j < i; j++) {
 			int dataPos = DataCellIndex( j, i );
 			float *pCell = m_pDataBuffer + dataPos;
+			MDTRA_PROF_SCOPE( "rmsd pair", MDTRA_PROF_COMPUTE );
 			m_pPDBFiles[i]->align_kabsch( m_pPDBFiles[j] );
 			*pCell = m_pPDBFiles[i]->get_rmsd( m_pPDBFiles[j] );
 			if (*pCell > m_dataMax) m_dataMax = *pCell;
@@ -471,18 +501,20 @@ void MDTRA_2D_RMSD_Dialog :: calc_rmsd( int trMin, int trMax )
 		if (s_bCancelBuild) break;
 	}
 
-	if (s_bCancelBuild)
+	if (s_bCancelBuild) {
+		ProfilerStop();
 		return;
+	}
 	
 	if (m_bProfiling)
 		profileEnd();
 }
 
-void MDTRA_2D_RMSD_Dialog :: build_texture( int trMin, int trMax )
+void MDTRA_2D_RMSD_Dialog :: build_texture( int dataSize, int trStride )
 {
 	float c_minScaleRMSD = optAutoPlotMin->isChecked() ? 1.0f : spinPlotMin->value();
 
-	int c = trMax-trMin+1;
+	int c = dataSize;
 	int ts = UTIL_BestPowerOf2( c, MAX_TEXTURE_SIZE );
 
 	const MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStreamByIndex( current_stream_index() );
@@ -565,7 +597,7 @@ void MDTRA_2D_RMSD_Dialog :: build_texture( int trMin, int trMax )
 		strPlotTitle = strPlotTitle.replace("%s", "%1").arg(pStream->name);
 
 	m_pPlot->setTitle( strPlotTitle );
-	m_pPlot->setDimension( c, pStream->xscale );
+	m_pPlot->setDimension( c, pStream->xscale * trStride );
 	m_pPlot->loadTexture( ts, ts, m_pTextureData );
 	m_pPlot->setSmoothTexture( optSmooth->isChecked() );
 
@@ -655,10 +687,12 @@ void MDTRA_2D_RMSD_Dialog :: exec_on_rebuild( void )
 
 	//Define trajectory fragment to analyze
 	int trajectoryMin = 1;
-	int trajectoryMax = pStream->files.count();
+	int trajectoryMax = MDTRA_GetStreamFrameCount( pStream );
+	int trajectoryStride = 1;
 	if (trajectoryRange->isChecked()) {
 		trajectoryMin = MDTRA_MAX( trajectoryMin, sIndex->value() );
 		trajectoryMax = MDTRA_MIN( trajectoryMax, eIndex->value() );
+		trajectoryStride = sbStride->value();
 	}
 
 	//Show progress info and hide plot
@@ -668,7 +702,7 @@ void MDTRA_2D_RMSD_Dialog :: exec_on_rebuild( void )
 	progressBar->setVisible( true );
 
 	//Load compact PDBs
-	bool bFileChange = load_pdb_files( trajectoryMin, trajectoryMax, bSelectionChange );
+	bool bFileChange = load_pdb_files( trajectoryMin, trajectoryMax, trajectoryStride, bSelectionChange );
 
 	if (s_bCancelBuild) {
 		progressBarMsg->setText( tr("Data not ready") );
@@ -694,7 +728,7 @@ void MDTRA_2D_RMSD_Dialog :: exec_on_rebuild( void )
 
 	if (bFileChange) {
 		//Calculate RMSD buffer
-		calc_rmsd( trajectoryMin, trajectoryMax );
+		calc_rmsd( m_iNumPDBFiles );
 
 		if (s_bCancelBuild) {
 			progressBarMsg->setText( tr("Data not ready") );
@@ -706,7 +740,7 @@ void MDTRA_2D_RMSD_Dialog :: exec_on_rebuild( void )
 	}
 	if (bTextureChange) {
 		//Prepare texture buffer
-		build_texture( trajectoryMin, trajectoryMax );
+		build_texture( m_iNumPDBFiles, trajectoryStride );
 
 		if (s_bCancelBuild) {
 			progressBarMsg->setText( tr("Data not ready") );
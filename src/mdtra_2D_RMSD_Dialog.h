@@ -60,9 +60,9 @@ private:
 	int current_stream_index( void );
 	void update_selection( void );
 	void display_selection( void );
-	bool load_pdb_files( int trMin, int trMax, bool bSelectionChange );
-	void calc_rmsd( int trMin, int trMax );
-	void build_texture( int trMin, int trMax );
+	bool load_pdb_files( int trMin, int trMax, int trStride, bool bSelectionChange );
+	void calc_rmsd( int dataSize );
+	void build_texture( int dataSize, int trStride );
 	void cancel_build( void );
 	void profileStart( void );
 	void profileEnd( void );
@@ -83,6 +83,7 @@ private:
 	int	 m_cachedStreamIndex;
 	int	 m_cachedPDBStreamIndex;
 	int	 m_cachedPDBMinMax[2];
+	int	 m_cachedPDBStride;
 	float* m_pDataBuffer;
 	float m_dataMax;
 	unsigned char* m_pTextureData;
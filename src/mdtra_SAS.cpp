@@ -235,7 +235,7 @@ void MDTRA_InitSAS( void )
 		// create atomic SAS geosphere
 		s_pSASDots = SAS_Geo( sasParms.geoSubdivisions, s_iSASNumDots );
 		s_iSASDotMaskSize = (s_iSASNumDots >> 5) + 1;
-		s_pSASDotMask = new dword[s_iSASDotMaskSize*2*MDTRA_MAX_THREADS];
+		s_pSASDotMask = new dword[s_iSASDotMaskSize*2*CountThreadSlots()];
 	}
 
 #if defined(MDTRA_ALLOW_CUDA)
@@ -295,14 +295,24 @@ float MDTRA_GetSASRadius( float vdwr )
 	return vdwr + sasParms.probeRadius;
 }
 
-float MDTRA_CalculateSAS( int threadnum, const MDTRA_PDB_Atom *pAtoms, int numAtoms )
+//atoms per stealable block of MDTRA_CalculateSAS
+#define MDTRA_SAS_BLOCK_ATOMS	64
+#define MDTRA_SAS_STACK_BLOCKS	1024	//block sums kept on the stack, covers structures up to 64K atoms
+
+typedef struct stMDTRA_SASRange {
+	const MDTRA_PDB_Atom*	pAtoms;
+	int						numAtoms;
+	float*					pBlockSAS;
+} MDTRA_SASRange;
+
+static float SAS_CalculateRange( int threadnum, const MDTRA_PDB_Atom *pAtoms, int numAtoms, int first, int last )
 {
 	float flSAS = 0.0f;
-	const MDTRA_PDB_Atom *pAt0 = pAtoms;
+	const MDTRA_PDB_Atom *pAt0 = pAtoms + first;
 	dword* pDotMask = s_pSASDotMask + threadnum*2*s_iSASDotMaskSize;
 	dword iDotsBuried;
 
-	for ( int i = 0; i < numAtoms; i++, pAt0++ ) {
+	for ( int i = first; i < last; i++, pAt0++ ) {
 		// check if we take this atom into account
 		if ( !(pAt0->atomFlags & PDB_FLAG_SAS))
 			continue;
@@ -374,6 +384,38 @@ float MDTRA_CalculateSAS( int threadnum, const MDTRA_PDB_Atom *pAtoms, int numAt
 	return flSAS;
 }
 
+static void SAS_CalculateBlock( int threadnum, int first, int last, void *pContext )
+{
+	MDTRA_SASRange *pRange = (MDTRA_SASRange*)pContext;
+	pRange->pBlockSAS[first / MDTRA_SAS_BLOCK_ATOMS] = SAS_CalculateRange( threadnum, pRange->pAtoms, pRange->numAtoms, first, last );
+}
+
+float MDTRA_CalculateSAS( int threadnum, const MDTRA_PDB_Atom *pAtoms, int numAtoms )
+{
+	if ( numAtoms < 2*MDTRA_SAS_BLOCK_ATOMS )
+		return SAS_CalculateRange( threadnum, pAtoms, numAtoms, 0, numAtoms );
+
+	// large structures are split into atom blocks that idle workers may steal;
+	// block sums are added in block order, so the result does not depend on scheduling
+	int numBlocks = (numAtoms + MDTRA_SAS_BLOCK_ATOMS - 1) / MDTRA_SAS_BLOCK_ATOMS;
+	float blockSAS[MDTRA_SAS_STACK_BLOCKS];
+	MDTRA_SASRange range;
+	range.pAtoms = pAtoms;
+	range.numAtoms = numAtoms;
+	range.pBlockSAS = ( numBlocks <= MDTRA_SAS_STACK_BLOCKS ) ? blockSAS : new float[numBlocks];
+	memset( range.pBlockSAS, 0, numBlocks*sizeof(float) );
+
+	RunThreadsOnRange( threadnum, numAtoms, MDTRA_SAS_BLOCK_ATOMS, SAS_CalculateBlock, &range );
+
+	float flSAS = 0.0f;
+	for ( int i = 0; i < numBlocks; i++ )
+		flSAS += range.pBlockSAS[i];
+
+	if ( range.pBlockSAS != blockSAS )
+		delete [] range.pBlockSAS;
+	return flSAS;
+}
+
 float MDTRA_CalculateOcclusion( int threadnum, const MDTRA_PDB_Atom *pAtoms, int numAtoms )
 {
 	float flOCC = 0.0f;
@@ -0,0 +1,131 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Pinning of worker threads to logical processors
+
+#include "mdtra_main.h"
+#include "mdtra_affinity.h"
+
+#if defined(WIN32)
+
+//only the processor group of the process is used
+static int AffinityGetProcessors( DWORD_PTR *pMask )
+{
+	DWORD_PTR processMask, systemMask;
+	if (!GetProcessAffinityMask( GetCurrentProcess(), &processMask, &systemMask ))
+		processMask = 1;
+
+	if (pMask)
+		*pMask = processMask;
+
+	int count = 0;
+	for (DWORD_PTR m = processMask; m; m &= (m - 1))
+		count++;
+	return count;
+}
+
+int AffinityCountProcessors( void )
+{
+	return AffinityGetProcessors( NULL );
+}
+
+bool AffinityPinCurrentThread( int threadnum )
+{
+	DWORD_PTR processMask;
+	int count = AffinityGetProcessors( &processMask );
+	if (count <= 0)
+		return false;
+
+	//pick the n-th allowed processor
+	int n = threadnum % count;
+	for (int bit = 0; bit < (int)(sizeof(DWORD_PTR) * 8); bit++) {
+		DWORD_PTR m = ((DWORD_PTR)1 << bit);
+		if (!(processMask & m))
+			continue;
+		if (n-- == 0)
+			return (SetThreadAffinityMask( GetCurrentThread(), m ) != 0);
+	}
+	return false;
+}
+
+#elif defined(LINUX)
+
+#include <sched.h>
+
+//processors the process may run on (taskset, cpusets); read once, before
+//any worker narrows its own mask
+static cpu_set_t s_processMask;
+static int s_processCount = -1;
+
+static void AffinityInit( void )
+{
+	if (s_processCount >= 0)
+		return;
+
+	CPU_ZERO( &s_processMask );
+	if (sched_getaffinity( 0, sizeof(s_processMask), &s_processMask ) != 0) {
+		s_processCount = 0;
+		return;
+	}
+	s_processCount = CPU_COUNT( &s_processMask );
+}
+
+int AffinityCountProcessors( void )
+{
+	AffinityInit();
+	return s_processCount;
+}
+
+bool AffinityPinCurrentThread( int threadnum )
+{
+	AffinityInit();
+	if (s_processCount <= 0)
+		return false;
+
+	//pick the n-th allowed processor
+	int n = threadnum % s_processCount;
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET( cpu, &s_processMask ))
+			continue;
+		if (n-- == 0) {
+			cpu_set_t mask;
+			CPU_ZERO( &mask );
+			CPU_SET( cpu, &mask );
+			return (pthread_setaffinity_np( pthread_self(), sizeof(mask), &mask ) == 0);
+		}
+	}
+	return false;
+}
+
+#else
+
+int AffinityCountProcessors( void )
+{
+	return 1;
+}
+
+bool AffinityPinCurrentThread( int threadnum )
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,223 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	AVX2/FMA kernels for centroid, Kabsch alignment and RMSD
+
+//This unit is built with AVX2 code generation (-mavx2 -mfma), so it includes
+//no headers with inline functions: the linker could keep the AVX2 copy of
+//such a function for the whole program and break it on older processors.
+#include <immintrin.h>
+#include "mdtra_avx.h"
+
+//same condition as MDTRA_ALLOW_AVX2 in mdtra_main.h
+#if !defined(_MSC_VER) || (_MSC_VER >= 1700)
+
+static inline float AVX_HorizontalSum( __m256 v )
+{
+	__m128 s = _mm_add_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+	s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+	s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 0x55 ) );
+	return _mm_cvtss_f32( s );
+}
+
+void AVX_PackedSum( const float *x, const float *y, const float *z, int count, float *pOut )
+{
+	__m256 sx = _mm256_setzero_ps();
+	__m256 sy = _mm256_setzero_ps();
+	__m256 sz = _mm256_setzero_ps();
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		sx = _mm256_add_ps( sx, _mm256_loadu_ps( x + i ) );
+		sy = _mm256_add_ps( sy, _mm256_loadu_ps( y + i ) );
+		sz = _mm256_add_ps( sz, _mm256_loadu_ps( z + i ) );
+	}
+
+	pOut[0] = AVX_HorizontalSum( sx );
+	pOut[1] = AVX_HorizontalSum( sy );
+	pOut[2] = AVX_HorizontalSum( sz );
+	_mm256_zeroupper();
+
+	for (; i < count; i++) {
+		pOut[0] += x[i];
+		pOut[1] += y[i];
+		pOut[2] += z[i];
+	}
+}
+
+void AVX_PackedTranslate( float *x, float *y, float *z, int count, const float *pOffset )
+{
+	__m256 ox = _mm256_set1_ps( pOffset[0] );
+	__m256 oy = _mm256_set1_ps( pOffset[1] );
+	__m256 oz = _mm256_set1_ps( pOffset[2] );
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps( x + i, _mm256_sub_ps( _mm256_loadu_ps( x + i ), ox ) );
+		_mm256_storeu_ps( y + i, _mm256_sub_ps( _mm256_loadu_ps( y + i ), oy ) );
+		_mm256_storeu_ps( z + i, _mm256_sub_ps( _mm256_loadu_ps( z + i ), oz ) );
+	}
+	_mm256_zeroupper();
+
+	for (; i < count; i++) {
+		x[i] -= pOffset[0];
+		y[i] -= pOffset[1];
+		z[i] -= pOffset[2];
+	}
+}
+
+//uMatrix is 3x3, row i holds the contribution of old coordinate i
+void AVX_PackedTransform( float *x, float *y, float *z, int count, const float *uMatrix )
+{
+	__m256 u00 = _mm256_set1_ps( uMatrix[0] ), u01 = _mm256_set1_ps( uMatrix[1] ), u02 = _mm256_set1_ps( uMatrix[2] );
+	__m256 u10 = _mm256_set1_ps( uMatrix[3] ), u11 = _mm256_set1_ps( uMatrix[4] ), u12 = _mm256_set1_ps( uMatrix[5] );
+	__m256 u20 = _mm256_set1_ps( uMatrix[6] ), u21 = _mm256_set1_ps( uMatrix[7] ), u22 = _mm256_set1_ps( uMatrix[8] );
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 vx = _mm256_loadu_ps( x + i );
+		__m256 vy = _mm256_loadu_ps( y + i );
+		__m256 vz = _mm256_loadu_ps( z + i );
+		_mm256_storeu_ps( x + i, _mm256_fmadd_ps( vz, u20, _mm256_fmadd_ps( vy, u10, _mm256_mul_ps( vx, u00 ) ) ) );
+		_mm256_storeu_ps( y + i, _mm256_fmadd_ps( vz, u21, _mm256_fmadd_ps( vy, u11, _mm256_mul_ps( vx, u01 ) ) ) );
+		_mm256_storeu_ps( z + i, _mm256_fmadd_ps( vz, u22, _mm256_fmadd_ps( vy, u12, _mm256_mul_ps( vx, u02 ) ) ) );
+	}
+	_mm256_zeroupper();
+
+	for (; i < count; i++) {
+		float ox = x[i], oy = y[i], oz = z[i];
+		x[i] = ox * uMatrix[0] + oy * uMatrix[3] + oz * uMatrix[6];
+		y[i] = ox * uMatrix[1] + oy * uMatrix[4] + oz * uMatrix[7];
+		z[i] = ox * uMatrix[2] + oy * uMatrix[5] + oz * uMatrix[8];
+	}
+}
+
+//rMatrix is 3x4 (row i, column j = sum of a[i]*b[j]), as align_kabsch builds it
+void AVX_PackedCovariance( const float *x1, const float *y1, const float *z1,
+						   const float *x2, const float *y2, const float *z2, int count, float *rMatrix )
+{
+	__m256 r00 = _mm256_setzero_ps(), r01 = _mm256_setzero_ps(), r02 = _mm256_setzero_ps();
+	__m256 r10 = _mm256_setzero_ps(), r11 = _mm256_setzero_ps(), r12 = _mm256_setzero_ps();
+	__m256 r20 = _mm256_setzero_ps(), r21 = _mm256_setzero_ps(), r22 = _mm256_setzero_ps();
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 bx = _mm256_loadu_ps( x2 + i );
+		__m256 by = _mm256_loadu_ps( y2 + i );
+		__m256 bz = _mm256_loadu_ps( z2 + i );
+		__m256 a = _mm256_loadu_ps( x1 + i );
+		r00 = _mm256_fmadd_ps( a, bx, r00 );
+		r01 = _mm256_fmadd_ps( a, by, r01 );
+		r02 = _mm256_fmadd_ps( a, bz, r02 );
+		a = _mm256_loadu_ps( y1 + i );
+		r10 = _mm256_fmadd_ps( a, bx, r10 );
+		r11 = _mm256_fmadd_ps( a, by, r11 );
+		r12 = _mm256_fmadd_ps( a, bz, r12 );
+		a = _mm256_loadu_ps( z1 + i );
+		r20 = _mm256_fmadd_ps( a, bx, r20 );
+		r21 = _mm256_fmadd_ps( a, by, r21 );
+		r22 = _mm256_fmadd_ps( a, bz, r22 );
+	}
+
+	rMatrix[0] = AVX_HorizontalSum( r00 );
+	rMatrix[1] = AVX_HorizontalSum( r01 );
+	rMatrix[2] = AVX_HorizontalSum( r02 );
+	rMatrix[3] = 0.0f;
+	rMatrix[4] = AVX_HorizontalSum( r10 );
+	rMatrix[5] = AVX_HorizontalSum( r11 );
+	rMatrix[6] = AVX_HorizontalSum( r12 );
+	rMatrix[7] = 0.0f;
+	rMatrix[8] = AVX_HorizontalSum( r20 );
+	rMatrix[9] = AVX_HorizontalSum( r21 );
+	rMatrix[10] = AVX_HorizontalSum( r22 );
+	rMatrix[11] = 0.0f;
+	_mm256_zeroupper();
+
+	for (; i < count; i++) {
+		rMatrix[0] += x1[i] * x2[i];
+		rMatrix[1] += x1[i] * y2[i];
+		rMatrix[2] += x1[i] * z2[i];
+		rMatrix[4] += y1[i] * x2[i];
+		rMatrix[5] += y1[i] * y2[i];
+		rMatrix[6] += y1[i] * z2[i];
+		rMatrix[8] += z1[i] * x2[i];
+		rMatrix[9] += z1[i] * y2[i];
+		rMatrix[10] += z1[i] * z2[i];
+	}
+}
+
+float AVX_PackedSquaredDeviation( const float *x1, const float *y1, const float *z1,
+								  const float *x2, const float *y2, const float *z2, int count )
+{
+	__m256 s0 = _mm256_setzero_ps();
+	__m256 s1 = _mm256_setzero_ps();
+	__m256 s2 = _mm256_setzero_ps();
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 d0 = _mm256_sub_ps( _mm256_loadu_ps( x1 + i ), _mm256_loadu_ps( x2 + i ) );
+		__m256 d1 = _mm256_sub_ps( _mm256_loadu_ps( y1 + i ), _mm256_loadu_ps( y2 + i ) );
+		__m256 d2 = _mm256_sub_ps( _mm256_loadu_ps( z1 + i ), _mm256_loadu_ps( z2 + i ) );
+		s0 = _mm256_fmadd_ps( d0, d0, s0 );
+		s1 = _mm256_fmadd_ps( d1, d1, s1 );
+		s2 = _mm256_fmadd_ps( d2, d2, s2 );
+	}
+
+	float flSum = AVX_HorizontalSum( _mm256_add_ps( _mm256_add_ps( s0, s1 ), s2 ) );
+	_mm256_zeroupper();
+
+	for (; i < count; i++) {
+		float dx = x1[i] - x2[i];
+		float dy = y1[i] - y2[i];
+		float dz = z1[i] - z2[i];
+		flSum += dx*dx + dy*dy + dz*dz;
+	}
+	return flSum;
+}
+
+//atoms are 16-byte aligned xyz[4] vectors, stride bytes apart
+void AVX_AtomsTranslate( float *pXYZ, int count, int stride, const float *pOffset )
+{
+	__m128 offset = _mm_setr_ps( pOffset[0], pOffset[1], pOffset[2], 0.0f );
+	char *p = (char*)pXYZ;
+
+	for (int i = 0; i < count; i++, p += stride)
+		_mm_store_ps( (float*)p, _mm_sub_ps( _mm_load_ps( (float*)p ), offset ) );
+}
+
+void AVX_AtomsTransform( float *pXYZ, int count, int stride, const float *uMatrix )
+{
+	__m128 r0 = _mm_setr_ps( uMatrix[0], uMatrix[1], uMatrix[2], 0.0f );
+	__m128 r1 = _mm_setr_ps( uMatrix[3], uMatrix[4], uMatrix[5], 0.0f );
+	__m128 r2 = _mm_setr_ps( uMatrix[6], uMatrix[7], uMatrix[8], 0.0f );
+	char *p = (char*)pXYZ;
+
+	for (int i = 0; i < count; i++, p += stride) {
+		__m128 v = _mm_load_ps( (float*)p );
+		__m128 n = _mm_mul_ps( _mm_permute_ps( v, 0x00 ), r0 );
+		n = _mm_fmadd_ps( _mm_permute_ps( v, 0x55 ), r1, n );
+		n = _mm_fmadd_ps( _mm_permute_ps( v, 0xAA ), r2, n );
+		_mm_store_ps( (float*)p, n );
+	}
+}
+
+#endif
@@ -0,0 +1,43 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_AVX_H
+#define MDTRA_AVX_H
+
+//AVX2/FMA geometric kernels
+//Packed kernels work on structure-of-arrays coordinates (x[], y[], z[] of
+//count atoms, see MDTRA_PackedCoords), eight atoms per instruction.
+//Atom kernels work on the xyz[4] vectors of an array of structures with a
+//byte stride between atoms, one atom per instruction.
+//Callers must check g_bSupportsAVX2 first: this is the only translation
+//unit built with AVX2 code generation.
+
+extern void  AVX_PackedSum( const float *x, const float *y, const float *z, int count, float *pOut );
+extern void  AVX_PackedTranslate( float *x, float *y, float *z, int count, const float *pOffset );
+extern void  AVX_PackedTransform( float *x, float *y, float *z, int count, const float *uMatrix );
+extern void  AVX_PackedCovariance( const float *x1, const float *y1, const float *z1,
+								   const float *x2, const float *y2, const float *z2, int count, float *rMatrix );
+extern float AVX_PackedSquaredDeviation( const float *x1, const float *y1, const float *z1,
+										 const float *x2, const float *y2, const float *z2, int count );
+
+extern void  AVX_AtomsTranslate( float *pXYZ, int count, int stride, const float *pOffset );
+extern void  AVX_AtomsTransform( float *pXYZ, int count, int stride, const float *uMatrix );
+
+#endif //MDTRA_AVX_H
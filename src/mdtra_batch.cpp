@@ -0,0 +1,291 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Headless batch mode: load a project, build it and export the results
+
+#include "mdtra_main.h"
+#include "mdtra_project.h"
+#include "mdtra_pdb_format.h"
+#include "mdtra_prefetch.h"
+#include "mdtra_frameCache.h"
+#include "mdtra_configFile.h"
+#include "mdtra_hbSearch.h"
+#include "mdtra_cpuid.h"
+#include "mdtra_cuda.h"
+#include "mdtra_SAS.h"
+#include "mdtra_profiler.h"
+#include "mdtra_batch.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSettings>
+#include <QtCore/QTextStream>
+#include <QtGui/QApplication>
+#include <QtGui/QMessageBox>
+
+typedef struct stMDTRA_BatchOptions
+{
+	QString		projectFile;
+	QString		outputDir;
+	QString		format;
+	int			first;
+	int			last;
+	int			stride;
+	int			filter;
+	bool		profile;
+} MDTRA_BatchOptions;
+
+static bool s_bHeadless = false;
+
+bool BatchIsHeadless( void )
+{
+	return s_bHeadless;
+}
+
+void BatchSetHeadless( bool headless )
+{
+	s_bHeadless = headless;
+}
+
+void BatchInformation( QWidget *parent, const QString &title, const QString &text )
+{
+	if (s_bHeadless) {
+		printf( "%s: %s\n", title.toLocal8Bit().constData(), text.toLocal8Bit().constData() );
+		fflush( stdout );
+		return;
+	}
+	QMessageBox::information( parent, title, text );
+}
+
+void BatchWarning( QWidget *parent, const QString &title, const QString &text )
+{
+	if (s_bHeadless) {
+		fprintf( stderr, "%s: %s\n", title.toLocal8Bit().constData(), text.toLocal8Bit().constData() );
+		fflush( stderr );
+		return;
+	}
+	QMessageBox::warning( parent, title, text );
+}
+
+bool BatchRequested( int argc, char *argv[] )
+{
+	for (int i = 1; i < argc; i++) {
+		if (argv[i] && !_stricmp( argv[i], "-batch" ))
+			return true;
+	}
+	return false;
+}
+
+static void BatchUsage( void )
+{
+	fprintf( stderr, "Usage: mdtra -batch <project.mdtra> [-out <dir>] [-format txt|csv]\n"
+					 "                    [-first <n>] [-last <n>] [-stride <n>] [-filter <n>] [-profile]\n"
+					 "                    [-trace <file.json>]\n" );
+}
+
+static bool BatchParseArgs( int argc, char *argv[], MDTRA_BatchOptions *pOptions )
+{
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+
+		if (!_stricmp( arg, "-batch" )) {
+			if (hasValue && argv[i+1][0] != '-')
+				pOptions->projectFile = QString::fromLocal8Bit( argv[++i] );
+		} else if (!_stricmp( arg, "-out" ) && hasValue) {
+			pOptions->outputDir = QString::fromLocal8Bit( argv[++i] );
+		} else if (!_stricmp( arg, "-format" ) && hasValue) {
+			pOptions->format = QString( argv[++i] ).toLower();
+		} else if (!_stricmp( arg, "-first" ) && hasValue) {
+			pOptions->first = MDTRA_MAX( 1, atoi( argv[++i] ) );
+		} else if (!_stricmp( arg, "-last" ) && hasValue) {
+			pOptions->last = MDTRA_MAX( 0, atoi( argv[++i] ) );
+		} else if (!_stricmp( arg, "-stride" ) && hasValue) {
+			pOptions->stride = MDTRA_MAX( 1, atoi( argv[++i] ) );
+		} else if (!_stricmp( arg, "-filter" ) && hasValue) {
+			pOptions->filter = MDTRA_MAX( 0, atoi( argv[++i] ) );
+		} else if (!_stricmp( arg, "-profile" )) {
+			pOptions->profile = true;
+		} else if (!_stricmp( arg, "-trace" ) && hasValue) {
+			pOptions->profile = true;
+			ProfilerSetTraceFile( QString::fromLocal8Bit( argv[++i] ) );
+		} else if (pOptions->projectFile.isEmpty() && arg[0] != '-') {
+			pOptions->projectFile = QString::fromLocal8Bit( arg );
+		} else {
+			fprintf( stderr, "Unknown or incomplete option: %s\n", arg );
+			return false;
+		}
+	}
+
+	if (pOptions->format != "txt" && pOptions->format != "csv") {
+		fprintf( stderr, "Unknown export format: %s\n", pOptions->format.toLocal8Bit().constData() );
+		return false;
+	}
+
+	return !pOptions->projectFile.isEmpty();
+}
+
+//same engine settings the main window applies, the command line overrides the build window
+static void BatchRestoreSettings( MDTRA_BatchOptions *pOptions )
+{
+	g_PDBFormatManager.loadFormats();
+
+	QSettings settings(g_pApp->applicationDirPath().append("/").append(CONFIG_DIRECTORY SETTINGS_FILENAME), QSettings::IniFormat);
+
+	pOptions->first = MDTRA_MAX( 1, settings.value("Preferences/BuildFirst", 1).toInt() );
+	pOptions->last = MDTRA_MAX( 0, settings.value("Preferences/BuildLast", 0).toInt() );
+	pOptions->stride = MDTRA_MAX( 1, settings.value("Preferences/BuildStride", 1).toInt() );
+	pOptions->profile = settings.value("Preferences/Profiling").toBool();
+	g_PDBFormatManager.setDefaultFormat( settings.value("Preferences/DefaultFormat").toUInt() );
+
+	float probeRadius = settings.value("Preferences/SASProbeRadius").toFloat();
+	if ( probeRadius >= 0.1f ) {
+		int subdivisions = settings.value("Preferences/SASSubdivisions").toInt();
+		bool excludeWater = settings.value("Preferences/SASExcludeWater").toBool();
+		MDTRA_SetSASParms( probeRadius, subdivisions, excludeWater );
+	}
+
+#if defined(MDTRA_ALLOW_SSE)
+	g_bAllowSSE = g_bSupportsSSE && settings.value("Preferences/AllowSSE").toBool();
+	g_bAllowCUDA = g_bSupportsCUDA && settings.value("Preferences/UseCUDA").toBool();
+#endif
+
+	ThreadSetDefault( settings.value("Preferences/ThreadCount").toInt(), settings.value("Preferences/LowPriority").toBool() ? 0 : 1 );
+	ThreadSetAffinity( settings.value("Preferences/PinThreads").toBool() );
+	PrefetchSetDefault( settings.value("Preferences/PrefetchDepth", MDTRA_DEFAULT_PREFETCH_DEPTH).toInt() );
+	FrameCacheSetDefault( settings.value("Preferences/FrameCacheSize", MDTRA_DEFAULT_FRAME_CACHE_SIZE).toInt(), settings.value("Preferences/FrameCacheQuantize").toBool() );
+	MDTRA_CUDA_InitDevice( settings.value("Preferences/CUDADevice").toInt() );
+}
+
+static bool BatchExportFile( MDTRA_Project *pProject, int resultIndex, const QString &fileName, const QString &format, int filter, bool stats )
+{
+	QFile f(fileName);
+	if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+		fprintf( stderr, "Cannot open file for writing: %s (%s)\n", fileName.toLocal8Bit().constData(), f.errorString().toLocal8Bit().constData() );
+		return false;
+	}
+
+	QTextStream stream(&f);
+	if (stats)
+		pProject->exportStats( resultIndex, format, &stream );
+	else
+		pProject->exportResult( resultIndex, format, &stream, filter );
+	stream.flush();
+	f.close();
+
+	printf( "Written %s\n", fileName.toLocal8Bit().constData() );
+	return true;
+}
+
+static int BatchRun( const MDTRA_BatchOptions *pOptions )
+{
+	MDTRA_Project project( NULL );
+	QFileInfo fi(pOptions->projectFile);
+	QFile f(pOptions->projectFile);
+
+	if (!f.open(QFile::ReadOnly)) {
+		fprintf( stderr, "Cannot open project file: %s (%s)\n", pOptions->projectFile.toLocal8Bit().constData(), f.errorString().toLocal8Bit().constData() );
+		return MDTRA_BATCH_LOAD_FAILED;
+	}
+
+	QDataStream stream(&f);
+	bool loaded = project.loadFile( fi.canonicalPath(), &stream );
+	f.close();
+	if (!loaded) {
+		fprintf( stderr, "Cannot read project file: %s\n", pOptions->projectFile.toLocal8Bit().constData() );
+		return MDTRA_BATCH_LOAD_FAILED;
+	}
+
+	printf( "Loaded %s: %d stream(s), %d data source(s), %d result(s)\n", pOptions->projectFile.toLocal8Bit().constData(),
+		project.getStreamCount(), project.getDataSourceCount(), project.getResultCount() );
+	fflush( stdout );
+
+	project.setBuildWindow( pOptions->first, pOptions->last, pOptions->stride );
+	project.setProfiling( pOptions->profile );
+
+	if (!project.build( true, NULL )) {
+		fprintf( stderr, "Nothing to build!\n" );
+		return MDTRA_BATCH_NOTHING_TO_BUILD;
+	}
+
+	int exitCode = MDTRA_BATCH_OK;
+	for (int i = 0; i < project.getResultCount(); i++) {
+		if (!project.fetchResult( i )->status) {
+			fprintf( stderr, "Result \"%s\" was not built\n", project.fetchResult( i )->name.toLocal8Bit().constData() );
+			exitCode = MDTRA_BATCH_BUILD_FAILED;
+		}
+	}
+	if (exitCode != MDTRA_BATCH_OK)
+		return exitCode;
+
+	QDir outDir(pOptions->outputDir);
+	if (!outDir.exists() && !QDir().mkpath( pOptions->outputDir )) {
+		fprintf( stderr, "Cannot create output directory: %s\n", pOptions->outputDir.toLocal8Bit().constData() );
+		return MDTRA_BATCH_EXPORT_FAILED;
+	}
+
+	for (int i = 0; i < project.getResultCount(); i++) {
+		int resultIndex = project.fetchResult( i )->index;
+		QString baseName = outDir.filePath( QString("%1_result%2").arg(fi.completeBaseName()).arg(resultIndex) );
+
+		if (!BatchExportFile( &project, resultIndex, baseName + "." + pOptions->format, pOptions->format, pOptions->filter, false ) ||
+			!BatchExportFile( &project, resultIndex, baseName + "_stats." + pOptions->format, pOptions->format, 0, true ))
+			exitCode = MDTRA_BATCH_EXPORT_FAILED;
+	}
+
+	return exitCode;
+}
+
+int BatchMain( int argc, char *argv[] )
+{
+#if defined(WIN32)
+	//the GUI subsystem has no console of its own, report to the one we were started from
+	if (AttachConsole( ATTACH_PARENT_PROCESS )) {
+		freopen( "CONOUT$", "w", stdout );
+		freopen( "CONOUT$", "w", stderr );
+	}
+#endif
+
+	BatchSetHeadless( true );
+
+	MDTRA_BatchOptions options;
+	options.outputDir = ".";
+	options.format = "txt";
+	options.filter = 0;
+	BatchRestoreSettings( &options );
+
+	if (!BatchParseArgs( argc, argv, &options )) {
+		BatchUsage();
+		return MDTRA_BATCH_USAGE;
+	}
+
+	MDTRA_ScanAndLoadConfigs();
+	HBInitConfigData();
+
+	int exitCode = BatchRun( &options );
+
+	HBFreeConfigData();
+	MDTRA_UnloadConfigs();
+	return exitCode;
+}
@@ -0,0 +1,54 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_BATCH_H
+#define MDTRA_BATCH_H
+
+//Headless batch mode
+//	mdtra -batch project.mdtra [-out dir] [-format txt|csv] [-first N] [-last N]
+//	      [-stride N] [-filter N] [-profile] [-trace file.json]
+//loads the project, rebuilds all results and writes every result and its
+//statistics to the output directory. No window or OpenGL context is created,
+//so it runs without a display. The exit code is one of MDTRA_BatchExitCode.
+//-profile prints the profiler summary, -trace also selects where the trace goes.
+
+enum MDTRA_BatchExitCode
+{
+	MDTRA_BATCH_OK = 0,
+	MDTRA_BATCH_USAGE,			//bad command line
+	MDTRA_BATCH_LOAD_FAILED,	//project file missing or unreadable
+	MDTRA_BATCH_NOTHING_TO_BUILD,
+	MDTRA_BATCH_BUILD_FAILED,	//interrupted, or a result was left unbuilt
+	MDTRA_BATCH_EXPORT_FAILED	//an output file could not be written
+};
+
+class QWidget;
+class QString;
+
+extern bool BatchRequested( int argc, char *argv[] );
+extern int  BatchMain( int argc, char *argv[] );
+extern bool BatchIsHeadless( void );
+extern void BatchSetHeadless( bool headless );
+
+//message boxes in the GUI, stdout/stderr in batch mode
+extern void BatchInformation( QWidget *parent, const QString &title, const QString &text );
+extern void BatchWarning( QWidget *parent, const QString &title, const QString &text );
+
+#endif //MDTRA_BATCH_H
@@ -25,12 +25,15 @@
 #include "mdtra_main.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb_format.h"
+#include "mdtra_pdb.h"
 #include "mdtra_compact_pdb.h"
 #include "mdtra_cpuid.h"
 #include "mdtra_math.h"
 #include "mdtra_utils.h"
+#include "mdtra_inputFile.h"
 #include "mdtra_select.h"
 #include "mdtra_sse.h"
+#include "mdtra_profiler.h"
 
 #define CPDB_FLAG_PROTEIN_BACKBONE	(1<<10)
 #define CPDB_FLAG_NUCLEIC_BACKBONE	(1<<11)
@@ -200,12 +203,12 @@ bool MDTRA_Compact_PDB_File :: read_atom( int threadnum, unsigned int format, co
 
 bool MDTRA_Compact_PDB_File :: load( int threadnum, unsigned int format, const char *filename, int streamFlags )
 {
-	FILE *fp = NULL;
+	MDTRA_InputFile file;
 	char linebuf[82];
 	int line_c = 0;
 	int residue_c = 0;
 
-	if (fopen_s( &fp, filename, "r" )) {
+	if (!file.open( threadnum, filename )) {
 		return false;
 	}
 
@@ -215,31 +218,33 @@ bool MDTRA_Compact_PDB_File :: load( int threadnum, unsigned int format, const c
 	int fIgnoreSolvent = streamFlags & STREAM_FLAG_IGNORE_SOLVENT;
 
 	//count ATOM lines
-	while ( !feof(fp) ) {
+	while ( !file.eof() ) {
 		linebuf[0] = 0;
-		if (!fgets( linebuf, 82, fp )) break;
+		if (!file.gets( linebuf, 82 )) break;
+		if (!_strnicmp( linebuf, "ENDMDL", 6 )) break;	//only the first model of multi-model files
 		if (!_strnicmp( linebuf, "ATOM  ", 6 ) || ( !fIgnoreHetatm && !_strnicmp( linebuf, "HETATM", 6 ) )) line_c++;
 	}
 
 	//allocate atoms
 	m_pAtoms = (MDTRA_Compact_PDB_Atom*)UTIL_AlignedMalloc(line_c * sizeof(MDTRA_Compact_PDB_Atom));
 	if (!m_pAtoms) {
-		fclose( fp );
+		file.close();
 		reset();
 		return false;
 	}
 	memset( m_pAtoms, 0, line_c * sizeof(MDTRA_Compact_PDB_Atom) );
 
 	//load ATOM lines
-	rewind(fp);
-	while ( !feof(fp) ) {
+	file.rewind();
+	while ( !file.eof() ) {
 		linebuf[0] = 0;
-		if (!fgets( linebuf, 82, fp )) break;
+		if (!file.gets( linebuf, 82 )) break;
+		if (!_strnicmp( linebuf, "ENDMDL", 6 )) break;	//only the first model of multi-model files
 		if (!_strnicmp( linebuf, "ATOM  ", 6 ) || 
 			( !fIgnoreHetatm && !_strnicmp( linebuf, "HETATM", 6 ) )) {
 			//parse atom
 			if (!read_atom( threadnum, format, linebuf, m_pAtoms + m_iNumAtoms, residue_c )) {
-				fclose( fp );
+				file.close();
 				reset();
 				return false;
 			}
@@ -248,13 +253,37 @@ bool MDTRA_Compact_PDB_File :: load( int threadnum, unsigned int format, const c
 			m_iNumAtoms++;
 		}
 	}
-	fclose( fp );
+	file.close();
 
 	set_flags();
 
 	return true;
 }
 
+bool MDTRA_Compact_PDB_File :: load_coords( const MDTRA_PDB_File *pSource )
+{
+	//replace coordinates of the loaded topology with the snapshot ones
+	//both atom lists are in the file order, so matching is done in a single pass
+	int j = 0;
+	int numSourceAtoms = pSource->getAtomCount();
+	MDTRA_Compact_PDB_Atom *pAtom = m_pAtoms;
+
+	for (int i = 0; i < m_iNumAtoms; i++, pAtom++) {
+		while (j < numSourceAtoms && pSource->fetchAtomByIndex( j )->serialnumber != pAtom->serialnumber)
+			j++;
+		if (j >= numSourceAtoms)
+			return false;
+		const MDTRA_PDB_Atom *pSrc = pSource->fetchAtomByIndex( j++ );
+		pAtom->original_xyz[0] = pSrc->original_xyz[0];
+		pAtom->original_xyz[1] = pSrc->original_xyz[1];
+		pAtom->original_xyz[2] = pSrc->original_xyz[2];
+		pAtom->original_xyz[3] = 0.0f;
+		memcpy( pAtom->modified_xyz, pAtom->original_xyz, sizeof(pAtom->original_xyz) );
+	}
+
+	return true;
+}
+
 const MDTRA_Compact_PDB_Atom* MDTRA_Compact_PDB_File :: fetchAtomBySerialNumber( int serialnumber ) const
 {
 	//fast case
@@ -270,6 +299,7 @@ const MDTRA_Compact_PDB_Atom* MDTRA_Compact_PDB_File :: fetchAtomBySerialNumber(
 
 void MDTRA_Compact_PDB_File :: move_to_centroid( void )
 {
+	MDTRA_PROF_SCOPE( "move to centroid", MDTRA_PROF_ALIGN );
 	XMM_FLOAT centroid_origin[4];
 	*(int*)&centroid_origin[0] = 0;
 	*(int*)&centroid_origin[1] = 0;
@@ -416,6 +446,7 @@ void MDTRA_Compact_PDB_File :: eigsrt( float *d, float *v )
 
 void MDTRA_Compact_PDB_File :: align_kabsch( const MDTRA_Compact_PDB_File *pOther )
 {
+	MDTRA_PROF_SCOPE( "align kabsch", MDTRA_PROF_ALIGN );
 	if (pOther->m_iNumAtoms != m_iNumAtoms)
 		return;
 	if (pOther == this)
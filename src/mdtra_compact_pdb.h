@@ -30,6 +30,7 @@ typedef struct stMDTRA_Compact_PDB_Atom
 } MDTRA_Compact_PDB_Atom;
 
 template<typename T> class MDTRA_SelectionSet;
+class MDTRA_PDB_File;
 
 class MDTRA_Compact_PDB_File
 {
@@ -38,6 +39,7 @@ public:
 	~MDTRA_Compact_PDB_File();
 
 	bool load( int threadnum, unsigned int format, const char *filename, int streamFlags );
+	bool load_coords( const MDTRA_PDB_File *pSource );
 	void unload( void );
 	void reset( void );
 
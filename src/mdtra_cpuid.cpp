@@ -21,6 +21,7 @@
 #include "mdtra_main.h"
 
 bool g_bSupportsSSE = false;
+bool g_bSupportsAVX2 = false;
 
 #if defined(MDTRA_ALLOW_SSE)
 bool g_bAllowSSE = false;
@@ -29,7 +30,7 @@ bool g_bAllowSSE = false;
 static bool cpuid(unsigned long function, unsigned long& out_eax, unsigned long& out_ebx, unsigned long& out_ecx, unsigned long& out_edx)
 {
 #if defined(LINUX)
-	asm("pushl %%ebx\n\t" "cpuid\n\t" "movl %%ebx,%%esi\n\t" "pop %%ebx": "=a" (out_eax), "=S" (out_ebx), "=c" (out_ecx), "=d" (out_edx) : "a" (function));
+	asm("pushl %%ebx\n\t" "cpuid\n\t" "movl %%ebx,%%esi\n\t" "pop %%ebx": "=a" (out_eax), "=S" (out_ebx), "=c" (out_ecx), "=d" (out_edx) : "a" (function), "c" (0));
 	return true;
 #elif defined(WIN32)
 	bool retval = true;
@@ -41,6 +42,7 @@ static bool cpuid(unsigned long function, unsigned long& out_eax, unsigned long&
         _asm
 		{
 			xor edx, edx
+			xor ecx, ecx
             mov eax, function
             cpuid
             mov local_eax, eax
@@ -67,13 +69,47 @@ static bool cpuid(unsigned long function, unsigned long& out_eax, unsigned long&
 #endif
 }
 
+//XCR0: which register states the OS saves on context switch
+static unsigned long xgetbv0( void )
+{
+	unsigned long local_eax;
+#if defined(LINUX)
+	asm(".byte 0x0f, 0x01, 0xd0": "=a" (local_eax) : "c" (0) : "%edx");
+#elif defined(WIN32)
+	_asm
+	{
+		xor ecx, ecx
+		_emit 0x0f
+		_emit 0x01
+		_emit 0xd0
+		mov local_eax, eax
+	}
+#endif
+	return local_eax;
+}
+
 void CheckCPU( void )
 {
 	g_bSupportsSSE = false;
+	g_bSupportsAVX2 = false;
 
     unsigned long eax,ebx,ecx,edx;
+    if( !cpuid(0,eax,ebx,ecx,edx) )
+		return;
+	unsigned long maxfunction = eax;
+
     if( !cpuid(1,eax,ebx,ecx,edx) )
 		return;
 
     g_bSupportsSSE = (( edx & 0x2000000L ) != 0);
+
+	//AVX2 needs FMA, AVX and OSXSAVE, and the OS must save XMM and YMM state
+	if ( maxfunction < 7 || ( ecx & 0x18001000L ) != 0x18001000L )
+		return;
+	if ( ( xgetbv0() & 0x6 ) != 0x6 )
+		return;
+    if( !cpuid(7,eax,ebx,ecx,edx) )
+		return;
+
+	g_bSupportsAVX2 = (( ebx & 0x20L ) != 0);
 }
\ No newline at end of file
@@ -22,6 +22,7 @@
 #define MDTRA_CPUID_H
 
 extern bool g_bSupportsSSE;
+extern bool g_bSupportsAVX2;
 extern bool g_bAllowSSE;
 
 extern void CheckCPU( void );
@@ -21,7 +21,7 @@
 #include "mdtra_main.h"
 #include "mdtra_cuda.h"
 #include "mdtra_mainWindow.h"
-#include <QtGui/QMessageBox>
+#include "mdtra_batch.h"
 
 #if defined(MDTRA_ALLOW_CUDA)
 #include <cuda.h>
@@ -64,7 +64,7 @@ void MDTRA_CUDA_InitDevice( int deviceNumber )
 void MDTRA_CUDA_ErrorMessage( const char* s, const char* f, int l )
 {
 	ThreadLock();
-	QMessageBox::warning( NULL, "CUDA Error", QString("Reason: %1\nFile: %2\nLine: %3").arg(s).arg(f).arg(l) );
+	BatchWarning( NULL, "CUDA Error", QString("Reason: %1\nFile: %2\nLine: %3").arg(s).arg(f).arg(l) );
 	ThreadUnlock();
 }
 
@@ -25,6 +25,7 @@
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb.h"
 #include "mdtra_utils.h"
@@ -129,7 +130,7 @@ MDTRA_DataSourceDialog :: MDTRA_DataSourceDialog( int index, QWidget *parent )
 		MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStream( i );
 		if (pStream && pStream->pdb) {
 			sCombo->addItem( QIcon(":/png/16x16/stream.png"), 
-							 tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()),
+							 tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )),
 							 pStream->index );
 			if (sIndex == pStream->index) sCombo->setCurrentIndex(c);
 			c++;
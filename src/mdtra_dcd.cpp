@@ -0,0 +1,205 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of MDTRA_DCD_Reader
+
+#include "mdtra_main.h"
+#include "mdtra_utils.h"
+#include "mdtra_dcd.h"
+
+#define DCD_HEADER_SIZE			84
+#define DCD_UNITCELL_SIZE		48
+#define DCD_ICNTRL_NSET			0
+#define DCD_ICNTRL_NAMNF		8
+#define DCD_ICNTRL_UNITCELL		10
+#define DCD_ICNTRL_4DIMS		11
+#define DCD_ICNTRL_CHARMM		19
+
+MDTRA_DCD_Reader :: MDTRA_DCD_Reader()
+{
+	m_iFirstFrameOffset = 0;
+	m_iFrameSize = 0;
+	m_bSwapBytes = false;
+	m_bHasUnitCell = false;
+	m_bHas4D = false;
+	m_pRawBuffer = new byte*[CountThreadSlots()];
+	memset( m_pRawBuffer, 0, sizeof(byte*) * CountThreadSlots() );
+}
+
+MDTRA_DCD_Reader :: ~MDTRA_DCD_Reader()
+{
+	for (int i = 0; i < CountThreadSlots(); i++) {
+		if (m_pRawBuffer[i]) UTIL_AlignedFree( m_pRawBuffer[i] );
+	}
+	delete [] m_pRawBuffer;
+}
+
+bool MDTRA_DCD_Reader :: readRecordMarker( FILE *fp, int *pOut )
+{
+	dword marker;
+	if (fread( &marker, sizeof(marker), 1, fp ) != 1)
+		return false;
+	if (m_bSwapBytes)
+		marker = UTIL_ByteSwap32( marker );
+	*pOut = (int)marker;
+	return true;
+}
+
+bool MDTRA_DCD_Reader :: open( const char *filename )
+{
+	FILE *fp = NULL;
+	if (fopen_s( &fp, filename, "rb" ))
+		return false;
+
+	//check header record and byte order
+	dword marker;
+	char signature[4];
+	int icntrl[20];
+	if (fread( &marker, sizeof(marker), 1, fp ) != 1) {
+		fclose( fp );
+		return false;
+	}
+	if (marker == DCD_HEADER_SIZE) {
+		m_bSwapBytes = false;
+	} else if (UTIL_ByteSwap32( marker ) == DCD_HEADER_SIZE) {
+		m_bSwapBytes = true;
+	} else {
+		fclose( fp );
+		return false;
+	}
+
+	int recordEnd;
+	if (fread( signature, sizeof(signature), 1, fp ) != 1 ||
+		fread( icntrl, sizeof(icntrl), 1, fp ) != 1 ||
+		!readRecordMarker( fp, &recordEnd ) ||
+		recordEnd != DCD_HEADER_SIZE ||
+		memcmp( signature, "CORD", 4 )) {
+		fclose( fp );
+		return false;
+	}
+
+	if (m_bSwapBytes) {
+		for (int i = 0; i < 20; i++)
+			icntrl[i] = (int)UTIL_ByteSwap32( (dword)icntrl[i] );
+	}
+
+	//fixed atoms make first frame different from the others, this is not supported
+	if (icntrl[DCD_ICNTRL_NAMNF] != 0) {
+		fclose( fp );
+		return false;
+	}
+
+	bool bCharmm = (icntrl[DCD_ICNTRL_CHARMM] != 0);
+	m_bHasUnitCell = bCharmm && (icntrl[DCD_ICNTRL_UNITCELL] != 0);
+	m_bHas4D = bCharmm && (icntrl[DCD_ICNTRL_4DIMS] != 0);
+
+	//skip title record
+	int titleSize;
+	if (!readRecordMarker( fp, &titleSize ) || titleSize < 0 ||
+		UTIL_FileSeek( fp, titleSize, SEEK_CUR ) ||
+		!readRecordMarker( fp, &recordEnd ) ||
+		recordEnd != titleSize) {
+		fclose( fp );
+		return false;
+	}
+
+	//read number of atoms
+	int natomsSize, natoms;
+	if (!readRecordMarker( fp, &natomsSize ) || natomsSize != 4 ||
+		!readRecordMarker( fp, &natoms ) || natoms <= 0 ||
+		!readRecordMarker( fp, &recordEnd ) || recordEnd != 4) {
+		fclose( fp );
+		return false;
+	}
+
+	m_iNumAtoms = natoms;
+	m_iFirstFrameOffset = UTIL_FileTell( fp );
+	m_iFrameSize = (qword)3 * (natoms * sizeof(float) + 2 * sizeof(dword));
+	if (m_bHasUnitCell)
+		m_iFrameSize += DCD_UNITCELL_SIZE + 2 * sizeof(dword);
+	if (m_bHas4D)
+		m_iFrameSize += natoms * sizeof(float) + 2 * sizeof(dword);
+
+	//frame count is taken from the file size, header value may be outdated
+	if (UTIL_FileSeek( fp, 0, SEEK_END )) {
+		fclose( fp );
+		return false;
+	}
+	qword fileSize = UTIL_FileTell( fp );
+	fclose( fp );
+
+	qword numFrames = (fileSize > m_iFirstFrameOffset) ? ((fileSize - m_iFirstFrameOffset) / m_iFrameSize) : 0;
+	if (icntrl[DCD_ICNTRL_NSET] > 0 && numFrames > (qword)icntrl[DCD_ICNTRL_NSET])
+		numFrames = icntrl[DCD_ICNTRL_NSET];
+	if (!numFrames)
+		return false;
+
+	m_iNumFrames = (int)numFrames;
+	setFileName( filename );
+	return true;
+}
+
+bool MDTRA_DCD_Reader :: readFrame( int threadnum, int frame, float *pOutXYZ )
+{
+	//this function MUST be thread-safe
+	FILE *fp = getFile( threadnum );
+	if (!fp)
+		return false;
+
+	if (!m_pRawBuffer[threadnum]) {
+		m_pRawBuffer[threadnum] = (byte*)UTIL_AlignedMalloc( (size_t)m_iFrameSize );
+		if (!m_pRawBuffer[threadnum])
+			return false;
+	}
+
+	byte *pRaw = m_pRawBuffer[threadnum];
+	if (UTIL_FileSeek( fp, m_iFirstFrameOffset + (qword)frame * m_iFrameSize, SEEK_SET ) ||
+		fread( pRaw, (size_t)m_iFrameSize, 1, fp ) != 1)
+		return false;
+
+	if (m_bHasUnitCell)
+		pRaw += DCD_UNITCELL_SIZE + 2 * sizeof(dword);
+
+	const dword recordSize = m_iNumAtoms * sizeof(float);
+	for (int axis = 0; axis < 3; axis++) {
+		dword marker = *(const dword*)pRaw;
+		if (m_bSwapBytes)
+			marker = UTIL_ByteSwap32( marker );
+		if (marker != recordSize)
+			return false;
+
+		const dword *pSrc = (const dword*)(pRaw + sizeof(dword));
+		float *pDst = pOutXYZ + axis;
+		if (m_bSwapBytes) {
+			for (int i = 0; i < m_iNumAtoms; i++, pDst += 3) {
+				dword v = UTIL_ByteSwap32( pSrc[i] );
+				memcpy( pDst, &v, sizeof(float) );
+			}
+		} else {
+			for (int i = 0; i < m_iNumAtoms; i++, pDst += 3)
+				memcpy( pDst, &pSrc[i], sizeof(float) );
+		}
+		pRaw += recordSize + 2 * sizeof(dword);
+	}
+
+	return true;
+}
@@ -0,0 +1,51 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_DCD_H
+#define MDTRA_DCD_H
+
+#include "mdtra_trajectory.h"
+
+//CHARMM/NAMD/X-PLOR binary DCD trajectory reader
+//All frames have the same size, so any frame is located by its byte offset
+class MDTRA_DCD_Reader : public MDTRA_TrajectoryReader
+{
+public:
+	MDTRA_DCD_Reader();
+	virtual ~MDTRA_DCD_Reader();
+
+	virtual bool open( const char *filename );
+
+protected:
+	virtual bool readFrame( int threadnum, int frame, float *pOutXYZ );
+
+private:
+	bool readRecordMarker( FILE *fp, int *pOut );
+
+private:
+	qword	m_iFirstFrameOffset;
+	qword	m_iFrameSize;
+	bool	m_bSwapBytes;
+	bool	m_bHasUnitCell;
+	bool	m_bHas4D;
+	byte**	m_pRawBuffer;
+};
+
+#endif //MDTRA_DCD_H
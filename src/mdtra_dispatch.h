@@ -0,0 +1,92 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_DISPATCH_H
+#define MDTRA_DISPATCH_H
+
+//Lock-free work dispatcher used by RunThreadsOn
+//Threads claim chunks of consecutive work indices with a compare-and-swap on a
+//shared counter. Chunks shrink with the remaining work (guided scheduling), so
+//tiny work items do not pay for a lock per item and the tail is still balanced.
+
+#define MDTRA_DISPATCH_CHUNK_FACTOR		4		//chunks per thread over the remaining work
+#define MDTRA_DISPATCH_MAX_CHUNK		64
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_InterlockedCompareExchange)
+#endif
+
+typedef struct stMDTRA_WorkDispatch
+{
+	volatile long	next;
+	long			count;
+	long			numThreads;
+	long			maxChunk;
+	volatile long	interrupt;
+} MDTRA_WorkDispatch;
+
+inline bool DispatchCompareExchange( volatile long *pDest, long oldValue, long newValue )
+{
+#if defined(_MSC_VER)
+	return (_InterlockedCompareExchange( pDest, newValue, oldValue ) == oldValue);
+#else
+	return __sync_bool_compare_and_swap( pDest, oldValue, newValue );
+#endif
+}
+
+inline void DispatchReset( MDTRA_WorkDispatch *pDispatch, int workcount, int numthreads, int maxchunk )
+{
+	pDispatch->next = 0;
+	pDispatch->count = workcount;
+	pDispatch->numThreads = (numthreads > 0) ? numthreads : 1;
+	pDispatch->maxChunk = (maxchunk > 0) ? maxchunk : 1;
+	pDispatch->interrupt = 0;
+}
+
+inline void DispatchInterrupt( MDTRA_WorkDispatch *pDispatch )
+{
+	pDispatch->interrupt = 1;
+}
+
+//returns first index of the claimed chunk and its size, or -1 if the work is complete or interrupted
+inline int DispatchNext( MDTRA_WorkDispatch *pDispatch, int *pCount )
+{
+	while (!pDispatch->interrupt) {
+		long start = pDispatch->next;
+		long remaining = pDispatch->count - start;
+		if (remaining <= 0)
+			return -1;
+
+		long chunk = remaining / (pDispatch->numThreads * MDTRA_DISPATCH_CHUNK_FACTOR);
+		if (chunk > pDispatch->maxChunk)
+			chunk = pDispatch->maxChunk;
+		if (chunk < 1)
+			chunk = 1;
+
+		if (DispatchCompareExchange( &pDispatch->next, start, start + chunk )) {
+			*pCount = (int)chunk;
+			return (int)start;
+		}
+	}
+	return -1;
+}
+
+#endif //MDTRA_DISPATCH_H
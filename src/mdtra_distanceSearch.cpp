@@ -26,6 +26,8 @@
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
 #include "mdtra_pdb.h"
+#include "mdtra_stream.h"
+#include "mdtra_prefetch.h"
 #include "mdtra_progressDialog.h"
 #include "mdtra_distanceSearch.h"
 
@@ -119,19 +121,41 @@ static inline void CalculateTableCell_DD( const MDTRA_PDB_File *pdb, int i1, int
 	}
 }
 
+void DistanceSearchCalculateCells( const MDTRA_PDB_File *pPdbFile, const MDTRA_DistanceSearchData *pData, int bufferDim, bool firstStep, float *pflCells )
+{
+	for (int i = 1; i < pData->selectionSize; i++) {
+		for (int j = 0; j < i; j++) {
+			if (pData->ignoreSameResidue) {
+				if (pPdbFile->is_selection_pair_of_same_residue( pData->selectionData[j], pData->selectionData[i] )) {
+					pflCells[(bufferDim == 1) ? TableCellIndex_SD( j, i ) : TableCellIndex_DD( j, i )] = -1.0f;
+					continue;
+				}
+			}
+			if (bufferDim == 1)
+				CalculateTableCell_SD( pPdbFile, j, pData->selectionData[j], i, pData->selectionData[i], pData->statParm, firstStep, pflCells );
+			else
+				CalculateTableCell_DD( pPdbFile, j, pData->selectionData[j], i, pData->selectionData[i], pData->statParm, firstStep, pflCells );
+		}
+	}
+}
+
 static const MDTRA_DistanceSearchData *pLocalDistanceSearchData = NULL;
 extern MDTRA_ProgressDialog *pProgressDialog;
-static bool s_threadStarted[MDTRA_MAX_THREADS];
+static bool *s_threadStarted = NULL;
 
 static void fn_DistanceSearch_SD( int threadnum, int num )
 {
 	//Load PDB file
 	MDTRA_PDB_File *pPdbFile;
-	if ( (pLocalDistanceSearchData->workStart + num) == 0) {
+	if (pLocalDistanceSearchData->pPrefetch) {
+		pLocalDistanceSearchData->pPrefetch->acquireFrame( threadnum, num, &pPdbFile );
+		if (!pPdbFile)
+			return;	//interrupted
+	} else if ( (pLocalDistanceSearchData->workStart + num) == 0) {
 		pPdbFile = pLocalDistanceSearchData->pStream->pdb;
 	} else {
 		pPdbFile = pLocalDistanceSearchData->tempPDB[threadnum];
-		pPdbFile->load( threadnum, pLocalDistanceSearchData->pStream->format_identifier, pLocalDistanceSearchData->pStream->files.at(pLocalDistanceSearchData->workStart + num).toAscii(), pLocalDistanceSearchData->pStream->flags );
+		MDTRA_LoadStreamFrame( threadnum, pLocalDistanceSearchData->pStream, pLocalDistanceSearchData->workStart + num, pPdbFile );
 	}
 
 	bool firstStep = false;
@@ -141,42 +165,29 @@ static void fn_DistanceSearch_SD( int threadnum, int num )
 	}
 
 	//Calculate all cells
-	for (int i = 1; i < pLocalDistanceSearchData->selectionSize; i++) {
-		for (int j = 0; j < i; j++) {
-			if (pLocalDistanceSearchData->ignoreSameResidue) {
-				if (pPdbFile->is_selection_pair_of_same_residue( pLocalDistanceSearchData->selectionData[j], pLocalDistanceSearchData->selectionData[i] )) {
-					pLocalDistanceSearchData->pResults[threadnum][TableCellIndex_SD( j, i )] = -1.0f;
-					continue;
-				}
-			}
-			CalculateTableCell_SD( pPdbFile, 
-								j,
-								pLocalDistanceSearchData->selectionData[j], 
-								i,
-								pLocalDistanceSearchData->selectionData[i], 
-								pLocalDistanceSearchData->statParm, 
-								firstStep,
-								pLocalDistanceSearchData->pResults[threadnum] );
-		}
-	}
+	DistanceSearchCalculateCells( pPdbFile, pLocalDistanceSearchData, 1, firstStep, pLocalDistanceSearchData->pResults[threadnum] );
 
-	if (pProgressDialog) {
-		pProgressDialog->advanceCurrentFile( num+1 );
-		if (pProgressDialog->checkInterrupt()) {
-			InterruptThreads();
-		}
-	}
+	if (pLocalDistanceSearchData->pPrefetch)
+		pLocalDistanceSearchData->pPrefetch->releaseFrame( num );
+
+	ProgressStepFile();
+	if (ProgressInterrupted())
+		InterruptThreads();
 }
 
 static void fn_DistanceSearch_DD( int threadnum, int num )
 {
 	//Load PDB file
 	MDTRA_PDB_File *pPdbFile;
-	if ( (pLocalDistanceSearchData->workStart + num) == 0) {
+	if (pLocalDistanceSearchData->pPrefetch) {
+		pLocalDistanceSearchData->pPrefetch->acquireFrame( threadnum, num, &pPdbFile );
+		if (!pPdbFile)
+			return;	//interrupted
+	} else if ( (pLocalDistanceSearchData->workStart + num) == 0) {
 		pPdbFile = pLocalDistanceSearchData->pStream->pdb;
 	} else {
 		pPdbFile = pLocalDistanceSearchData->tempPDB[threadnum];
-		pPdbFile->load( threadnum, pLocalDistanceSearchData->pStream->format_identifier, pLocalDistanceSearchData->pStream->files.at(pLocalDistanceSearchData->workStart + num).toAscii(), pLocalDistanceSearchData->pStream->flags );
+		MDTRA_LoadStreamFrame( threadnum, pLocalDistanceSearchData->pStream, pLocalDistanceSearchData->workStart + num, pPdbFile );
 	}
 
 	bool firstStep = false;
@@ -186,31 +197,14 @@ static void fn_DistanceSearch_DD( int threadnum, int num )
 	}
 
 	//Calculate all cells
-	for (int i = 1; i < pLocalDistanceSearchData->selectionSize; i++) {
-		for (int j = 0; j < i; j++) {
-			if (pLocalDistanceSearchData->ignoreSameResidue) {
-				if (pPdbFile->is_selection_pair_of_same_residue( pLocalDistanceSearchData->selectionData[j], pLocalDistanceSearchData->selectionData[i] )) {
-					pLocalDistanceSearchData->pResults[threadnum][TableCellIndex_DD( j, i )] = -1.0f;
-					continue;
-				}
-			}
-			CalculateTableCell_DD( pPdbFile, 
-								j,
-								pLocalDistanceSearchData->selectionData[j], 
-								i,
-								pLocalDistanceSearchData->selectionData[i], 
-								pLocalDistanceSearchData->statParm, 
-								firstStep,
-								pLocalDistanceSearchData->pResults[threadnum] );
-		}
-	}
+	DistanceSearchCalculateCells( pPdbFile, pLocalDistanceSearchData, 2, firstStep, pLocalDistanceSearchData->pResults[threadnum] );
 
-	if (pProgressDialog) {
-		pProgressDialog->advanceCurrentFile( num+1 );
-		if (pProgressDialog->checkInterrupt()) {
-			InterruptThreads();
-		}
-	}
+	if (pLocalDistanceSearchData->pPrefetch)
+		pLocalDistanceSearchData->pPrefetch->releaseFrame( num );
+
+	ProgressStepFile();
+	if (ProgressInterrupted())
+		InterruptThreads();
 }
 
 static void fn_DistanceSearchJoin_SD( int threadnum )
@@ -438,20 +432,27 @@ bool SetupDistanceSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_DistanceSea
 			return false;
 	}
 
+	s_threadStarted = new bool[CountThreads()];
+
 	for (int i = 0; i < 2; i++) {
+		s_ldsd[i].pResults = new float*[CountThreads()];
+		s_ldsd[i].tempPDB = new MDTRA_PDB_File*[CountThreads()];
+		memset( s_ldsd[i].pResults, 0, sizeof(float*) * CountThreads() );
+		memset( s_ldsd[i].tempPDB, 0, sizeof(MDTRA_PDB_File*) * CountThreads() );
+
 		for (int j = 0; j < CountThreads(); j++) {
 			if (s_bufferDim == 1) s_ldsd[i].pResults[j] = new float[TableCellSize_SD(s_ldsd[i].selectionSize)];
 			else s_ldsd[i].pResults[j] = new float[TableCellSize_DD(s_ldsd[i].selectionSize)];
 			if (!s_ldsd[i].pResults[j])
 				return false;
 
-			if (s_bufferDim == 1) memset( s_ldsd[i].pResults[j], 0, sizeof(float)*TableCellSize_SD(s_ldsd[i].selectionSize) );
-			else memset( s_ldsd[i].pResults[j], 0, sizeof(float)*TableCellSize_DD(s_ldsd[i].selectionSize) );
-
 			s_ldsd[i].tempPDB[j] = new MDTRA_PDB_File;
 			if (!s_ldsd[i].tempPDB[j])
 				return false;
 		}
+		if (s_bufferDim == 1) ThreadFirstTouch( (void**)s_ldsd[i].pResults, sizeof(float)*TableCellSize_SD(s_ldsd[i].selectionSize) );
+		else ThreadFirstTouch( (void**)s_ldsd[i].pResults, sizeof(float)*TableCellSize_DD(s_ldsd[i].selectionSize) );
+		s_ldsd[i].pPrefetch = MDTRA_CreateFramePrefetcher( s_ldsd[i].pStream, NULL, s_ldsd[i].workStart );
 	}
 
 	return true;
@@ -475,11 +476,11 @@ bool PerformDistanceSearch( void )
 		memset( s_threadStarted, 0, sizeof(bool) * CountThreads() );
 
 		if (s_bufferDim == 1) {
-			RunThreadsOnIndividual( pLocalDistanceSearchData->workCount, fn_DistanceSearch_SD );
+			RunThreadsOnPrefetched( pLocalDistanceSearchData->workCount, fn_DistanceSearch_SD, pLocalDistanceSearchData->pPrefetch );
 			for (int j = 1; j < CountThreads(); j++) fn_DistanceSearchJoin_SD( j );
 			fn_DistanceSearchFinalize_SD();
 		} else {
-			RunThreadsOnIndividual( pLocalDistanceSearchData->workCount, fn_DistanceSearch_DD );
+			RunThreadsOnPrefetched( pLocalDistanceSearchData->workCount, fn_DistanceSearch_DD, pLocalDistanceSearchData->pPrefetch );
 			for (int j = 1; j < CountThreads(); j++) fn_DistanceSearchJoin_DD( j );
 			fn_DistanceSearchFinalize_DD();
 		}
@@ -511,18 +512,29 @@ bool PerformDistanceSearch( void )
 void FreeDistanceSearch( void )
 {
 	for (int i = 0; i < 2; i++) {
-		for (int j = 0; j < CountThreads(); j++) {
-			if (s_ldsd[i].pResults[j]) {
+		if (s_ldsd[i].pResults) {
+			for (int j = 0; j < CountThreads(); j++)
 				delete [] s_ldsd[i].pResults[j];
-				s_ldsd[i].pResults[j] = NULL;
-			}
-			if (s_ldsd[i].tempPDB[j]) {
+			delete [] s_ldsd[i].pResults;
+			s_ldsd[i].pResults = NULL;
+		}
+		if (s_ldsd[i].tempPDB) {
+			for (int j = 0; j < CountThreads(); j++)
 				delete s_ldsd[i].tempPDB[j];
-				s_ldsd[i].tempPDB[j] = NULL;
-			}
+			delete [] s_ldsd[i].tempPDB;
+			s_ldsd[i].tempPDB = NULL;
+		}
+		if (s_ldsd[i].pPrefetch) {
+			delete s_ldsd[i].pPrefetch;
+			s_ldsd[i].pPrefetch = NULL;
 		}
 	}
 
+	if (s_threadStarted) {
+		delete [] s_threadStarted;
+		s_threadStarted = NULL;
+	}
+
 	s_pMainWindow = NULL;
 	s_SignificantPairs.clear();
 }
\ No newline at end of file
@@ -47,9 +47,10 @@ typedef struct stMDTRA_DistanceSearchData
 	bool					ignoreSameResidue;
 	int						selectionSize;
 	const int*				selectionData;
-	MDTRA_PDB_File*			tempPDB[MDTRA_MAX_THREADS];
+	MDTRA_PDB_File**		tempPDB;
+	MDTRA_FramePrefetcher*	pPrefetch;
 	MDTRA_StatParm			statParm;
-	float*					pResults[MDTRA_MAX_THREADS];
+	float**					pResults;
 } MDTRA_DistanceSearchData;
 
 typedef struct stMDTRA_DistanceSearchPair
@@ -67,4 +68,7 @@ extern bool SetupDistanceSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_Dist
 extern bool PerformDistanceSearch( void );
 extern void FreeDistanceSearch( void );
 
+//accumulates one snapshot into a cell table (bufferDim floats per atom pair)
+extern void DistanceSearchCalculateCells( const MDTRA_PDB_File *pPdbFile, const MDTRA_DistanceSearchData *pData, int bufferDim, bool firstStep, float *pflCells );
+
 #endif //MDTRA_DISTANCESEARCH_H
\ No newline at end of file
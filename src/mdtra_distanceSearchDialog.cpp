@@ -25,6 +25,7 @@
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb.h"
 #include "mdtra_utils.h"
@@ -87,10 +88,10 @@ MDTRA_DistanceSearchDialog :: MDTRA_DistanceSearchDialog( QWidget *parent )
 		MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStream( i );
 		if (pStream && pStream->pdb) {
 			sCombo->addItem( QIcon(":/png/16x16/stream.png"), 
-							 tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()),
+							 tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )),
 							 pStream->index );
 			sCombo2->addItem( QIcon(":/png/16x16/stream.png"), 
-							 tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()),
+							 tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )),
 							 pStream->index );
 		}
 	}
@@ -155,7 +156,7 @@ void MDTRA_DistanceSearchDialog :: exec_on_stream_change( void )
 	const MDTRA_Stream *pStream1 = m_pMainWindow->getProject()->fetchStreamByIndex( streamIndex1 );
 	const MDTRA_Stream *pStream2 = m_pMainWindow->getProject()->fetchStreamByIndex( streamIndex2 );
 
-	eIndex->setMaximum( MDTRA_MIN( pStream1->files.count(), pStream2->files.count() ) );
+	eIndex->setMaximum( MDTRA_MIN( MDTRA_GetStreamFrameCount( pStream1 ), MDTRA_GetStreamFrameCount( pStream2 ) ) );
 }
 
 void MDTRA_DistanceSearchDialog :: exec_on_selection_editingFinished( void )
@@ -458,7 +459,7 @@ void MDTRA_DistanceSearchDialog :: exec_on_accept( void )
 
 	//Define trajectory fragment to analyze
 	pDsInfo->trajectoryMin = 1;
-	pDsInfo->trajectoryMax = MDTRA_MIN(pStream1->files.count(), pStream2->files.count());
+	pDsInfo->trajectoryMax = MDTRA_MIN(MDTRA_GetStreamFrameCount( pStream1 ), MDTRA_GetStreamFrameCount( pStream2 ));
 	if (trajectoryRange->isChecked()) {
 		pDsInfo->trajectoryMin = MDTRA_MAX( pDsInfo->trajectoryMin, sIndex->value() );
 		pDsInfo->trajectoryMax = MDTRA_MIN( pDsInfo->trajectoryMax, eIndex->value() );
@@ -26,6 +26,8 @@
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
 #include "mdtra_pdb.h"
+#include "mdtra_stream.h"
+#include "mdtra_prefetch.h"
 #include "mdtra_progressDialog.h"
 #include "mdtra_forceSearch.h"
 #include "mdtra_math.h"
@@ -169,7 +171,7 @@ static inline void CalculateTableCell_DD( const MDTRA_PDB_File *pdb1, const MDTR
 
 static const MDTRA_ForceSearchData *pLocalForceSearchData = NULL;
 extern MDTRA_ProgressDialog *pProgressDialog;
-static bool s_threadStarted[MDTRA_MAX_THREADS];
+static bool *s_threadStarted = NULL;
 
 static void fn_ForceSearch_SD( int threadnum, int num )
 {
@@ -177,14 +179,18 @@ static void fn_ForceSearch_SD( int threadnum, int num )
 	MDTRA_PDB_File *pPdbFile1;
 	MDTRA_PDB_File *pPdbFile2;
 
-	if ( (pLocalForceSearchData->workStart + num) == 0) {
+	if (pLocalForceSearchData->pPrefetch) {
+		pLocalForceSearchData->pPrefetch->acquireFrame( threadnum, num, &pPdbFile1, &pPdbFile2 );
+		if (!pPdbFile1)
+			return;	//interrupted
+	} else if ( (pLocalForceSearchData->workStart + num) == 0) {
 		pPdbFile1 = pLocalForceSearchData->pStream1->pdb;
 		pPdbFile2 = pLocalForceSearchData->pStream2->pdb;
 	} else {
 		pPdbFile1 = pLocalForceSearchData->tempPDB[0][threadnum];
-		pPdbFile1->load( threadnum, pLocalForceSearchData->pStream1->format_identifier, pLocalForceSearchData->pStream1->files.at(pLocalForceSearchData->workStart + num).toAscii(), pLocalForceSearchData->pStream1->flags );
+		MDTRA_LoadStreamFrame( threadnum, pLocalForceSearchData->pStream1, pLocalForceSearchData->workStart + num, pPdbFile1 );
 		pPdbFile2 = pLocalForceSearchData->tempPDB[1][threadnum];
-		pPdbFile2->load( threadnum, pLocalForceSearchData->pStream2->format_identifier, pLocalForceSearchData->pStream2->files.at(pLocalForceSearchData->workStart + num).toAscii(), pLocalForceSearchData->pStream2->flags );
+		MDTRA_LoadStreamFrame( threadnum, pLocalForceSearchData->pStream2, pLocalForceSearchData->workStart + num, pPdbFile2 );
 	}
 
 	bool firstStep = false;
@@ -203,12 +209,12 @@ static void fn_ForceSearch_SD( int threadnum, int num )
 								pLocalForceSearchData->pResults[threadnum] );
 	}
 
-	if (pProgressDialog) {
-		pProgressDialog->advanceCurrentFile( num+1 );
-		if (pProgressDialog->checkInterrupt()) {
-			InterruptThreads();
-		}
-	}
+	if (pLocalForceSearchData->pPrefetch)
+		pLocalForceSearchData->pPrefetch->releaseFrame( num );
+
+	ProgressStepFile();
+	if (ProgressInterrupted())
+		InterruptThreads();
 }
 
 static void fn_ForceSearch_DD( int threadnum, int num )
@@ -217,14 +223,18 @@ static void fn_ForceSearch_DD( int threadnum, int num )
 	MDTRA_PDB_File *pPdbFile1;
 	MDTRA_PDB_File *pPdbFile2;
 
-	if ( (pLocalForceSearchData->workStart + num) == 0) {
+	if (pLocalForceSearchData->pPrefetch) {
+		pLocalForceSearchData->pPrefetch->acquireFrame( threadnum, num, &pPdbFile1, &pPdbFile2 );
+		if (!pPdbFile1)
+			return;	//interrupted
+	} else if ( (pLocalForceSearchData->workStart + num) == 0) {
 		pPdbFile1 = pLocalForceSearchData->pStream1->pdb;
 		pPdbFile2 = pLocalForceSearchData->pStream2->pdb;
 	} else {
 		pPdbFile1 = pLocalForceSearchData->tempPDB[0][threadnum];
-		pPdbFile1->load( threadnum, pLocalForceSearchData->pStream1->format_identifier, pLocalForceSearchData->pStream1->files.at(pLocalForceSearchData->workStart + num).toAscii(), pLocalForceSearchData->pStream1->flags );
+		MDTRA_LoadStreamFrame( threadnum, pLocalForceSearchData->pStream1, pLocalForceSearchData->workStart + num, pPdbFile1 );
 		pPdbFile2 = pLocalForceSearchData->tempPDB[1][threadnum];
-		pPdbFile2->load( threadnum, pLocalForceSearchData->pStream2->format_identifier, pLocalForceSearchData->pStream2->files.at(pLocalForceSearchData->workStart + num).toAscii(), pLocalForceSearchData->pStream2->flags );
+		MDTRA_LoadStreamFrame( threadnum, pLocalForceSearchData->pStream2, pLocalForceSearchData->workStart + num, pPdbFile2 );
 	}
 
 	bool firstStep = false;
@@ -243,12 +253,12 @@ static void fn_ForceSearch_DD( int threadnum, int num )
 								pLocalForceSearchData->pResults[threadnum] );
 	}
 
-	if (pProgressDialog) {
-		pProgressDialog->advanceCurrentFile( num+1 );
-		if (pProgressDialog->checkInterrupt()) {
-			InterruptThreads();
-		}
-	}
+	if (pLocalForceSearchData->pPrefetch)
+		pLocalForceSearchData->pPrefetch->releaseFrame( num );
+
+	ProgressStepFile();
+	if (ProgressInterrupted())
+		InterruptThreads();
 }
 
 static void fn_ForceSearchJoin_SD( int threadnum )
@@ -497,6 +507,14 @@ bool SetupForceSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_ForceSearchInf
 	if (!s_lfsd.pStream2)
 		return false;
 
+	s_threadStarted = new bool[CountThreads()];
+	s_lfsd.pResults = new float*[CountThreads()];
+	s_lfsd.tempPDB[0] = new MDTRA_PDB_File*[CountThreads()];
+	s_lfsd.tempPDB[1] = new MDTRA_PDB_File*[CountThreads()];
+	memset( s_lfsd.pResults, 0, sizeof(float*) * CountThreads() );
+	memset( s_lfsd.tempPDB[0], 0, sizeof(MDTRA_PDB_File*) * CountThreads() );
+	memset( s_lfsd.tempPDB[1], 0, sizeof(MDTRA_PDB_File*) * CountThreads() );
+
 	for (int j = 0; j < CountThreads(); j++) {
 		s_lfsd.pResults[j] = new float[s_lfsd.selectionSize*s_bufferDim*2];
 		if (!s_lfsd.pResults[j])
@@ -512,6 +530,9 @@ bool SetupForceSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_ForceSearchInf
 			return false;
 	}
 
+	//both streams are read by the same prefetcher, reader threads own the I/O slots
+	s_lfsd.pPrefetch = MDTRA_CreateFramePrefetcher( s_lfsd.pStream1, s_lfsd.pStream2, s_lfsd.workStart );
+
 	return true;
 }
 
@@ -532,11 +553,11 @@ bool PerformForceSearch( void )
 	memset( s_threadStarted, 0, sizeof(bool) * CountThreads() );
 	
 	if (s_bufferDim == 1) {
-		RunThreadsOnIndividual( pLocalForceSearchData->workCount, fn_ForceSearch_SD );
+		RunThreadsOnPrefetched( pLocalForceSearchData->workCount, fn_ForceSearch_SD, pLocalForceSearchData->pPrefetch );
 		for (int j = 1; j < CountThreads(); j++) fn_ForceSearchJoin_SD( j );
 		fn_ForceSearchFinalize_SD();
 	} else {
-		RunThreadsOnIndividual( pLocalForceSearchData->workCount, fn_ForceSearch_DD );
+		RunThreadsOnPrefetched( pLocalForceSearchData->workCount, fn_ForceSearch_DD, pLocalForceSearchData->pPrefetch );
 		for (int j = 1; j < CountThreads(); j++) fn_ForceSearchJoin_DD( j );
 		fn_ForceSearchFinalize_DD();
 	}
@@ -563,20 +584,28 @@ bool PerformForceSearch( void )
 
 void FreeForceSearch( void )
 {
-	for (int j = 0; j < CountThreads(); j++) {
-		if (s_lfsd.pResults[j]) {
+	if (s_lfsd.pResults) {
+		for (int j = 0; j < CountThreads(); j++)
 			delete [] s_lfsd.pResults[j];
-			s_lfsd.pResults[j] = NULL;
-		}
-		if (s_lfsd.tempPDB[0][j]) {
-			delete s_lfsd.tempPDB[0][j];
-			s_lfsd.tempPDB[0][j] = NULL;
-		}
-		if (s_lfsd.tempPDB[1][j]) {
-			delete s_lfsd.tempPDB[1][j];
-			s_lfsd.tempPDB[1][j] = NULL;
+		delete [] s_lfsd.pResults;
+		s_lfsd.pResults = NULL;
+	}
+	for (int i = 0; i < 2; i++) {
+		if (s_lfsd.tempPDB[i]) {
+			for (int j = 0; j < CountThreads(); j++)
+				delete s_lfsd.tempPDB[i][j];
+			delete [] s_lfsd.tempPDB[i];
+			s_lfsd.tempPDB[i] = NULL;
 		}
 	}
+	if (s_lfsd.pPrefetch) {
+		delete s_lfsd.pPrefetch;
+		s_lfsd.pPrefetch = NULL;
+	}
+	if (s_threadStarted) {
+		delete [] s_threadStarted;
+		s_threadStarted = NULL;
+	}
 
 	s_pMainWindow = NULL;
 	s_SignificantAtoms.clear();
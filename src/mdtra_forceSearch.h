@@ -45,9 +45,10 @@ typedef struct stMDTRA_ForceSearchData
 	const MDTRA_Stream*		pStream2;
 	int						selectionSize;
 	const int*				selectionData[2];
-	MDTRA_PDB_File*			tempPDB[2][MDTRA_MAX_THREADS];
+	MDTRA_PDB_File**		tempPDB[2];
+	MDTRA_FramePrefetcher*	pPrefetch;
 	MDTRA_StatParm			statParm;
-	float*					pResults[MDTRA_MAX_THREADS];
+	float**					pResults;
 } MDTRA_ForceSearchData;
 
 typedef struct stMDTRA_ForceSearchAtom
@@ -25,6 +25,7 @@
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb_format.h"
 #include "mdtra_pdb.h"
@@ -91,10 +92,10 @@ MDTRA_ForceSearchDialog :: MDTRA_ForceSearchDialog( QWidget *parent )
 			&& g_PDBFormatManager.checkFormat(pStream->format_identifier,PDB_FS_FORCE_Y) 
 			&& g_PDBFormatManager.checkFormat(pStream->format_identifier,PDB_FS_FORCE_Z) ) {
 			sCombo->addItem( QIcon(":/png/16x16/stream.png"), 
-							 tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()),
+							 tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )),
 							 pStream->index );
 			sCombo2->addItem( QIcon(":/png/16x16/stream.png"), 
-							 tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()),
+							 tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )),
 							 pStream->index );
 		}
 	}
@@ -159,7 +160,7 @@ void MDTRA_ForceSearchDialog :: exec_on_stream_change( void )
 	const MDTRA_Stream *pStream1 = m_pMainWindow->getProject()->fetchStreamByIndex( streamIndex1 );
 	const MDTRA_Stream *pStream2 = m_pMainWindow->getProject()->fetchStreamByIndex( streamIndex2 );
 
-	eIndex->setMaximum( MDTRA_MIN( pStream1->files.count(), pStream2->files.count() ) );
+	eIndex->setMaximum( MDTRA_MIN( MDTRA_GetStreamFrameCount( pStream1 ), MDTRA_GetStreamFrameCount( pStream2 ) ) );
 }
 
 void MDTRA_ForceSearchDialog :: exec_on_selection_editingFinished( void )
@@ -462,7 +463,7 @@ void MDTRA_ForceSearchDialog :: exec_on_accept( void )
 
 	//Define trajectory fragment to analyze
 	pFsInfo->trajectoryMin = 1;
-	pFsInfo->trajectoryMax = MDTRA_MIN(pStream1->files.count(), pStream2->files.count());
+	pFsInfo->trajectoryMax = MDTRA_MIN(MDTRA_GetStreamFrameCount( pStream1 ), MDTRA_GetStreamFrameCount( pStream2 ));
 	if (trajectoryRange->isChecked()) {
 		pFsInfo->trajectoryMin = MDTRA_MAX( pFsInfo->trajectoryMin, sIndex->value() );
 		pFsInfo->trajectoryMax = MDTRA_MIN( pFsInfo->trajectoryMax, eIndex->value() );
@@ -0,0 +1,356 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of the shared snapshot frame cache
+
+#include <QtCore/QHash>
+#include <QtCore/QPair>
+#include "mdtra_main.h"
+#include "mdtra_project.h"
+#include "mdtra_pdb.h"
+#include "mdtra_pdb_format.h"
+#include "mdtra_utils.h"
+#include "mdtra_frameCache.h"
+
+#define FRAME_CACHE_QUANT_LEVELS	65535.0f
+
+typedef QPair<const MDTRA_Stream*, int> MDTRA_FrameCacheKey;
+
+typedef struct stMDTRA_CachedFrame
+{
+	MDTRA_FrameCacheKey			key;
+	int							numAtoms;
+	int							numPins;
+	bool						dead;		//invalidated while pinned, freed by the last unpin
+	bool						quantized;
+	bool						hasForce;
+	float						bias[3];
+	float						scale[3];
+	byte*						pData;
+	size_t						dataSize;
+	struct stMDTRA_CachedFrame*	pPrev;
+	struct stMDTRA_CachedFrame*	pNext;
+} MDTRA_CachedFrame;
+
+static QHash<MDTRA_FrameCacheKey, MDTRA_CachedFrame*> s_FrameCache;
+static MDTRA_CachedFrame *s_pFrameCacheHead = NULL;	//most recently used
+static MDTRA_CachedFrame *s_pFrameCacheTail = NULL;	//least recently used
+static size_t s_iFrameCacheSize = 0;
+static size_t s_iFrameCacheBudget = (size_t)MDTRA_DEFAULT_FRAME_CACHE_SIZE << 20;
+static int s_iFrameCacheMegabytes = MDTRA_DEFAULT_FRAME_CACHE_SIZE;
+static bool s_bFrameCacheQuantize = false;
+
+//per-thread decode buffers, threadnum is owned by a single thread at a time
+static float **FrameCacheCreateScratch( void )
+{
+	float **ppScratch = new float*[CountThreadSlots()];
+	memset( ppScratch, 0, sizeof(float*) * CountThreadSlots() );
+	return ppScratch;
+}
+
+static int *FrameCacheCreateScratchSize( void )
+{
+	int *pSize = new int[CountThreadSlots()];
+	memset( pSize, 0, sizeof(int) * CountThreadSlots() );
+	return pSize;
+}
+
+static float **s_pFrameCacheScratch = FrameCacheCreateScratch();
+static int *s_iFrameCacheScratchSize = FrameCacheCreateScratchSize();
+
+static void FrameCacheLink( MDTRA_CachedFrame *pEntry )
+{
+	pEntry->pPrev = NULL;
+	pEntry->pNext = s_pFrameCacheHead;
+	if (s_pFrameCacheHead)
+		s_pFrameCacheHead->pPrev = pEntry;
+	s_pFrameCacheHead = pEntry;
+	if (!s_pFrameCacheTail)
+		s_pFrameCacheTail = pEntry;
+}
+
+static void FrameCacheUnlink( MDTRA_CachedFrame *pEntry )
+{
+	if (pEntry->pPrev)
+		pEntry->pPrev->pNext = pEntry->pNext;
+	else
+		s_pFrameCacheHead = pEntry->pNext;
+	if (pEntry->pNext)
+		pEntry->pNext->pPrev = pEntry->pPrev;
+	else
+		s_pFrameCacheTail = pEntry->pPrev;
+	pEntry->pPrev = pEntry->pNext = NULL;
+}
+
+static void FrameCacheFree( MDTRA_CachedFrame *pEntry )
+{
+	UTIL_AlignedFree( pEntry->pData );
+	delete pEntry;
+}
+
+static void FrameCacheRemove( MDTRA_CachedFrame *pEntry )
+{
+	//called with ThreadLock held
+	FrameCacheUnlink( pEntry );
+	s_FrameCache.remove( pEntry->key );
+	s_iFrameCacheSize -= pEntry->dataSize;
+	FrameCacheFree( pEntry );
+}
+
+static void FrameCacheKill( MDTRA_CachedFrame *pEntry )
+{
+	//called with ThreadLock held; a pinned entry is still being decoded, so it
+	//only leaves the cache here and its memory goes with the last unpin
+	if (!pEntry->numPins) {
+		FrameCacheRemove( pEntry );
+		return;
+	}
+	FrameCacheUnlink( pEntry );
+	s_FrameCache.remove( pEntry->key );
+	pEntry->dead = true;
+}
+
+static void FrameCacheEvict( size_t budget )
+{
+	//called with ThreadLock held, entries being decoded are skipped
+	MDTRA_CachedFrame *pEntry = s_pFrameCacheTail;
+	while (pEntry && s_iFrameCacheSize > budget) {
+		MDTRA_CachedFrame *pPrev = pEntry->pPrev;
+		if (!pEntry->numPins)
+			FrameCacheRemove( pEntry );
+		pEntry = pPrev;
+	}
+}
+
+static float *FrameCacheScratch( int threadnum, int numFloats )
+{
+	if (s_iFrameCacheScratchSize[threadnum] < numFloats) {
+		if (s_pFrameCacheScratch[threadnum])
+			UTIL_AlignedFree( s_pFrameCacheScratch[threadnum] );
+		s_pFrameCacheScratch[threadnum] = (float*)UTIL_AlignedMalloc( numFloats * sizeof(float) );
+		s_iFrameCacheScratchSize[threadnum] = s_pFrameCacheScratch[threadnum] ? numFloats : 0;
+	}
+	return s_pFrameCacheScratch[threadnum];
+}
+
+static bool FrameCacheHasForce( const MDTRA_Stream *pStream )
+{
+	return g_PDBFormatManager.checkFormat( pStream->format_identifier, PDB_FS_FORCE_X ) &&
+		   g_PDBFormatManager.checkFormat( pStream->format_identifier, PDB_FS_FORCE_Y ) &&
+		   g_PDBFormatManager.checkFormat( pStream->format_identifier, PDB_FS_FORCE_Z );
+}
+
+void FrameCacheSetDefault( int megabytes, bool quantize )
+{
+	if (megabytes < 0)
+		megabytes = MDTRA_DEFAULT_FRAME_CACHE_SIZE;
+	else if (megabytes > MDTRA_MAX_FRAME_CACHE_SIZE)
+		megabytes = MDTRA_MAX_FRAME_CACHE_SIZE;
+
+	//entries of the other storage type are useless now
+	if (quantize != s_bFrameCacheQuantize)
+		MDTRA_ClearFrameCache();
+
+	s_iFrameCacheMegabytes = megabytes;
+	s_iFrameCacheBudget = (size_t)megabytes << 20;
+	s_bFrameCacheQuantize = quantize;
+
+	ThreadLock();
+	FrameCacheEvict( s_iFrameCacheBudget );
+	ThreadUnlock();
+}
+
+int FrameCacheBudget( void )
+{
+	return s_iFrameCacheMegabytes;
+}
+
+bool MDTRA_LookupCachedFrame( int threadnum, const MDTRA_Stream *pStream, int frame, MDTRA_PDB_File *pPdbFile )
+{
+	//this function MUST be thread-safe
+	if (!s_iFrameCacheBudget)
+		return false;
+
+	ThreadLock();
+	MDTRA_CachedFrame *pEntry = s_FrameCache.value( MDTRA_FrameCacheKey( pStream, frame ), NULL );
+	if (pEntry) {
+		//move to front and keep it alive while we decode outside the lock
+		FrameCacheUnlink( pEntry );
+		FrameCacheLink( pEntry );
+		pEntry->numPins++;
+	}
+	ThreadUnlock();
+
+	if (!pEntry)
+		return false;
+
+	int numCoords = pEntry->numAtoms * 3;
+	const float *pCoords = (const float*)pEntry->pData;
+	const float *pForces = NULL;
+
+	if (pEntry->quantized) {
+		float *pScratch = FrameCacheScratch( threadnum, numCoords );
+		if (pScratch) {
+			const word *pQuant = (const word*)pEntry->pData;
+			for (int i = 0; i < numCoords; i += 3) {
+				pScratch[i+0] = pEntry->bias[0] + (float)pQuant[i+0] * pEntry->scale[0];
+				pScratch[i+1] = pEntry->bias[1] + (float)pQuant[i+1] * pEntry->scale[1];
+				pScratch[i+2] = pEntry->bias[2] + (float)pQuant[i+2] * pEntry->scale[2];
+			}
+			if (pEntry->hasForce)
+				pForces = (const float*)(pEntry->pData + numCoords * sizeof(word));
+		}
+		pCoords = pScratch;
+	} else if (pEntry->hasForce) {
+		pForces = pCoords + numCoords;
+	}
+
+	bool bResult = pCoords && pPdbFile->load_coords( pStream->pdb, pCoords, pForces );
+
+	ThreadLock();
+	pEntry->numPins--;
+	if (pEntry->dead && !pEntry->numPins) {
+		s_iFrameCacheSize -= pEntry->dataSize;
+		FrameCacheFree( pEntry );
+	}
+	ThreadUnlock();
+
+	return bResult;
+}
+
+void MDTRA_StoreCachedFrame( int threadnum, const MDTRA_Stream *pStream, int frame, const MDTRA_PDB_File *pPdbFile )
+{
+	//this function MUST be thread-safe
+	if (!s_iFrameCacheBudget || !pStream->pdb)
+		return;
+
+	//entries are restored over the stream topology, frames with a different one are not cached
+	int numAtoms = pPdbFile->getAtomCount();
+	if (numAtoms <= 0 || numAtoms != pStream->pdb->getAtomCount())
+		return;
+
+	MDTRA_FrameCacheKey key( pStream, frame );
+	ThreadLock();
+	bool bCached = s_FrameCache.contains( key );
+	ThreadUnlock();
+	if (bCached)
+		return;
+
+	int numCoords = numAtoms * 3;
+	bool bHasForce = FrameCacheHasForce( pStream );
+	size_t forceSize = bHasForce ? numCoords * sizeof(float) : 0;
+	size_t coordSize = s_bFrameCacheQuantize ? numCoords * sizeof(word) : numCoords * sizeof(float);
+	if (coordSize + forceSize > s_iFrameCacheBudget)
+		return;
+
+	MDTRA_CachedFrame *pEntry = new MDTRA_CachedFrame;
+	pEntry->key = key;
+	pEntry->numAtoms = numAtoms;
+	pEntry->numPins = 0;
+	pEntry->dead = false;
+	pEntry->quantized = s_bFrameCacheQuantize;
+	pEntry->hasForce = bHasForce;
+	pEntry->dataSize = coordSize + forceSize;
+	pEntry->pData = (byte*)UTIL_AlignedMalloc( pEntry->dataSize );
+	pEntry->pPrev = pEntry->pNext = NULL;
+	if (!pEntry->pData) {
+		delete pEntry;
+		return;
+	}
+
+	if (!pEntry->quantized) {
+		pPdbFile->get_coords( (float*)pEntry->pData, bHasForce ? (float*)(pEntry->pData + coordSize) : NULL );
+	} else {
+		float *pScratch = FrameCacheScratch( threadnum, numCoords );
+		if (!pScratch) {
+			FrameCacheFree( pEntry );
+			return;
+		}
+		pPdbFile->get_coords( pScratch, bHasForce ? (float*)(pEntry->pData + coordSize) : NULL );
+
+		float vMin[3], vMax[3];
+		for (int j = 0; j < 3; j++)
+			vMin[j] = vMax[j] = pScratch[j];
+		for (int i = 3; i < numCoords; i += 3) {
+			for (int j = 0; j < 3; j++) {
+				if (pScratch[i+j] < vMin[j]) vMin[j] = pScratch[i+j];
+				if (pScratch[i+j] > vMax[j]) vMax[j] = pScratch[i+j];
+			}
+		}
+
+		float invScale[3];
+		for (int j = 0; j < 3; j++) {
+			pEntry->bias[j] = vMin[j];
+			pEntry->scale[j] = (vMax[j] - vMin[j]) / FRAME_CACHE_QUANT_LEVELS;
+			invScale[j] = (pEntry->scale[j] > 0.0f) ? (1.0f / pEntry->scale[j]) : 0.0f;
+		}
+
+		word *pQuant = (word*)pEntry->pData;
+		for (int i = 0; i < numCoords; i += 3) {
+			for (int j = 0; j < 3; j++) {
+				float q = (pScratch[i+j] - vMin[j]) * invScale[j] + 0.5f;
+				pQuant[i+j] = (word)MDTRA_MIN( q, FRAME_CACHE_QUANT_LEVELS );
+			}
+		}
+	}
+
+	ThreadLock();
+	if (s_FrameCache.contains( key )) {
+		//another thread got here first
+		ThreadUnlock();
+		FrameCacheFree( pEntry );
+		return;
+	}
+	s_FrameCache.insert( key, pEntry );
+	FrameCacheLink( pEntry );
+	s_iFrameCacheSize += pEntry->dataSize;
+	FrameCacheEvict( s_iFrameCacheBudget );
+	ThreadUnlock();
+}
+
+void MDTRA_InvalidateCachedFrames( const MDTRA_Stream *pStream )
+{
+	ThreadLock();
+	MDTRA_CachedFrame *pEntry = s_pFrameCacheHead;
+	while (pEntry) {
+		MDTRA_CachedFrame *pNext = pEntry->pNext;
+		if (pEntry->key.first == pStream)
+			FrameCacheKill( pEntry );
+		pEntry = pNext;
+	}
+	ThreadUnlock();
+}
+
+void MDTRA_ClearFrameCache( void )
+{
+	ThreadLock();
+	FrameCacheEvict( 0 );
+	ThreadUnlock();
+
+	for (int i = 0; i < CountThreadSlots(); i++) {
+		if (s_pFrameCacheScratch[i]) {
+			UTIL_AlignedFree( s_pFrameCacheScratch[i] );
+			s_pFrameCacheScratch[i] = NULL;
+		}
+		s_iFrameCacheScratchSize[i] = 0;
+	}
+}
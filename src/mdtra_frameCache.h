@@ -0,0 +1,42 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_FRAMECACHE_H
+#define MDTRA_FRAMECACHE_H
+
+#define MDTRA_DEFAULT_FRAME_CACHE_SIZE	256		//megabytes
+#define MDTRA_MAX_FRAME_CACHE_SIZE		65536
+
+typedef struct stMDTRA_Stream MDTRA_Stream;
+class MDTRA_PDB_File;
+
+//Process-wide LRU cache of decoded snapshot coordinates
+//Keyed by (stream, frame), shared by every consumer of MDTRA_LoadStreamFrame
+//so that back-to-back analyses of the same stream are served from RAM.
+//Quantized entries keep xyz as 16-bit fixed point relative to the frame bounds.
+extern void FrameCacheSetDefault( int megabytes, bool quantize );
+extern int  FrameCacheBudget( void );
+
+extern bool MDTRA_LookupCachedFrame( int threadnum, const MDTRA_Stream *pStream, int frame, MDTRA_PDB_File *pPdbFile );
+extern void MDTRA_StoreCachedFrame( int threadnum, const MDTRA_Stream *pStream, int frame, const MDTRA_PDB_File *pPdbFile );
+extern void MDTRA_InvalidateCachedFrames( const MDTRA_Stream *pStream );
+extern void MDTRA_ClearFrameCache( void );
+
+#endif //MDTRA_FRAMECACHE_H
@@ -27,6 +27,8 @@
 #include "mdtra_math.h"
 #include "mdtra_project.h"
 #include "mdtra_pdb.h"
+#include "mdtra_stream.h"
+#include "mdtra_sweep.h"
 #include "mdtra_utils.h"
 #include "mdtra_configFile.h"
 #include "mdtra_progressDialog.h"
@@ -68,22 +70,23 @@ static const MDTRA_HBTripletDonorInfo *HBFetchDonor( const MDTRA_PDB_File *ppdb,
 {
 	const int numDonors = s_TripletDonorInfo.count();
 	for (int i = firstDonor; i < numDonors; i++) {
-		if ( pAtom->residuenumber > 1 && (s_TripletDonorInfo[i].flags & DF_NTERM))
+		const MDTRA_HBTripletDonorInfo &donorInfo = s_TripletDonorInfo.at(i);
+		if ( pAtom->residuenumber > 1 && (donorInfo.flags & DF_NTERM))
 			continue;
-		if (_stricmp( pAtom->trimmed_title, s_TripletDonorInfo[i].XTitle ))
+		if (_stricmp( pAtom->trimmed_title, donorInfo.XTitle ))
 			continue;
-		if ( s_TripletDonorInfo[i].XResidue && _stricmp( pAtom->trimmed_residue, s_TripletDonorInfo[i].XResidue ))
+		if ( donorInfo.XResidue && _stricmp( pAtom->trimmed_residue, donorInfo.XResidue ))
 			continue;
 
 		// get a corresponding H-atom
-		const MDTRA_PDB_Atom *pAtH = ppdb->fetchAtomByDesc( pAtom->chainIndex, pAtom->residuenumber, s_TripletDonorInfo[i].HTitle );
+		const MDTRA_PDB_Atom *pAtH = ppdb->fetchAtomByDesc( pAtom->chainIndex, pAtom->residuenumber, donorInfo.HTitle );
 		if ( !pAtH )
 			continue;
 		if (pHAtom)
 			*pHAtom = pAtH;
 
 		firstDonor = i+1;
-		return &s_TripletDonorInfo[i];
+		return &s_TripletDonorInfo.at(i);
 	}
 
 	return NULL;
@@ -93,11 +96,12 @@ static const MDTRA_HBTripletAcceptorInfo *HBFetchAcceptor( const MDTRA_PDB_File
 {
 	const int numAcceptors = s_TripletAcceptorInfo.count();
 	for (int i = 0; i < numAcceptors; i++) {
-		if (_stricmp( pAtom->trimmed_title, s_TripletAcceptorInfo[i].YTitle ))
+		const MDTRA_HBTripletAcceptorInfo &acceptorInfo = s_TripletAcceptorInfo.at(i);
+		if (_stricmp( pAtom->trimmed_title, acceptorInfo.YTitle ))
 			continue;
-		if ( s_TripletAcceptorInfo[i].YResidue && _stricmp( pAtom->trimmed_residue, s_TripletAcceptorInfo[i].YResidue ))
+		if ( acceptorInfo.YResidue && _stricmp( pAtom->trimmed_residue, acceptorInfo.YResidue ))
 			continue;
-		return &s_TripletAcceptorInfo[i];
+		return &acceptorInfo;
 	}
 
 	return NULL;
@@ -428,7 +432,13 @@ float HBCalcPair( const MDTRA_PDB_File *ppdb, const MDTRA_PDB_Atom *pDonor, cons
 	return bestEnergy;
 }
 
-static bool HBGetTriplets( void )
+#define HB_TRIPLET_BLOCK_ATOMS	32
+
+typedef QVector<MDTRA_HBSearchTriplet> MDTRA_HBTripletList;
+
+//collects the triplets of X atom i; grouping only merges triplets of the same
+//X atom, so donor atoms are independent of each other
+static void HBGetAtomTriplets( int i, MDTRA_HBTripletList &triplets )
 {
 	MDTRA_HBSearchTriplet localTriplet;
 	localTriplet.flags = 0;
@@ -438,146 +448,184 @@ static bool HBGetTriplets( void )
 	float lensq;
 #endif
 
-	for ( int i = 0; i < s_lhbsd.pStream->pdb->getAtomCount(); i++ ) {
-		//get X atom pointer
-		const MDTRA_PDB_Atom *pAtX = s_lhbsd.pStream->pdb->fetchAtomByIndex( i );
-		const MDTRA_PDB_Atom *pAtH = NULL;
-
-		//update wait dialog
-		QApplication::processEvents();
-		if (pWaitDialog->checkInterrupt())
-			return false;
+	//get X atom pointer
+	const MDTRA_PDB_Atom *pAtX = s_lhbsd.pStream->pdb->fetchAtomByIndex( i );
+	const MDTRA_PDB_Atom *pAtH = NULL;
 
-		//get donor info
-		const MDTRA_HBTripletDonorInfo *pDonorInfo;
-		int firstDonor = 0;
-		int startSize = s_iHBRealSize;
-		
-		while ((pDonorInfo = HBFetchDonor( s_lhbsd.pStream->pdb, pAtX, firstDonor, &pAtH ))) {
-			//X-H pair is valid
-			localTriplet.atX = pAtX->serialnumber;
-			localTriplet.atH[0] = pAtH->serialnumber;
-			localTriplet.xff = pDonorInfo->ffCode;
-
-			for ( int j = 1; j < MAX_GROUPED_HYDROGENS; j++ )
-				localTriplet.atH[j] = -1;	//not grouped (one hydrogen per triplet)
-			for ( int j = 1; j < MAX_GROUPED_ACCEPTORS; j++ )
-				localTriplet.atY[j] = -1;	//not grouped (one acceptor per triplet)
-
-			for ( int j = 0; j < s_lhbsd.pStream->pdb->getAtomCount(); j++) {
-				//get Y atom pointer
-				if ( i == j ) continue;
-				const MDTRA_PDB_Atom *pAtY = s_lhbsd.pStream->pdb->fetchAtomByIndex( j );
-
-				//ignore the same residue
-				if ( pAtY->residueserial == pAtX->residueserial )
-					continue;
+	//get donor info
+	const MDTRA_HBTripletDonorInfo *pDonorInfo;
+	int firstDonor = 0;
+	int startSize = triplets.count();
+	
+	while ((pDonorInfo = HBFetchDonor( s_lhbsd.pStream->pdb, pAtX, firstDonor, &pAtH ))) {
+		//X-H pair is valid
+		localTriplet.atX = pAtX->serialnumber;
+		localTriplet.atH[0] = pAtH->serialnumber;
+		localTriplet.xff = pDonorInfo->ffCode;
+
+		for ( int j = 1; j < MAX_GROUPED_HYDROGENS; j++ )
+			localTriplet.atH[j] = -1;	//not grouped (one hydrogen per triplet)
+		for ( int j = 1; j < MAX_GROUPED_ACCEPTORS; j++ )
+			localTriplet.atY[j] = -1;	//not grouped (one acceptor per triplet)
+
+		for ( int j = 0; j < s_lhbsd.pStream->pdb->getAtomCount(); j++) {
+			//get Y atom pointer
+			if ( i == j ) continue;
+			const MDTRA_PDB_Atom *pAtY = s_lhbsd.pStream->pdb->fetchAtomByIndex( j );
+
+			//ignore the same residue
+			if ( pAtY->residueserial == pAtX->residueserial )
+				continue;
 
 #ifdef XY_CUTOFF
-				//cut by X-Y distance
-				//NB: distance must be large enough to ensure these atoms
-				//	  will never get close along the trajectory dynamics!
-				Vec3_Sub( vecDist, pAtX->xyz, pAtY->xyz );
-				Vec3_LenSq( lensq, vecDist );
-				if ( lensq > XY_CUTOFF_DIST_SQ )
-					continue;
+			//cut by X-Y distance
+			//NB: distance must be large enough to ensure these atoms
+			//	  will never get close along the trajectory dynamics!
+			Vec3_Sub( vecDist, pAtX->xyz, pAtY->xyz );
+			Vec3_LenSq( lensq, vecDist );
+			if ( lensq > XY_CUTOFF_DIST_SQ )
+				continue;
 #endif
 
-				//get acceptor info
-				const MDTRA_HBTripletAcceptorInfo *pAcceptorInfo = HBFetchAcceptor( s_lhbsd.pStream->pdb, pAtY );
-				if (!pAcceptorInfo)
-					continue;
+			//get acceptor info
+			const MDTRA_HBTripletAcceptorInfo *pAcceptorInfo = HBFetchAcceptor( s_lhbsd.pStream->pdb, pAtY );
+			if (!pAcceptorInfo)
+				continue;
 
-				//ignore the neighbour residue, if both residue titles are NULL
-				if ( !pDonorInfo->XResidue && !pAcceptorInfo->YResidue &&
-					((pAtY->residueserial == pAtX->residueserial - 1) || (pAtY->residueserial == pAtX->residueserial + 1)))
-					continue;
-			
-				//X-H-Y triple is valid
-				localTriplet.atY[0] = pAtY->serialnumber;
-				localTriplet.yff = pAcceptorInfo->ffCode;
-				localTriplet.groupIndex = pAcceptorInfo->groupIndex;
-			
-			/*	OutputDebugString( QString("Triplet: %1%2%3 - %4%5%6 - %7%8%9\n")
-					.arg(pAtX->trimmed_residue).arg(pAtX->residuenumber).arg(pAtX->trimmed_title)
-					.arg(pAtH->trimmed_residue).arg(pAtH->residuenumber).arg(pAtH->trimmed_title)
-					.arg(pAtY->trimmed_residue).arg(pAtY->residuenumber).arg(pAtY->trimmed_title)
-					.toAscii());*/
-
-				if ( s_lhbsd.grouping && (pDonorInfo->flags & DF_HGROUP) ) {
-					//Find existing X-Y triplet and add new H-atom
-					bool bFound = false;
-					for ( int k = startSize; k < s_iHBRealSize; k++ ) {
-						MDTRA_HBSearchTriplet *pExistingTriplet = const_cast<MDTRA_HBSearchTriplet*>(&s_HBonds.at(k));
-						if ( pExistingTriplet->atX != localTriplet.atX )
-							continue;
-						int l;
-						for ( l = 0; l < MAX_GROUPED_ACCEPTORS; l++ ) {
-							if ( pExistingTriplet->atY[l] == localTriplet.atY[0] )
-								break;
-						}
-						if ( l == MAX_GROUPED_ACCEPTORS )
-							continue;
-
-						for ( l = 0; l < MAX_GROUPED_HYDROGENS; l++ ) {
-							if ( pExistingTriplet->atH[l] == localTriplet.atH[0] ) {
-								//already exists
-								bFound = true;
-								break;
-							} else if ( pExistingTriplet->atH[l] < 0 ) {
-								pExistingTriplet->atH[l] = localTriplet.atH[0];
-								bFound = true;
-								break;
-							}
-						}
-						break;
+			//ignore the neighbour residue, if both residue titles are NULL
+			if ( !pDonorInfo->XResidue && !pAcceptorInfo->YResidue &&
+				((pAtY->residueserial == pAtX->residueserial - 1) || (pAtY->residueserial == pAtX->residueserial + 1)))
+				continue;
+		
+			//X-H-Y triple is valid
+			localTriplet.atY[0] = pAtY->serialnumber;
+			localTriplet.yff = pAcceptorInfo->ffCode;
+			localTriplet.groupIndex = pAcceptorInfo->groupIndex;
+		
+		/*	OutputDebugString( QString("Triplet: %1%2%3 - %4%5%6 - %7%8%9\n")
+				.arg(pAtX->trimmed_residue).arg(pAtX->residuenumber).arg(pAtX->trimmed_title)
+				.arg(pAtH->trimmed_residue).arg(pAtH->residuenumber).arg(pAtH->trimmed_title)
+				.arg(pAtY->trimmed_residue).arg(pAtY->residuenumber).arg(pAtY->trimmed_title)
+				.toAscii());*/
+
+			if ( s_lhbsd.grouping && (pDonorInfo->flags & DF_HGROUP) ) {
+				//Find existing X-Y triplet and add new H-atom
+				bool bFound = false;
+				for ( int k = startSize; k < triplets.count(); k++ ) {
+					MDTRA_HBSearchTriplet *pExistingTriplet = &triplets[k];
+					if ( pExistingTriplet->atX != localTriplet.atX )
+						continue;
+					int l;
+					for ( l = 0; l < MAX_GROUPED_ACCEPTORS; l++ ) {
+						if ( pExistingTriplet->atY[l] == localTriplet.atY[0] )
+							break;
 					}
-					if ( bFound )
+					if ( l == MAX_GROUPED_ACCEPTORS )
 						continue;
-				}
 
-				if ( s_lhbsd.grouping && pAcceptorInfo->groupIndex ) {
-					//Find existing X-Y triplet and add new Y-atom
-					bool bFound = false;
-					for ( int k = startSize; k < s_iHBRealSize; k++ ) {
-						MDTRA_HBSearchTriplet *pExistingTriplet = const_cast<MDTRA_HBSearchTriplet*>(&s_HBonds.at(k));
-						if ( pExistingTriplet->atX != localTriplet.atX )
-							continue;
-						if ( pExistingTriplet->groupIndex != localTriplet.groupIndex )
-							continue;
-						//Y-atom must be of the same residue
-						const MDTRA_PDB_Atom *pAtY2 = s_lhbsd.pStream->pdb->fetchAtomByIndex( pExistingTriplet->atY[0] );
-						if ( pAtY2->residueserial != pAtY->residueserial )
-							continue;
-						int l;
-						for ( l = 0; l < MAX_GROUPED_ACCEPTORS; l++ ) {
-							if ( pExistingTriplet->atY[l] == localTriplet.atY[0] ) {
-								//already exists
-								bFound = true;
-								break;
-							} else if ( pExistingTriplet->atY[l] < 0 ) {
-								pExistingTriplet->atY[l] = localTriplet.atY[0];
-								bFound = true;
-								break;
-							}
+					for ( l = 0; l < MAX_GROUPED_HYDROGENS; l++ ) {
+						if ( pExistingTriplet->atH[l] == localTriplet.atH[0] ) {
+							//already exists
+							bFound = true;
+							break;
+						} else if ( pExistingTriplet->atH[l] < 0 ) {
+							pExistingTriplet->atH[l] = localTriplet.atH[0];
+							bFound = true;
+							break;
 						}
-						break;
 					}
-					if ( bFound )
-						continue;
+					break;
 				}
+				if ( bFound )
+					continue;
+			}
 
-				if (s_iHBRealSize >= s_iHBBufferSize-1) {
-					s_HBonds << localTriplet;
-					s_iHBBufferSize++;
-				} else {
-					s_HBonds.replace( s_iHBRealSize, localTriplet );
+			if ( s_lhbsd.grouping && pAcceptorInfo->groupIndex ) {
+				//Find existing X-Y triplet and add new Y-atom
+				bool bFound = false;
+				for ( int k = startSize; k < triplets.count(); k++ ) {
+					MDTRA_HBSearchTriplet *pExistingTriplet = &triplets[k];
+					if ( pExistingTriplet->atX != localTriplet.atX )
+						continue;
+					if ( pExistingTriplet->groupIndex != localTriplet.groupIndex )
+						continue;
+					//Y-atom must be of the same residue
+					const MDTRA_PDB_Atom *pAtY2 = s_lhbsd.pStream->pdb->fetchAtomByIndex( pExistingTriplet->atY[0] );
+					if ( pAtY2->residueserial != pAtY->residueserial )
+						continue;
+					int l;
+					for ( l = 0; l < MAX_GROUPED_ACCEPTORS; l++ ) {
+						if ( pExistingTriplet->atY[l] == localTriplet.atY[0] ) {
+							//already exists
+							bFound = true;
+							break;
+						} else if ( pExistingTriplet->atY[l] < 0 ) {
+							pExistingTriplet->atY[l] = localTriplet.atY[0];
+							bFound = true;
+							break;
+						}
+					}
+					break;
 				}
-				s_iHBRealSize++;
+				if ( bFound )
+					continue;
+			}
+
+			triplets << localTriplet;
+		}
+	}
+}
+
+static void HBGetTripletBlock( int threadnum, int first, int last, void *pContext )
+{
+	MDTRA_HBTripletList *pBlocks = (MDTRA_HBTripletList*)pContext;
+	MDTRA_HBTripletList &triplets = pBlocks[first / HB_TRIPLET_BLOCK_ATOMS];
+
+	for ( int i = first; i < last; i++ ) {
+		if (pWaitDialog->checkInterrupt())
+			return;
+		HBGetAtomTriplets( i, triplets );
+	}
+}
+
+static bool HBGetTriplets( void )
+{
+	const int numAtoms = s_lhbsd.pStream->pdb->getAtomCount();
+	const int numBlocks = (numAtoms + HB_TRIPLET_BLOCK_ATOMS - 1) / HB_TRIPLET_BLOCK_ATOMS;
+	MDTRA_HBTripletList *pBlocks = new MDTRA_HBTripletList[numBlocks];
+
+	if ( CountThreads() > 1 ) {
+		//blocks of donor atoms are run by the pool, the wait dialog is updated meanwhile
+		RunThreadsOnRange( 0, numAtoms, HB_TRIPLET_BLOCK_ATOMS, HBGetTripletBlock, pBlocks );
+	} else {
+		for ( int i = 0; i < numAtoms; i++ ) {
+			//update wait dialog
+			QApplication::processEvents();
+			if (pWaitDialog->checkInterrupt())
+				break;
+			HBGetAtomTriplets( i, pBlocks[i / HB_TRIPLET_BLOCK_ATOMS] );
+		}
+	}
+
+	if (pWaitDialog->checkInterrupt()) {
+		delete [] pBlocks;
+		return false;
+	}
+
+	//merge in atom order, so the triplets are the same as from a serial pass
+	for ( int b = 0; b < numBlocks; b++ ) {
+		for ( int k = 0; k < pBlocks[b].count(); k++ ) {
+			if (s_iHBRealSize >= s_iHBBufferSize-1) {
+				s_HBonds << pBlocks[b].at(k);
+				s_iHBBufferSize++;
+			} else {
+				s_HBonds.replace( s_iHBRealSize, pBlocks[b].at(k) );
 			}
+			s_iHBRealSize++;
 		}
 	}
 
+	delete [] pBlocks;
 	return true;
 }
 
@@ -676,27 +724,16 @@ static void HBCalcTriplet( int threadnum, MDTRA_PDB_File *ppdb, int index )
 #endif
 }
 
-static void f_HBSearch( int threadnum, int num )
+static void f_HBSearch( int threadnum, int num, MDTRA_PDB_File *pPdbFile, void *pContext )
 {
-	//Load PDB file
-	MDTRA_PDB_File *pPdbFile;
-	if ( (s_lhbsd.workStart + num) == 0) {
-		pPdbFile = s_lhbsd.pStream->pdb;
-	} else {
-		pPdbFile = s_lhbsd.tempPDB[threadnum];
-		pPdbFile->load( threadnum, s_lhbsd.pStream->format_identifier, s_lhbsd.pStream->files.at(s_lhbsd.workStart + num).toAscii(), s_lhbsd.pStream->flags );
-	}
+	//H-Bond energies only depend on internal geometry, so the snapshot
+	//may come in any orientation
+	if (!pPdbFile)
+		return;
 
 	//Calculate H-Bonds
 	for (int i = 0; i < s_iHBRealSize; i++)
 		HBCalcTriplet( threadnum, pPdbFile, i );
-
-	if (pProgressDialog) {
-		pProgressDialog->advanceCurrentFile( num+1 );
-		if (pProgressDialog->checkInterrupt()) {
-			InterruptThreads();
-		}
-	}
 }
 
 static void f_HBJoin( int threadnum )
@@ -750,7 +787,8 @@ bool SetupHBSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_HBSearchInfo *pSe
 
 	//setup local search data
 	s_lhbsd.workStart = pSearchInfo->trajectoryMin - 1;
-	s_lhbsd.workCount = pSearchInfo->trajectoryMax - pSearchInfo->trajectoryMin + 1;
+	s_lhbsd.workStride = MDTRA_MAX( 1, pSearchInfo->trajectoryStride );
+	s_lhbsd.workCount = (pSearchInfo->trajectoryMax - pSearchInfo->trajectoryMin) / s_lhbsd.workStride + 1;
 	s_lhbsd.minCount = (int)ceil(((float)pSearchInfo->minPercent / 100.0f) * s_lhbsd.workCount);
 	s_lhbsd.minEnergy = pSearchInfo->minEnergy;
 	s_lhbsd.grouping = pSearchInfo->grouping;
@@ -775,12 +813,6 @@ bool SetupHBSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_HBSearchInfo *pSe
 	QApplication::processEvents();
 
 	//allocate thread memory
-	for (int i = 0; i < CountThreads(); i++) {
-		s_lhbsd.tempPDB[i] = new MDTRA_PDB_File;
-		if (!s_lhbsd.tempPDB[i])
-			return false;
-	}
-
 	s_flHBEnergy = new float[s_iHBRealSize * CountThreads()];
 	s_flHBLength = new float[s_iHBRealSize * CountThreads()];
 	s_iHBCount = new int[s_iHBRealSize * CountThreads()];
@@ -804,6 +836,24 @@ bool SetupHBSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_HBSearchInfo *pSe
 	return true;
 }
 
+void QueueHBSearch( MDTRA_FrameSweep *pSweep )
+{
+	pSweep->addConsumer( s_lhbsd.pStream, s_lhbsd.workStart, s_lhbsd.workStride, s_lhbsd.workCount, f_HBSearch, NULL );
+}
+
+bool FinishHBSearch( void )
+{
+	for (int i = 1; i < CountThreads(); i++) f_HBJoin( i );
+	bool b = f_HBFinalize();
+
+	if (!b) {
+		QMessageBox::warning(s_pMainWindow, "H-Bond Search Results", "No significant hydrogen bonds were found!\nPlease make your significance criterion less strict.");
+		return false;
+	}
+
+	return true;
+}
+
 bool PerformHBSearch( void )
 {
 	MDTRA_ProgressDialog dlgProgress( s_pMainWindow );
@@ -816,20 +866,15 @@ bool PerformHBSearch( void )
 	dlgProgress.setCurrentStream( 0 );
 	dlgProgress.setCurrentFile( 0 );
 
-	RunThreadsOnIndividual( s_lhbsd.workCount, f_HBSearch );
-
-	if (dlgProgress.checkInterrupt())
+	MDTRA_FrameSweep sweep;
+	QueueHBSearch( &sweep );
+	if (!sweep.run( false ))
 		return false;
 
 	dlgProgress.setProgressAtMax();
 
-	for (int i = 1; i < CountThreads(); i++) f_HBJoin( i );
-	bool b = f_HBFinalize();
-
-	if (!b) {
-		QMessageBox::warning(s_pMainWindow, "H-Bond Search Results", "No significant hydrogen bonds were found!\nPlease make your significance criterion less strict.");
+	if (!FinishHBSearch())
 		return false;
-	}
 
 	dlgProgress.hide();
 	QApplication::processEvents();
@@ -841,13 +886,6 @@ void FreeHBSearch( void )
 {
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
-	for (int i = 0; i < CountThreads(); i++) {
-		if (s_lhbsd.tempPDB[i]) {
-			delete s_lhbsd.tempPDB[i];
-			s_lhbsd.tempPDB[i] = NULL;
-		}
-	}
-
 	if (s_flHBEnergy) {
 		delete [] s_flHBEnergy;
 		s_flHBEnergy = NULL;
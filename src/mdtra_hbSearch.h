@@ -75,6 +75,7 @@ typedef struct stMDTRA_HBSearchInfo {
 	int		streamIndex;
 	int		trajectoryMin;
 	int		trajectoryMax;
+	int		trajectoryStride;
 	int		minPercent;
 	float	minEnergy;
 	bool	grouping;
@@ -83,12 +84,12 @@ typedef struct stMDTRA_HBSearchInfo {
 typedef struct stMDTRA_HBSearchData
 {
 	int						workStart;
+	int						workStride;
 	int						workCount;
 	int						minCount;
 	float					minEnergy;
 	bool					grouping;
 	const MDTRA_Stream*		pStream;	
-	MDTRA_PDB_File*			tempPDB[MDTRA_MAX_THREADS];
 } MDTRA_HBSearchData;
 
 #define TF_VALID			(1<<0)
@@ -109,10 +110,13 @@ public:
 } MDTRA_HBSearchTriplet;
 
 class MDTRA_MainWindow;
+class MDTRA_FrameSweep;
 
 extern float HBCalcPair( const MDTRA_PDB_File *ppdb, const MDTRA_PDB_Atom *pDonor, const MDTRA_PDB_Atom *pAcceptor );
 extern bool SetupHBSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_HBSearchInfo *pSearchInfo );
 extern bool PerformHBSearch( void );
+extern void QueueHBSearch( MDTRA_FrameSweep *pSweep );
+extern bool FinishHBSearch( void );
 extern void FreeHBSearch( void );
 extern void FreeHBSearchOnExit( void );
 extern void HBInitConfigData( void );
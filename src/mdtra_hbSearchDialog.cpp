@@ -25,6 +25,7 @@
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb.h"
 #include "mdtra_utils.h"
@@ -55,7 +56,7 @@ MDTRA_HBSearchDialog :: MDTRA_HBSearchDialog( QWidget *parent )
 		MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStream( i );
 		if (pStream && pStream->pdb) {
 			sCombo->addItem( QIcon(":/png/16x16/stream.png"), 
-							 tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()),
+							 tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )),
 							 pStream->index );
 		}
 	}
@@ -79,7 +80,7 @@ void MDTRA_HBSearchDialog :: exec_on_stream_change( void )
 {
 	int streamIndex = sCombo->itemData( sCombo->currentIndex() ).toInt();
 	const MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStreamByIndex( streamIndex );
-	eIndex->setMaximum( pStream->files.count() );
+	eIndex->setMaximum( MDTRA_GetStreamFrameCount( pStream ) );
 }
 
 void MDTRA_HBSearchDialog :: exec_on_accept( void )
@@ -97,10 +98,12 @@ void MDTRA_HBSearchDialog :: exec_on_accept( void )
 
 	//Define trajectory fragment to analyze
 	pHBsInfo->trajectoryMin = 1;
-	pHBsInfo->trajectoryMax = pStream->files.count();
+	pHBsInfo->trajectoryMax = MDTRA_GetStreamFrameCount( pStream );
+	pHBsInfo->trajectoryStride = 1;
 	if (trajectoryRange->isChecked()) {
 		pHBsInfo->trajectoryMin = MDTRA_MAX( pHBsInfo->trajectoryMin, sIndex->value() );
 		pHBsInfo->trajectoryMax = MDTRA_MIN( pHBsInfo->trajectoryMax, eIndex->value() );
+		pHBsInfo->trajectoryStride = sbStride->value();
 	}
 
 	//Define significance criterion
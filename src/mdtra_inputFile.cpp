@@ -0,0 +1,412 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of MDTRA_InputFile
+
+#include "mdtra_main.h"
+#include "mdtra_utils.h"
+#include "mdtra_inputFile.h"
+
+#if defined(LINUX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+#if defined(MDTRA_ALLOW_ZLIB)
+#include <zlib.h>
+#endif
+
+#define INPUT_FILE_PLAIN		0
+#define INPUT_FILE_MAPPED		1
+#define INPUT_FILE_GZIP			2
+
+#define INPUT_CHUNK_SIZE		(256 * 1024)
+#define INPUT_LINE_SIZE			1024
+
+//decoder state is allocated once per thread and reused by every file it reads
+typedef struct stMDTRA_InputBuffers
+{
+	byte*	pInput;
+	byte*	pOutput;
+	char*	pLine;
+#if defined(MDTRA_ALLOW_ZLIB)
+	z_stream zs;
+	bool	zsInit;
+#endif
+} MDTRA_InputBuffers;
+
+static MDTRA_InputBuffers *InputFile_CreateBuffers( void )
+{
+	MDTRA_InputBuffers *pBuffers = new MDTRA_InputBuffers[CountThreadSlots()];
+	memset( pBuffers, 0, sizeof(MDTRA_InputBuffers) * CountThreadSlots() );
+	return pBuffers;
+}
+
+//one set of buffers per thread slot, allocated before any thread is started
+static MDTRA_InputBuffers *s_InputBuffers = InputFile_CreateBuffers();
+
+static bool InputFile_AllocBuffers( MDTRA_InputBuffers *pBuffers, bool bCompressed )
+{
+	if (!pBuffers->pLine)
+		pBuffers->pLine = (char*)UTIL_AlignedMalloc( INPUT_LINE_SIZE );
+	if (!bCompressed)
+		return (pBuffers->pLine != NULL);
+
+	if (!pBuffers->pInput)
+		pBuffers->pInput = (byte*)UTIL_AlignedMalloc( INPUT_CHUNK_SIZE );
+	if (!pBuffers->pOutput)
+		pBuffers->pOutput = (byte*)UTIL_AlignedMalloc( INPUT_CHUNK_SIZE );
+	return (pBuffers->pLine && pBuffers->pInput && pBuffers->pOutput);
+}
+
+static const char *InputFile_Map( const char *filename, qword *pSize )
+{
+#if defined(WIN32)
+	HANDLE hFile = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if (hFile == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx( hFile, &fileSize ) || fileSize.QuadPart <= 0 || (qword)fileSize.QuadPart > (qword)((size_t)-1)) {
+		CloseHandle( hFile );
+		return NULL;
+	}
+
+	HANDLE hMapping = CreateFileMappingA( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( hFile );
+	if (!hMapping)
+		return NULL;
+
+	//the view keeps the mapping alive
+	void *pData = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( hMapping );
+	if (!pData)
+		return NULL;
+
+	*pSize = (qword)fileSize.QuadPart;
+	return (const char*)pData;
+#elif defined(LINUX)
+	int fd = ::open( filename, O_RDONLY );
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	if (fstat( fd, &st ) || st.st_size <= 0 || (qword)st.st_size > (qword)((size_t)-1)) {
+		::close( fd );
+		return NULL;
+	}
+
+	void *pData = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	::close( fd );
+	if (pData == MAP_FAILED)
+		return NULL;
+
+	madvise( pData, (size_t)st.st_size, MADV_SEQUENTIAL );
+	*pSize = (qword)st.st_size;
+	return (const char*)pData;
+#endif
+}
+
+static void InputFile_Unmap( const char *pData, qword size )
+{
+#if defined(WIN32)
+	UnmapViewOfFile( pData );
+#elif defined(LINUX)
+	munmap( (void*)pData, (size_t)size );
+#endif
+}
+
+MDTRA_InputFile :: MDTRA_InputFile()
+{
+	m_pFile = NULL;
+	m_pMapped = NULL;
+	m_iMappedSize = 0;
+	m_iMappedPos = 0;
+	m_iThread = 0;
+	m_iType = INPUT_FILE_PLAIN;
+	m_iOutPos = 0;
+	m_iOutSize = 0;
+	m_iInPos = 0;
+	m_iInSize = 0;
+	m_bStreamEnd = false;
+}
+
+MDTRA_InputFile :: ~MDTRA_InputFile()
+{
+	close();
+}
+
+bool MDTRA_InputFile :: open( int threadnum, const char *filename )
+{
+	close();
+
+	m_iThread = threadnum;
+	MDTRA_InputBuffers *pBuffers = &s_InputBuffers[m_iThread];
+
+	//check the signature
+	byte signature[4];
+	size_t sigSize = 0;
+	memset( signature, 0, sizeof(signature) );
+
+	m_pMapped = InputFile_Map( filename, &m_iMappedSize );
+	if (m_pMapped) {
+		sigSize = (size_t)MDTRA_MIN( m_iMappedSize, (qword)sizeof(signature) );
+		memcpy( signature, m_pMapped, sigSize );
+	} else {
+		if (fopen_s( &m_pFile, filename, "r" )) {
+			m_pFile = NULL;
+			return false;
+		}
+		sigSize = fread( signature, 1, sizeof(signature), m_pFile );
+	}
+
+	if (sigSize >= 2 && signature[0] == 0x1F && signature[1] == 0x8B)
+		m_iType = INPUT_FILE_GZIP;
+	else
+		m_iType = m_pMapped ? INPUT_FILE_MAPPED : INPUT_FILE_PLAIN;
+
+	if (!InputFile_AllocBuffers( pBuffers, (m_iType == INPUT_FILE_GZIP) )) {
+		close();
+		return false;
+	}
+
+	if (m_iType == INPUT_FILE_MAPPED) {
+		m_iMappedPos = 0;
+		return true;
+	}
+	if (m_iType == INPUT_FILE_PLAIN) {
+		::rewind( m_pFile );
+		return true;
+	}
+
+	//compressed data must be read in binary mode
+	if (m_pMapped) {
+		InputFile_Unmap( m_pMapped, m_iMappedSize );
+		m_pMapped = NULL;
+		m_iMappedSize = 0;
+	} else {
+		fclose( m_pFile );
+		m_pFile = NULL;
+	}
+	if (fopen_s( &m_pFile, filename, "rb" )) {
+		m_pFile = NULL;
+		close();
+		return false;
+	}
+
+#if defined(MDTRA_ALLOW_ZLIB)
+	if (!pBuffers->zsInit) {
+		memset( &pBuffers->zs, 0, sizeof(pBuffers->zs) );
+		if (inflateInit2( &pBuffers->zs, 16 + MAX_WBITS ) != Z_OK) {
+			close();
+			return false;
+		}
+		pBuffers->zsInit = true;
+	}
+#else
+	close();
+	return false;
+#endif
+
+	rewind();
+	return true;
+}
+
+void MDTRA_InputFile :: close( void )
+{
+	if (m_pFile) {
+		fclose( m_pFile );
+		m_pFile = NULL;
+	}
+	if (m_pMapped) {
+		InputFile_Unmap( m_pMapped, m_iMappedSize );
+		m_pMapped = NULL;
+	}
+	m_iMappedSize = m_iMappedPos = 0;
+	m_iType = INPUT_FILE_PLAIN;
+	m_iOutPos = m_iOutSize = 0;
+	m_iInPos = m_iInSize = 0;
+	m_bStreamEnd = false;
+}
+
+void MDTRA_InputFile :: rewind( void )
+{
+	if (m_iType == INPUT_FILE_MAPPED) {
+		m_iMappedPos = 0;
+		return;
+	}
+	if (!m_pFile)
+		return;
+
+	::rewind( m_pFile );
+	m_iOutPos = m_iOutSize = 0;
+	m_iInPos = m_iInSize = 0;
+	m_bStreamEnd = false;
+
+#if defined(MDTRA_ALLOW_ZLIB)
+	if (m_iType == INPUT_FILE_GZIP) {
+		z_stream *zs = &s_InputBuffers[m_iThread].zs;
+		inflateReset( zs );
+		zs->next_in = NULL;
+		zs->avail_in = 0;
+	}
+#endif
+}
+
+bool MDTRA_InputFile :: eof( void ) const
+{
+	if (m_iType == INPUT_FILE_MAPPED)
+		return (m_iMappedPos >= m_iMappedSize);
+	if (!m_pFile)
+		return true;
+	if (m_iType == INPUT_FILE_PLAIN)
+		return (feof( m_pFile ) != 0);
+	return (m_bStreamEnd && m_iOutPos >= m_iOutSize);
+}
+
+bool MDTRA_InputFile :: refill( void )
+{
+	//decode next portion of the file into the output buffer
+	MDTRA_InputBuffers *pBuffers = &s_InputBuffers[m_iThread];
+	m_iOutPos = 0;
+	m_iOutSize = 0;
+
+	while (!m_bStreamEnd && !m_iOutSize) {
+		if (m_iInPos >= m_iInSize) {
+			m_iInPos = 0;
+			m_iInSize = (int)fread( pBuffers->pInput, 1, INPUT_CHUNK_SIZE, m_pFile );
+			if (m_iInSize <= 0) {
+				m_iInSize = 0;
+				m_bStreamEnd = true;
+				break;
+			}
+		}
+
+#if defined(MDTRA_ALLOW_ZLIB)
+		if (m_iType == INPUT_FILE_GZIP) {
+			z_stream *zs = &pBuffers->zs;
+			zs->next_in = pBuffers->pInput + m_iInPos;
+			zs->avail_in = m_iInSize - m_iInPos;
+			zs->next_out = pBuffers->pOutput;
+			zs->avail_out = INPUT_CHUNK_SIZE;
+			int ret = inflate( zs, Z_NO_FLUSH );
+			m_iInPos = m_iInSize - zs->avail_in;
+			m_iOutSize = INPUT_CHUNK_SIZE - zs->avail_out;
+			if (ret == Z_STREAM_END) {
+				//gzip files may consist of several members
+				inflateReset( zs );
+			} else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+				m_bStreamEnd = true;
+			}
+		}
+#endif
+	}
+
+	return (m_iOutSize > 0);
+}
+
+const char *MDTRA_InputFile :: getLine( int *pLength )
+{
+	//returns the next line including its terminator, the line is not null-terminated
+	//the pointer stays valid until the next call
+	if (m_iType == INPUT_FILE_MAPPED) {
+		if (m_iMappedPos >= m_iMappedSize)
+			return NULL;
+		const char *pLine = m_pMapped + m_iMappedPos;
+		size_t remaining = (size_t)(m_iMappedSize - m_iMappedPos);
+		const char *pNext = (const char*)memchr( pLine, '\n', remaining );
+		size_t length = pNext ? (size_t)(pNext - pLine + 1) : remaining;
+		m_iMappedPos += length;
+		*pLength = (int)length;
+		return pLine;
+	}
+
+	if (!m_pFile)
+		return NULL;
+
+	char *pLineBuffer = s_InputBuffers[m_iThread].pLine;
+	if (m_iType == INPUT_FILE_PLAIN) {
+		if (!fgets( pLineBuffer, INPUT_LINE_SIZE, m_pFile ))
+			return NULL;
+		*pLength = (int)strlen( pLineBuffer );
+		return pLineBuffer;
+	}
+
+	//compressed: return the line in place if it is not split between chunks
+	if (m_iOutPos >= m_iOutSize && !refill())
+		return NULL;
+
+	const char *pOutput = (const char*)s_InputBuffers[m_iThread].pOutput;
+	const char *pLine = pOutput + m_iOutPos;
+	const char *pNext = (const char*)memchr( pLine, '\n', m_iOutSize - m_iOutPos );
+	if (pNext) {
+		*pLength = (int)(pNext - pLine + 1);
+		m_iOutPos += *pLength;
+		return pLine;
+	}
+
+	//assemble the line, its tail beyond the line buffer is skipped
+	int length = 0;
+	for (;;) {
+		if (m_iOutPos >= m_iOutSize && !refill())
+			break;
+		pLine = pOutput + m_iOutPos;
+		int available = m_iOutSize - m_iOutPos;
+		pNext = (const char*)memchr( pLine, '\n', available );
+		int chunk = pNext ? (int)(pNext - pLine + 1) : available;
+		int copy = MDTRA_MIN( chunk, INPUT_LINE_SIZE - length );
+		memcpy( pLineBuffer + length, pLine, copy );
+		length += copy;
+		m_iOutPos += chunk;
+		if (pNext)
+			break;
+	}
+
+	*pLength = length;
+	return length ? pLineBuffer : NULL;
+}
+
+char *MDTRA_InputFile :: gets( char *buffer, int size )
+{
+	//same semantics as fgets in text mode, but the tail of lines longer than the buffer is skipped
+	if (size <= 0)
+		return NULL;
+
+	int length;
+	const char *pLine = getLine( &length );
+	if (!pLine)
+		return NULL;
+
+	bool bNewLine = (pLine[length-1] == '\n');
+	int content = bNewLine ? (length - 1) : length;
+	if (bNewLine && content > 0 && pLine[content-1] == '\r')
+		content--;
+
+	int copy = MDTRA_MIN( content, size - (bNewLine ? 2 : 1) );
+	if (copy < 0)
+		copy = 0;
+	memcpy( buffer, pLine, copy );
+	if (bNewLine && copy < size - 1)
+		buffer[copy++] = '\n';
+	buffer[copy] = 0;
+	return buffer;
+}
@@ -0,0 +1,58 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_INPUT_FILE_H
+#define MDTRA_INPUT_FILE_H
+
+//Text input file with transparent decompression
+//Plain files are memory-mapped and scanned for lines in place,
+//gzip files are detected by their signature
+//and decoded in chunks through buffers owned by the calling thread
+class MDTRA_InputFile
+{
+public:
+	MDTRA_InputFile();
+	~MDTRA_InputFile();
+
+	bool open( int threadnum, const char *filename );
+	void close( void );
+	void rewind( void );
+	bool eof( void ) const;
+	char *gets( char *buffer, int size );
+	const char *getLine( int *pLength );
+
+protected:
+	bool refill( void );
+
+private:
+	FILE*	m_pFile;
+	const char* m_pMapped;
+	qword	m_iMappedSize;
+	qword	m_iMappedPos;
+	int		m_iThread;
+	int		m_iType;
+	int		m_iOutPos;
+	int		m_iOutSize;
+	int		m_iInPos;
+	int		m_iInSize;
+	bool	m_bStreamEnd;
+};
+
+#endif //MDTRA_INPUT_FILE_H
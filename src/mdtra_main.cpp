@@ -20,13 +20,14 @@
 ***************************************************************************/
 
 // Purpose:
-//	Create QApplication and main window
+//	Create QApplication and main window, or run the headless batch mode
 //	Implement OS-dependent "main" entry points
 
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_cpuid.h"
 #include "mdtra_cuda.h"
+#include "mdtra_batch.h"
 #include <QtGui/QApplication>
 #include <QtOpenGL/QtOpenGL>
 
@@ -42,8 +43,6 @@ int lcMain( int argc, char *argv[] )
 	CheckCPU();
 	MDTRA_CUDA_CheckSupport();
 
-	QGL::setPreferredPaintEngine(QPaintEngine::OpenGL);
-
 	QLocale usLocale(QLocale::English, QLocale::UnitedStates);
 	QLocale::setDefault(usLocale);
 
@@ -52,6 +51,16 @@ int lcMain( int argc, char *argv[] )
 	QTextCodec::setCodecForLocale(codec);
 #endif
 
+	//batch mode never creates a widget, so it needs no display or OpenGL
+	if (BatchRequested( argc, argv )) {
+		g_pApp = new QApplication( argc, argv, false );
+		int result = BatchMain( argc, argv );
+		ThreadPoolShutdown();
+		return result;
+	}
+
+	QGL::setPreferredPaintEngine(QPaintEngine::OpenGL);
+
 	g_pApp = new QApplication( argc, argv );
 
 #if !defined(MDTRA_NO_SPLASH)
@@ -76,7 +85,9 @@ int lcMain( int argc, char *argv[] )
 		mdtraMainWindow.loadFile( argv[argc-1] );
 	}
 
-	return g_pApp->exec();
+	int result = g_pApp->exec();
+	ThreadPoolShutdown();
+	return result;
 }
 
 #if defined(WIN32)
@@ -40,8 +40,12 @@
 #include <algorithm>
 
 #define MDTRA_ALLOW_SSE
+#if !defined(_MSC_VER) || (_MSC_VER >= 1700)
+#define MDTRA_ALLOW_AVX2	//AVX2 intrinsics need Visual C++ 2012 or newer
+#endif
 #define MDTRA_ALLOW_CUDA
 #define MDTRA_ALLOW_PRINTER
+#define MDTRA_ALLOW_ZLIB	//Windows builds use the zlib bundled with and exported by QtCore4
 
 #if defined(WIN32)
 
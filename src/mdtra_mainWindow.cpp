@@ -29,6 +29,10 @@
 #include "mdtra_pdb_format.h"
 #include "mdtra_plot.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
+#include "mdtra_prefetch.h"
+#include "mdtra_sweep.h"
+#include "mdtra_frameCache.h"
 #include "mdtra_saverestore.h"
 #include "mdtra_select.h"
 #include "mdtra_configFile.h"
@@ -148,6 +152,7 @@ static MDTRAMenuDesc g_MenuItems[] =
 { "ToolsTorsionSearch", "&Tools", "&Torsion Search...", ":/png/16x16/ts.png", "F9", "Search for meaningful torsion angles", SLOT(toolsTorsionSearch()), false, 0, MENUDESC_DEFAULT },
 { "ToolsForceSearch", "&Tools", "&Force Search...", ":/png/16x16/force.png", NULL, "Search for meaningful force differences (BioPASED format only)", SLOT(toolsForceSearch()), false, 0, MENUDESC_DEFAULT },
 { "ToolsHBSearch", "&Tools", "&H-Bonds Search...", ":/png/16x16/hbond.png", "F10", "Search for meaningful hydrogen bonds along the trajectory", SLOT(toolsHBSearch()), false, 0, MENUDESC_DEFAULT },
+{ "ToolsBatchSweep", "&Tools", "&Batch Sweep Mode", NULL, NULL, "Queue torsion and H-Bonds searches and run them in the same trajectory pass as the next build", SLOT(toolsBatchSweep()), true, 0, MENUDESC_DEFAULT },
 { NULL, "&Tools", NULL, NULL, NULL, NULL, NULL, false, 0, MENUDESC_DEFAULT },
 /*{ "ToolsPCA", "&Tools", "&Principal Component Analysis...", ":/png/16x16/pca.png", "F11", "Perform principal component analysis", SLOT(toolsPCA()), false, 0, MENUDESC_DEFAULT },*/
 { "Tools2DRMSD", "&Tools", "Calculate 2D-&RMSD...", ":/png/16x16/rmsd2d.png", "F12", "Calculate two-dimensional RMSD mp", SLOT(tools2DRMSD()), false, 0, MENUDESC_DEFAULT },
@@ -227,7 +232,14 @@ MDTRA_MainWindow :: MDTRA_MainWindow( QWidget *parent, Qt::WindowFlags flags )
 	m_bMultisampleAA = false;
 	m_bAllowSSE = true;
 	m_bLowPriority = false;
+	m_bPinThreads = false;
 	m_iThreadCount = -1;
+	m_iPrefetchDepth = MDTRA_DEFAULT_PREFETCH_DEPTH;
+	m_iFrameCacheSize = MDTRA_DEFAULT_FRAME_CACHE_SIZE;
+	m_bFrameCacheQuantize = false;
+	m_iBuildFirst = 1;
+	m_iBuildLast = 0;
+	m_iBuildStride = 1;
 	m_bPlotShowGrid = true;
 	m_bPlotShowLabels = true;
 	m_bPlotShowLegend = true;
@@ -245,6 +257,9 @@ MDTRA_MainWindow :: MDTRA_MainWindow( QWidget *parent, Qt::WindowFlags flags )
 
 	m_pProject = new MDTRA_Project( this );
 	m_pColorManager = new MDTRA_ColorManager;
+	m_pBatchSweep = new MDTRA_FrameSweep;
+	m_bBatchSweep = false;
+	m_iBatchQueue = 0;
 	
 	resetCounters();
 	setupMenuBar();
@@ -265,6 +280,9 @@ MDTRA_MainWindow :: MDTRA_MainWindow( QWidget *parent, Qt::WindowFlags flags )
 #endif
 
 	ThreadSetDefault( m_iThreadCount, m_bLowPriority ? 0 : 1 );
+	ThreadSetAffinity( m_bPinThreads );
+	PrefetchSetDefault( m_iPrefetchDepth );
+	FrameCacheSetDefault( m_iFrameCacheSize, m_bFrameCacheQuantize );
 	MDTRA_CUDA_InitDevice( getCUDADevice() );
 	statusBar()->showMessage(tr("Welcome to " APPLICATION_TITLE_FULL " " APPLICATION_VERSION));
 }
@@ -286,6 +304,10 @@ MDTRA_MainWindow :: ~MDTRA_MainWindow()
 		delete m_pColorManager;
 		m_pColorManager = NULL;
 	}
+	if (m_pBatchSweep) {
+		delete m_pBatchSweep;
+		m_pBatchSweep = NULL;
+	}
 	g_pMainWindow = NULL;
 }
 
@@ -963,11 +985,18 @@ void MDTRA_MainWindow :: saveSettings( void )
 	settings.setValue("Preferences/MultisampleAA", m_bMultisampleAA);
 	settings.setValue("Preferences/AllowSSE", m_bAllowSSE);
 	settings.setValue("Preferences/LowPriority", m_bLowPriority);
+	settings.setValue("Preferences/PinThreads", m_bPinThreads);
 	settings.setValue("Preferences/UseCUDA", m_bUseCUDA);
 	settings.setValue("Preferences/CUDADevice", m_iCUDADevice);
 	settings.setValue("Preferences/Profiling", m_bProfilingEnabled);
 	settings.setValue("Preferences/EnableBalloonTips", m_bEnableBalloonTips);
 	settings.setValue("Preferences/ThreadCount", m_iThreadCount);
+	settings.setValue("Preferences/PrefetchDepth", m_iPrefetchDepth);
+	settings.setValue("Preferences/FrameCacheSize", m_iFrameCacheSize);
+	settings.setValue("Preferences/FrameCacheQuantize", m_bFrameCacheQuantize);
+	settings.setValue("Preferences/BuildFirst", m_iBuildFirst);
+	settings.setValue("Preferences/BuildLast", m_iBuildLast);
+	settings.setValue("Preferences/BuildStride", m_iBuildStride);
 	settings.setValue("Preferences/PlotShowGrid", m_bPlotShowGrid);
 	settings.setValue("Preferences/PlotShowLabels", m_bPlotShowLabels);
 	settings.setValue("Preferences/PlotShowLegend", m_bPlotShowLegend);
@@ -1007,11 +1036,18 @@ void MDTRA_MainWindow :: restoreSettings( void )
 	m_bMultisampleAA = settings.value("Preferences/MultisampleAA").toBool();
 	m_bAllowSSE = settings.value("Preferences/AllowSSE").toBool();
 	m_bLowPriority = settings.value("Preferences/LowPriority").toBool();
+	m_bPinThreads = settings.value("Preferences/PinThreads").toBool();
 	m_bUseCUDA = settings.value("Preferences/UseCUDA").toBool();
 	m_iCUDADevice = settings.value("Preferences/CUDADevice").toInt();
 	m_bProfilingEnabled = settings.value("Preferences/Profiling").toBool();
 	m_bEnableBalloonTips = settings.value("Preferences/EnableBalloonTips").toBool();
 	m_iThreadCount = settings.value("Preferences/ThreadCount").toInt();
+	m_iPrefetchDepth = settings.value("Preferences/PrefetchDepth", MDTRA_DEFAULT_PREFETCH_DEPTH).toInt();
+	m_iFrameCacheSize = settings.value("Preferences/FrameCacheSize", MDTRA_DEFAULT_FRAME_CACHE_SIZE).toInt();
+	m_bFrameCacheQuantize = settings.value("Preferences/FrameCacheQuantize").toBool();
+	m_iBuildFirst = MDTRA_MAX( 1, settings.value("Preferences/BuildFirst", 1).toInt() );
+	m_iBuildLast = MDTRA_MAX( 0, settings.value("Preferences/BuildLast", 0).toInt() );
+	m_iBuildStride = MDTRA_MAX( 1, settings.value("Preferences/BuildStride", 1).toInt() );
 	m_bPlotShowGrid = settings.value("Preferences/PlotShowGrid").toBool();
 	m_bPlotShowLabels = settings.value("Preferences/PlotShowLabels").toBool();
 	m_bPlotShowLegend = settings.value("Preferences/PlotShowLegend").toBool();
@@ -1384,7 +1420,7 @@ void MDTRA_MainWindow :: remove_selection( void )
 
 void MDTRA_MainWindow :: build_result_collectors( void )
 {
-	if (m_pResultCollectionList->count() < 1) {
+	if (m_pResultCollectionList->count() < 1 && !m_iBatchQueue) {
         QMessageBox::warning(this, tr(APPLICATION_TITLE_SMALL), tr("Nothing to build!"));
         return;
 	}
@@ -1393,7 +1429,7 @@ void MDTRA_MainWindow :: build_result_collectors( void )
 	m_pTrayIcon->setToolTip(tr(APPLICATION_TITLE_SMALL " " APPLICATION_VERSION " [Building...]" ));
 	statusBar()->showMessage(tr("Building results, please wait..."));
 
-	if (!m_pProject->build( false )) {
+	if (!m_pProject->build( false, m_iBatchQueue ? m_pBatchSweep : NULL )) {
 		QApplication::restoreOverrideCursor();
 		statusBar()->showMessage("");
 		m_pTrayIcon->setToolTip(tr(APPLICATION_TITLE_SMALL " " APPLICATION_VERSION " [Idle]" ));
@@ -1407,11 +1443,12 @@ void MDTRA_MainWindow :: build_result_collectors( void )
 	if ( m_bEnableBalloonTips )
 		m_pTrayIcon->showMessage(tr(APPLICATION_TITLE_SMALL " " APPLICATION_VERSION), tr("Build process is complete!"));
 	updateTitleBar( true );
+	finishBatchSweep();
 }
 
 void MDTRA_MainWindow :: rebuild_all_result_collectors( void )
 {
-	if (m_pResultCollectionList->count() < 1) {
+	if (m_pResultCollectionList->count() < 1 && !m_iBatchQueue) {
         QMessageBox::warning(this, tr(APPLICATION_TITLE_SMALL), tr("Nothing to build!"));
         return;
 	}
@@ -1427,7 +1464,7 @@ void MDTRA_MainWindow :: rebuild_all_result_collectors( void )
 	statusBar()->showMessage(tr("Rebilding all results, please wait..."));
 	m_pPlot->disable( tr("Rebuilding results, please wait...") );
 
-	if (!m_pProject->build( true )) {
+	if (!m_pProject->build( true, m_iBatchQueue ? m_pBatchSweep : NULL )) {
 		QApplication::restoreOverrideCursor();
 		statusBar()->showMessage("");
 		m_pTrayIcon->setToolTip(tr(APPLICATION_TITLE_SMALL " " APPLICATION_VERSION " [Idle]" ));
@@ -1441,6 +1478,14 @@ void MDTRA_MainWindow :: rebuild_all_result_collectors( void )
 	if ( m_bEnableBalloonTips )
 		m_pTrayIcon->showMessage(tr(APPLICATION_TITLE_SMALL " " APPLICATION_VERSION), tr("Build process is complete!"));
 	updateTitleBar( true );
+	finishBatchSweep();
+}
+
+void MDTRA_MainWindow :: getBuildWindow( MDTRA_FrameWindow *pWindow ) const
+{
+	pWindow->first = m_iBuildFirst;
+	pWindow->last = m_iBuildLast;
+	pWindow->stride = m_iBuildStride;
 }
 
 int MDTRA_MainWindow :: getSelectedResultCollectorIndex( void )
@@ -1572,7 +1617,7 @@ void MDTRA_MainWindow :: select_result_collector( void )
 
 	for (int i = 0; i < maxDataSize; i++) {
 		if (pResult->layout == MDTRA_LAYOUT_TIME)
-			vLabels << QString("%1").arg(i);
+			vLabels << QString("%1").arg( MDTRA_GetDSRefSnapshot( &pResult->sourceList.at(0), i ) );
 		else
 			vLabels << QString("%1").arg(i+1);
 	}
@@ -1706,6 +1751,9 @@ void MDTRA_MainWindow :: editPreferences( void )
 	if (dialog.exec()) {
 		dialog.savePreferences();
 		ThreadSetDefault( m_iThreadCount, m_bLowPriority ? 0 : 1 );
+		ThreadSetAffinity( m_bPinThreads );
+		PrefetchSetDefault( m_iPrefetchDepth );
+		FrameCacheSetDefault( m_iFrameCacheSize, m_bFrameCacheQuantize );
 		select_result_collector();
 	} else {
 		dialog.discardPreferences();
@@ -1933,6 +1981,11 @@ void MDTRA_MainWindow :: toolsTorsionSearch( void )
         return;
 	}
 
+	if (m_iBatchQueue & BATCH_TORSIONSEARCH) {
+        QMessageBox::warning(this, tr(APPLICATION_TITLE_SMALL), tr("Torsion search is already queued for the next build!"));
+        return;
+	}
+
 	MDTRA_TorsionSearchDialog dialog(this);
 	if (dialog.exec()) {
 		dialog.hide();
@@ -1942,6 +1995,8 @@ void MDTRA_MainWindow :: toolsTorsionSearch( void )
 			FreeTorsionSearch();
 			return;
 		}
+		if (queueBatchSearch( BATCH_TORSIONSEARCH ))
+			return;
 		if (PerformTorsionSearch()) {
 			//Show search results dialog
 			MDTRA_TorsionSearchResultsDialog resultsDialog(this);
@@ -1983,6 +2038,11 @@ void MDTRA_MainWindow :: toolsHBSearch( void )
         return;
 	}
 
+	if (m_iBatchQueue & BATCH_HBSEARCH) {
+        QMessageBox::warning(this, tr(APPLICATION_TITLE_SMALL), tr("H-Bonds search is already queued for the next build!"));
+        return;
+	}
+
 	MDTRA_HBSearchDialog dialog(this);
 	if (dialog.exec()) {
 		dialog.hide();
@@ -1993,6 +2053,8 @@ void MDTRA_MainWindow :: toolsHBSearch( void )
 			FreeHBSearch();
 			return;
 		}
+		if (queueBatchSearch( BATCH_HBSEARCH ))
+			return;
 		if (PerformHBSearch()) {
 			//Show search results dialog
 			MDTRA_HBSearchResultsDialog resultsDialog(this);
@@ -2002,6 +2064,65 @@ void MDTRA_MainWindow :: toolsHBSearch( void )
 	}
 }
 
+void MDTRA_MainWindow :: toolsBatchSweep( void )
+{
+	m_bBatchSweep = !m_bBatchSweep;
+
+	for (int i = 0; i < m_pActionList.size(); ++i) {
+		if (m_pActionList.at(i)->objectName() == QString("ToolsBatchSweep")) {
+			m_pActionList.at(i)->setChecked(m_bBatchSweep);
+		}
+	}
+
+	//leaving batch mode runs whatever is still queued
+	if (!m_bBatchSweep && m_iBatchQueue)
+		build_result_collectors();
+}
+
+bool MDTRA_MainWindow :: queueBatchSearch( int searchFlag )
+{
+	//search must be set up already; it runs within the next build sweep
+	if (!m_bBatchSweep)
+		return false;
+
+	if (searchFlag == BATCH_TORSIONSEARCH)
+		QueueTorsionSearch( m_pBatchSweep );
+	else
+		QueueHBSearch( m_pBatchSweep );
+
+	m_iBatchQueue |= searchFlag;
+	statusBar()->showMessage(tr("Search is queued and will run with the next build"), 2000);
+	return true;
+}
+
+void MDTRA_MainWindow :: finishBatchSweep( void )
+{
+	if (!m_iBatchQueue)
+		return;
+
+	bool bComplete = m_pBatchSweep->isComplete();
+
+	if (m_iBatchQueue & BATCH_TORSIONSEARCH) {
+		if (bComplete && FinishTorsionSearch()) {
+			//Show search results dialog
+			MDTRA_TorsionSearchResultsDialog resultsDialog(this);
+			resultsDialog.exec();
+		}
+		FreeTorsionSearch();
+	}
+	if (m_iBatchQueue & BATCH_HBSEARCH) {
+		if (bComplete && FinishHBSearch()) {
+			//Show search results dialog
+			MDTRA_HBSearchResultsDialog resultsDialog(this);
+			resultsDialog.exec();
+		}
+		FreeHBSearch();
+	}
+
+	m_pBatchSweep->clear();
+	m_iBatchQueue = 0;
+}
+
 void MDTRA_MainWindow :: tools2DRMSD( void )
 {
 	if (m_pProject->getValidStreamCount() < 1) {
@@ -2072,7 +2193,7 @@ void MDTRA_MainWindow :: exec_on_cell_dblclicked( int row, int column )
 	if (!pResult || pResult->layout != MDTRA_LAYOUT_TIME)
 		return;
 
-	viewPDBFiles( row );
+	viewPDBFiles( MDTRA_GetDSRefSnapshot( &pResult->sourceList.at(0), row ) );
 }
 
 void MDTRA_MainWindow :: viewPDBFiles( int trajectoryPos )
@@ -2200,13 +2321,13 @@ bool MDTRA_MainWindow :: generateTemporaryPDBFiles( int resultIndex, int traject
 		MDTRA_Stream *pStream = m_pProject->fetchStreamByIndex( pDS->streamIndex );
 		if (!pStream)
 			continue;
-		if ( trajectoryPos >= pStream->files.count() )
+		if ( trajectoryPos >= MDTRA_GetStreamFrameCount( pStream ) )
 			continue;
 
-		MDTRA_PDB_File *pdbFile = new MDTRA_PDB_File(0, pStream->format_identifier, pStream->files.at(trajectoryPos).toAscii(), pStream->flags);
+		MDTRA_PDB_File *pdbFile = new MDTRA_PDB_File;
 		if (!pdbFile)
 			continue;
-		if (!pdbFile->getAtomCount()) {
+		if (!MDTRA_LoadStreamFrame( 0, pStream, trajectoryPos, pdbFile ) || !pdbFile->getAtomCount()) {
 			delete pdbFile;
 			continue;
 		}
@@ -59,6 +59,9 @@ typedef enum eMDTRA_Languages
 
 #define MAX_RECENT_FILES	8
 
+#define BATCH_HBSEARCH			(1<<0)
+#define BATCH_TORSIONSEARCH		(1<<1)
+
 class QLabel;
 class QListWidget;
 class QSplitter;
@@ -71,6 +74,7 @@ class MDTRA_Project;
 class MDTRA_ColorManager;
 class MDTRA_PDB_Renderer;
 class MDTRA_Program_Interpreter;
+class MDTRA_FrameSweep;
 
 class MDTRA_MainWindow : public QMainWindow
 {
@@ -114,12 +118,17 @@ public:
 	void setMultisampleAA( bool value ) { m_bMultisampleAA = value; }
 	void setAllowSSE( bool value ) { m_bAllowSSE = value; }
 	void setLowPriority( bool value ) { m_bLowPriority = value; }
+	void setPinThreads( bool value ) { m_bPinThreads = value; }
 	void setUseCUDA( bool value );
 	void setCUDADevice( int value ) { m_iCUDADevice = value; }
 	void setPlotDataFilter( bool value ) { m_bPlotDataFilter = value; }
 	void setPlotDataFilterSize( int value ) { m_iPlotDataFilterSize = value; }
 	void setPlotPolarAngles( bool value ) { m_bPlotPolarAngles = value; }
 	void setNumThreads( int value ) { m_iThreadCount = value; }
+	void setPrefetchDepth( int value ) { m_iPrefetchDepth = value; }
+	void setFrameCacheSize( int value ) { m_iFrameCacheSize = value; }
+	void setFrameCacheQuantize( bool value ) { m_bFrameCacheQuantize = value; }
+	void setBuildWindow( int first, int last, int stride ) { m_iBuildFirst = first; m_iBuildLast = last; m_iBuildStride = stride; }
 	void setXScaleUnits( int value ) { m_xScaleUnits = value; }
 	void setViewerType( int value ) { m_iViewer = value; }
 	void setRasMolPath( const QString &p ) { m_rasMolPath = p; }
@@ -130,11 +139,19 @@ public:
 	bool multisampleAA( void ) const { return m_bMultisampleAA; }
 	bool allowSSE( void ) const { return m_bAllowSSE; }
 	bool lowPriority( void ) const { return m_bLowPriority; }
+	bool pinThreads( void ) const { return m_bPinThreads; }
 	bool useCUDA( void ) const { return m_bUseCUDA; }
 	int  getCUDADevice( void ) const { return m_iCUDADevice; }
 	bool plotDataFilter( void ) const { return m_bPlotDataFilter; }
 	int  plotDataFilterSize( void ) const { return m_iPlotDataFilterSize; }
 	int  numThreads( void ) const { return m_iThreadCount; }
+	int  prefetchDepth( void ) const { return m_iPrefetchDepth; }
+	int  frameCacheSize( void ) const { return m_iFrameCacheSize; }
+	bool frameCacheQuantize( void ) const { return m_bFrameCacheQuantize; }
+	int  buildFirst( void ) const { return m_iBuildFirst; }
+	int  buildLast( void ) const { return m_iBuildLast; }
+	int  buildStride( void ) const { return m_iBuildStride; }
+	void getBuildWindow( struct stMDTRA_FrameWindow *pWindow ) const;
 	bool plotShowGrid( void ) const { return m_bPlotShowGrid; }
 	bool plotShowLabels( void ) const { return m_bPlotShowLabels; }
 	bool plotShowLegend( void ) const { return m_bPlotShowLegend; }
@@ -193,6 +210,7 @@ private slots:
 	void toolsTorsionSearch( void );
 	void toolsForceSearch( void );
 	void toolsHBSearch( void );
+	void toolsBatchSweep( void );
 	void toolsPCA( void );
 	void tools2DRMSD( void );
 	void toolsDDM( void );
@@ -226,6 +244,8 @@ private:
 	void updatePanelVisibility( const QString &name, bool bVis );
 	void update_toolbars( void );
 	void enablePlotControls( bool bEnable );
+	bool queueBatchSearch( int searchFlag );
+	void finishBatchSweep( void );
 	
 private:
 	QSystemTrayIcon *m_pTrayIcon;
@@ -235,6 +255,9 @@ private:
 	QLabel*			m_pLblPlotCoords;
 	MDTRA_Project*	m_pProject;
 	MDTRA_ColorManager *m_pColorManager;
+	MDTRA_FrameSweep* m_pBatchSweep;
+	bool			m_bBatchSweep;
+	int				m_iBatchQueue;
 	QAction*		m_pRecentFileActions[MAX_RECENT_FILES];
 	QAction*		m_pRecentFileSeparator;
 	QStringList		m_RecentFileList;
@@ -257,9 +280,16 @@ private:
 	bool			m_bMultisampleAA;
 	bool			m_bAllowSSE;
 	bool			m_bLowPriority;
+	bool			m_bPinThreads;
 	bool			m_bPlotDataFilter;
 	int				m_iPlotDataFilterSize;
 	int				m_iThreadCount;
+	int				m_iPrefetchDepth;
+	int				m_iFrameCacheSize;
+	bool			m_bFrameCacheQuantize;
+	int				m_iBuildFirst;
+	int				m_iBuildLast;
+	int				m_iBuildStride;
 	bool			m_bPlotShowGrid;
 	bool			m_bPlotShowLabels;
 	bool			m_bPlotShowLegend;
@@ -27,6 +27,8 @@
 #include "mdtra_project.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb.h"
+#include "mdtra_stream.h"
+#include "mdtra_prefetch.h"
 #include "mdtra_progressDialog.h"
 #include "mdtra_waitDialog.h"
 #include "mdtra_pca.h"
@@ -45,31 +47,17 @@ static float *s_memoryHunk = NULL;
 static float *s_pCovarianceMatrix;
 static float *s_pMeans;
 static float *s_pJacobiTemp;
+static char *s_pThreadMeansHunk = NULL;
+static float **s_ppThreadMeans = NULL;
+
+//per-thread mean buffers start on their own page so first-touch can place them
+#define PCA_PAGE_SIZE	4096
 
 extern MDTRA_ProgressDialog *pProgressDialog;
 static MDTRA_WaitDialog *pWaitDialog = NULL;
 
-static void f_BuildCovarianceMatrix( int threadnum, int num )
+void PCAAccumulateMeans( const MDTRA_PDB_File *pPdbFile, float *pMeans )
 {
-	//Load PDB file
-	MDTRA_PDB_File *pPdbFile;
-	if ( (s_lpcad.workStart + num) == 0) {
-		pPdbFile = s_lpcad.pStream->pdb;
-	} else {
-		pPdbFile = s_lpcad.tempPDB[threadnum];
-		pPdbFile->load( threadnum, s_lpcad.pStream->format_identifier, s_lpcad.pStream->files.at(s_lpcad.workStart + num).toAscii(), s_lpcad.pStream->flags );
-		pPdbFile->move_to_centroid();
-		pPdbFile->align_kabsch( s_lpcad.pStream->pdb );
-	}
-
-	//Set PCA flag
-	pPdbFile->set_flag( s_lpcad.selectionSize, s_lpcad.selectionData, PDB_FLAG_PCA );
-
-	//s_pMeans is thread-safe
-	//s_pCovarianceMatrix is NOT (we cannot allocate such huge amount of memory for each thread, sorry)
-	float *pMeans = s_pMeans + s_lpcad.selectionSize*3*threadnum;
-
-	//First, calculate partial sums into pMeans
 	for (int i = 0; i < pPdbFile->getAtomCount(); i++) {
 		const MDTRA_PDB_Atom *pAt = pPdbFile->fetchAtomByIndex( i );
 		if ( pAt->atomFlags & PDB_FLAG_PCA ) {
@@ -79,9 +67,10 @@ static void f_BuildCovarianceMatrix( int threadnum, int num )
 			pMeans += 3;
 		}
 	}
+}
 
-	//Sync and calculate covariance for an upper-right matrix part
-	ThreadLock();
+void PCAAccumulateCovariance( const MDTRA_PDB_File *pPdbFile, int selectionSize, float *pCovariance )
+{
 	int ii = 0;
 	for (int i = 0; i < pPdbFile->getAtomCount(); i++) {
 		const MDTRA_PDB_Atom *pAt1 = pPdbFile->fetchAtomByIndex( i );
@@ -96,9 +85,9 @@ static void f_BuildCovarianceMatrix( int threadnum, int num )
 
 			for (int k = 0; k < 3; k++) {
 				for (int l = k; l < 3; l++) {
-					int offset = (jj*3+k)*s_lpcad.selectionSize*3 + ii*3 + l;
-					assert( offset < g_iNumEigens*g_iNumEigens );
-					float *pCov = s_pCovarianceMatrix + offset;
+					int offset = (jj*3+k)*selectionSize*3 + ii*3 + l;
+					assert( offset < selectionSize*selectionSize*9 );
+					float *pCov = pCovariance + offset;
 					*pCov += pAt1->xyz[k]*pAt2->xyz[l];
 				}
 			}
@@ -106,14 +95,48 @@ static void f_BuildCovarianceMatrix( int threadnum, int num )
 		}
 		ii++;
 	}
-	ThreadUnlock();
+}
 
-	if (pProgressDialog) {
-		pProgressDialog->advanceCurrentFile( num+1 );
-		if (pProgressDialog->checkInterrupt()) {
-			InterruptThreads();
-		}
+static void f_BuildCovarianceMatrix( int threadnum, int num )
+{
+	//Load PDB file
+	MDTRA_PDB_File *pPdbFile;
+	if (s_lpcad.pPrefetch) {
+		s_lpcad.pPrefetch->acquireFrame( threadnum, num, &pPdbFile );
+		if (!pPdbFile)
+			return;	//interrupted
+	} else if ( (s_lpcad.workStart + num * s_lpcad.workStride) == 0) {
+		pPdbFile = s_lpcad.pStream->pdb;
+	} else {
+		pPdbFile = s_lpcad.tempPDB[threadnum];
+		MDTRA_LoadStreamFrame( threadnum, s_lpcad.pStream, s_lpcad.workStart + num * s_lpcad.workStride, pPdbFile );
+	}
+	if ( (s_lpcad.workStart + num * s_lpcad.workStride) != 0) {
+		pPdbFile->move_to_centroid();
+		pPdbFile->align_kabsch( s_lpcad.pStream->pdb );
 	}
+
+	//Set PCA flag
+	pPdbFile->set_flag( s_lpcad.selectionSize, s_lpcad.selectionData, PDB_FLAG_PCA );
+
+	//s_ppThreadMeans is thread-safe
+	//s_pCovarianceMatrix is NOT (we cannot allocate such huge amount of memory for each thread, sorry)
+	float *pMeans = s_ppThreadMeans[threadnum];
+
+	//First, calculate partial sums into pMeans
+	PCAAccumulateMeans( pPdbFile, pMeans );
+
+	//Sync and calculate covariance for an upper-right matrix part
+	ThreadLock();
+	PCAAccumulateCovariance( pPdbFile, s_lpcad.selectionSize, s_pCovarianceMatrix );
+	ThreadUnlock();
+
+	if (s_lpcad.pPrefetch)
+		s_lpcad.pPrefetch->releaseFrame( num );
+
+	ProgressStepFile();
+	if (ProgressInterrupted())
+		InterruptThreads();
 }
 
 static void f_FinalizeCovarianceMatrix( void )
@@ -123,8 +146,8 @@ static void f_FinalizeCovarianceMatrix( void )
 	//Reduce mean values
 	int numThreads = CountThreads();
 	for (int i = 0; i < s_lpcad.selectionSize*3; i++) {
-		for (int j = 1; j < numThreads; j++) {
-			s_pMeans[i] += s_pMeans[i + s_lpcad.selectionSize*3*j];
+		for (int j = 0; j < numThreads; j++) {
+			s_pMeans[i] += s_ppThreadMeans[j][i];
 		}
 		s_pMeans[i] *= fInvNumSnapshots;
 	}
@@ -279,7 +302,8 @@ bool SetupPCA( MDTRA_MainWindow *pMainWindow, const MDTRA_PCAInfo *pInfo, size_t
 	if (pOutOfMemSize) *pOutOfMemSize = 0;
 
 	s_lpcad.workStart = pInfo->trajectoryMin - 1;
-	s_lpcad.workCount = pInfo->trajectoryMax - pInfo->trajectoryMin + 1;
+	s_lpcad.workStride = MDTRA_MAX( 1, pInfo->trajectoryStride );
+	s_lpcad.workCount = (pInfo->trajectoryMax - pInfo->trajectoryMin) / s_lpcad.workStride + 1;
 	s_lpcad.pStream = s_pMainWindow->getProject()->fetchStreamByIndex( pInfo->streamIndex );
 	if (!s_lpcad.pStream || !s_lpcad.pStream->pdb)
 		return false;
@@ -289,7 +313,9 @@ bool SetupPCA( MDTRA_MainWindow *pMainWindow, const MDTRA_PCAInfo *pInfo, size_t
 
 	g_iNumEigens = s_lpcad.selectionSize*3;
 	g_iNumDisplayEigens = pInfo->numDisplayPC;
-	size_t numAllocFloats = g_iNumEigens*g_iNumEigens + g_iNumEigens*MDTRA_MAX(totalThreads, g_iNumEigens+3);
+	size_t numAllocFloats = g_iNumEigens*g_iNumEigens + g_iNumEigens*(g_iNumEigens+3);
+	size_t threadMeansSize = (g_iNumEigens*sizeof(float) + PCA_PAGE_SIZE - 1) & ~(size_t)(PCA_PAGE_SIZE - 1);
+	size_t numThreadMeansBytes = threadMeansSize*totalThreads + PCA_PAGE_SIZE;
 
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 	assert( s_memoryHunk == NULL );
@@ -299,21 +325,41 @@ bool SetupPCA( MDTRA_MainWindow *pMainWindow, const MDTRA_PCAInfo *pInfo, size_t
 		QApplication::restoreOverrideCursor();
 		return false;
 	}
+	assert( s_pThreadMeansHunk == NULL );
+	s_pThreadMeansHunk = (char*)malloc( numThreadMeansBytes );
+	if (!s_pThreadMeansHunk) {
+		free( s_memoryHunk );
+		s_memoryHunk = NULL;
+		if (pOutOfMemSize) *pOutOfMemSize = numThreadMeansBytes;
+		QApplication::restoreOverrideCursor();
+		return false;
+	}
 	memset(s_memoryHunk,0,numAllocFloats*sizeof(float));
 
 	s_pCovarianceMatrix = s_memoryHunk;
 	s_pMeans = s_memoryHunk + g_iNumEigens*g_iNumEigens;
 
+	//per-thread mean buffers are zeroed by the threads that use them,
+	//and summed into s_pMeans when the covariance matrix is finalized
+	char *pThreadMeans = s_pThreadMeansHunk + (PCA_PAGE_SIZE - ((size_t)s_pThreadMeansHunk & (PCA_PAGE_SIZE - 1)));
+	s_ppThreadMeans = new float*[totalThreads];
+	for (int i = 0; i < totalThreads; i++)
+		s_ppThreadMeans[i] = (float*)(pThreadMeans + threadMeansSize*i);
+	ThreadFirstTouch( (void**)s_ppThreadMeans, g_iNumEigens*sizeof(float) );
+
 	g_pEigenValues = s_memoryHunk + g_iNumEigens*g_iNumEigens;
 	g_pEigenVectors = g_pEigenValues + g_iNumEigens;
 	s_pJacobiTemp = g_pEigenVectors + g_iNumEigens*g_iNumEigens;
 
 	//allocate thread memory
+	s_lpcad.tempPDB = new MDTRA_PDB_File*[CountThreads()];
+	memset( s_lpcad.tempPDB, 0, sizeof(MDTRA_PDB_File*) * CountThreads() );
 	for (int i = 0; i < CountThreads(); i++) {
 		s_lpcad.tempPDB[i] = new MDTRA_PDB_File;
 		if (!s_lpcad.tempPDB[i])
 			return false;
 	}
+	s_lpcad.pPrefetch = MDTRA_CreateFramePrefetcher( s_lpcad.pStream, NULL, s_lpcad.workStart, s_lpcad.workStride );
 
 	QApplication::restoreOverrideCursor();
 	return true;
@@ -331,7 +377,7 @@ bool PerformPCA( void )
 	dlgProgress.setCurrentStream( 0 );
 	dlgProgress.setCurrentFile( 0 );
 	
-	RunThreadsOnIndividual( s_lpcad.workCount, f_BuildCovarianceMatrix );
+	RunThreadsOnPrefetched( s_lpcad.workCount, f_BuildCovarianceMatrix, s_lpcad.pPrefetch );
 
 	if (dlgProgress.checkInterrupt())
 		return false;
@@ -374,17 +420,29 @@ void FreePCA( void )
 {
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
-	for (int i = 0; i < CountThreads(); i++) {
-		if (s_lpcad.tempPDB[i]) {
+	if (s_lpcad.tempPDB) {
+		for (int i = 0; i < CountThreads(); i++)
 			delete s_lpcad.tempPDB[i];
-			s_lpcad.tempPDB[i] = NULL;
-		}
+		delete [] s_lpcad.tempPDB;
+		s_lpcad.tempPDB = NULL;
+	}
+	if (s_lpcad.pPrefetch) {
+		delete s_lpcad.pPrefetch;
+		s_lpcad.pPrefetch = NULL;
 	}
 
 	if (s_memoryHunk) {
 		free( s_memoryHunk );
 		s_memoryHunk = NULL;
 	}
+	if (s_ppThreadMeans) {
+		delete [] s_ppThreadMeans;
+		s_ppThreadMeans = NULL;
+	}
+	if (s_pThreadMeansHunk) {
+		free( s_pThreadMeansHunk );
+		s_pThreadMeansHunk = NULL;
+	}
 
 	g_pEigenValues = NULL;
 	g_pEigenVectors = NULL;
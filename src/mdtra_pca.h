@@ -25,6 +25,7 @@ typedef struct stMDTRA_PCAInfo {
 	int		streamIndex;
 	int		trajectoryMin;
 	int		trajectoryMax;
+	int		trajectoryStride;
 	int		selectionSize;
 	int*	selectionData;
 	int		numDisplayPC;
@@ -33,15 +34,22 @@ typedef struct stMDTRA_PCAInfo {
 typedef struct stMDTRA_PCAData
 {
 	int						workStart;
+	int						workStride;
 	int						workCount;
 	int						selectionSize;
 	int*					selectionData;
 	const MDTRA_Stream*		pStream;	
-	MDTRA_PDB_File*			tempPDB[MDTRA_MAX_THREADS];
+	MDTRA_PDB_File**		tempPDB;
+	MDTRA_FramePrefetcher*	pPrefetch;
 } MDTRA_PCAData;
 
 extern bool SetupPCA( MDTRA_MainWindow *pMainWindow, const MDTRA_PCAInfo *pInfo, size_t *pOutOfMemSize );
 extern bool PerformPCA( void );
 extern void FreePCA( void );
 
+//per-snapshot sums over the atoms flagged PDB_FLAG_PCA: coordinates into
+//pMeans (selectionSize*3), products into the upper part of pCovariance
+extern void PCAAccumulateMeans( const MDTRA_PDB_File *pPdbFile, float *pMeans );
+extern void PCAAccumulateCovariance( const MDTRA_PDB_File *pPdbFile, int selectionSize, float *pCovariance );
+
 #endif //MDTRA_PCA_H
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb.h"
 #include "mdtra_select.h"
@@ -64,7 +65,7 @@ MDTRA_PCADialog :: MDTRA_PCADialog( QWidget *parent )
 		MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStream( i );
 		if (pStream && pStream->pdb) {
 			sCombo->addItem( QIcon(":/png/16x16/stream.png"), 
-							 tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()),
+							 tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )),
 							 pStream->index );
 		}
 	}
@@ -112,7 +113,7 @@ void MDTRA_PCADialog :: exec_on_stream_change( void )
 {
 	int streamIndex = sCombo->itemData( sCombo->currentIndex() ).toInt();
 	const MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStreamByIndex( streamIndex );
-	eIndex->setMaximum( pStream->files.count() );
+	eIndex->setMaximum( MDTRA_GetStreamFrameCount( pStream ) );
 }
 
 void MDTRA_PCADialog :: exec_on_selection_editingFinished( void )
@@ -274,10 +275,12 @@ void MDTRA_PCADialog :: exec_on_accept( void )
 
 	//Define trajectory fragment to analyze
 	pInfo->trajectoryMin = 1;
-	pInfo->trajectoryMax = pStream->files.count();
+	pInfo->trajectoryMax = MDTRA_GetStreamFrameCount( pStream );
+	pInfo->trajectoryStride = 1;
 	if (trajectoryRange->isChecked()) {
 		pInfo->trajectoryMin = MDTRA_MAX( pInfo->trajectoryMin, sIndex->value() );
 		pInfo->trajectoryMax = MDTRA_MIN( pInfo->trajectoryMax, eIndex->value() );
+		pInfo->trajectoryStride = sbStride->value();
 	}
 
 	//Define selection
@@ -32,10 +32,13 @@
 #include "mdtra_cuda.h"
 #include "mdtra_math.h"
 #include "mdtra_utils.h"
+#include "mdtra_inputFile.h"
 #include "mdtra_select.h"
 #include "mdtra_sse.h"
+#include "mdtra_avx.h"
 #include "mdtra_SAS.h"
 #include "mdtra_hbSearch.h"
+#include "mdtra_profiler.h"
 
 //-------------------------------------------------------------------------
 // These Standard Reference PDB Frames were taken from 3DNA parameter files
@@ -122,6 +125,7 @@ MDTRA_PDB_File :: MDTRA_PDB_File()
 	m_pResidues = NULL;
 	m_pTempFloats = NULL;
 	memset( m_vecCentroidOrigin, 0, sizeof(m_vecCentroidOrigin) );
+	m_pPackedCoords = NULL;
 }
 
 MDTRA_PDB_File :: MDTRA_PDB_File( int threadnum, unsigned int format, const char *filename, int streamFlags )
@@ -136,6 +140,7 @@ MDTRA_PDB_File :: MDTRA_PDB_File( int threadnum, unsigned int format, const char
 	m_pResidues = NULL;
 	m_pTempFloats = NULL;
 	memset( m_vecCentroidOrigin, 0, sizeof(m_vecCentroidOrigin) );
+	m_pPackedCoords = NULL;
 	load( threadnum, format, filename, streamFlags );
 }
 
@@ -158,6 +163,7 @@ void MDTRA_PDB_File :: unload( void )
 		UTIL_AlignedFree(m_pTempFloats);
 		m_pTempFloats = NULL;
 	}
+	free_packed_coords();
 	m_iNumAtoms = 0;
 	m_iNumLastFlaggedAtoms = 0;
 	m_iNumBackboneAtoms = 0;
@@ -176,6 +182,10 @@ void MDTRA_PDB_File :: reset( void )
 	m_iLastChainIndex = 0;
 	m_bChainTerminator = false;
 	memset( m_vecCentroidOrigin, 0, sizeof(m_vecCentroidOrigin) );
+	if (m_pPackedCoords) {
+		m_pPackedCoords->count = -1;
+		m_pPackedCoords->valid = false;
+	}
 }
 
 void MDTRA_PDB_File :: alloc_floats( int count )
@@ -303,9 +313,9 @@ void MDTRA_PDB_File :: set_atom_flags( int residueFlags, MDTRA_PDB_Atom *pOut )
 	}
 }
 
-bool MDTRA_PDB_File :: read_atom( int threadnum, unsigned int format, const char *linebuf, MDTRA_PDB_Atom *pOut )
+bool MDTRA_PDB_File :: read_atom( int threadnum, unsigned int format, const char *linebuf, int length, MDTRA_PDB_Atom *pOut )
 {
-	if (!g_PDBFormatManager.parse( threadnum, format, linebuf, 
+	if (!g_PDBFormatManager.parse( threadnum, format, linebuf, length, 
 								   &pOut->serialnumber, &pOut->residuenumber, 
 								   pOut->title, pOut->residue,
 								   &pOut->chain, pOut->xyz, pOut->force )) {
@@ -357,47 +367,90 @@ bool MDTRA_PDB_File :: read_atom( int threadnum, unsigned int format, const char
 	return true;
 }
 
+static bool IsSolventResidue( const char *trimmed_residue )
+{
+	return (!_stricmp( trimmed_residue, "HOH" ) ||
+			!_stricmp( trimmed_residue, "H2O" ) ||
+			!_stricmp( trimmed_residue, "WAT" ) ||
+			!_stricmp( trimmed_residue, "CL-" ) ||
+			!_stricmp( trimmed_residue, "NA+" ));
+}
+
+#define PDB_RECORD_OTHER		0
+#define PDB_RECORD_ATOM			1
+#define PDB_RECORD_HETATM		2
+#define PDB_RECORD_TER			3
+#define PDB_RECORD_ENDMDL		4
+
+static inline int GetRecordType( const char *line, int length )
+{
+	//dispatch on the first character, only the candidate record name is compared
+	switch (line[0]) {
+	case 'A':
+	case 'a':
+		if (length >= 6 && !_strnicmp( line, "ATOM  ", 6 )) return PDB_RECORD_ATOM;
+		break;
+	case 'H':
+	case 'h':
+		if (length >= 6 && !_strnicmp( line, "HETATM", 6 )) return PDB_RECORD_HETATM;
+		break;
+	case 'T':
+	case 't':
+		if (length >= 3 && !_strnicmp( line, "TER", 3 )) return PDB_RECORD_TER;
+		break;
+	case 'E':
+	case 'e':
+		if (length >= 6 && !_strnicmp( line, "ENDMDL", 6 )) return PDB_RECORD_ENDMDL;
+		break;
+	default:
+		break;
+	}
+	return PDB_RECORD_OTHER;
+}
+
+//opening (and mapping) the file is charged to I/O, the rest of a load to parsing
+static bool PDB_OpenFile( MDTRA_InputFile *pFile, int threadnum, const char *filename )
+{
+	MDTRA_PROF_SCOPE( "open file", MDTRA_PROF_IO );
+	return pFile->open( threadnum, filename );
+}
+
 bool MDTRA_PDB_File :: load( int threadnum, unsigned int format, const char *filename, int streamFlags )
 {
-	FILE *fp = NULL;
-	if (fopen_s( &fp, filename, "r" )) {
+	MDTRA_PROF_SCOPE( "parse frame", MDTRA_PROF_PARSE );
+	MDTRA_InputFile file;
+	if (!PDB_OpenFile( &file, threadnum, filename )) {
 		return false;
 	}
 
 	reset();
 
-	char linebuf[82];
+	const char *pLine;
+	int lineLength;
 	int lastresnum = -1;
 	m_iFirstResidue = -1;
 
 	int fIgnoreHetatm = streamFlags & STREAM_FLAG_IGNORE_HETATM;
 	int fIgnoreSolvent = streamFlags & STREAM_FLAG_IGNORE_SOLVENT;
 
-	while ( !feof(fp) ) {
-		linebuf[0] = 0;
-		if (!fgets( linebuf, 82, fp )) break;
-		if (!_strnicmp( linebuf, "ATOM  ", 6 ) || 
-			( !fIgnoreHetatm && !_strnicmp( linebuf, "HETATM", 6 ) ) ) {
+	//lines are parsed in place, straight into the atom buffer
+	while ( (pLine = file.getLine( &lineLength )) != NULL ) {
+		int recordType = GetRecordType( pLine, lineLength );
+		if (recordType == PDB_RECORD_ENDMDL) break;	//only the first model of multi-model files
+		if (recordType == PDB_RECORD_ATOM || ( !fIgnoreHetatm && recordType == PDB_RECORD_HETATM )) {
 			//parse atom
 			if (!ensure_atom_buffer_size()) {
-				fclose( fp );
+				file.close();
 				reset();
 				return false;
 			}
-			if (!read_atom( threadnum, format, linebuf, m_pAtoms + m_iNumAtoms )) {
-				fclose( fp );
+			if (!read_atom( threadnum, format, pLine, lineLength, m_pAtoms + m_iNumAtoms )) {
+				file.close();
 				reset();
 				return false;
 			}
-			if ( fIgnoreSolvent ) {
-				if (!_stricmp( m_pAtoms[m_iNumAtoms].trimmed_residue, "HOH" ) ||
-					!_stricmp( m_pAtoms[m_iNumAtoms].trimmed_residue, "H2O" ) ||
-					!_stricmp( m_pAtoms[m_iNumAtoms].trimmed_residue, "WAT" ) ||
-					!_stricmp( m_pAtoms[m_iNumAtoms].trimmed_residue, "CL-" ) ||
-					!_stricmp( m_pAtoms[m_iNumAtoms].trimmed_residue, "NA+" )) {
-					continue;
-				}
-			}
+			if ( fIgnoreSolvent && IsSolventResidue( m_pAtoms[m_iNumAtoms].trimmed_residue ) )
+				continue;
 			if (lastresnum != m_pAtoms[m_iNumAtoms].residuenumber) {
 				lastresnum = m_pAtoms[m_iNumAtoms].residuenumber;
 				if ( m_iFirstResidue < 0 )
@@ -406,40 +459,186 @@ bool MDTRA_PDB_File :: load( int threadnum, unsigned int format, const char *fil
 			}
 			m_pAtoms[m_iNumAtoms].residueserial = m_iNumResidues;
 			m_iNumAtoms++;
-		} else if (!_strnicmp( linebuf, "TER", 3 )) {
+		} else if (recordType == PDB_RECORD_TER) {
 			m_bChainTerminator = true;
-		} else {
-			printf( linebuf );
 		}
 	}
-	fclose( fp );
+	file.close();
 	set_flags();
 	return true;
 }
 
-bool MDTRA_PDB_File :: load( const MDTRA_PDB_File* pOther )
+bool MDTRA_PDB_File :: copy_topology( const MDTRA_PDB_File* pOther )
 {
 	reset();
 
 	m_iNumAtoms = pOther->getAtomCount();
 	m_iNumResidues = pOther->getResidueCount();
 
-	m_iMaxAtoms = m_iNumAtoms;
-	m_pAtoms = (MDTRA_PDB_Atom*)UTIL_AlignedMalloc(m_iMaxAtoms * sizeof(MDTRA_PDB_Atom));
+	//reuse atom and residue buffers if they are large enough
+	if (m_iMaxAtoms < m_iNumAtoms) {
+		if (m_pAtoms) UTIL_AlignedFree( m_pAtoms );
+		m_iMaxAtoms = m_iNumAtoms;
+		m_pAtoms = (MDTRA_PDB_Atom*)UTIL_AlignedMalloc(m_iMaxAtoms * sizeof(MDTRA_PDB_Atom));
+		if (!m_pAtoms) {
+			m_iMaxAtoms = 0;
+			reset();
+			return false;
+		}
+	}
 	memcpy( m_pAtoms, pOther->m_pAtoms, sizeof(MDTRA_PDB_Atom)*m_iNumAtoms);
 
-	m_iFirstResidue = pOther->m_iFirstResidue;
-	m_iMaxResidues = m_iNumResidues;
-	m_pResidues = (int*)UTIL_AlignedMalloc( m_iMaxResidues * sizeof(int) );
-	memcpy( m_pResidues, pOther->m_pResidues, sizeof(int)*m_iNumResidues);
+	if (m_iMaxResidues < m_iNumResidues) {
+		if (m_pResidues) UTIL_AlignedFree( m_pResidues );
+		m_iMaxResidues = m_iNumResidues;
+		m_pResidues = (int*)UTIL_AlignedMalloc( m_iMaxResidues * sizeof(int) );
+		if (!m_pResidues) {
+			m_iMaxResidues = 0;
+			reset();
+			return false;
+		}
+	}
+	if (m_iNumResidues > 0)
+		memcpy( m_pResidues, pOther->m_pResidues, sizeof(int)*m_iNumResidues);
 
+	m_iFirstResidue = pOther->m_iFirstResidue;
 	m_iNumLastFlaggedAtoms = pOther->m_iNumLastFlaggedAtoms;
 	m_iNumBackboneAtoms = pOther->m_iNumBackboneAtoms;
 	memcpy( m_vecCentroidOrigin, pOther->m_vecCentroidOrigin, sizeof(m_vecCentroidOrigin) );
 
+	//the backbone index list depends on topology only
+	if (pOther->m_pPackedCoords && pOther->m_pPackedCoords->count >= 0 && alloc_packed_coords( pOther->m_pPackedCoords->count ))
+		memcpy( m_pPackedCoords->index, pOther->m_pPackedCoords->index, sizeof(int)*m_pPackedCoords->count );
+
+	return true;
+}
+
+bool MDTRA_PDB_File :: load( const MDTRA_PDB_File* pOther )
+{
+	return copy_topology( pOther );
+}
+
+bool MDTRA_PDB_File :: loadCoordinates( int threadnum, unsigned int format, const char *filename, int streamFlags, const MDTRA_PDB_File* pTopology )
+{
+	//topology (titles, residues, radii, flags) is taken from the first stream frame,
+	//only coordinates and forces are parsed from the file
+	if (!pTopology || pTopology == this)
+		return load( threadnum, format, filename, streamFlags );
+
+	MDTRA_PROF_SCOPE( "parse coordinates", MDTRA_PROF_PARSE );
+	MDTRA_InputFile file;
+	if (!PDB_OpenFile( &file, threadnum, filename )) {
+		return false;
+	}
+
+	if (!copy_topology( pTopology )) {
+		file.close();
+		return false;
+	}
+	memset( m_vecCentroidOrigin, 0, sizeof(m_vecCentroidOrigin) );
+
+	const char *pLine;
+	int lineLength;
+	char residue[81];
+	int serialnumber;
+	int iAtom = 0;
+	bool bMismatch = false;
+
+	int fIgnoreHetatm = streamFlags & STREAM_FLAG_IGNORE_HETATM;
+	int fIgnoreSolvent = streamFlags & STREAM_FLAG_IGNORE_SOLVENT;
+
+	while ( (pLine = file.getLine( &lineLength )) != NULL ) {
+		int recordType = GetRecordType( pLine, lineLength );
+		if (recordType == PDB_RECORD_ENDMDL) break;	//only the first model of multi-model files
+		if (recordType != PDB_RECORD_ATOM && ( fIgnoreHetatm || recordType != PDB_RECORD_HETATM ))
+			continue;
+
+		if ( fIgnoreSolvent ) {
+			if (!g_PDBFormatManager.parse( threadnum, format, pLine, lineLength, NULL, NULL, NULL, residue, NULL, NULL, NULL )) {
+				bMismatch = true;
+				break;
+			}
+			char *p = residue;
+			while (*p && isspace(*p)) p++;
+			char *e = p + strlen(p) - 1;
+			while (e >= p && isspace(*e)) { *e = 0; e--; }
+			if ( IsSolventResidue( p ) )
+				continue;
+		}
+
+		if ( iAtom >= m_iNumAtoms ) {
+			bMismatch = true;
+			break;
+		}
+
+		MDTRA_PDB_Atom *pAt = m_pAtoms + iAtom;
+		if (!g_PDBFormatManager.parse( threadnum, format, pLine, lineLength, &serialnumber, NULL, NULL, NULL, NULL, pAt->xyz, pAt->force ) ||
+			serialnumber != pAt->serialnumber ) {
+			bMismatch = true;
+			break;
+		}
+
+		pAt->xyz[3] = 0.0f;
+		memcpy( pAt->xyz2, pAt->xyz, sizeof(pAt->xyz) );
+		memcpy( pAt->original_xyz, pAt->xyz, sizeof(pAt->xyz) );
+		iAtom++;
+	}
+	file.close();
+
+	if ( bMismatch || iAtom != m_iNumAtoms ) {
+		//frame does not match the topology, perform full load
+		return load( threadnum, format, filename, streamFlags );
+	}
+
 	return true;
 }
 
+bool MDTRA_PDB_File :: load_coords( const MDTRA_PDB_File* pTopology, const float *pCoords, const float *pForces )
+{
+	//take atoms from topology and replace coordinates (and forces, if given)
+	//the result is identical to loading the frame from PDB file
+	if (pTopology != this && !copy_topology( pTopology ))
+		return false;
+
+	memset( m_vecCentroidOrigin, 0, sizeof(m_vecCentroidOrigin) );
+	if (m_pPackedCoords) m_pPackedCoords->valid = false;
+
+	MDTRA_PDB_Atom *pAt = m_pAtoms;
+	for (int i = 0; i < m_iNumAtoms; i++, pAt++, pCoords += 3) {
+		pAt->xyz[0] = pCoords[0];
+		pAt->xyz[1] = pCoords[1];
+		pAt->xyz[2] = pCoords[2];
+		pAt->xyz[3] = 0.0f;
+		memcpy( pAt->xyz2, pAt->xyz, sizeof(pAt->xyz) );
+		memcpy( pAt->original_xyz, pAt->xyz, sizeof(pAt->xyz) );
+		if (pForces) {
+			pAt->force[0] = pForces[0];
+			pAt->force[1] = pForces[1];
+			pAt->force[2] = pForces[2];
+			pForces += 3;
+		}
+	}
+
+	return true;
+}
+
+void MDTRA_PDB_File :: get_coords( float *pCoords, float *pForces ) const
+{
+	//original (not centered) coordinates are returned
+	const MDTRA_PDB_Atom *pAt = m_pAtoms;
+	for (int i = 0; i < m_iNumAtoms; i++, pAt++, pCoords += 3) {
+		pCoords[0] = pAt->original_xyz[0];
+		pCoords[1] = pAt->original_xyz[1];
+		pCoords[2] = pAt->original_xyz[2];
+		if (pForces) {
+			pForces[0] = pAt->force[0];
+			pForces[1] = pAt->force[1];
+			pForces[2] = pAt->force[2];
+			pForces += 3;
+		}
+	}
+}
+
 static const char *ftos83_local_independent( float f )
 {
 	static char m_floatBuffer[8][16];
@@ -553,6 +752,7 @@ int MDTRA_PDB_File :: fetchAtomIndexByDesc( int chain, int resnum, const char *a
 
 void MDTRA_PDB_File :: clear_coords( void )
 {
+	if (m_pPackedCoords) m_pPackedCoords->valid = false;
 	for (int i = 0; i < m_iNumAtoms; i++) {
 		m_pAtoms[i].xyz[0] = 0;
 		m_pAtoms[i].xyz[1] = 0;
@@ -565,6 +765,7 @@ void MDTRA_PDB_File :: average_coords( const MDTRA_PDB_File *pOther, float scale
 	if (pOther->m_iNumAtoms != m_iNumAtoms)
 		return;
 
+	if (m_pPackedCoords) m_pPackedCoords->valid = false;
 	for (int i = 0; i < m_iNumAtoms; i++) {
 		m_pAtoms[i].xyz[0] += pOther->m_pAtoms[i].xyz[0] * scale;
 		m_pAtoms[i].xyz[1] += pOther->m_pAtoms[i].xyz[1] * scale;
@@ -582,6 +783,15 @@ void MDTRA_PDB_File :: finalize_coords( void )
 
 void MDTRA_PDB_File :: move_to_centroid( void )
 {
+	MDTRA_PROF_SCOPE( "move to centroid", MDTRA_PROF_ALIGN );
+#if defined(MDTRA_ALLOW_AVX2)
+	if (g_bAllowSSE && g_bSupportsAVX2 && ((m_pPackedCoords && m_pPackedCoords->valid) || pack_coords())) {
+		move_to_centroid_packed();
+		return;
+	}
+#endif
+	if (m_pPackedCoords) m_pPackedCoords->valid = false;
+
 	XMM_FLOAT centroid_origin[4];
 	*(int*)&centroid_origin[0] = 0;
 	*(int*)&centroid_origin[1] = 0;
@@ -631,6 +841,7 @@ void MDTRA_PDB_File :: move_to_centroid( void )
 
 void MDTRA_PDB_File :: move_to_centroid2( void )
 {
+	MDTRA_PROF_SCOPE( "move to centroid", MDTRA_PROF_ALIGN );
 	XMM_FLOAT centroid_origin[4];
 	*(int*)&centroid_origin[0] = 0;
 	*(int*)&centroid_origin[1] = 0;
@@ -887,17 +1098,84 @@ void MDTRA_PDB_File :: eigsrt4( float *d, float *v ) const
 	}
 }
 
+//Builds the Kabsch rotation matrix from the R-matrix (3x4, rows padded to XMM vectors)
+//uMatrix is 3x3, new xyz[j] = sum of xyz[i] * uMatrix[i*3+j]
+bool MDTRA_PDB_File :: kabsch_rotation( const float *rMatrix, float *uMatrix ) const
+{
+	XMM_FLOAT rtrMatrix[12];
+
+	//Build RtR-matrix
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			rtrMatrix[i*4+j] = rMatrix[0*4+i]*rMatrix[0*4+j] + rMatrix[1*4+i]*rMatrix[1*4+j] + rMatrix[2*4+i]*rMatrix[2*4+j];
+		}
+	}
+
+	//Get eigenvalues
+	XMM_FLOAT eVal[4];
+	XMM_FLOAT eVec[12];
+
+	if (!jacobi3( rtrMatrix, eVal, eVec ))
+		return false;
+	eigsrt3( eVal, eVec );
+
+	//eVec2 = eVec0 x eVec1
+	eVec[2*4+0] = eVec[0*4+1]*eVec[1*4+2] - eVec[0*4+2]*eVec[1*4+1];
+	eVec[2*4+1] = eVec[0*4+2]*eVec[1*4+0] - eVec[0*4+0]*eVec[1*4+2];
+	eVec[2*4+2] = eVec[0*4+0]*eVec[1*4+1] - eVec[0*4+1]*eVec[1*4+0];
+
+	//Calculate B-vectors
+	XMM_FLOAT bVec[12];
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			bVec[j*4+i] = rMatrix[i*4+0]*eVec[j*4+0] + rMatrix[i*4+1]*eVec[j*4+1] + rMatrix[i*4+2]*eVec[j*4+2];
+			if(j < 2) bVec[j*4+i] /= sqrtf(eVal[j]);
+		}
+	}
+
+	float bVecTemp[3];
+
+	//bVecTemp = bVec0 x bVec1
+	bVecTemp[0] = bVec[0*4+1]*bVec[1*4+2] - bVec[0*4+2]*bVec[1*4+1];
+	bVecTemp[1] = bVec[0*4+2]*bVec[1*4+0] - bVec[0*4+0]*bVec[1*4+2];
+	bVecTemp[2] = bVec[0*4+0]*bVec[1*4+1] - bVec[0*4+1]*bVec[1*4+0];
+
+	//adjust rotation
+	float s = ((bVecTemp[0] * bVec[2*4+0] + bVecTemp[1] * bVec[2*4+1] + bVecTemp[2] * bVec[2*4+2]) < 0.0f) ? (-1.0f) : (1.0f);
+	bVec[2*4+0] = s * bVecTemp[0];
+	bVec[2*4+1] = s * bVecTemp[1];
+	bVec[2*4+2] = s * bVecTemp[2];
+
+	//Calculate rotation matrix
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			uMatrix[i*3+j] = bVec[0*4+i]*eVec[0*4+j] + bVec[1*4+i]*eVec[1*4+j] + bVec[2*4+i]*eVec[2*4+j];
+		}
+	}
+
+	return true;
+}
+
 void MDTRA_PDB_File :: align_kabsch( const MDTRA_PDB_File *pOther )
 {
+	MDTRA_PROF_SCOPE( "align kabsch", MDTRA_PROF_ALIGN );
 	if (m_iNumBackboneAtoms < 2)
 		return;
 
+#if defined(MDTRA_ALLOW_AVX2)
+	if (use_packed_coords( pOther )) {
+		align_kabsch_packed( pOther );
+		return;
+	}
+#endif
+	if (m_pPackedCoords) m_pPackedCoords->valid = false;
+
 #if defined(MDTRA_ALLOW_SSE)
 	int sizeof_pdb_atom = sizeof(MDTRA_PDB_Atom);
 #endif
 
 	XMM_FLOAT rMatrix[12];
-	XMM_FLOAT rtrMatrix[12];
 
 	memset( rMatrix, 0, sizeof(rMatrix) );
 
@@ -914,78 +1192,21 @@ void MDTRA_PDB_File :: align_kabsch( const MDTRA_PDB_File *pOther )
 				}
 			}
 		}
-
-		//Build RtR-matrix
-		for (int i = 0; i < 3; i++) {
-			for (int j = 0; j < 3; j++) {
-				rtrMatrix[i*4+j] = rMatrix[0*4+i]*rMatrix[0*4+j] + rMatrix[1*4+i]*rMatrix[1*4+j] + rMatrix[2*4+i]*rMatrix[2*4+j];
-			}
-		}
 #if defined(MDTRA_ALLOW_SSE)
 	} else {
+		//the macro also builds the RtR-matrix, kabsch_rotation rebuilds it from rMatrix
+		XMM_FLOAT rtrMatrix[12];
 		SSE_PDB_CALC_RTR_MATRIX(MDTRA_PDB_Atom, xyz, PDB_FLAG_BACKBONE);
 	}
 #endif
 
-	//Get eigenvalues
-	XMM_FLOAT eVal[4];
-	XMM_FLOAT eVec[12];
-
-	if (!jacobi3( rtrMatrix, eVal, eVec ))
+	float uMatrix[9];
+	if (!kabsch_rotation( rMatrix, uMatrix ))
 		return;
-	eigsrt3( eVal, eVec );
-
-/*
-	// SSE version is NOT optimal
-#if defined(MDTRA_ALLOW_SSE)
-	if (!g_bAllowSSE) {
-#endif*/
-		//eVec2 = eVec0 x eVec1
-		eVec[2*4+0] = eVec[0*4+1]*eVec[1*4+2] - eVec[0*4+2]*eVec[1*4+1];
-		eVec[2*4+1] = eVec[0*4+2]*eVec[1*4+0] - eVec[0*4+0]*eVec[1*4+2];
-		eVec[2*4+2] = eVec[0*4+0]*eVec[1*4+1] - eVec[0*4+1]*eVec[1*4+0];
-/*#if defined(MDTRA_ALLOW_SSE)
-	} else {
-		SSE_PDB_CALC_EVEC2();
-	}
-#endif*/
-
-	//Calculate B-vectors
-	XMM_FLOAT bVec[12];
-
-	for (int i = 0; i < 3; i++) {
-		for (int j = 0; j < 3; j++) {
-			bVec[j*4+i] = rMatrix[i*4+0]*eVec[j*4+0] + rMatrix[i*4+1]*eVec[j*4+1] + rMatrix[i*4+2]*eVec[j*4+2];
-			if(j < 2) bVec[j*4+i] /= sqrtf(eVal[j]);
-		}
-	}
 
 #if defined(MDTRA_ALLOW_SSE) && defined(WIN32)
 	if (!g_bAllowSSE) {
 #endif
-		float bVecTemp[3];
-
-		//bVecTemp = bVec0 x bVec1
-		bVecTemp[0] = bVec[0*4+1]*bVec[1*4+2] - bVec[0*4+2]*bVec[1*4+1];
-		bVecTemp[1] = bVec[0*4+2]*bVec[1*4+0] - bVec[0*4+0]*bVec[1*4+2];
-		bVecTemp[2] = bVec[0*4+0]*bVec[1*4+1] - bVec[0*4+1]*bVec[1*4+0];
-
-		//adjust rotation
-		float s = ((bVecTemp[0] * bVec[2*4+0] + bVecTemp[1] * bVec[2*4+1] + bVecTemp[2] * bVec[2*4+2]) < 0.0f) ? (-1.0f) : (1.0f);
-		bVec[2*4+0] = s * bVecTemp[0];
-		bVec[2*4+1] = s * bVecTemp[1];
-		bVec[2*4+2] = s * bVecTemp[2];
-
-		//Calculate rotation matrix
-		float uMatrix[9];
-		memset( uMatrix, 0, sizeof(uMatrix) );
-
-		for (int i = 0; i < 3; i++) {
-			for (int j = 0; j < 3; j++) {
-				uMatrix[i*3+j] = bVec[0*4+i]*eVec[0*4+j] + bVec[1*4+i]*eVec[1*4+j] + bVec[2*4+i]*eVec[2*4+j];
-			}
-		}
-
 		//Transform coords
 		float oldCoord[3];
 		for (int i = 0; i < m_iNumAtoms; i++) {
@@ -998,92 +1219,25 @@ void MDTRA_PDB_File :: align_kabsch( const MDTRA_PDB_File *pOther )
 		}
 #if defined(MDTRA_ALLOW_SSE) && defined(WIN32)
 	} else {
-		XMM_FLOAT flt_zero[4];
-		*(int*)&flt_zero[0] = 0;
-		*(int*)&flt_zero[1] = 0;
-		*(int*)&flt_zero[2] = 0;
+		//rotation matrix rows padded to XMM vectors
+		XMM_FLOAT uRows[12];
+		for (int i = 0; i < 3; i++) {
+			uRows[i*4+0] = uMatrix[i*3+0];
+			uRows[i*4+1] = uMatrix[i*3+1];
+			uRows[i*4+2] = uMatrix[i*3+2];
+			uRows[i*4+3] = 0.0f;
+		}
 
 		_asm 
 		{
-			movaps	xmm0, xmmword ptr[bVec+0]
-			movaps	xmm1, xmmword ptr[bVec+16]
-			movaps	xmm4, xmmword ptr[bVec+32]
-			movaps	xmm2, xmm0
-			movaps	xmm3, xmm1
-			shufps	xmm0, xmm0, 11001001b
-			shufps	xmm1, xmm1, 11010010b
-			mulps	xmm0, xmm1
-			shufps	xmm2, xmm2, 11010010b
-			shufps	xmm3, xmm3, 11001001b
-			mulps	xmm2, xmm3
-			subps	xmm0, xmm2
-
-			mulps	xmm4, xmm0
-			movaps	xmm5, xmm4
-			shufps	xmm5, xmm5, 11100001b
-			addss	xmm4, xmm5
-			shufps	xmm5, xmm5, 11100110b
-			addss	xmm4, xmm5
-
-			comiss	xmm4, flt_zero
-			jnz		dont_negate
-			movaps	xmm2, xmm0
-			movaps	xmm0, xmmword ptr[flt_zero]
-			subps	xmm0, xmm2
-
-	dont_negate:
-			movaps	xmmword ptr[bVec+32], xmm0
-
 			mov		esi, DWORD PTR[this]
 			mov		ecx, DWORD PTR[esi].m_iNumAtoms
 			mov		edx, DWORD PTR[esi].m_pAtoms
 			xor		eax, eax
 
-			movaps	xmm3, xmmword ptr[eVec+0]
-			movaps	xmm4, xmmword ptr[eVec+16]
-			movaps	xmm5, xmmword ptr[eVec+32]
-
-			movaps	xmm0, xmmword ptr[bVec+0]
-			shufps	xmm0, xmm0, 00000000b
-			mulps	xmm0, xmm3
-			movaps	xmm7, xmmword ptr[bVec+16]
-			shufps	xmm7, xmm7, 00000000b
-			movaps	xmm6, xmm4
-			mulps	xmm6, xmm7
-			addps	xmm0, xmm6
-			movaps	xmm7, xmmword ptr[bVec+32]
-			shufps	xmm7, xmm7, 00000000b
-			movaps	xmm6, xmm5
-			mulps	xmm6, xmm7
-			addps	xmm0, xmm6
-
-			movaps	xmm1, xmmword ptr[bVec+0]
-			shufps	xmm1, xmm1, 01010101b
-			mulps	xmm1, xmm3
-			movaps	xmm7, xmmword ptr[bVec+16]
-			shufps	xmm7, xmm7, 01010101b
-			movaps	xmm6, xmm4
-			mulps	xmm6, xmm7
-			addps	xmm1, xmm6
-			movaps	xmm7, xmmword ptr[bVec+32]
-			shufps	xmm7, xmm7, 01010101b
-			movaps	xmm6, xmm5
-			mulps	xmm6, xmm7
-			addps	xmm1, xmm6
-
-			movaps	xmm2, xmmword ptr[bVec+0]
-			shufps	xmm2, xmm2, 10101010b
-			mulps	xmm2, xmm3
-			movaps	xmm7, xmmword ptr[bVec+16]
-			shufps	xmm7, xmm7, 10101010b
-			movaps	xmm6, xmm4
-			mulps	xmm6, xmm7
-			addps	xmm2, xmm6
-			movaps	xmm7, xmmword ptr[bVec+32]
-			shufps	xmm7, xmm7, 10101010b
-			movaps	xmm6, xmm5
-			mulps	xmm6, xmm7
-			addps	xmm2, xmm6
+			movaps	xmm0, xmmword ptr[uRows+0]
+			movaps	xmm1, xmmword ptr[uRows+16]
+			movaps	xmm2, xmmword ptr[uRows+32]
 
 	transform_more:
 			movaps	xmm3, xmmword ptr[edx+eax].xyz
@@ -1107,6 +1261,7 @@ void MDTRA_PDB_File :: align_kabsch( const MDTRA_PDB_File *pOther )
 
 void MDTRA_PDB_File :: align_kabsch2( const MDTRA_PDB_File *pOther )
 {
+	MDTRA_PROF_SCOPE( "align kabsch", MDTRA_PROF_ALIGN );
 	if (pOther->m_iNumAtoms != m_iNumAtoms)
 		return;
 
@@ -1337,6 +1492,11 @@ float MDTRA_PDB_File :: get_rmsd( const MDTRA_PDB_File *pOther ) const
 	if (pOther->m_iNumAtoms != m_iNumAtoms)
 		return -1.0f;
 
+#if defined(MDTRA_ALLOW_AVX2)
+	if (use_packed_coords( pOther ))
+		return get_rmsd_packed( pOther );
+#endif
+
 	XMM_FLOAT inv_num_atoms = 1.0f / m_iNumBackboneAtoms;
 
 #if defined(MDTRA_ALLOW_SSE)
@@ -1361,6 +1521,154 @@ float MDTRA_PDB_File :: get_rmsd( const MDTRA_PDB_File *pOther ) const
 #endif
 }
 
+bool MDTRA_PDB_File :: alloc_packed_coords( int count )
+{
+	if (!m_pPackedCoords) {
+		m_pPackedCoords = new MDTRA_PackedCoords;
+		if (!m_pPackedCoords)
+			return false;
+		memset( m_pPackedCoords, 0, sizeof(MDTRA_PackedCoords) );
+		m_pPackedCoords->count = -1;
+	}
+	if (m_pPackedCoords->maxCount < count || !m_pPackedCoords->index) {
+		if (m_pPackedCoords->index) {
+			UTIL_AlignedFree( m_pPackedCoords->index );
+			m_pPackedCoords->index = NULL;
+			m_pPackedCoords->maxCount = 0;
+		}
+		//round up to whole AVX vectors
+		int maxCount = (count + 7) & ~7;
+		if (!maxCount) maxCount = 8;
+		m_pPackedCoords->index = (int*)UTIL_AlignedMalloc( maxCount * (sizeof(int) + 3 * sizeof(float)) );
+		if (!m_pPackedCoords->index)
+			return false;
+		m_pPackedCoords->maxCount = maxCount;
+		m_pPackedCoords->x = (float*)(m_pPackedCoords->index + maxCount);
+		m_pPackedCoords->y = m_pPackedCoords->x + maxCount;
+		m_pPackedCoords->z = m_pPackedCoords->y + maxCount;
+	}
+	m_pPackedCoords->count = count;
+	m_pPackedCoords->valid = false;
+	return true;
+}
+
+void MDTRA_PDB_File :: free_packed_coords( void )
+{
+	if (!m_pPackedCoords)
+		return;
+	if (m_pPackedCoords->index)
+		UTIL_AlignedFree( m_pPackedCoords->index );
+	delete m_pPackedCoords;
+	m_pPackedCoords = NULL;
+}
+
+bool MDTRA_PDB_File :: build_packed_index( void )
+{
+	int count = 0;
+	for (int i = 0; i < m_iNumAtoms; i++) {
+		if (m_pAtoms[i].atomFlags & PDB_FLAG_BACKBONE)
+			count++;
+	}
+
+	if (!alloc_packed_coords( count ))
+		return false;
+
+	int *pIndex = m_pPackedCoords->index;
+	for (int i = 0; i < m_iNumAtoms; i++) {
+		if (m_pAtoms[i].atomFlags & PDB_FLAG_BACKBONE)
+			*pIndex++ = i;
+	}
+	return true;
+}
+
+bool MDTRA_PDB_File :: pack_coords( void )
+{
+	if ((!m_pPackedCoords || m_pPackedCoords->count < 0) && !build_packed_index())
+		return false;
+
+	const int *pIndex = m_pPackedCoords->index;
+	for (int i = 0; i < m_pPackedCoords->count; i++) {
+		const MDTRA_PDB_Atom *pAt = m_pAtoms + pIndex[i];
+		m_pPackedCoords->x[i] = pAt->xyz[0];
+		m_pPackedCoords->y[i] = pAt->xyz[1];
+		m_pPackedCoords->z[i] = pAt->xyz[2];
+	}
+	m_pPackedCoords->valid = true;
+	return true;
+}
+
+//the other file is shared between worker threads, so it cannot be packed here:
+//it was packed when it was moved to its centroid
+bool MDTRA_PDB_File :: use_packed_coords( const MDTRA_PDB_File *pOther ) const
+{
+#if defined(MDTRA_ALLOW_AVX2)
+	if (!g_bAllowSSE || !g_bSupportsAVX2)
+		return false;
+	if (!m_pPackedCoords || !pOther->m_pPackedCoords)
+		return false;
+	return ( m_pPackedCoords->valid && pOther->m_pPackedCoords->valid &&
+			 m_pPackedCoords->count == pOther->m_pPackedCoords->count );
+#else
+	return false;
+#endif
+}
+
+void MDTRA_PDB_File :: move_to_centroid_packed( void )
+{
+#if defined(MDTRA_ALLOW_AVX2)
+	float centroid_origin[3];
+	memset( centroid_origin, 0, sizeof(centroid_origin) );
+
+	if (m_pPackedCoords->count > 0) {
+		float inv_num_atoms = 1.0f / m_pPackedCoords->count;
+		AVX_PackedSum( m_pPackedCoords->x, m_pPackedCoords->y, m_pPackedCoords->z, m_pPackedCoords->count, centroid_origin );
+		centroid_origin[0] *= inv_num_atoms;
+		centroid_origin[1] *= inv_num_atoms;
+		centroid_origin[2] *= inv_num_atoms;
+	}
+
+	AVX_AtomsTranslate( m_pAtoms->xyz, m_iNumAtoms, sizeof(MDTRA_PDB_Atom), centroid_origin );
+	AVX_PackedTranslate( m_pPackedCoords->x, m_pPackedCoords->y, m_pPackedCoords->z, m_pPackedCoords->count, centroid_origin );
+
+	memcpy( m_vecCentroidOrigin, centroid_origin, sizeof(m_vecCentroidOrigin) );
+#endif
+}
+
+void MDTRA_PDB_File :: align_kabsch_packed( const MDTRA_PDB_File *pOther )
+{
+#if defined(MDTRA_ALLOW_AVX2)
+	XMM_FLOAT rMatrix[12];
+
+	//Build R-matrix
+	AVX_PackedCovariance( m_pPackedCoords->x, m_pPackedCoords->y, m_pPackedCoords->z,
+						  pOther->m_pPackedCoords->x, pOther->m_pPackedCoords->y, pOther->m_pPackedCoords->z,
+						  m_pPackedCoords->count, rMatrix );
+
+	float uMatrix[9];
+	if (!kabsch_rotation( rMatrix, uMatrix ))
+		return;
+
+	//Transform coords, the packed copy stays in sync
+	AVX_AtomsTransform( m_pAtoms->xyz, m_iNumAtoms, sizeof(MDTRA_PDB_Atom), uMatrix );
+	AVX_PackedTransform( m_pPackedCoords->x, m_pPackedCoords->y, m_pPackedCoords->z, m_pPackedCoords->count, uMatrix );
+#endif
+}
+
+float MDTRA_PDB_File :: get_rmsd_packed( const MDTRA_PDB_File *pOther ) const
+{
+#if defined(MDTRA_ALLOW_AVX2)
+	if (!m_pPackedCoords->count)
+		return 0.0f;
+
+	float flRMSD = AVX_PackedSquaredDeviation( m_pPackedCoords->x, m_pPackedCoords->y, m_pPackedCoords->z,
+											   pOther->m_pPackedCoords->x, pOther->m_pPackedCoords->y, pOther->m_pPackedCoords->z,
+											   m_pPackedCoords->count );
+	return sqrtf( flRMSD / m_pPackedCoords->count );
+#else
+	return 0.0f;
+#endif
+}
+
 void MDTRA_PDB_File :: get_rmsd_of_residues( const MDTRA_PDB_File *pOther, float *pOutData ) const
 {
 	//TODO: SSE version
@@ -55,6 +55,20 @@ typedef struct stMDTRA_PDB_Atom
 	char		trimmed_residue[5];
 } MDTRA_PDB_Atom;
 
+//Packed structure-of-arrays copy of the backbone coordinates
+//The alignment and RMSD kernels read it instead of striding through whole
+//atoms and testing their flags
+typedef struct stMDTRA_PackedCoords
+{
+	int			count;		//number of packed atoms, -1 until the index list is built
+	int			maxCount;
+	int*		index;		//atom index of each packed slot
+	float*		x;
+	float*		y;
+	float*		z;
+	bool		valid;		//coordinates match the atoms
+} MDTRA_PackedCoords;
+
 template<typename T> class MDTRA_SelectionSet;
 
 class MDTRA_PDB_File
@@ -66,6 +80,9 @@ public:
 
 	bool load( int threadnum, unsigned int format, const char *filename, int streamFlags );
 	bool load( const MDTRA_PDB_File* pOther );
+	bool loadCoordinates( int threadnum, unsigned int format, const char *filename, int streamFlags, const MDTRA_PDB_File* pTopology );
+	bool load_coords( const MDTRA_PDB_File* pTopology, const float *pCoords, const float *pForces );
+	void get_coords( float *pCoords, float *pForces ) const;
 	bool save( const char *filename );
 	void unload( void );
 	void reset( void );
@@ -129,7 +146,8 @@ public:
 
 protected:
 	bool ensure_atom_buffer_size( void );
-	bool read_atom( int threadnum, unsigned int format, const char *linebuf, MDTRA_PDB_Atom *pOut );
+	bool copy_topology( const MDTRA_PDB_File* pOther );
+	bool read_atom( int threadnum, unsigned int format, const char *linebuf, int length, MDTRA_PDB_Atom *pOut );
 	void set_atom_flags( int residueFlags, MDTRA_PDB_Atom *pOut );
 	void set_flags( void );
 	bool jacobi3( float *matrix, float *d, float *v ) const;
@@ -137,8 +155,18 @@ protected:
 	void eigsrt3( float *d, float *v ) const;
 	void eigsrt4( float *d, float *v ) const;
 	const MDTRA_SRFDef* get_residue_SRFDef( const char *residueTitle ) const;
+	bool alloc_packed_coords( int count );
+	void free_packed_coords( void );
+	bool build_packed_index( void );
+	bool pack_coords( void );
+	bool use_packed_coords( const MDTRA_PDB_File *pOther ) const;
+	void move_to_centroid_packed( void );
+	void align_kabsch_packed( const MDTRA_PDB_File *pOther );
+	float get_rmsd_packed( const MDTRA_PDB_File *pOther ) const;
 
 private:
+	bool kabsch_rotation( const float *rMatrix, float *uMatrix ) const;
+
 	int					m_iNumAtoms;
 	int					m_iNumBackboneAtoms;
 	int					m_iNumLastFlaggedAtoms;
@@ -152,6 +180,7 @@ private:
 	int					m_iLastChainIndex;
 	bool				m_bChainTerminator;
 	int					m_iFirstResidue;
+	MDTRA_PackedCoords*	m_pPackedCoords;	//allocated with the first packed index
 };
 
 #endif //MDTRA_PDB_H
\ No newline at end of file
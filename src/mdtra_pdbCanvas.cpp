@@ -70,6 +70,7 @@ Make tweakable:
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_math.h"
 #include "mdtra_pdbCanvas.h"
 #include "mdtra_colors.h"
@@ -362,6 +363,21 @@ void MDTRA_PDB_Canvas :: setPlaybackSpeed( float value )
 	m_playbackSpeed = value;
 }
 
+static void LoadStreamSnapshot( MDTRA_Render_PDB_File *pOut, const MDTRA_Stream *pStream, int snapshotIndex )
+{
+	if (!MDTRA_IsTrajectoryStream( pStream )) {
+		pOut->load( 0, pStream->format_identifier, pStream->files.at(snapshotIndex).toAscii(), pStream->flags );
+		return;
+	}
+
+	//trajectory streams: topology from the PDB file, coordinates from the trajectory
+	MDTRA_PDB_File framePDB;
+	if (!pOut->load( 0, pStream->format_identifier, pStream->files.at(0).toAscii(), pStream->flags ))
+		return;
+	if (!MDTRA_LoadStreamFrame( 0, pStream, snapshotIndex, &framePDB ) || !pOut->load_coords( &framePDB ))
+		pOut->reset();
+}
+
 void MDTRA_PDB_Canvas :: setSnapshotIndex( int value )
 {
 	m_snapshotIndex = value;
@@ -374,7 +390,7 @@ void MDTRA_PDB_Canvas :: setSnapshotIndex( int value )
 		pRendition->cacheSpot = 0;
 		// check reference
 		if ( pRendition->reference->getAtomCount() <= 0 ) {
-			pRendition->reference->load( 0, pRendition->stream->format_identifier, pRendition->stream->files.at(0).toAscii(), pRendition->stream->flags );
+			LoadStreamSnapshot( pRendition->reference, pRendition->stream, 0 );
 			if ( pRendition->reference->getAtomCount() <= 0 )
 				continue;
 			pRendition->reference->move_to_centroid();
@@ -414,14 +430,14 @@ void MDTRA_PDB_Canvas :: loadCacheFile( int cacheSpot, int snapshotIndex )
 			pRendition->cache[cacheSpot]->reset();
 			continue;
 		}
-		if ( pRendition->stream->files.count() <= snapshotIndex ) {
+		if ( MDTRA_GetStreamFrameCount( pRendition->stream ) <= snapshotIndex ) {
 			// snapshot out of range
 			pRendition->cache[cacheSpot]->reset();
 			continue;
 		}
 
 		// load file
-		pRendition->cache[cacheSpot]->load( 0, pRendition->stream->format_identifier, pRendition->stream->files.at(snapshotIndex).toAscii(), pRendition->stream->flags );
+		LoadStreamSnapshot( pRendition->cache[cacheSpot], pRendition->stream, snapshotIndex );
 		if ( pRendition->cache[cacheSpot]->getAtomCount() <= 0 )
 			continue;
 
@@ -0,0 +1,164 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of MDTRA_PDB_Model_Reader
+
+#include "mdtra_main.h"
+#include "mdtra_utils.h"
+#include "mdtra_pdb_format.h"
+#include "mdtra_pdbModels.h"
+
+MDTRA_PDB_Model_Reader :: MDTRA_PDB_Model_Reader( unsigned int format )
+{
+	m_iFormat = format;
+	m_pFrameOffsets = NULL;
+	m_iMaxFrameSize = 0;
+	m_pRawBuffer = new char*[CountThreadSlots()];
+	memset( m_pRawBuffer, 0, sizeof(char*) * CountThreadSlots() );
+}
+
+MDTRA_PDB_Model_Reader :: ~MDTRA_PDB_Model_Reader()
+{
+	for (int i = 0; i < CountThreadSlots(); i++) {
+		if (m_pRawBuffer[i]) UTIL_AlignedFree( m_pRawBuffer[i] );
+	}
+	delete [] m_pRawBuffer;
+	if (m_pFrameOffsets)
+		free( m_pFrameOffsets );
+}
+
+bool MDTRA_PDB_Model_Reader :: buildFrameIndex( FILE *fp )
+{
+	//single pass over the file, remember where every MODEL record starts
+	char linebuf[256];
+	int numAllocated = 0;
+	int numAtoms = 0;
+	qword offset = 0;
+	bool bLineStart = true;
+	bool bFirstModel = false;
+
+	m_iNumFrames = 0;
+	m_iNumAtoms = 0;
+
+	while ( !feof(fp) ) {
+		linebuf[0] = 0;
+		if (!fgets( linebuf, sizeof(linebuf), fp )) break;
+		int len = (int)strlen( linebuf );
+
+		if (bLineStart) {
+			if (!_strnicmp( linebuf, "MODEL ", 6 )) {
+				if (m_iNumFrames + 1 >= numAllocated) {
+					numAllocated = MDTRA_MAX( numAllocated * 2, 1024 );
+					qword *pNewOffsets = (qword*)realloc( m_pFrameOffsets, numAllocated * sizeof(qword) );
+					if (!pNewOffsets)
+						return false;
+					m_pFrameOffsets = pNewOffsets;
+				}
+				m_pFrameOffsets[m_iNumFrames++] = offset;
+				bFirstModel = (m_iNumFrames == 1);
+			} else if (!_strnicmp( linebuf, "ENDMDL", 6 )) {
+				bFirstModel = false;
+			} else if (bFirstModel && (!_strnicmp( linebuf, "ATOM  ", 6 ) || !_strnicmp( linebuf, "HETATM", 6 ))) {
+				numAtoms++;
+			}
+		}
+
+		bLineStart = (len > 0 && linebuf[len-1] == '\n');
+		offset += len;
+	}
+
+	m_iNumAtoms = numAtoms;
+	if (m_iNumFrames <= 0 || m_iNumAtoms <= 0)
+		return false;
+
+	//end offset of the last frame
+	m_pFrameOffsets[m_iNumFrames] = offset;
+
+	m_iMaxFrameSize = 0;
+	for (int i = 0; i < m_iNumFrames; i++)
+		m_iMaxFrameSize = MDTRA_MAX( m_iMaxFrameSize, (int)(m_pFrameOffsets[i+1] - m_pFrameOffsets[i]) );
+
+	return true;
+}
+
+bool MDTRA_PDB_Model_Reader :: open( const char *filename )
+{
+	//binary mode keeps byte offsets valid on every platform
+	FILE *fp = NULL;
+	if (fopen_s( &fp, filename, "rb" ))
+		return false;
+
+	bool bResult = buildFrameIndex( fp );
+	fclose( fp );
+
+	if (!bResult)
+		return false;
+
+	setFileName( filename );
+	return true;
+}
+
+bool MDTRA_PDB_Model_Reader :: readFrame( int threadnum, int frame, float *pOutXYZ )
+{
+	//this function MUST be thread-safe
+	FILE *fp = getFile( threadnum );
+	if (!fp)
+		return false;
+
+	if (!m_pRawBuffer[threadnum]) {
+		m_pRawBuffer[threadnum] = (char*)UTIL_AlignedMalloc( m_iMaxFrameSize + 1 );
+		if (!m_pRawBuffer[threadnum])
+			return false;
+	}
+
+	//read the whole model at once
+	char *pData = m_pRawBuffer[threadnum];
+	int frameSize = (int)(m_pFrameOffsets[frame+1] - m_pFrameOffsets[frame]);
+	if (UTIL_FileSeek( fp, m_pFrameOffsets[frame], SEEK_SET ) ||
+		fread( pData, frameSize, 1, fp ) != 1)
+		return false;
+	pData[frameSize] = 0;
+
+	int numAtoms = 0;
+	const char *pLine = pData;
+	const char *pEnd = pData + frameSize;
+
+	while (pLine < pEnd) {
+		const char *pNext = (const char*)memchr( pLine, '\n', pEnd - pLine );
+		pNext = pNext ? (pNext + 1) : pEnd;
+
+		if (!_strnicmp( pLine, "ENDMDL", 6 ))
+			break;
+
+		if (!_strnicmp( pLine, "ATOM  ", 6 ) || !_strnicmp( pLine, "HETATM", 6 )) {
+			if (numAtoms >= m_iNumAtoms)
+				return false;
+			if (!g_PDBFormatManager.parse( threadnum, m_iFormat, pLine, (int)(pNext - pLine), NULL, NULL, NULL, NULL, NULL, pOutXYZ + numAtoms * 3, NULL ))
+				return false;
+			numAtoms++;
+		}
+
+		pLine = pNext;
+	}
+
+	return (numAtoms == m_iNumAtoms);
+}
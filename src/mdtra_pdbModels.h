@@ -0,0 +1,50 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_PDB_MODELS_H
+#define MDTRA_PDB_MODELS_H
+
+#include "mdtra_trajectory.h"
+
+//Multi-model PDB file reader (MODEL/ENDMDL records)
+//Byte offset of every MODEL record is indexed once on open,
+//so every thread seeks straight to its frame
+class MDTRA_PDB_Model_Reader : public MDTRA_TrajectoryReader
+{
+public:
+	MDTRA_PDB_Model_Reader( unsigned int format );
+	virtual ~MDTRA_PDB_Model_Reader();
+
+	virtual bool open( const char *filename );
+
+protected:
+	virtual bool readFrame( int threadnum, int frame, float *pOutXYZ );
+
+private:
+	bool buildFrameIndex( FILE *fp );
+
+private:
+	unsigned int m_iFormat;
+	qword*	m_pFrameOffsets;
+	int		m_iMaxFrameSize;
+	char**	m_pRawBuffer;
+};
+
+#endif //MDTRA_PDB_MODELS_H
@@ -25,6 +25,7 @@
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_colors.h"
 #include "mdtra_pdbCanvas.h"
 #include "mdtra_pdbRenderer.h"
@@ -248,8 +249,8 @@ void MDTRA_PDB_Renderer :: addDataDescStream( int index )
 	const MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStreamByIndex( index );
 	assert( pStream != NULL );
 	m_streams.push_back( index );
-	if ( pStream->files.size() > m_iMaxSnaphots )
-		m_iMaxSnaphots = pStream->files.size();
+	if ( MDTRA_GetStreamFrameCount( pStream ) > m_iMaxSnaphots )
+		m_iMaxSnaphots = MDTRA_GetStreamFrameCount( pStream );
 
 	// add to canvas
 	m_pCanvas->addStream( pStream );
@@ -75,8 +75,10 @@ MDTRA_PDBFormatManager :: MDTRA_PDBFormatManager()
 {
 	m_pFormatList = NULL;
 	m_iLastFreeIdentifier = PDB_USER_FORMAT;
-	memset( m_iCachedFormatIdentifier, 0xFF, sizeof(m_iCachedFormatIdentifier) );
-	memset( m_pCachedFormat, 0, sizeof(m_pCachedFormat) );
+	m_iCachedFormatIdentifier = new unsigned int[CountThreadSlots()];
+	m_pCachedFormat = new const PDBFormat_t*[CountThreadSlots()];
+	memset( m_iCachedFormatIdentifier, 0xFF, sizeof(unsigned int) * CountThreadSlots() );
+	memset( m_pCachedFormat, 0, sizeof(const PDBFormat_t*) * CountThreadSlots() );
 	m_iNumUserFormats = 0;
 }
 
@@ -89,6 +91,8 @@ MDTRA_PDBFormatManager :: ~MDTRA_PDBFormatManager()
 		delete pFormat;
 		pFormat = pTemp;
 	}
+	delete [] m_pCachedFormat;
+	delete [] m_iCachedFormatIdentifier;
 }
 
 unsigned int MDTRA_PDBFormatManager :: registerFormat( const PDBFormat_t* pFormat )
@@ -155,7 +159,7 @@ void MDTRA_PDBFormatManager :: unregisterFormat( const PDBFormat_t* pFormat )
 	}
 
 
-	for (int i = 0; i < MDTRA_MAX_THREADS; i++) {
+	for (int i = 0; i < CountThreadSlots(); i++) {
 		if (m_pCachedFormat[i] == pFormat) {
 			m_iCachedFormatIdentifier[i] = 0xFFFFFFFF;
 			m_pCachedFormat[i] = NULL;
@@ -179,8 +183,8 @@ void MDTRA_PDBFormatManager :: pushFormats( void )
 		pFormat = pFormat->next;
 	}
 
-	memset( m_iCachedFormatIdentifier, 0xFF, sizeof(m_iCachedFormatIdentifier) );
-	memset( m_pCachedFormat, 0, sizeof(m_pCachedFormat) );
+	memset( m_iCachedFormatIdentifier, 0xFF, sizeof(unsigned int) * CountThreadSlots() );
+	memset( m_pCachedFormat, 0, sizeof(const PDBFormat_t*) * CountThreadSlots() );
 }
 
 void MDTRA_PDBFormatManager :: popFormats( bool restore )
@@ -299,84 +303,102 @@ void MDTRA_PDBFormatManager :: setDefaultFormat( unsigned int format )
 	if (!fetchFormat( format )) m_iDefaultFormatIdentifier = PDB_GENERIC_FORMAT;
 }
 
-int MDTRA_PDBFormatManager :: parseInteger( const char *buffer, const PDBField_t *pField ) 
+int MDTRA_PDBFormatManager :: parseInteger( const char *buffer, int length, const PDBField_t *pField ) 
 {
-	if (pField->size <= 0)	//not defined
+	if (pField->size <= 0 || pField->start >= length)	//not defined or out of line
 		return 0;
 
-	char localbuffer[81];
-	memset(localbuffer, 0, sizeof(localbuffer));
-	strncpy_s( localbuffer, buffer + pField->start, pField->size );
+	//decode the column in place
+	const char *field = buffer + pField->start;
+	int size = MDTRA_MIN( pField->size, length - pField->start );
 
 	switch (pField->type) {
 	default:
 	case PDB_FT_STRING:
 	case PDB_FT_INTEGER:
-		return UTIL_Atoi(localbuffer);
+		return UTIL_ParseFixedInt( field, size );
 	case PDB_FT_CHARACTER:
-		return localbuffer[0];
+		return field[0];
 	case PDB_FT_FLOAT:
-		return (int)UTIL_Atof(localbuffer);
+		return (int)UTIL_ParseFixedFloat( field, size );
 	}
 }
 
-float MDTRA_PDBFormatManager :: parseFloat( const char *buffer, const PDBField_t *pField ) 
+float MDTRA_PDBFormatManager :: parseFloat( const char *buffer, int length, const PDBField_t *pField ) 
 {
-	if (pField->size <= 0)	//not defined
+	if (pField->size <= 0 || pField->start >= length)	//not defined or out of line
 		return 0.0f;
 
-	char localbuffer[81];
-	memset(localbuffer, 0, sizeof(localbuffer));
-	strncpy_s( localbuffer, buffer + pField->start, pField->size );
+	//decode the column in place
+	const char *field = buffer + pField->start;
+	int size = MDTRA_MIN( pField->size, length - pField->start );
 
 	switch (pField->type) {
 	default:
 	case PDB_FT_STRING:
 	case PDB_FT_FLOAT:
-		return (float)UTIL_Atof(localbuffer);
+		return UTIL_ParseFixedFloat( field, size );
 	case PDB_FT_CHARACTER:
-		return (float)localbuffer[0];
+		return (float)field[0];
 	case PDB_FT_INTEGER:
-		return (float)UTIL_Atoi(localbuffer);
+		return (float)UTIL_ParseFixedInt( field, size );
 	}
 }
 
-void MDTRA_PDBFormatManager :: parseString( const char *buffer, const PDBField_t *pField, char *out_string ) 
+void MDTRA_PDBFormatManager :: parseString( const char *buffer, int length, const PDBField_t *pField, char *out_string ) 
 {
-	if (pField->size <= 0)	//not defined
+	if (pField->size <= 0 || pField->start >= length) {	//not defined or out of line
 		out_string[0] = 0;
-	else
-		strncpy_s( out_string, pField->size+1, buffer + pField->start, pField->size );
+		return;
+	}
+
+	const char *field = buffer + pField->start;
+	int size = MDTRA_MIN( pField->size, length - pField->start );
+	int i;
+	for (i = 0; i < size && field[i]; i++)
+		out_string[i] = field[i];
+	out_string[i] = 0;
 }
 
 bool MDTRA_PDBFormatManager :: parse( int threadnum, unsigned int format, const char *buffer, 
 									  int *out_serialnumber, int *out_residuenumber, 
 									  char *out_atomtitle, char *out_residuetitle, 
 									  short *out_chain, float *out_coords, float *out_force )
+{
+	return parse( threadnum, format, buffer, (int)strlen( buffer ), out_serialnumber, out_residuenumber,
+				  out_atomtitle, out_residuetitle, out_chain, out_coords, out_force );
+}
+
+bool MDTRA_PDBFormatManager :: parse( int threadnum, unsigned int format, const char *buffer, int length,
+									  int *out_serialnumber, int *out_residuenumber, 
+									  char *out_atomtitle, char *out_residuetitle, 
+									  short *out_chain, float *out_coords, float *out_force )
 {
 	//parse line and extract data based on format def
+	//buffer is not required to be null-terminated
 	if (m_iCachedFormatIdentifier[threadnum] != format) {
 		m_iCachedFormatIdentifier[threadnum] = format;
 		m_pCachedFormat[threadnum] = fetchFormat( format );
 	}
 
-	if (!m_pCachedFormat[threadnum])
+	const PDBFormat_t *pFormat = m_pCachedFormat[threadnum];
+	if (!pFormat)
 		return false;
 
-	if (out_serialnumber) *out_serialnumber = parseInteger( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_SERIALNUMBER] );
-	if (out_residuenumber) *out_residuenumber = parseInteger( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_RESIDUENUMBER] );
-	if (out_chain) *out_chain = (short)parseInteger( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_CHAIN] );
-	if (out_atomtitle) parseString( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_ATOMTITLE], out_atomtitle );
-	if (out_residuetitle) parseString( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_RESIDUETITLE], out_residuetitle );
+	if (out_serialnumber) *out_serialnumber = parseInteger( buffer, length, &pFormat->fields[PDB_FS_SERIALNUMBER] );
+	if (out_residuenumber) *out_residuenumber = parseInteger( buffer, length, &pFormat->fields[PDB_FS_RESIDUENUMBER] );
+	if (out_chain) *out_chain = (short)parseInteger( buffer, length, &pFormat->fields[PDB_FS_CHAIN] );
+	if (out_atomtitle) parseString( buffer, length, &pFormat->fields[PDB_FS_ATOMTITLE], out_atomtitle );
+	if (out_residuetitle) parseString( buffer, length, &pFormat->fields[PDB_FS_RESIDUETITLE], out_residuetitle );
 	if (out_coords) {
-		out_coords[0] = parseFloat( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_COORD_X] );
-		out_coords[1] = parseFloat( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_COORD_Y] );
-		out_coords[2] = parseFloat( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_COORD_Z] );
+		out_coords[0] = parseFloat( buffer, length, &pFormat->fields[PDB_FS_COORD_X] );
+		out_coords[1] = parseFloat( buffer, length, &pFormat->fields[PDB_FS_COORD_Y] );
+		out_coords[2] = parseFloat( buffer, length, &pFormat->fields[PDB_FS_COORD_Z] );
 	}
 	if (out_force) {
-		out_force[0] = parseFloat( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_FORCE_X] );
-		out_force[1] = parseFloat( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_FORCE_Y] );
-		out_force[2] = parseFloat( buffer, &m_pCachedFormat[threadnum]->fields[PDB_FS_FORCE_Z] );
+		out_force[0] = parseFloat( buffer, length, &pFormat->fields[PDB_FS_FORCE_X] );
+		out_force[1] = parseFloat( buffer, length, &pFormat->fields[PDB_FS_FORCE_Y] );
+		out_force[2] = parseFloat( buffer, length, &pFormat->fields[PDB_FS_FORCE_Z] );
 	}
 
 	return true;
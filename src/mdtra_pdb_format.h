@@ -86,22 +86,23 @@ public:
 	void setDefaultFormat( unsigned int format );
 	const PDBFormat_t *fetchFormat( unsigned int identifier );
 	bool parse( int threadnum, unsigned int format, const char *buffer, int *out_serialnumber, int *out_residuenumber, char *out_atomtitle, char *out_residuetitle, short *out_chain, float *out_coords, float *out_force );
+	bool parse( int threadnum, unsigned int format, const char *buffer, int length, int *out_serialnumber, int *out_residuenumber, char *out_atomtitle, char *out_residuetitle, short *out_chain, float *out_coords, float *out_force );
 	bool checkFormat( unsigned int identifier, PDBFieldSense_e fieldSense );
 
 	void pushFormats( void );
 	void popFormats( bool restore );
 
 private:
-	int parseInteger( const char *buffer, const PDBField_t *pField );
-	float parseFloat( const char *buffer, const PDBField_t *pField );
-	void parseString( const char *buffer, const PDBField_t *pField, char *out_string );
+	int parseInteger( const char *buffer, int length, const PDBField_t *pField );
+	float parseFloat( const char *buffer, int length, const PDBField_t *pField );
+	void parseString( const char *buffer, int length, const PDBField_t *pField, char *out_string );
 
 private:
 	PDBFormat_t *m_pFormatList;
-	const PDBFormat_t *m_pCachedFormat[MDTRA_MAX_THREADS];
+	const PDBFormat_t **m_pCachedFormat;
 	int m_iNumUserFormats;
 	unsigned int m_iLastFreeIdentifier;
-	unsigned int m_iCachedFormatIdentifier[MDTRA_MAX_THREADS];
+	unsigned int *m_iCachedFormatIdentifier;
 	unsigned int m_iDefaultFormatIdentifier;
 
 	PDBFormat_t *m_pStoredFormatList;
@@ -179,6 +179,9 @@ void MDTRA_Plot :: addPlotData( const QString &title, const MDTRA_DSRef* pref )
 	pd.title = title;
 	pd.pDataRef = pref;
 	pd.xOffset = 0;
+	pd.xOrigin = 0.0f;
+	if ( m_Layout == MDTRA_LAYOUT_TIME && pref->windowStride > 0 )
+		pd.xOrigin = (float)pref->windowStart / (float)pref->windowStride;
 	if ( m_Layout == MDTRA_LAYOUT_RESIDUE ) {
 		pd.xOffset = 1;
 		const MDTRA_DataSource *pSrc = m_pMainWindow->getProject()->fetchDataSourceByIndex( pref->dataSourceIndex );
@@ -384,10 +387,11 @@ void MDTRA_Plot :: setupPlotPaintStruct( void )
 			if (pDataPtr[j] < m_PPS.dataMin.y()) m_PPS.dataMin.setY( pDataPtr[j] );
 		}
 
-		if (iDataSize > m_PPS.xdataWidth)
-			m_PPS.xdataWidth = iDataSize;
+		int iDataWidth = iDataSize + (int)MDTRA_ROUND( m_PlotData.at(i).xOrigin );
+		if (iDataWidth > m_PPS.xdataWidth)
+			m_PPS.xdataWidth = iDataWidth;
 
-		float flDataSize = (float)iDataSize * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+		float flDataSize = ((float)iDataSize + m_PlotData.at(i).xOrigin) * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 		if (flDataSize > m_PPS.dataMax.x()) 
 			m_PPS.dataMax.setX( flDataSize );
 	}
@@ -674,7 +678,7 @@ bool MDTRA_Plot :: renderPlotDataCartesian_OpenGL( void )
 		glBegin( GL_LINE_STRIP );
 			for (int j = 0; j < iDataSize; j++) {
 				int realj = j + m_PlotData.at(i).xOffset;
-				float xvalue = realj * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+				float xvalue = (realj + m_PlotData.at(i).xOrigin) * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 				float xdataofs = xvalue * m_PPS.dataScale.x() + m_PPS.dataBias.x();
 				if ( xdataofs < 0 ) continue;
 				if ( xdataofs > m_PPS.rcData.width() ) break;
@@ -856,7 +860,7 @@ bool MDTRA_Plot :: renderPlotDataCartesian_OpenGL( void )
 			int snapNum = (m_Layout != MDTRA_LAYOUT_TIME) ? (pLabel->snapshotNum-m_PlotData.at(pLabel->sourceNum).xOffset) : pLabel->snapshotNum;
 			int realSnapNum = ( m_Layout == MDTRA_LAYOUT_TIME ) ? snapNum : (snapNum+m_PlotData.at(pLabel->sourceNum).xOffset);
 
-			float xvalue = realSnapNum * (m_PlotData.at(pLabel->sourceNum).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+			float xvalue = (realSnapNum + m_PlotData.at(pLabel->sourceNum).xOrigin) * (m_PlotData.at(pLabel->sourceNum).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 			float yvalue = sampleData( pDataPtr, snapNum, iDataSize );
 
 			int xpos = xvalue * m_PPS.dataScale.x() + m_PPS.dataBias.x();
@@ -1065,7 +1069,7 @@ bool MDTRA_Plot :: renderPlotDataPolar_OpenGL( void )
 			float prevangle = FLT_MIN;
 			for (int j = 0; j < iDataSize; j++) {
 				int realj = j + m_PlotData.at(i).xOffset;
-				float xvalue = realj * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+				float xvalue = (realj + m_PlotData.at(i).xOrigin) * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 				float xdataofs = ( xvalue * m_PPS.dataScale.x() + m_PPS.dataBias.x() ) * 0.5f;
 				if ( xdataofs < 0 ) continue;
 				if ( xdataofs > plotDataHalfWidth ) break;
@@ -1268,7 +1272,7 @@ bool MDTRA_Plot :: renderPlotDataPolar_OpenGL( void )
 			int snapNum = (m_Layout != MDTRA_LAYOUT_TIME) ? (pLabel->snapshotNum-1) : pLabel->snapshotNum;
 			int realSnapNum = ( m_Layout == MDTRA_LAYOUT_TIME ) ? snapNum : (snapNum+m_PlotData.at(pLabel->sourceNum).xOffset);
 
-			float xvalue = realSnapNum * (m_PlotData.at(pLabel->sourceNum).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+			float xvalue = (realSnapNum + m_PlotData.at(pLabel->sourceNum).xOrigin) * (m_PlotData.at(pLabel->sourceNum).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 			float yvalue = sampleData( pDataPtr, snapNum, iDataSize );
 			if ( m_DataScaleUnits == MDTRA_YSU_DEGREES )
 				yvalue = UTIL_deg2rad( yvalue );
@@ -1597,7 +1601,7 @@ bool MDTRA_Plot :: renderPlotDataCartesian_Generic( QPainter* pPainter )
 		bool pathStarted = false;
 		for (int j = 0; j < iDataSize; j++) {
 			int realj = j + m_PlotData.at(i).xOffset;
-			float xvalue = realj * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+			float xvalue = (realj + m_PlotData.at(i).xOrigin) * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 			float xdataofs = xvalue * m_PPS.dataScale.x() + m_PPS.dataBias.x();
 			if ( xdataofs < 0 ) continue;
 			if ( xdataofs > m_PPS.rcData.width() ) break;
@@ -1760,7 +1764,7 @@ bool MDTRA_Plot :: renderPlotDataCartesian_Generic( QPainter* pPainter )
 			int snapNum = (m_Layout != MDTRA_LAYOUT_TIME) ? (pLabel->snapshotNum-1) : pLabel->snapshotNum;
 			int realSnapNum = ( m_Layout == MDTRA_LAYOUT_TIME ) ? snapNum : (snapNum+m_PlotData.at(pLabel->sourceNum).xOffset);
 
-			float xvalue = realSnapNum * (m_PlotData.at(pLabel->sourceNum).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+			float xvalue = (realSnapNum + m_PlotData.at(pLabel->sourceNum).xOrigin) * (m_PlotData.at(pLabel->sourceNum).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 			float yvalue = sampleData( pDataPtr, snapNum, iDataSize );
 
 			int xpos = xvalue * m_PPS.dataScale.x() + m_PPS.dataBias.x();
@@ -1980,7 +1984,7 @@ bool MDTRA_Plot :: renderPlotDataPolar_Generic( QPainter* pPainter )
 		float prevangle = FLT_MIN;
 		for (int j = 0; j < iDataSize; j++) {
 			int realj = j + m_PlotData.at(i).xOffset;
-			float xvalue = realj * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+			float xvalue = (realj + m_PlotData.at(i).xOrigin) * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 			float xdataofs = ( xvalue * m_PPS.dataScale.x() + m_PPS.dataBias.x() ) * 0.5f;
 			if ( xdataofs < 0 ) continue;
 			if ( xdataofs > plotDataHalfWidth ) break;
@@ -2158,7 +2162,7 @@ bool MDTRA_Plot :: renderPlotDataPolar_Generic( QPainter* pPainter )
 			int snapNum = (m_Layout != MDTRA_LAYOUT_TIME) ? (pLabel->snapshotNum-1) : pLabel->snapshotNum;
 			int realSnapNum = ( m_Layout == MDTRA_LAYOUT_TIME ) ? snapNum : (snapNum+m_PlotData.at(pLabel->sourceNum).xOffset);
 
-			float xvalue = realSnapNum * (m_PlotData.at(pLabel->sourceNum).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+			float xvalue = (realSnapNum + m_PlotData.at(pLabel->sourceNum).xOrigin) * (m_PlotData.at(pLabel->sourceNum).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 			float yvalue = sampleData( pDataPtr, snapNum, iDataSize );
 			if ( m_DataScaleUnits == MDTRA_YSU_DEGREES )
 				yvalue = UTIL_deg2rad( yvalue );
@@ -2660,6 +2664,7 @@ int MDTRA_Plot :: getClosestSourceNum( int snapshotIndex, int localY )
 
 		int localSnapshotIndex = snapshotIndex;
 		if (m_Layout != MDTRA_LAYOUT_TIME) localSnapshotIndex-=m_PlotData.at(i).xOffset;
+		else localSnapshotIndex-=(int)MDTRA_ROUND( m_PlotData.at(i).xOrigin );
 		if ( localSnapshotIndex < 0 )
 			continue;
 
@@ -2667,7 +2672,7 @@ int MDTRA_Plot :: getClosestSourceNum( int snapshotIndex, int localY )
 		float sampledData = sampleData( pDataPtr, localSnapshotIndex, iDataSize );
 		
 		if ( m_PPS.polarCoords ) {
-			float xvalue = localSnapshotIndex * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
+			float xvalue = (localSnapshotIndex + m_PlotData.at(i).xOrigin) * (m_PlotData.at(i).pDataRef->xscale * flXScaleUnit_Scale[m_iXScaleUnits] + flXScaleUnit_Bias[m_iXScaleUnits]);
 			float xdataofs = ( xvalue * m_PPS.dataScale.x() + m_PPS.dataBias.x() ) * 0.5f;
 			if ( xdataofs < 0 ) continue;
 			if ( xdataofs > (m_PPS.rcData.width() >> 1) ) continue;
@@ -2712,11 +2717,16 @@ void MDTRA_Plot :: mouseDoubleClickEvent( QMouseEvent* pe )
 	if (newX < 0)
 		return;
 
-	int r = QMessageBox::warning( this, tr("Confirm"), tr("View trajectory file(s) at snapshot #%1?").arg(newX), 
+	int srcNum = getClosestSourceNum( newX, pe->y() );
+	if (srcNum < 0)
+		return;
+
+	int snapshot = MDTRA_GetDSRefSnapshot( m_PlotData.at(srcNum).pDataRef, newX - (int)MDTRA_ROUND( m_PlotData.at(srcNum).xOrigin ) );
+	int r = QMessageBox::warning( this, tr("Confirm"), tr("View trajectory file(s) at snapshot #%1?").arg(snapshot), 
 								  QMessageBox::Yes | QMessageBox::Default, QMessageBox::No );
 
 	if (r == QMessageBox::Yes)
-		m_pMainWindow->viewPDBFiles( newX );
+		m_pMainWindow->viewPDBFiles( snapshot );
 }
 
 void MDTRA_Plot :: updateSelectionRect( const QPoint &newp )
@@ -2835,7 +2845,11 @@ void MDTRA_Plot :: addLabel( void )
 
 	switch (m_Layout) {
 	default:
-	case MDTRA_LAYOUT_TIME: lbl.text = QString("Snapshot %1").arg(newX); break;
+	case MDTRA_LAYOUT_TIME:
+		//labels keep the data index, the build window only moves the plot origin
+		newX -= (int)MDTRA_ROUND( m_PlotData.at(srcNum).xOrigin );
+		lbl.text = QString("Snapshot %1").arg( MDTRA_GetDSRefSnapshot( m_PlotData.at(srcNum).pDataRef, newX ) );
+		break;
 	case MDTRA_LAYOUT_RESIDUE: 
 		{
 			MDTRA_DataSource *pDS = m_pMainWindow->getProject()->fetchDataSourceByIndex(m_PlotData.at(srcNum).pDataRef->dataSourceIndex);
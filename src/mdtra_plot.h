@@ -34,6 +34,7 @@ typedef struct stMDTRA_PlotData
 	QString title;
 	const struct stMDTRA_DSRef*	pDataRef;
 	int xOffset;
+	float xOrigin;		//data steps before the first value, the build window start
 } MDTRA_PlotData;
 
 typedef struct stMDTRA_PlotPaintStruct
@@ -32,6 +32,8 @@
 #include "mdtra_formatDialog.h"
 #include "mdtra_cuda.h"
 #include "mdtra_SAS.h"
+#include "mdtra_prefetch.h"
+#include "mdtra_frameCache.h"
 
 #include <QtGui/QColorDialog>
 #include <QtGui/QMessageBox>
@@ -66,6 +68,7 @@ MDTRA_PreferencesDialog :: MDTRA_PreferencesDialog( QWidget *parent )
 
 	cbMultisampleAA->setChecked( m_pMainWindow->multisampleAA() );
 	cbLowPriority->setChecked( m_pMainWindow->lowPriority() );
+	cbPinThreads->setChecked( m_pMainWindow->pinThreads() );
 #if defined(MDTRA_ALLOW_SSE)
 	cbSSE->setChecked( m_pMainWindow->allowSSE() );
 	cbSSE->setEnabled( g_bSupportsSSE );
@@ -85,16 +88,22 @@ MDTRA_PreferencesDialog :: MDTRA_PreferencesDialog( QWidget *parent )
 	mtCombo->clear();
 	mtCombo->addItem( "Autodetect" );
 	mtCombo->addItem( "Single-threaded" );
-	for (int i = 2; i <= MDTRA_MAX_THREADS; i++)
+	for (int i = 2; i <= CountThreadSlots(); i++)
 		mtCombo->addItem( tr("Multi-threaded (%1 threads)").arg(i) );
 
 	int currentThreads = m_pMainWindow->numThreads();
 	if (currentThreads < 0) 
 		currentThreads = 0;
-	if (currentThreads > MDTRA_MAX_THREADS)
-		currentThreads = MDTRA_MAX_THREADS;
+	if (currentThreads > CountThreadSlots())
+		currentThreads = CountThreadSlots();
 	mtCombo->setCurrentIndex( currentThreads );
 
+	sbPrefetchDepth->setMaximum( MDTRA_MAX_PREFETCH_DEPTH );
+	sbPrefetchDepth->setValue( m_pMainWindow->prefetchDepth() );
+	sbBuildFirst->setValue( m_pMainWindow->buildFirst() );
+	sbBuildLast->setValue( m_pMainWindow->buildLast() );
+	sbBuildStride->setValue( m_pMainWindow->buildStride() );
+
 	cbDataFilter->setChecked( m_pMainWindow->plotDataFilter() );
 	sbDataFilter->setValue( m_pMainWindow->plotDataFilterSize() );
 	cbPlotPolarAngles->setChecked( m_pMainWindow->plotPolarAngles() );
@@ -117,6 +126,10 @@ MDTRA_PreferencesDialog :: MDTRA_PreferencesDialog( QWidget *parent )
 	sasAccuracy->setCurrentIndex( subdivisions );
 	cbSasNoWater->setChecked( excludeWater );
 
+	sbFrameCache->setMaximum( MDTRA_MAX_FRAME_CACHE_SIZE );
+	sbFrameCache->setValue( m_pMainWindow->frameCacheSize() );
+	cbFrameCacheQuantize->setChecked( m_pMainWindow->frameCacheQuantize() );
+
 	m_ColorList.clear();
 	for (int i = 0; i < m_pMainWindow->getColorManager()->numColors(); i++)
 		m_ColorList << m_pMainWindow->getColorManager()->color(i);
@@ -166,6 +179,7 @@ void MDTRA_PreferencesDialog :: savePreferences( void )
 
 	m_pMainWindow->setMultisampleAA( cbMultisampleAA->isChecked() );
 	m_pMainWindow->setLowPriority( cbLowPriority->isChecked() );
+	m_pMainWindow->setPinThreads( cbPinThreads->isChecked() );
 
 	bool bAllowSSE = cbSSE->isChecked();
 	if (!g_bSupportsSSE)
@@ -184,6 +198,8 @@ void MDTRA_PreferencesDialog :: savePreferences( void )
 #endif
 
 	m_pMainWindow->setNumThreads( mtCombo->currentIndex() ? mtCombo->currentIndex() : -1 );
+	m_pMainWindow->setPrefetchDepth( sbPrefetchDepth->value() );
+	m_pMainWindow->setBuildWindow( sbBuildFirst->value(), sbBuildLast->value(), sbBuildStride->value() );
 	m_pMainWindow->setPlotDataFilter( cbDataFilter->isChecked() );
 	m_pMainWindow->setPlotDataFilterSize( sbDataFilter->value() );
 	m_pMainWindow->setPlotPolarAngles( cbPlotPolarAngles->isChecked() );
@@ -195,6 +211,9 @@ void MDTRA_PreferencesDialog :: savePreferences( void )
 	bool excludeWater = cbSasNoWater->isChecked();
 	MDTRA_SetSASParms( probeRadius, subdivisions, excludeWater );
 
+	m_pMainWindow->setFrameCacheSize( sbFrameCache->value() );
+	m_pMainWindow->setFrameCacheQuantize( cbFrameCacheQuantize->isChecked() );
+
 	if (viewer0->isChecked())
 		m_pMainWindow->setViewerType(0);
 	else if (viewer1->isChecked())
@@ -0,0 +1,562 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of MDTRA_FramePrefetcher
+
+#include "mdtra_main.h"
+#include "mdtra_project.h"
+#include "mdtra_pdb.h"
+#include "mdtra_stream.h"
+#include "mdtra_prefetch.h"
+#include "mdtra_profiler.h"
+
+#define PREFETCH_SLOT_FREE		0
+#define PREFETCH_SLOT_LOADING	1
+#define PREFETCH_SLOT_READY		2
+#define PREFETCH_SLOT_IN_USE	3
+
+static int prefetchdepth = MDTRA_DEFAULT_PREFETCH_DEPTH;
+
+void PrefetchSetDefault( int depth )
+{
+	prefetchdepth = depth;
+	if (prefetchdepth < 0)
+		prefetchdepth = MDTRA_DEFAULT_PREFETCH_DEPTH;
+	else if (prefetchdepth > MDTRA_MAX_PREFETCH_DEPTH)
+		prefetchdepth = MDTRA_MAX_PREFETCH_DEPTH;
+}
+
+int CountPrefetchFrames( void )
+{
+	return prefetchdepth;
+}
+
+static MDTRA_PrefetchTuning s_lastTuning;
+static bool s_bLastTuning = false;
+
+bool PrefetchGetLastTuning( MDTRA_PrefetchTuning *pTuning )
+{
+	if (!s_bLastTuning)
+		return false;
+	*pTuning = s_lastTuning;
+	return true;
+}
+
+typedef struct stMDTRA_PrefetchReader
+{
+	MDTRA_FramePrefetcher*	pPrefetcher;
+	int						reader;
+} MDTRA_PrefetchReader;
+
+#if defined(USE_WIN32_THREADS)
+
+struct stMDTRA_PrefetchSync
+{
+	CRITICAL_SECTION		crit;
+	CONDITION_VARIABLE		slotFree;
+	CONDITION_VARIABLE		slotReady;
+	HANDLE					threadhandle[MDTRA_MAX_PREFETCH_DEPTH];
+	MDTRA_PrefetchReader	readers[MDTRA_MAX_PREFETCH_DEPTH];
+};
+
+static DWORD WINAPI PrefetchEntryStub( LPVOID pParam )
+{
+	MDTRA_PrefetchReader *pReader = (MDTRA_PrefetchReader*)pParam;
+	pReader->pPrefetcher->readerLoop( pReader->reader );
+	return 0;
+}
+
+static void PrefetchInitSync( MDTRA_PrefetchSync *pSync )
+{
+	InitializeCriticalSection( &pSync->crit );
+	InitializeConditionVariable( &pSync->slotFree );
+	InitializeConditionVariable( &pSync->slotReady );
+}
+
+static void PrefetchFreeSync( MDTRA_PrefetchSync *pSync )
+{
+	DeleteCriticalSection( &pSync->crit );
+}
+
+static void PrefetchLock( MDTRA_PrefetchSync *pSync ) { EnterCriticalSection( &pSync->crit ); }
+static void PrefetchUnlock( MDTRA_PrefetchSync *pSync ) { LeaveCriticalSection( &pSync->crit ); }
+static void PrefetchWaitFree( MDTRA_PrefetchSync *pSync ) { SleepConditionVariableCS( &pSync->slotFree, &pSync->crit, INFINITE ); }
+static void PrefetchWaitReady( MDTRA_PrefetchSync *pSync ) { SleepConditionVariableCS( &pSync->slotReady, &pSync->crit, INFINITE ); }
+static void PrefetchSignalFree( MDTRA_PrefetchSync *pSync ) { WakeAllConditionVariable( &pSync->slotFree ); }
+static void PrefetchSignalReady( MDTRA_PrefetchSync *pSync ) { WakeAllConditionVariable( &pSync->slotReady ); }
+
+static bool PrefetchStartThread( MDTRA_PrefetchSync *pSync, int i )
+{
+	pSync->threadhandle[i] = CreateThread( NULL, 0, (LPTHREAD_START_ROUTINE)PrefetchEntryStub, (LPVOID)&pSync->readers[i], 0, NULL );
+	return (pSync->threadhandle[i] != NULL);
+}
+
+static void PrefetchJoinThreads( MDTRA_PrefetchSync *pSync, int count )
+{
+	if (count <= 0)
+		return;
+	WaitForMultipleObjects( count, pSync->threadhandle, TRUE, INFINITE );
+	for (int i = 0; i < count; i++)
+		CloseHandle( pSync->threadhandle[i] );
+}
+
+#elif defined(USE_POSIX_THREADS)
+
+struct stMDTRA_PrefetchSync
+{
+	pthread_mutex_t			mutex;
+	pthread_cond_t			slotFree;
+	pthread_cond_t			slotReady;
+	pthread_t				threadhandle[MDTRA_MAX_PREFETCH_DEPTH];
+	MDTRA_PrefetchReader	readers[MDTRA_MAX_PREFETCH_DEPTH];
+};
+
+static void* PrefetchEntryStub( void* pParam )
+{
+	MDTRA_PrefetchReader *pReader = (MDTRA_PrefetchReader*)pParam;
+	pReader->pPrefetcher->readerLoop( pReader->reader );
+	return NULL;
+}
+
+static void PrefetchInitSync( MDTRA_PrefetchSync *pSync )
+{
+	pthread_mutex_init( &pSync->mutex, NULL );
+	pthread_cond_init( &pSync->slotFree, NULL );
+	pthread_cond_init( &pSync->slotReady, NULL );
+}
+
+static void PrefetchFreeSync( MDTRA_PrefetchSync *pSync )
+{
+	pthread_cond_destroy( &pSync->slotReady );
+	pthread_cond_destroy( &pSync->slotFree );
+	pthread_mutex_destroy( &pSync->mutex );
+}
+
+static void PrefetchLock( MDTRA_PrefetchSync *pSync ) { pthread_mutex_lock( &pSync->mutex ); }
+static void PrefetchUnlock( MDTRA_PrefetchSync *pSync ) { pthread_mutex_unlock( &pSync->mutex ); }
+static void PrefetchWaitFree( MDTRA_PrefetchSync *pSync ) { pthread_cond_wait( &pSync->slotFree, &pSync->mutex ); }
+static void PrefetchWaitReady( MDTRA_PrefetchSync *pSync ) { pthread_cond_wait( &pSync->slotReady, &pSync->mutex ); }
+static void PrefetchSignalFree( MDTRA_PrefetchSync *pSync ) { pthread_cond_broadcast( &pSync->slotFree ); }
+static void PrefetchSignalReady( MDTRA_PrefetchSync *pSync ) { pthread_cond_broadcast( &pSync->slotReady ); }
+
+static bool PrefetchStartThread( MDTRA_PrefetchSync *pSync, int i )
+{
+	return (pthread_create( &pSync->threadhandle[i], NULL, PrefetchEntryStub, (void*)&pSync->readers[i] ) == 0);
+}
+
+static void PrefetchJoinThreads( MDTRA_PrefetchSync *pSync, int count )
+{
+	for (int i = 0; i < count; i++)
+		pthread_join( pSync->threadhandle[i], NULL );
+}
+
+#else
+
+//single-threaded: snapshots are loaded by the worker on demand
+struct stMDTRA_PrefetchSync
+{
+	MDTRA_PrefetchReader	readers[MDTRA_MAX_PREFETCH_DEPTH];
+};
+
+static void PrefetchInitSync( MDTRA_PrefetchSync *pSync ) {}
+static void PrefetchFreeSync( MDTRA_PrefetchSync *pSync ) {}
+static void PrefetchLock( MDTRA_PrefetchSync *pSync ) {}
+static void PrefetchUnlock( MDTRA_PrefetchSync *pSync ) {}
+static void PrefetchWaitFree( MDTRA_PrefetchSync *pSync ) {}
+static void PrefetchWaitReady( MDTRA_PrefetchSync *pSync ) {}
+static void PrefetchSignalFree( MDTRA_PrefetchSync *pSync ) {}
+static void PrefetchSignalReady( MDTRA_PrefetchSync *pSync ) {}
+static bool PrefetchStartThread( MDTRA_PrefetchSync *pSync, int i ) { return false; }
+static void PrefetchJoinThreads( MDTRA_PrefetchSync *pSync, int count ) {}
+
+#endif
+
+MDTRA_FramePrefetcher :: MDTRA_FramePrefetcher( const MDTRA_Stream *pStream, const MDTRA_Stream *pStream2, int workStart, int workStride )
+{
+	m_pStreams[0] = pStream;
+	m_pStreams[1] = pStream2;
+	m_iNumStreams = pStream2 ? 2 : 1;
+	m_pSegments = new MDTRA_PrefetchSegment[1];
+	m_pSegments[0].pStream = pStream;
+	m_pSegments[0].workBase = 0;
+	m_pSegments[0].workStart = workStart;
+	m_pSegments[0].workStride = workStride;
+	m_iNumSegments = 1;
+	m_iWorkCount = 0;
+	m_iNextFrame = 0;
+	m_iNumFloats = 0;
+	m_iNumSlots = 0;
+	m_iBlockLimit = 1;
+	m_iNumReaders = 0;
+	m_iMaxReaders = 0;
+	m_iReaderLimit = MDTRA_MAX_PREFETCH_DEPTH;
+	m_iWorkerLimit = 0;
+	m_bTuning = false;
+	m_bAbort = false;
+	m_pSlots = NULL;
+	m_pSync = new MDTRA_PrefetchSync;
+	PrefetchInitSync( m_pSync );
+}
+
+MDTRA_FramePrefetcher :: ~MDTRA_FramePrefetcher()
+{
+	stop();
+	freeSlots();
+	PrefetchFreeSync( m_pSync );
+	delete m_pSync;
+	delete [] m_pSegments;
+}
+
+void MDTRA_FramePrefetcher :: alloc_floats( int count )
+{
+	m_iNumFloats = count;
+	for (int i = 0; i < m_iNumSlots; i++) {
+		for (int j = 0; j < m_iNumStreams; j++)
+			m_pSlots[i].pdb[j]->alloc_floats( count );
+	}
+}
+
+bool MDTRA_FramePrefetcher :: appendStream( const MDTRA_Stream *pStream, int workStart, int workStride, int workBase )
+{
+	if (m_iNumStreams > 1 || workBase <= m_pSegments[m_iNumSegments-1].workBase)
+		return false;
+
+	MDTRA_PrefetchSegment *pSegments = new MDTRA_PrefetchSegment[m_iNumSegments+1];
+	memcpy( pSegments, m_pSegments, m_iNumSegments * sizeof(MDTRA_PrefetchSegment) );
+	delete [] m_pSegments;
+	m_pSegments = pSegments;
+
+	m_pSegments[m_iNumSegments].pStream = pStream;
+	m_pSegments[m_iNumSegments].workBase = workBase;
+	m_pSegments[m_iNumSegments].workStart = workStart;
+	m_pSegments[m_iNumSegments].workStride = workStride;
+	m_iNumSegments++;
+	return true;
+}
+
+const MDTRA_PrefetchSegment *MDTRA_FramePrefetcher :: findSegment( int num ) const
+{
+	int lo = 0;
+	int hi = m_iNumSegments - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) >> 1;
+		if (m_pSegments[mid].workBase <= num)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return m_pSegments + lo;
+}
+
+//workers claim blocks of consecutive frames, a worker ahead in frame order gets its
+//slots only as the ring covers the blocks before it; blocks are limited so that
+//one block per worker fits the memory budget
+int MDTRA_FramePrefetcher :: calcBlockLimit( void ) const
+{
+	int maxAtoms = 0;
+	for (int i = 0; i < m_iNumSegments; i++) {
+		if (m_pSegments[i].pStream->pdb)
+			maxAtoms = MDTRA_MAX( maxAtoms, m_pSegments[i].pStream->pdb->getAtomCount() );
+	}
+	if (m_iNumStreams > 1 && m_pStreams[1]->pdb)
+		maxAtoms = MDTRA_MAX( maxAtoms, m_pStreams[1]->pdb->getAtomCount() );
+
+	double slotBytes = (double)m_iNumStreams * (maxAtoms * sizeof(MDTRA_PDB_Atom) + m_iNumFloats * sizeof(float));
+	double blockLimit = MDTRA_PREFETCH_BLOCK_MEMORY / (MDTRA_MAX( slotBytes, 1.0 ) * CountThreads());
+	if (blockLimit > MDTRA_PREFETCH_MAX_BLOCK)
+		blockLimit = MDTRA_PREFETCH_MAX_BLOCK;
+	return MDTRA_MAX( (int)blockLimit, 1 );
+}
+
+bool MDTRA_FramePrefetcher :: allocSlots( int numSlots )
+{
+	if (m_pSlots && m_iNumSlots == numSlots)
+		return true;
+
+	freeSlots();
+
+	m_pSlots = new MDTRA_PrefetchSlot[numSlots];
+	if (!m_pSlots)
+		return false;
+
+	memset( m_pSlots, 0, sizeof(MDTRA_PrefetchSlot) * numSlots );
+	m_iNumSlots = numSlots;
+	for (int i = 0; i < m_iNumSlots; i++) {
+		for (int j = 0; j < m_iNumStreams; j++) {
+			m_pSlots[i].pdb[j] = new MDTRA_PDB_File;
+			if (m_iNumFloats > 0)
+				m_pSlots[i].pdb[j]->alloc_floats( m_iNumFloats );
+		}
+	}
+	return true;
+}
+
+void MDTRA_FramePrefetcher :: freeSlots( void )
+{
+	if (!m_pSlots)
+		return;
+
+	for (int i = 0; i < m_iNumSlots; i++) {
+		for (int j = 0; j < m_iNumStreams; j++) {
+			if (m_pSlots[i].pdb[j])
+				delete m_pSlots[i].pdb[j];
+		}
+	}
+	delete [] m_pSlots;
+	m_pSlots = NULL;
+	m_iNumSlots = 0;
+}
+
+bool MDTRA_FramePrefetcher :: start( int workCount )
+{
+	stop();
+
+	//every worker holds a block of snapshots, prefetch depth snapshots are decoded ahead
+	m_iBlockLimit = calcBlockLimit();
+	if (!allocSlots( CountThreads() * m_iBlockLimit + MDTRA_MAX( CountPrefetchFrames(), 1 ) ))
+		return false;
+
+	for (int i = 0; i < m_iNumSlots; i++) {
+		m_pSlots[i].frame = i;
+		m_pSlots[i].state = PREFETCH_SLOT_FREE;
+		m_pSlots[i].loaded = false;
+		m_pSlots[i].acquireTime = 0.0;
+	}
+
+	m_iWorkCount = workCount;
+	m_iNextFrame = 0;
+	m_bAbort = false;
+
+	//readers use I/O thread slots 0..N-1, workers do not touch them while prefetching
+	int numReaders = MDTRA_MIN( CountThreads(), CountPrefetchFrames() );
+	if (numReaders < 1) numReaders = 1;
+	if (numReaders > MDTRA_MAX_PREFETCH_DEPTH) numReaders = MDTRA_MAX_PREFETCH_DEPTH;
+
+	//short runs are not worth the sampling
+	s_bLastTuning = false;
+	m_bTuning = (CountThreads() > 1 && workCount >= MDTRA_PREFETCH_TUNE_FRAMES * 4);
+	m_iMaxReaders = numReaders;
+	m_iReaderLimit = m_bTuning ? 1 : numReaders;
+	m_iWorkerLimit = 0;
+	memset( m_fLoadUsec, 0, sizeof(m_fLoadUsec) );
+	memset( m_iLoadCount, 0, sizeof(m_iLoadCount) );
+	m_fComputeUsec = 0.0;
+	m_iComputeCount = 0;
+
+	for (int i = 0; i < numReaders; i++) {
+		m_pSync->readers[i].pPrefetcher = this;
+		m_pSync->readers[i].reader = i;
+		if (!PrefetchStartThread( m_pSync, i )) {
+#ifdef _DEBUG
+			OutputDebugString("MDTRA_FramePrefetcher: unable to create reader thread!\n");
+#endif
+			break;
+		}
+		m_iNumReaders++;
+	}
+
+	if (!m_iNumReaders)
+		m_bTuning = false;
+	return (m_iNumReaders > 0);
+}
+
+void MDTRA_FramePrefetcher :: abort( void )
+{
+	PrefetchLock( m_pSync );
+	m_bAbort = true;
+	PrefetchSignalFree( m_pSync );
+	PrefetchSignalReady( m_pSync );
+	PrefetchUnlock( m_pSync );
+}
+
+void MDTRA_FramePrefetcher :: stop( void )
+{
+	abort();
+
+	PrefetchJoinThreads( m_pSync, m_iNumReaders );
+	m_iNumReaders = 0;
+}
+
+void MDTRA_FramePrefetcher :: loadSlot( int threadnum, int num )
+{
+	//called with sync locked
+	MDTRA_PrefetchSlot *pSlot = m_pSlots + (num % m_iNumSlots);
+
+	//back-pressure: wait until the worker releases the previous snapshot of this slot
+	if (!m_bAbort && (pSlot->frame != num || pSlot->state != PREFETCH_SLOT_FREE)) {
+		MDTRA_PROF_SCOPE( "wait for free slot", MDTRA_PROF_WAIT );
+		while (!m_bAbort && (pSlot->frame != num || pSlot->state != PREFETCH_SLOT_FREE))
+			PrefetchWaitFree( m_pSync );
+	}
+	if (m_bAbort)
+		return;
+
+	pSlot->state = PREFETCH_SLOT_LOADING;
+	PrefetchUnlock( m_pSync );
+
+	bool loaded = true;
+	double loadStart = m_bTuning ? ThreadMicroseconds() : 0.0;
+	const MDTRA_PrefetchSegment *pSeg = findSegment( num );
+	int frame = pSeg->workStart + (num - pSeg->workBase) * pSeg->workStride;
+	if (frame > 0) {
+		for (int i = 0; i < m_iNumStreams; i++) {
+			if (!MDTRA_LoadStreamFrame( threadnum, i ? m_pStreams[i] : pSeg->pStream, frame, pSlot->pdb[i] ))
+				loaded = false;
+		}
+	}
+
+	PrefetchLock( m_pSync );
+	pSlot->loaded = loaded;
+	pSlot->state = PREFETCH_SLOT_READY;
+	PrefetchSignalReady( m_pSync );
+
+	if (m_bTuning && num < MDTRA_PREFETCH_TUNE_FRAMES * 2) {
+		int phase = num / MDTRA_PREFETCH_TUNE_FRAMES;
+		m_fLoadUsec[phase] += ThreadMicroseconds() - loadStart;
+		m_iLoadCount[phase]++;
+		if (m_iLoadCount[1] == MDTRA_PREFETCH_TUNE_FRAMES && m_iComputeCount >= MDTRA_PREFETCH_TUNE_FRAMES)
+			tune();
+	}
+}
+
+//called with sync locked once the second phase is loaded and enough frames are computed
+void MDTRA_FramePrefetcher :: tune( void )
+{
+	double load1 = m_fLoadUsec[0] / MDTRA_MAX( m_iLoadCount[0], 1 );
+	double loadN = m_fLoadUsec[1] / MDTRA_MAX( m_iLoadCount[1], 1 );
+	double compute = MDTRA_MAX( m_fComputeUsec / MDTRA_MAX( m_iComputeCount, 1 ), 1.0 );
+
+	//aggregate read rate of all readers over one: close to 1 if the device serializes reads
+	int readers = m_iMaxReaders;
+	if (readers > 1 && (loadN <= 0.0 || readers * load1 / loadN < MDTRA_PREFETCH_MIN_SPEEDUP))
+		readers = 1;
+	double load = (readers > 1) ? loadN : load1;
+
+	//enough workers to consume what the readers decode, then only the readers they need
+	int workers = CountThreads();
+	if (load > 0.0)
+		workers = MDTRA_MAX( 1, MDTRA_MIN( workers, (int)ceil( compute * readers / load ) ) );
+	readers = MDTRA_MAX( 1, MDTRA_MIN( readers, (int)ceil( workers * load / compute ) ) );
+
+	m_iReaderLimit = readers;
+	m_iWorkerLimit = workers;
+	m_bTuning = false;
+	PrefetchSignalFree( m_pSync );
+
+	s_lastTuning.readers = readers;
+	s_lastTuning.workers = workers;
+	s_lastTuning.loadUsec = load1;
+	s_lastTuning.parallelLoadUsec = loadN;
+	s_lastTuning.computeUsec = compute;
+	s_bLastTuning = true;
+}
+
+void MDTRA_FramePrefetcher :: readerLoop( int reader )
+{
+	ProfilerNameThread( MDTRA_PROF_THREAD_READER, reader );
+	PrefetchLock( m_pSync );
+	while (!m_bAbort && m_iNextFrame < m_iWorkCount) {
+		//readers above the limit idle until it is raised
+		if (reader >= m_iReaderLimit) {
+			PrefetchWaitFree( m_pSync );
+			continue;
+		}
+		int num = m_iNextFrame;
+		m_iNextFrame++;
+		if (m_bTuning && num == MDTRA_PREFETCH_TUNE_FRAMES) {
+			m_iReaderLimit = m_iMaxReaders;
+			PrefetchSignalFree( m_pSync );
+		}
+		loadSlot( reader, num );
+	}
+	PrefetchUnlock( m_pSync );
+}
+
+bool MDTRA_FramePrefetcher :: acquireFrame( int threadnum, int num, MDTRA_PDB_File **ppPdbFile, MDTRA_PDB_File **ppPdbFile2 )
+{
+	MDTRA_PrefetchSlot *pSlot = m_pSlots + (num % m_iNumSlots);
+
+	PrefetchLock( m_pSync );
+
+	//no reader threads, load on the calling thread
+	if (!m_iNumReaders)
+		loadSlot( threadnum, num );
+
+	if (!m_bAbort && (pSlot->frame != num || pSlot->state != PREFETCH_SLOT_READY)) {
+		MDTRA_PROF_SCOPE( "wait for frame", MDTRA_PROF_WAIT );
+		while (!m_bAbort && (pSlot->frame != num || pSlot->state != PREFETCH_SLOT_READY))
+			PrefetchWaitReady( m_pSync );
+	}
+	if (pSlot->frame != num || pSlot->state != PREFETCH_SLOT_READY) {
+		//run was interrupted before the snapshot was decoded
+		PrefetchUnlock( m_pSync );
+		*ppPdbFile = NULL;
+		if (ppPdbFile2) *ppPdbFile2 = NULL;
+		return false;
+	}
+	pSlot->state = PREFETCH_SLOT_IN_USE;
+	if (m_bTuning)
+		pSlot->acquireTime = ThreadMicroseconds();
+	bool loaded = pSlot->loaded;
+
+	PrefetchUnlock( m_pSync );
+
+	const MDTRA_PrefetchSegment *pSeg = findSegment( num );
+	if ((pSeg->workStart + (num - pSeg->workBase) * pSeg->workStride) == 0) {
+		*ppPdbFile = pSeg->pStream->pdb;
+		if (ppPdbFile2) *ppPdbFile2 = m_pStreams[1] ? m_pStreams[1]->pdb : NULL;
+	} else {
+		*ppPdbFile = pSlot->pdb[0];
+		if (ppPdbFile2) *ppPdbFile2 = pSlot->pdb[1];
+	}
+	return loaded;
+}
+
+void MDTRA_FramePrefetcher :: releaseFrame( int num )
+{
+	MDTRA_PrefetchSlot *pSlot = m_pSlots + (num % m_iNumSlots);
+
+	PrefetchLock( m_pSync );
+	if (pSlot->frame != num || pSlot->state != PREFETCH_SLOT_IN_USE) {
+		//never acquired, the run was interrupted
+		PrefetchUnlock( m_pSync );
+		return;
+	}
+	if (m_bTuning && pSlot->acquireTime > 0.0) {
+		m_fComputeUsec += ThreadMicroseconds() - pSlot->acquireTime;
+		m_iComputeCount++;
+		if (m_iLoadCount[1] == MDTRA_PREFETCH_TUNE_FRAMES && m_iComputeCount == MDTRA_PREFETCH_TUNE_FRAMES)
+			tune();
+	}
+	pSlot->acquireTime = 0.0;
+	pSlot->state = PREFETCH_SLOT_FREE;
+	pSlot->frame = num + m_iNumSlots;
+	PrefetchSignalFree( m_pSync );
+	PrefetchUnlock( m_pSync );
+}
+
+MDTRA_FramePrefetcher *MDTRA_CreateFramePrefetcher( const MDTRA_Stream *pStream, const MDTRA_Stream *pStream2, int workStart, int workStride )
+{
+	if (!CountPrefetchFrames())
+		return NULL;
+	return new MDTRA_FramePrefetcher( pStream, pStream2, workStart, workStride );
+}
@@ -0,0 +1,145 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_PREFETCH_H
+#define MDTRA_PREFETCH_H
+
+#define MDTRA_MAX_PREFETCH_DEPTH		64
+#define MDTRA_DEFAULT_PREFETCH_DEPTH	4
+#define MDTRA_MAX_PREFETCH_STREAMS		2
+#define MDTRA_PREFETCH_MAX_BLOCK		16
+#define MDTRA_PREFETCH_BLOCK_MEMORY		(64 * 1024 * 1024)	//snapshot memory the ring may spend on frame blocks
+#define MDTRA_PREFETCH_TUNE_FRAMES		16		//frames sampled per tuning phase
+#define MDTRA_PREFETCH_MIN_SPEEDUP		1.5		//parallel reads must beat one reader by this much
+
+typedef struct stMDTRA_Stream MDTRA_Stream;
+typedef struct stMDTRA_PrefetchSync MDTRA_PrefetchSync;
+class MDTRA_PDB_File;
+
+extern void PrefetchSetDefault( int depth );
+extern int  CountPrefetchFrames( void );
+
+typedef struct stMDTRA_PrefetchSlot
+{
+	MDTRA_PDB_File*	pdb[MDTRA_MAX_PREFETCH_STREAMS];
+	int				frame;
+	int				state;
+	bool			loaded;
+	double			acquireTime;
+} MDTRA_PrefetchSlot;
+
+//concurrency chosen from the first frames of the last prefetched run
+typedef struct stMDTRA_PrefetchTuning
+{
+	int				readers;
+	int				workers;
+	double			loadUsec;			//per frame, one reader
+	double			parallelLoadUsec;	//per frame, all readers at once
+	double			computeUsec;		//per frame
+} MDTRA_PrefetchTuning;
+
+extern bool PrefetchGetLastTuning( MDTRA_PrefetchTuning *pTuning );
+
+//work items [workBase, next segment's workBase) map to frames of one stream
+typedef struct stMDTRA_PrefetchSegment
+{
+	const MDTRA_Stream*	pStream;
+	int					workBase;
+	int					workStart;
+	int					workStride;
+} MDTRA_PrefetchSegment;
+
+//Decouples snapshot I/O from the compute threads
+//Reader threads decode snapshots into a bounded ring of slots ahead of
+//the workers started by RunThreadsOnPrefetched, a slot is reused only after
+//the worker releases the snapshot it holds. Reader threads own the per-thread
+//I/O resources (file handles, parse buffers) while the prefetcher runs.
+//
+//A long run is tuned from its first frames: one reader loads the first phase,
+//all readers the second. If parallel reads do not pay off (a spinning disk),
+//a single reader is kept; then just enough workers are left to consume what
+//the readers decode, all of them when the run is compute bound.
+class MDTRA_FramePrefetcher
+{
+public:
+	MDTRA_FramePrefetcher( const MDTRA_Stream *pStream, const MDTRA_Stream *pStream2, int workStart, int workStride );
+	~MDTRA_FramePrefetcher();
+
+	void alloc_floats( int count );
+
+	//chains another stream into the ring, its items start at workBase; lets a single
+	//work queue run over several streams (single stream prefetchers only)
+	bool appendStream( const MDTRA_Stream *pStream, int workStart, int workStride, int workBase );
+
+	bool start( int workCount );
+	void stop( void );
+
+	//wakes readers and workers waiting on the ring, further acquires fail; safe from any thread
+	void abort( void );
+
+	//largest block of consecutive frames one worker may claim, the ring holds a block per worker
+	int getBlockLimit( void ) const { return m_iBlockLimit; }
+
+	//number of workers the run should keep once tuned, 0 until then
+	int getWorkerLimit( void ) const { return m_iWorkerLimit; }
+
+	//wait until the snapshot is decoded, stream frame 0 is never loaded and
+	//refers to the stream PDB; returns false if the snapshot failed to load,
+	//with NULL files if the run was aborted first
+	bool acquireFrame( int threadnum, int num, MDTRA_PDB_File **ppPdbFile, MDTRA_PDB_File **ppPdbFile2 = NULL );
+	void releaseFrame( int num );
+
+	void readerLoop( int reader );
+
+private:
+	bool allocSlots( int numSlots );
+	void freeSlots( void );
+	void loadSlot( int threadnum, int num );
+	const MDTRA_PrefetchSegment *findSegment( int num ) const;
+	int calcBlockLimit( void ) const;
+	void tune( void );
+
+private:
+	const MDTRA_Stream*	m_pStreams[MDTRA_MAX_PREFETCH_STREAMS];
+	int					m_iNumStreams;
+	MDTRA_PrefetchSegment*	m_pSegments;
+	int					m_iNumSegments;
+	int					m_iWorkCount;
+	int					m_iNextFrame;
+	int					m_iNumFloats;
+	int					m_iNumSlots;
+	int					m_iBlockLimit;
+	int					m_iNumReaders;
+	int					m_iMaxReaders;
+	volatile int		m_iReaderLimit;
+	volatile int		m_iWorkerLimit;
+	bool				m_bTuning;
+	double				m_fLoadUsec[2];
+	int					m_iLoadCount[2];
+	double				m_fComputeUsec;
+	int					m_iComputeCount;
+	bool				m_bAbort;
+	MDTRA_PrefetchSlot*	m_pSlots;
+	MDTRA_PrefetchSync*	m_pSync;
+};
+
+extern MDTRA_FramePrefetcher *MDTRA_CreateFramePrefetcher( const MDTRA_Stream *pStream, const MDTRA_Stream *pStream2, int workStart, int workStride = 1 );
+
+#endif //MDTRA_PREFETCH_H
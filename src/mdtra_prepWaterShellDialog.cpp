@@ -26,6 +26,7 @@
 #include "mdtra_pipe.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_prepWaterShellDialog.h"
 
 #include <QtGui/QFileDialog>
@@ -58,7 +59,7 @@ MDTRA_PrepWaterShellDialog :: MDTRA_PrepWaterShellDialog( QWidget *parent )
 		MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStream( i );
 		if (pStream && pStream->pdb) {
 			sCombo->addItem( QIcon(":/png/16x16/stream.png"), 
-				tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()),
+				tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )),
 				pStream->index );
 		}
 	}
@@ -85,7 +86,7 @@ void MDTRA_PrepWaterShellDialog :: exec_on_stream_change( void )
 {
 	int streamIndex = sCombo->itemData( sCombo->currentIndex() ).toInt();
 	const MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStreamByIndex( streamIndex );
-	eIndex->setMaximum( pStream->files.count() );
+	eIndex->setMaximum( MDTRA_GetStreamFrameCount( pStream ) );
 #if QT_VERSION >= 0x040700
 	QString streamPDB = QFileInfo( pStream->files.at( 0 ) ).completeBaseName();
 	txtOutputPDB->setPlaceholderText( streamPDB.append( ".wbr.pdb" ) );
@@ -144,6 +145,12 @@ void MDTRA_PrepWaterShellDialog :: exec_on_prep( void )
 		return;
 	}
 
+	//external program reads PDB snapshots only
+	if (MDTRA_IsTrajectoryStream( pStream )) {
+		QMessageBox::warning(this, tr(APPLICATION_TITLE_SMALL), tr("Trajectory file streams are not supported by this tool!"));
+		return;
+	}
+
 	txtOutput->clear();
 	btnRun->setEnabled( false );
 
@@ -165,7 +172,7 @@ void MDTRA_PrepWaterShellDialog :: exec_on_prep( void )
 	}
 
 	int trajectoryMin = 1;
-	int trajectoryMax = pStream->files.count();
+	int trajectoryMax = MDTRA_GetStreamFrameCount( pStream );
 	if (trajectoryRange->isChecked()) {
 		trajectoryMin = MDTRA_MAX( trajectoryMin, sIndex->value() );
 		trajectoryMax = MDTRA_MIN( trajectoryMax, eIndex->value());
@@ -0,0 +1,387 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of the hierarchical per-thread profiler
+
+#include "mdtra_main.h"
+#include "mdtra_profiler.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_InterlockedIncrement)
+#endif
+
+typedef struct stMDTRA_ProfEvent
+{
+	const char*	name;
+	double		start;			//microseconds since the session start
+	double		duration;
+	short		phase;
+	short		depth;
+} MDTRA_ProfEvent;
+
+typedef struct stMDTRA_ProfFrame
+{
+	const char*	name;
+	int			phase;
+	double		start;
+	double		childUsec;
+} MDTRA_ProfFrame;
+
+typedef struct stMDTRA_ProfScopeStat
+{
+	const char*	name;
+	int			phase;
+	int			count;
+	double		totalUsec;
+	double		selfUsec;
+} MDTRA_ProfScopeStat;
+
+typedef struct stMDTRA_ProfThread
+{
+	int						kind;
+	int						index;
+	int						depth;			//may exceed MDTRA_PROF_MAX_DEPTH, deeper scopes are not timed
+	MDTRA_ProfFrame			stack[MDTRA_PROF_MAX_DEPTH];
+	MDTRA_ProfEvent*		pEvents;		//ring buffer
+	long					numEvents;		//events recorded, the ring keeps the last MDTRA_PROF_RING_SIZE
+	int						numScopes;
+	MDTRA_ProfScopeStat		scopes[MDTRA_PROF_MAX_SCOPES];
+	double					phaseUsec[MDTRA_PROF_PHASE_COUNT];
+} MDTRA_ProfThread;
+
+static const char *s_phaseNames[MDTRA_PROF_PHASE_COUNT] = { "build", "io", "parse", "align", "compute", "reduce", "wait", "gui" };
+
+volatile bool g_bProfilerActive = false;
+
+static MDTRA_ProfThread *s_pThreads[MDTRA_PROF_MAX_THREADS];
+static volatile long s_iNumThreads = 0;		//registrations, may exceed MDTRA_PROF_MAX_THREADS
+static int s_iSession = 0;
+static double s_flStartUsec = 0.0;
+static double s_flStopUsec = 0.0;
+static QString s_traceFile;
+
+static MDTRA_THREAD_LOCAL MDTRA_ProfThread *tl_pThread = NULL;
+static MDTRA_THREAD_LOCAL int tl_iSession = 0;
+static MDTRA_THREAD_LOCAL int tl_iKind = MDTRA_PROF_THREAD_MAIN;
+static MDTRA_THREAD_LOCAL int tl_iIndex = 0;
+
+static long ProfilerIncrement( volatile long *pValue )
+{
+#if defined(_MSC_VER)
+	return _InterlockedIncrement( pValue );
+#else
+	return __sync_add_and_fetch( pValue, 1 );
+#endif
+}
+
+static void ProfilerResetThread( MDTRA_ProfThread *pThread )
+{
+	MDTRA_ProfEvent *pEvents = pThread->pEvents;
+	memset( pThread, 0, sizeof(MDTRA_ProfThread) );
+	pThread->pEvents = pEvents;
+}
+
+//the first scope of a thread in a session claims a record
+static MDTRA_ProfThread *ProfilerCurrentThread( bool create )
+{
+	if (tl_iSession == s_iSession)
+		return tl_pThread;
+	if (!create)
+		return NULL;
+
+	tl_iSession = s_iSession;
+	tl_pThread = NULL;
+
+	long slot = ProfilerIncrement( &s_iNumThreads ) - 1;
+	if (slot >= MDTRA_PROF_MAX_THREADS)
+		return NULL;
+
+	MDTRA_ProfThread *pThread = s_pThreads[slot];
+	if (!pThread) {
+		pThread = new MDTRA_ProfThread;
+		pThread->pEvents = new MDTRA_ProfEvent[MDTRA_PROF_RING_SIZE];
+		ProfilerResetThread( pThread );
+		s_pThreads[slot] = pThread;
+	}
+	pThread->kind = tl_iKind;
+	pThread->index = tl_iIndex;
+	tl_pThread = pThread;
+	return pThread;
+}
+
+static MDTRA_ProfScopeStat *ProfilerFindScope( MDTRA_ProfThread *pThread, const char *name, int phase )
+{
+	for (int i = 0; i < pThread->numScopes; i++) {
+		MDTRA_ProfScopeStat *pStat = pThread->scopes + i;
+		if (pStat->name == name && pStat->phase == phase)
+			return pStat;
+	}
+
+	//the last entry collects whatever does not fit
+	MDTRA_ProfScopeStat *pStat = pThread->scopes + pThread->numScopes;
+	if (pThread->numScopes == MDTRA_PROF_MAX_SCOPES - 1) {
+		name = "(other)";
+		if (pStat->name)
+			return pStat;
+	} else {
+		pThread->numScopes++;
+	}
+	pStat->name = name;
+	pStat->phase = phase;
+	return pStat;
+}
+
+void ProfilerStart( void )
+{
+	int numThreads = MDTRA_MIN( (int)s_iNumThreads, MDTRA_PROF_MAX_THREADS );
+	for (int i = 0; i < numThreads; i++)
+		ProfilerResetThread( s_pThreads[i] );
+
+	s_iNumThreads = 0;
+	s_iSession++;
+	s_flStartUsec = ThreadMicroseconds();
+	s_flStopUsec = s_flStartUsec;
+	g_bProfilerActive = true;
+}
+
+void ProfilerStop( void )
+{
+	g_bProfilerActive = false;
+	s_flStopUsec = ThreadMicroseconds();
+}
+
+void ProfilerNameThread( MDTRA_ProfThreadKind kind, int index )
+{
+	tl_iKind = kind;
+	tl_iIndex = index;
+}
+
+void ProfilerBegin( const char *name, MDTRA_ProfPhase phase )
+{
+	if (!g_bProfilerActive)
+		return;
+
+	MDTRA_ProfThread *pThread = ProfilerCurrentThread( true );
+	if (!pThread)
+		return;
+
+	int depth = pThread->depth++;
+	if (depth >= MDTRA_PROF_MAX_DEPTH)
+		return;
+
+	MDTRA_ProfFrame *pFrame = pThread->stack + depth;
+	pFrame->name = name;
+	pFrame->phase = phase;
+	pFrame->childUsec = 0.0;
+	pFrame->start = ThreadMicroseconds();
+}
+
+void ProfilerEnd( void )
+{
+	if (!g_bProfilerActive)
+		return;
+
+	MDTRA_ProfThread *pThread = ProfilerCurrentThread( false );
+	if (!pThread || pThread->depth <= 0)
+		return;
+
+	double now = ThreadMicroseconds();
+	int depth = --pThread->depth;
+	if (depth >= MDTRA_PROF_MAX_DEPTH)
+		return;
+
+	const MDTRA_ProfFrame *pFrame = pThread->stack + depth;
+	double total = now - pFrame->start;
+	double self = total - pFrame->childUsec;
+	if (depth > 0)
+		pThread->stack[depth-1].childUsec += total;
+
+	pThread->phaseUsec[pFrame->phase] += self;
+
+	MDTRA_ProfScopeStat *pStat = ProfilerFindScope( pThread, pFrame->name, pFrame->phase );
+	pStat->count++;
+	pStat->totalUsec += total;
+	pStat->selfUsec += self;
+
+	MDTRA_ProfEvent *pEvent = pThread->pEvents + (pThread->numEvents % MDTRA_PROF_RING_SIZE);
+	pEvent->name = pFrame->name;
+	pEvent->start = pFrame->start - s_flStartUsec;
+	pEvent->duration = total;
+	pEvent->phase = (short)pFrame->phase;
+	pEvent->depth = (short)depth;
+	pThread->numEvents++;
+}
+
+//////////////////////////////////////////////////////////////////////
+// reports
+
+static QString ProfilerThreadName( const MDTRA_ProfThread *pThread )
+{
+	switch (pThread->kind) {
+	default:
+	case MDTRA_PROF_THREAD_MAIN: return QString("main");
+	case MDTRA_PROF_THREAD_WORKER: return QString("worker %1").arg(pThread->index);
+	case MDTRA_PROF_THREAD_READER: return QString("reader %1").arg(pThread->index);
+	}
+}
+
+static bool ProfilerScopeGreater( const MDTRA_ProfScopeStat &a, const MDTRA_ProfScopeStat &b )
+{
+	return (a.selfUsec > b.selfUsec);
+}
+
+QString ProfilerSummary( void )
+{
+	int numThreads = MDTRA_MIN( (int)s_iNumThreads, MDTRA_PROF_MAX_THREADS );
+	double phaseUsec[MDTRA_PROF_PHASE_COUNT];
+	double allUsec = 0.0;
+	long lostEvents = 0;
+	QList<MDTRA_ProfScopeStat> scopes;
+
+	memset( phaseUsec, 0, sizeof(phaseUsec) );
+	for (int i = 0; i < numThreads; i++) {
+		const MDTRA_ProfThread *pThread = s_pThreads[i];
+		for (int p = 0; p < MDTRA_PROF_PHASE_COUNT; p++) {
+			phaseUsec[p] += pThread->phaseUsec[p];
+			allUsec += pThread->phaseUsec[p];
+		}
+		if (pThread->numEvents > MDTRA_PROF_RING_SIZE)
+			lostEvents += pThread->numEvents - MDTRA_PROF_RING_SIZE;
+
+		//same scope on different threads shares the name literal
+		for (int j = 0; j < pThread->numScopes; j++) {
+			const MDTRA_ProfScopeStat *pStat = pThread->scopes + j;
+			int k;
+			for (k = 0; k < scopes.count(); k++) {
+				if (scopes.at(k).name == pStat->name && scopes.at(k).phase == pStat->phase)
+					break;
+			}
+			if (k == scopes.count()) {
+				scopes << *pStat;
+			} else {
+				MDTRA_ProfScopeStat &merged = scopes[k];
+				merged.count += pStat->count;
+				merged.totalUsec += pStat->totalUsec;
+				merged.selfUsec += pStat->selfUsec;
+			}
+		}
+	}
+	std::sort( scopes.begin(), scopes.end(), ProfilerScopeGreater );
+
+	QString text = QString("Profiled %1 ms on %2 thread(s)\n").arg((s_flStopUsec - s_flStartUsec) * 0.001, 0, 'f', 1).arg(numThreads);
+	if ((int)s_iNumThreads > numThreads)
+		text += QString("%1 thread(s) beyond the first %2 were not recorded\n").arg((int)s_iNumThreads - numThreads).arg(MDTRA_PROF_MAX_THREADS);
+
+	text += QString("\n%1 %2 %3\n").arg("Phase", -10).arg("Self ms", 12).arg("Share", 8);
+	for (int p = 0; p < MDTRA_PROF_PHASE_COUNT; p++) {
+		if (phaseUsec[p] <= 0.0)
+			continue;
+		text += QString("%1 %2 %3%\n").arg(s_phaseNames[p], -10).arg(phaseUsec[p] * 0.001, 12, 'f', 2)
+			.arg(allUsec > 0.0 ? phaseUsec[p] * 100.0 / allUsec : 0.0, 7, 'f', 1);
+	}
+
+	text += QString("\n%1 %2 %3 %4\n").arg("Thread", -10).arg("Busy ms", 12).arg("Wait ms", 12).arg("Scopes", 10);
+	for (int i = 0; i < numThreads; i++) {
+		const MDTRA_ProfThread *pThread = s_pThreads[i];
+		double waitUsec = pThread->phaseUsec[MDTRA_PROF_WAIT] + pThread->phaseUsec[MDTRA_PROF_GUI];
+		double busyUsec = -waitUsec;
+		for (int p = 0; p < MDTRA_PROF_PHASE_COUNT; p++)
+			busyUsec += pThread->phaseUsec[p];
+		text += QString("%1 %2 %3 %4\n").arg(ProfilerThreadName( pThread ), -10).arg(busyUsec * 0.001, 12, 'f', 2)
+			.arg(waitUsec * 0.001, 12, 'f', 2).arg(pThread->numEvents, 10);
+	}
+
+	text += QString("\n%1 %2 %3 %4 %5\n").arg("Scope", -24).arg("Phase", -8).arg("Calls", 10).arg("Total ms", 12).arg("Self ms", 12);
+	for (int i = 0; i < scopes.count(); i++) {
+		const MDTRA_ProfScopeStat *pStat = &scopes.at(i);
+		text += QString("%1 %2 %3 %4 %5\n").arg(pStat->name, -24).arg(s_phaseNames[pStat->phase], -8).arg(pStat->count, 10)
+			.arg(pStat->totalUsec * 0.001, 12, 'f', 2).arg(pStat->selfUsec * 0.001, 12, 'f', 2);
+	}
+
+	if (lostEvents > 0)
+		text += QString("\nThe trace keeps the last %1 scopes per thread, %2 older ones were dropped\n").arg(MDTRA_PROF_RING_SIZE).arg(lostEvents);
+	return text;
+}
+
+static void ProfilerWriteString( FILE *fp, const char *s )
+{
+	fputc( '"', fp );
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fputc( '\\', fp );
+		if ((unsigned char)*s >= 0x20)
+			fputc( *s, fp );
+	}
+	fputc( '"', fp );
+}
+
+//Chrome trace event format: complete ("X") events, one track per thread
+bool ProfilerWriteTrace( const QString &fileName )
+{
+	FILE *fp = NULL;
+	if (fopen_s( &fp, fileName.toLocal8Bit().constData(), "w" ))
+		return false;
+
+	int numThreads = MDTRA_MIN( (int)s_iNumThreads, MDTRA_PROF_MAX_THREADS );
+
+	fprintf( fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+	fprintf( fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"MDTRA\"}}" );
+
+	for (int i = 0; i < numThreads; i++) {
+		const MDTRA_ProfThread *pThread = s_pThreads[i];
+		fprintf( fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", i );
+		ProfilerWriteString( fp, ProfilerThreadName( pThread ).toLatin1().constData() );
+		fprintf( fp, "}}" );
+
+		long count = MDTRA_MIN( pThread->numEvents, (long)MDTRA_PROF_RING_SIZE );
+		long oldest = pThread->numEvents - count;
+		for (long j = 0; j < count; j++) {
+			const MDTRA_ProfEvent *pEvent = pThread->pEvents + ((oldest + j) % MDTRA_PROF_RING_SIZE);
+			fprintf( fp, ",\n{\"name\":" );
+			ProfilerWriteString( fp, pEvent->name );
+			fprintf( fp, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+					 s_phaseNames[pEvent->phase], pEvent->start, pEvent->duration, i );
+		}
+	}
+
+	fprintf( fp, "\n]}\n" );
+	bool ok = !ferror( fp );
+	fclose( fp );
+	return ok;
+}
+
+void ProfilerSetTraceFile( const QString &fileName )
+{
+	s_traceFile = fileName;
+}
+
+QString ProfilerTraceFile( void )
+{
+	if (!s_traceFile.isEmpty())
+		return s_traceFile;
+	return QDir::temp().filePath( "mdtra_trace.json" );
+}
@@ -0,0 +1,93 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_PROFILER_H
+#define MDTRA_PROFILER_H
+
+//Hierarchical per-thread profiler
+//Scoped timers record into a ring buffer of the thread they run on, so
+//recording takes no lock. Time of every scope is split into the time of
+//its children and its own (self) time, which is charged to the phase of
+//the scope. A finished session is reported as a summary table and can be
+//written as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+//Scopes cost a single flag test while no session is running.
+
+#define MDTRA_PROF_MAX_THREADS		64
+#define MDTRA_PROF_MAX_DEPTH		32
+#define MDTRA_PROF_MAX_SCOPES		64			//distinct scope names per thread
+#define MDTRA_PROF_RING_SIZE		32768		//trace events kept per thread
+
+typedef enum {
+	MDTRA_PROF_BUILD = 0,		//orchestration: setup and bookkeeping
+	MDTRA_PROF_IO,				//reading frames, cache lookups
+	MDTRA_PROF_PARSE,			//decoding frames into atoms
+	MDTRA_PROF_ALIGN,			//superposition
+	MDTRA_PROF_COMPUTE,			//analysis kernels
+	MDTRA_PROF_REDUCE,			//merging per-thread and per-frame data
+	MDTRA_PROF_WAIT,			//blocked on other threads
+	MDTRA_PROF_GUI,				//event processing and progress updates
+	MDTRA_PROF_PHASE_COUNT
+} MDTRA_ProfPhase;
+
+typedef enum {
+	MDTRA_PROF_THREAD_MAIN = 0,
+	MDTRA_PROF_THREAD_WORKER,
+	MDTRA_PROF_THREAD_READER
+} MDTRA_ProfThreadKind;
+
+class QString;
+
+extern volatile bool g_bProfilerActive;
+
+//owner side, not thread-safe; workers must be idle when a session starts or stops
+extern void ProfilerStart( void );
+extern void ProfilerStop( void );
+extern QString ProfilerSummary( void );
+extern bool ProfilerWriteTrace( const QString &fileName );
+extern void ProfilerSetTraceFile( const QString &fileName );
+extern QString ProfilerTraceFile( void );
+
+//worker side, thread-safe; Begin and End pairs outside of a session are ignored
+extern void ProfilerNameThread( MDTRA_ProfThreadKind kind, int index );
+extern void ProfilerBegin( const char *name, MDTRA_ProfPhase phase );
+extern void ProfilerEnd( void );
+
+class MDTRA_ProfScope
+{
+public:
+	MDTRA_ProfScope( const char *name, MDTRA_ProfPhase phase ) : m_bActive( g_bProfilerActive ) { if (m_bActive) ProfilerBegin( name, phase ); }
+	~MDTRA_ProfScope() { if (m_bActive) ProfilerEnd(); }
+
+private:
+	bool m_bActive;
+};
+
+//the scope variable is named after the line, so several scopes may share a block
+#define MDTRA_PROF_CONCAT2(a, b)			a##b
+#define MDTRA_PROF_CONCAT(a, b)				MDTRA_PROF_CONCAT2(a, b)
+#define MDTRA_PROF_SCOPE_VAR				MDTRA_PROF_CONCAT(mdtra_prof_scope_, __LINE__)
+
+//name must be a string literal or otherwise outlive the session
+#define MDTRA_PROF_SCOPE(name, phase)		MDTRA_ProfScope MDTRA_PROF_SCOPE_VAR( name, phase )
+
+#define MDTRA_PROF_START(f)					{ MDTRA_ProfScope MDTRA_PROF_SCOPE_VAR( #f, MDTRA_PROF_COMPUTE );
+#define MDTRA_PROF_END()					}
+
+#endif //MDTRA_PROFILER_H
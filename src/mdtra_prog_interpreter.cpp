@@ -28,9 +28,9 @@
 #include "mdtra_progressDialog.h"
 #include "mdtra_prog_state.h"
 #include "mdtra_prog_interpreter.h"
+#include "mdtra_batch.h"
 
 #include <QtGui/QApplication>
-#include <QtGui/QMessageBox>
 
 //must not be enabled! only for debug!!
 #define SHOW_ERROR_MSG
@@ -81,11 +81,11 @@ bool MDTRA_Program_Interpreter :: Init( void* pdbFile, int dataSize )
 		m_states[i].dataSize = dataSize;
 
 		if ( luaL_loadbinary( L, m_pcode, m_isize, NULL ) ) {
-			QMessageBox::warning( NULL, QString(APPLICATION_TITLE_SMALL), "Failed to load program");
+			BatchWarning( NULL, QString(APPLICATION_TITLE_SMALL), "Failed to load program");
 			return false;
 		}
 		if ( lua_pcall(L, 0, LUA_MULTRET, 0) ) {
-			QMessageBox::warning( NULL, QString(APPLICATION_TITLE_SMALL), "Failed to initialize program");
+			BatchWarning( NULL, QString(APPLICATION_TITLE_SMALL), "Failed to initialize program");
 			return false;
 		}
 	}
@@ -123,7 +123,7 @@ void MDTRA_Program_Interpreter :: RunError( lua_State* L )
 #endif
 	ThreadUnlock();
 
-	QMessageBox::warning( pProgressDialog, APPLICATION_TITLE_SMALL, msgstring );
+	BatchWarning( pProgressDialog, APPLICATION_TITLE_SMALL, msgstring );
 }
 
 bool MDTRA_Program_Interpreter :: Main( int threadnum, int num, void* pdbFile, float* presult )
@@ -0,0 +1,76 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of the progress and cancellation channel
+
+#include "mdtra_progress.h"
+
+MDTRA_ProgressChannel g_Progress = { 0, 0, 0, 0, 0 };
+
+void ProgressReset( void )
+{
+	g_Progress.files = 0;
+	g_Progress.stream = 0;
+	g_Progress.interrupt = 0;
+	g_Progress.fileCount = 0;
+	g_Progress.streamCount = 0;
+}
+
+void ProgressSetFileCount( int count )
+{
+	g_Progress.fileCount = count;
+}
+
+void ProgressSetStreamCount( int count )
+{
+	g_Progress.streamCount = count;
+}
+
+void ProgressSetFiles( int value )
+{
+	g_Progress.files = value;
+}
+
+void ProgressSetStream( int value )
+{
+	g_Progress.stream = value;
+}
+
+int ProgressGetPercent( void )
+{
+	long count = g_Progress.fileCount;
+	if (count <= 0)
+		return 0;
+
+	long files = g_Progress.files;
+	if (files >= count)
+		return 100;
+	return (int)((double)files * 100.0 / (double)count);
+}
+
+int ProgressGetStream( void )
+{
+	long stream = g_Progress.stream;
+	if (stream > g_Progress.streamCount)
+		stream = g_Progress.streamCount;
+	return (int)stream;
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_PROGRESS_H
+#define MDTRA_PROGRESS_H
+
+//Lock-free progress and cancellation channel
+//Workers only touch atomic counters: work items completed, the last stream
+//started and the interrupt flag. Whoever shows the progress (the progress
+//dialog, or a console report in headless runs) samples the counters at its
+//own refresh rate, so a work item costs no lock and no event processing.
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_InterlockedIncrement)
+#pragma intrinsic(_InterlockedCompareExchange)
+#endif
+
+typedef struct stMDTRA_ProgressChannel
+{
+	volatile long	files;			//work items completed
+	volatile long	stream;			//streams started
+	volatile long	interrupt;
+	long			fileCount;
+	long			streamCount;
+} MDTRA_ProgressChannel;
+
+extern MDTRA_ProgressChannel g_Progress;
+
+//owner side, not thread-safe
+extern void ProgressReset( void );
+extern void ProgressSetFileCount( int count );
+extern void ProgressSetStreamCount( int count );
+extern void ProgressSetFiles( int value );
+extern void ProgressSetStream( int value );
+extern int  ProgressGetPercent( void );
+extern int  ProgressGetStream( void );
+
+//worker side, thread-safe
+inline void ProgressStepFile( void )
+{
+#if defined(_MSC_VER)
+	_InterlockedIncrement( &g_Progress.files );
+#else
+	__sync_add_and_fetch( &g_Progress.files, 1 );
+#endif
+}
+
+//stream = index of the stream a work item belongs to; the channel keeps the last one started
+inline void ProgressAdvanceStream( int stream )
+{
+	long value = stream + 1;
+	long current;
+	while ((current = g_Progress.stream) < value) {
+#if defined(_MSC_VER)
+		if (_InterlockedCompareExchange( &g_Progress.stream, value, current ) == current)
+#else
+		if (__sync_bool_compare_and_swap( &g_Progress.stream, current, value ))
+#endif
+			break;
+	}
+}
+
+inline void ProgressInterrupt( void )
+{
+	g_Progress.interrupt = 1;
+}
+
+inline bool ProgressInterrupted( void )
+{
+	return (g_Progress.interrupt != 0);
+}
+
+#endif //MDTRA_PROGRESS_H
@@ -43,12 +43,9 @@ MDTRA_ProgressDialog :: MDTRA_ProgressDialog( QWidget *parent )
 	currentProgress->setMaximum(100);
 
 	m_iStreamCount = 0;
-	m_iFileCount = 0;
 	m_iCurrentStream = 0;
-	m_iCurrentFile = 0;
-	m_iCurrentPercent = -1;
-	m_bInterrupt = false;
-	m_bUpdateGUI = false;
+	m_iCurrentPercent = 0;
+	ProgressReset();
 
 	connect(pushButton, SIGNAL(clicked()), this, SLOT(set_interrupt()));
 }
@@ -56,6 +53,7 @@ MDTRA_ProgressDialog :: MDTRA_ProgressDialog( QWidget *parent )
 void MDTRA_ProgressDialog :: setStreamCount( int value )
 {
 	m_iStreamCount = value;
+	ProgressSetStreamCount( value );
 	lblStreams->setText( tr("Stream: %1/%2").arg(m_iCurrentStream).arg(m_iStreamCount) );
 	streamProgress->setMaximum( value );
 	QApplication::processEvents();
@@ -63,16 +61,16 @@ void MDTRA_ProgressDialog :: setStreamCount( int value )
 
 void MDTRA_ProgressDialog :: setFileCount( int value )
 {
-	m_iFileCount = value;
-	m_iCurrentPercent = (m_iCurrentFile * 100 / m_iFileCount);
+	ProgressSetFileCount( value );
+	m_iCurrentPercent = ProgressGetPercent();
 	lblCurrent->setText( tr("Current Stream: %1%").arg(m_iCurrentPercent) );
 	QApplication::processEvents();
 }
 
 void MDTRA_ProgressDialog :: setCurrentStream( int value )
 {
-	m_iCurrentStream = value + 1;
-	if (m_iCurrentStream > m_iStreamCount) m_iCurrentStream = m_iStreamCount;
+	ProgressSetStream( value + 1 );
+	m_iCurrentStream = ProgressGetStream();
 	lblStreams->setText( tr("Stream: %1/%2").arg(m_iCurrentStream).arg(m_iStreamCount) );
 	streamProgress->setValue( value );
 	QApplication::processEvents();
@@ -80,8 +78,8 @@ void MDTRA_ProgressDialog :: setCurrentStream( int value )
 
 void MDTRA_ProgressDialog :: setCurrentFile( int value )
 {
-	m_iCurrentFile = value;
-	m_iCurrentPercent = (m_iCurrentFile * 100 / m_iFileCount);
+	ProgressSetFiles( value );
+	m_iCurrentPercent = ProgressGetPercent();
 	lblCurrent->setText( tr("Current Stream: %1%").arg(m_iCurrentPercent) );
 	currentProgress->setValue( m_iCurrentPercent );
 	QApplication::processEvents();
@@ -97,64 +95,49 @@ void MDTRA_ProgressDialog :: setProgressAtMax( void )
 	QApplication::processEvents();
 }
 
-void MDTRA_ProgressDialog :: advanceCurrentFile( int value )
-{
-	if (value <= m_iCurrentFile)
-		return;
-
-	m_iCurrentFile = value;
-	int iPercent = (m_iCurrentFile * 100 / m_iFileCount);
-	if (iPercent > m_iCurrentPercent) {
-		ThreadLock();
-		m_iCurrentPercent = iPercent;
-		m_bUpdateGUI = true;
-		if (CountThreads() <= 1) {
-			updateGUI();
-			QApplication::processEvents();
-		}
-		ThreadUnlock();
-	}
-}
-
 void MDTRA_ProgressDialog :: set_interrupt( void )
 {
-	m_bInterrupt = true;
+	ProgressInterrupt();
 }
 
 void MDTRA_ProgressDialog :: updateGUI( void )
 {
-	if (!m_bUpdateGUI)
+	//samples the progress channel, called on the GUI thread only
+	if (!needUpdateGUI())
 		return;
 
+	m_iCurrentStream = ProgressGetStream();
+	m_iCurrentPercent = ProgressGetPercent();
+	lblStreams->setText( tr("Stream: %1/%2").arg(m_iCurrentStream).arg(m_iStreamCount) );
+	streamProgress->setValue( m_iCurrentStream - 1 );
 	lblCurrent->setText( tr("Current Stream: %1%").arg(m_iCurrentPercent) );
 	currentProgress->setValue( m_iCurrentPercent );
-	m_bUpdateGUI = false;
 }
 
 void MDTRA_ProgressBarWrapper :: setValue( int value )
 {
-	if (value <= m_iValue)
-		return;
+	//lock-free maximum, the GUI thread picks the value up in updateGUI
+	long current;
+	while ((current = m_iValue) < value) {
+#if defined(_MSC_VER)
+		if (_InterlockedCompareExchange( &m_iValue, value, current ) == current)
+#else
+		if (__sync_bool_compare_and_swap( &m_iValue, current, (long)value ))
+#endif
+			break;
+	}
 
-	m_iValue = value;
-	int iPercent = (m_iValue * 100 / m_iMaxValue);
-	if (iPercent > m_iCurrentPercent) {
-		ThreadLock();
-		m_iCurrentPercent = iPercent;
-		m_bUpdateGUI = true;
-		if (m_bSingleThreaded || CountThreads() <= 1) {
-			updateGUI();
-			QApplication::processEvents();
-		}
-		ThreadUnlock();
+	if (m_bSingleThreaded && needUpdateGUI()) {
+		updateGUI();
+		QApplication::processEvents();
 	}
 }
 
 void MDTRA_ProgressBarWrapper :: updateGUI( void )
 {
-	if (!m_bUpdateGUI || !m_pBar)
+	if (!needUpdateGUI())
 		return;
 
+	m_iCurrentPercent = getPercent();
 	m_pBar->setValue( m_iCurrentPercent );
-	m_bUpdateGUI = false;
-}
\ No newline at end of file
+}
@@ -24,6 +24,7 @@
 #include <QtGui/QDialog>
 
 #include "ui_progressDialog.h"
+#include "mdtra_progress.h"
 
 class MDTRA_MainWindow;
 
@@ -37,11 +38,10 @@ public:
 	void setFileCount( int value );
 	void setCurrentStream( int value );
 	void setCurrentFile( int value );
-	void advanceCurrentFile( int value );
 	void setProgressAtMax( void );
 	void updateGUI( void );
-	bool checkInterrupt( void ) { return m_bInterrupt; }
-	bool needUpdateGUI( void ) { return m_bUpdateGUI; }
+	bool checkInterrupt( void ) { return ProgressInterrupted(); }
+	bool needUpdateGUI( void ) { return (ProgressGetPercent() != m_iCurrentPercent || ProgressGetStream() != m_iCurrentStream); }
 
 private slots:
 	void set_interrupt( void );
@@ -49,32 +49,30 @@ private slots:
 private:
 	MDTRA_MainWindow* m_pMainWindow;
 	int m_iStreamCount;
-	int m_iFileCount;
 	int m_iCurrentStream;
-	int m_iCurrentFile;
 	int m_iCurrentPercent;
-	bool m_bInterrupt;
-	bool m_bUpdateGUI;
 };
 
 class MDTRA_ProgressBarWrapper
 {
 public:
-	MDTRA_ProgressBarWrapper() { m_pBar = NULL; m_bUpdateGUI = false; }
+	MDTRA_ProgressBarWrapper() { m_pBar = NULL; m_iValue = 0; m_iMaxValue = 0; m_iCurrentPercent = -1; m_bSingleThreaded = false; }
 	void setProgressBar( QProgressBar* pBar ) { m_pBar = pBar; }
 	void setSingleThreaded( bool b ) { m_bSingleThreaded = b; }
-	bool needUpdateGUI( void ) { return m_bUpdateGUI; }
+	bool needUpdateGUI( void ) { return (m_pBar && getPercent() > m_iCurrentPercent); }
 	void setMaximumValue( int value ) { m_iMaxValue = value; }
 	void resetValue( int value ) { m_iValue = value; m_iCurrentPercent = -1; }
 	void setValue( int value );
 	void updateGUI( void );
 
+private:
+	int getPercent( void ) const { return (m_iMaxValue > 0) ? (int)((double)m_iValue * 100.0 / (double)m_iMaxValue) : 0; }
+
 private:
 	QProgressBar *m_pBar;
-	int m_iValue;
+	volatile long m_iValue;		//written by workers
 	int m_iMaxValue;
-	int m_iCurrentPercent;
-	bool m_bUpdateGUI;
+	int m_iCurrentPercent;		//shown by the GUI thread
 	bool m_bSingleThreaded;
 };
 
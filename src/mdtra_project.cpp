@@ -27,17 +27,23 @@
 #include "mdtra_math.h"
 #include "mdtra_project.h"
 #include "mdtra_pdb.h"
+#include "mdtra_stream.h"
+#include "mdtra_sweep.h"
+#include "mdtra_prefetch.h"
 #include "mdtra_pdb_format.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_SAS.h"
 #include "mdtra_utils.h"
+#include "mdtra_progress.h"
+#include "mdtra_profiler.h"
 #include "mdtra_progressDialog.h"
 #include "mdtra_prog_state.h"
 #include "mdtra_prog_interpreter.h"
+#include "mdtra_batch.h"
 
+#include <QtCore/QDir>
 #include <QtCore/QTextStream>
 #include <QtGui/QListWidget>
-#include <QtGui/QMessageBox>
 
 extern QStringList UTIL_MakeRelativeFileNames( const QStringList &list, const QString &basePath );
 extern QStringList UTIL_MakeAbsoluteFileNames( const QStringList &list, const QString &basePath );
@@ -67,7 +73,10 @@ const char *szScaleUnitNames[MDTRA_YSU_MAX] =
 MDTRA_Project :: MDTRA_Project( MDTRA_MainWindow *pMainWindow ) 
 			   : m_pMainWindow(pMainWindow)
 {
-	assert( m_pMainWindow != NULL );
+	m_iBuildFirst = 1;
+	m_iBuildLast = 0;
+	m_iBuildStride = 1;
+	m_bProfiling = false;
 }
 
 MDTRA_Project :: ~MDTRA_Project()
@@ -78,7 +87,7 @@ MDTRA_Project :: ~MDTRA_Project()
 void MDTRA_Project :: clear()
 {
 	for (int i = 0; i < m_StreamList.count(); i++) {
-		if (m_StreamList.at(i).pdb) delete m_StreamList.at(i).pdb;
+		MDTRA_FreeStream( const_cast<MDTRA_Stream*>(&m_StreamList.at(i)) );
 	}
 	for (int i = 0; i < m_ResultList.count(); i++) {
 		for (int j = 0; j < m_ResultList.at(i).sourceList.count(); j++) {
@@ -91,7 +100,8 @@ void MDTRA_Project :: clear()
 	m_DataSourceList.clear();
 	m_ResultList.clear();
 
-	m_pMainWindow->resetCounters();
+	if (m_pMainWindow)
+		m_pMainWindow->resetCounters();
 
 	updateStreamList();
 	updateDataSourceList();
@@ -121,9 +131,10 @@ bool MDTRA_Project :: loadFile( const QString &projectPath, QDataStream *stream
 
 	//read streams
 	*stream >> c;
-	m_pMainWindow->setStreamCounter( c );
+	if (m_pMainWindow)
+		m_pMainWindow->setStreamCounter( c );
 	for (int i = 0; i < m_StreamList.count(); i++) {
-		if (m_StreamList.at(i).pdb) delete m_StreamList.at(i).pdb;
+		MDTRA_FreeStream( const_cast<MDTRA_Stream*>(&m_StreamList.at(i)) );
 	}
 	m_StreamList.clear();
 	qint32 streamCount;
@@ -141,23 +152,14 @@ bool MDTRA_Project :: loadFile( const QString &projectPath, QDataStream *stream
 		if (newstream.flags & STREAM_FLAG_RELATIVE_PATHS)
 			newstream.files = UTIL_MakeAbsoluteFileNames( newstream.files, projectPath );
 		
-		if (newstream.files.count() > 0) {
-			newstream.pdb = new MDTRA_PDB_File;
-			if (!newstream.pdb->load( 0, newstream.format_identifier, newstream.files.at(0).toAscii(), newstream.flags )) {
-				delete newstream.pdb;
-				newstream.pdb = NULL;
-			} else {
-				newstream.pdb->move_to_centroid();
-			}
-		} else {
-			newstream.pdb = NULL;
-		}
+		MDTRA_InitStream( &newstream );
 		m_StreamList << newstream;
 	}
 
 	//read data sources
 	*stream >> c;
-	m_pMainWindow->setDataSourceCounter( c );
+	if (m_pMainWindow)
+		m_pMainWindow->setDataSourceCounter( c );
 	m_DataSourceList.clear();
 	qint32 dsCount;
 	*stream >> dsCount;
@@ -212,7 +214,8 @@ bool MDTRA_Project :: loadFile( const QString &projectPath, QDataStream *stream
 
 	//read results
 	*stream >> c;
-	m_pMainWindow->setResultCounter( c );
+	if (m_pMainWindow)
+		m_pMainWindow->setResultCounter( c );
 	m_ResultList.clear();
 	qint32 resultCount;
 	*stream >> resultCount;
@@ -238,6 +241,13 @@ bool MDTRA_Project :: loadFile( const QString &projectPath, QDataStream *stream
 			*stream >> dsref.bias;
 			*stream >> dsref.xscale;
 			stream->readRawData( dsref.reserved, sizeof( dsref.reserved ) );
+			dsref.windowStart = 0;
+			dsref.windowStride = 1;
+			if (version > MDTRA_PROJECT_FILE_VERSION_NOWINDOW) {
+				*stream >> dsref.windowStart;
+				*stream >> dsref.windowStride;
+			}
+			dsref.buildTime = 0.0f;
 
 			for (int k = 0; k < MDTRA_SP_MAX; k++)
 				*stream >> dsref.stat[k];
@@ -360,6 +370,8 @@ bool MDTRA_Project :: saveFile( const QString &projectPath, QDataStream *stream
 			*stream << m_ResultList.at(i).sourceList.at(j).bias;
 			*stream << m_ResultList.at(i).sourceList.at(j).xscale;
 			stream->writeRawData( m_ResultList.at(i).sourceList.at(j).reserved, sizeof(m_ResultList.at(i).sourceList.at(j).reserved) );
+			*stream << (qint32)m_ResultList.at(i).sourceList.at(j).windowStart;
+			*stream << (qint32)m_ResultList.at(i).sourceList.at(j).windowStride;
 
 			for (int k = 0; k < MDTRA_SP_MAX; k++) {
 				*stream << m_ResultList.at(i).sourceList.at(j).stat[k];
@@ -472,17 +484,7 @@ int MDTRA_Project :: registerStream( const QString &name, const QStringList &fil
 	stream.xscale = xscale;
 	stream.format_identifier = format_identifier;
 	stream.flags = flags;
-	if (files.count() > 0) {
-		stream.pdb = new MDTRA_PDB_File;
-		if (!stream.pdb->load( 0, stream.format_identifier, stream.files.at(0).toAscii(), stream.flags )) {
-			delete stream.pdb;
-			stream.pdb = NULL;
-		} else {
-			stream.pdb->move_to_centroid();
-		}
-	} else {
-		stream.pdb = NULL;
-	}
+	MDTRA_InitStream( &stream );
 	memset( stream.reserved, 0, sizeof(stream.reserved) );
 	m_StreamList << stream;
 	updateStreamList();
@@ -515,7 +517,7 @@ void MDTRA_Project :: unregisterStream( int index )
 
 	for (int i = 0; i < m_StreamList.count(); i++) {
 		if (m_StreamList.at(i).index == index) {
-			if (m_StreamList.at(i).pdb) delete m_StreamList.at(i).pdb;
+			MDTRA_FreeStream( const_cast<MDTRA_Stream*>(&m_StreamList.at(i)) );
 			m_StreamList.removeAt(i);
 			break;
 		}
@@ -537,29 +539,23 @@ void MDTRA_Project :: modifyStream( int index, const QString &name, const QStrin
 	pStream->xscale = xscale;
 	pStream->format_identifier = format_identifier;
 	pStream->flags = flags;
-	if (pStream->pdb) delete pStream->pdb;
-	if (files.count() > 0) {
-		pStream->pdb = new MDTRA_PDB_File;
-		if (!pStream->pdb->load( 0, pStream->format_identifier, files.at(0).toAscii(), pStream->flags )) {
-			delete pStream->pdb;
-			pStream->pdb = NULL;
-		} else {
-			pStream->pdb->move_to_centroid();
-		}
-	} else {
-		pStream->pdb = NULL;
-	}
+	MDTRA_FreeStream( pStream );
+	MDTRA_InitStream( pStream );
 	invalidateDataSourceByStreamIndex( index );
 	updateStreamList();
+	updateDataSourceList();
 	updateResultList();
 }
 
 void MDTRA_Project :: updateStreamList()
 {
+	if (!m_pMainWindow)
+		return;
+
 	m_pMainWindow->getStreamListWidget()->clear();
 	for (int i = 0; i < m_StreamList.count(); i++) {
 		const MDTRA_Stream *pStream = &m_StreamList.at(i);
-		QListWidgetItem *pItem = new QListWidgetItem( QObject::tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()), m_pMainWindow->getStreamListWidget() );
+		QListWidgetItem *pItem = new QListWidgetItem( QObject::tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )), m_pMainWindow->getStreamListWidget() );
 		pItem->setIcon( QIcon(":/png/16x16/stream.png") );
 		pItem->setData( Qt::UserRole, pStream->index );
 	}
@@ -752,18 +748,29 @@ void MDTRA_Project :: invalidateDataSourceByIndex( int index )
 
 void MDTRA_Project :: updateDataSourceList()
 {
+	if (!m_pMainWindow)
+		return;
+
+	int oldIndex = m_pMainWindow->getDataSourceListWidget()->currentRow();
+
 	m_pMainWindow->getDataSourceListWidget()->clear();
 	for (int i = 0; i < m_DataSourceList.count(); i++) {
 		const MDTRA_DataSource *pDS = &m_DataSourceList.at(i);
-		QListWidgetItem *pItem = new QListWidgetItem( QObject::tr("DATA SOURCE %1: %2\nData Type: %3\nStream source: STREAM %4")
-														.arg(pDS->index)
-														.arg(pDS->name)
-														.arg(UTIL_GetDataSourceTypeName(pDS->type))
-														.arg(pDS->streamIndex), 
-														m_pMainWindow->getDataSourceListWidget() );
+		QString itemText = QObject::tr("DATA SOURCE %1: %2\nData Type: %3\nStream source: STREAM %4")
+										.arg(pDS->index)
+										.arg(pDS->name)
+										.arg(UTIL_GetDataSourceTypeName(pDS->type))
+										.arg(pDS->streamIndex);
+		float buildTime = getDataSourceBuildTime( pDS->index );
+		if (buildTime > 0.0f)
+			itemText.append( QObject::tr("\nBuild time: %1 ms").arg(buildTime, 0, 'f', 1) );
+		QListWidgetItem *pItem = new QListWidgetItem( itemText, m_pMainWindow->getDataSourceListWidget() );
 		pItem->setIcon( QIcon(":/png/16x16/source.png") );
 		pItem->setData( Qt::UserRole, pDS->index );
 	}
+
+	if (oldIndex >=0 && oldIndex < m_pMainWindow->getDataSourceListWidget()->count())
+		m_pMainWindow->getDataSourceListWidget()->setCurrentRow(oldIndex);
 }
 
 bool MDTRA_Project :: checkUniqueResultName( const QString &name )
@@ -802,6 +809,11 @@ int MDTRA_Project :: registerResult( const QString &name, MDTRA_DataType type, M
 	result.units = scaleUnits;
 	result.layout = layout;
 	result.sourceList = dsref;
+	for (int i = 0; i < result.sourceList.count(); i++) {
+		result.sourceList[i].windowStart = 0;
+		result.sourceList[i].windowStride = 1;
+		result.sourceList[i].buildTime = 0.0f;
+	}
 	memset( result.reserved, 0, sizeof(result.reserved) );
 	m_ResultList << result;
 	if (updateGUI)
@@ -874,7 +886,11 @@ void MDTRA_Project :: modifyResult( int index, const QString &name, MDTRA_DataTy
 			pDSRef->iActualDataSize = 0;
 			pDSRef->pData = NULL;
 			pDSRef->pCorrelation = NULL;
+			pDSRef->windowStart = 0;
+			pDSRef->windowStride = 1;
+			pDSRef->buildTime = 0.0f;
 		}
+		updateDataSourceList();
 	} else {
 		for (int i = 0; i < pResult->sourceList.count(); i++) {
 			MDTRA_DSRef* pDSRef = const_cast<MDTRA_DSRef*>(&pResult->sourceList.at(i));
@@ -904,10 +920,13 @@ void MDTRA_Project :: invalidateResult( int index, bool updateList )
 		}
 		pDSRef->iDataSize = 0;
 		pDSRef->iActualDataSize = 0;
+		pDSRef->buildTime = 0.0f;
 	}
 
-	if (updateList)
+	if (updateList) {
+		updateDataSourceList();
 		updateResultList();
+	}
 }
 
 bool MDTRA_Project :: addResultLabel( int index, const MDTRA_Label *pLabel )
@@ -956,6 +975,9 @@ bool MDTRA_Project :: removeResultLabel( int index, int labelIndex )
 
 void MDTRA_Project :: updateResultList()
 {
+	if (!m_pMainWindow)
+		return;
+
 	int oldIndex = m_pMainWindow->getResultListWidget()->currentRow();
 
 	m_pMainWindow->getResultListWidget()->clear();
@@ -976,6 +998,10 @@ void MDTRA_Project :: updateResultList()
 			itemText.append( QObject::tr("Status: Modified") );
 		}
 
+		float buildTime = getResultBuildTime( pResult );
+		if (buildTime > 0.0f)
+			itemText.append( QObject::tr("\nBuild time: %1 ms").arg(buildTime, 0, 'f', 1) );
+
 		QListWidgetItem *pItem = new QListWidgetItem( itemText, m_pMainWindow->getResultListWidget() );
 		if (pResult->status > 0) {
 			pItem->setIcon( QIcon(":/png/16x16/result.png") );
@@ -1029,6 +1055,28 @@ int MDTRA_Project :: getResultDataSourceCountByDataSourceIndex( int index )
 	return c;
 }
 
+//milliseconds the last builds spent on the data source, over all results that use it
+float MDTRA_Project :: getDataSourceBuildTime( int index ) const
+{
+	float t = 0.0f;
+	for (int i = 0; i < m_ResultList.count(); i++) {
+		const QList<MDTRA_DSRef> *pRefList = &m_ResultList.at(i).sourceList;
+		for (int j = 0; j < pRefList->count(); j++) {
+			if (pRefList->at(j).dataSourceIndex == index)
+				t += pRefList->at(j).buildTime;
+		}
+	}
+	return t;
+}
+
+float MDTRA_Project :: getResultBuildTime( const MDTRA_Result *pResult ) const
+{
+	float t = 0.0f;
+	for (int i = 0; i < pResult->sourceList.count(); i++)
+		t += pResult->sourceList.at(i).buildTime;
+	return t;
+}
+
 float MDTRA_Project :: sampleData( const float *pDataPtr, int iSample, int iMaxSample, int iFilterSize, MDTRA_YScaleUnits ysu )
 {
 	if ( iFilterSize <= 1 )
@@ -1089,6 +1137,23 @@ float MDTRA_Project :: sampleData( const float *pDataPtr, int iSample, int iMaxS
 	return ( fSample / (float)(sampleMax - sampleMin) );
 }
 
+int MDTRA_GetDSRefSnapshot( const MDTRA_DSRef *pDSRef, int index )
+{
+	return pDSRef->windowStart + index * MDTRA_MAX( pDSRef->windowStride, 1 );
+}
+
+int MDTRA_Project :: exportRowLabel( const MDTRA_Result *pResult, int row ) const
+{
+	//time layout rows are numbered by the stream snapshot (1-based) the values were built from
+	if (pResult->layout != MDTRA_LAYOUT_TIME)
+		return row + 1;
+	for (int j = 0; j < pResult->sourceList.count(); j++) {
+		if (row < pResult->sourceList.at(j).iActualDataSize)
+			return MDTRA_GetDSRefSnapshot( &pResult->sourceList.at(j), row ) + 1;
+	}
+	return row + 1;
+}
+
 void MDTRA_Project :: exportResultToTXT( const MDTRA_Result *pResult, QTextStream *stream, int dataFilter )
 {
 	int iNumRows = 0;
@@ -1105,7 +1170,7 @@ void MDTRA_Project :: exportResultToTXT( const MDTRA_Result *pResult, QTextStrea
 	*stream << endl;
 
 	for (int i = 0; i < iNumRows; i++) {
-		*stream << (QString("%1").arg( i + 1 ));
+		*stream << (QString("%1").arg( exportRowLabel( pResult, i ) ));
 		for (int j = 0; j < iNumCols; j++) {
 			const MDTRA_DSRef *dataRef = &pResult->sourceList.at(j);
 			if ( i < dataRef->iActualDataSize ) {
@@ -1136,7 +1201,7 @@ void MDTRA_Project :: exportResultToCSV( const MDTRA_Result *pResult, QTextStrea
 	*stream << endl;
 
 	for (int i = 0; i < iNumRows; i++) {
-		*stream << (QString("%1").arg( i + 1 ));
+		*stream << (QString("%1").arg( exportRowLabel( pResult, i ) ));
 		for (int j = 0; j < iNumCols; j++) {
 			const MDTRA_DSRef *dataRef = &pResult->sourceList.at(j);
 			if ( i < dataRef->iActualDataSize ) {
@@ -1195,6 +1260,11 @@ void MDTRA_Project :: exportStatsToTXT( const MDTRA_Result *pResult, QTextStream
 		}
 		*stream << endl;
 	}
+	*stream << QString("\"Build Time (ms)\"");
+	for (int j = 0; j < iNumCols; j++) {
+		*stream << QString("\t%1").arg( pResult->sourceList.at(j).buildTime, 0, 'f', 3 );
+	}
+	*stream << endl;
 
 	if (bHasCorrelationData) {
 		for (int i = 0; i < iNumCols; i++) {
@@ -1240,6 +1310,11 @@ void MDTRA_Project :: exportStatsToCSV( const MDTRA_Result *pResult, QTextStream
 		}
 		*stream << endl;
 	}
+	*stream << QString("\"Build Time (ms)\"");
+	for (int j = 0; j < iNumCols; j++) {
+		*stream << QString(";%1").arg( pResult->sourceList.at(j).buildTime, 0, 'f', 3 );
+	}
+	*stream << endl;
 
 	if (bHasCorrelationData) {
 		for (int i = 0; i < iNumCols; i++) {
@@ -1265,10 +1340,9 @@ void MDTRA_Project :: exportStats( int index, const QString &fileSuffix, QTextSt
 	}
 }
 
-static MDTRA_StreamWork *pLocalStreamWork = NULL;
 extern MDTRA_ProgressDialog *pProgressDialog;
 
-static void fn_BuildStreamData_ResidueBased( MDTRA_StreamWorkResult *pResult, MDTRA_PDB_File *pPdbFile, bool &bAligned, int threadnum, int num, int numfiles )
+static void fn_BuildStreamData_ResidueBased( const MDTRA_StreamWork *pStreamWork, MDTRA_StreamWorkResult *pResult, MDTRA_PDB_File *pPdbFile, bool &bAligned, int threadnum, int num, int numfiles )
 {
 	int iNumFloats;
 	float *pCurrentFloat;
@@ -1295,13 +1369,13 @@ static void fn_BuildStreamData_ResidueBased( MDTRA_StreamWorkResult *pResult, MD
 		if (!bAligned) {
 			//align PDB file with first file in stream
 			pPdbFile->move_to_centroid();
-			pPdbFile->align_kabsch( pLocalStreamWork->pStream->pdb );
+			pPdbFile->align_kabsch( pStreamWork->pStream->pdb );
 			bAligned = true;
 		}
-		pPdbFile->get_rmsd_of_residues( pLocalStreamWork->pStream->pdb, pFloats );
+		pPdbFile->get_rmsd_of_residues( pStreamWork->pStream->pdb, pFloats );
 		break;
 	case MDTRA_DT_RMSD_SEL:
-		if (pLocalStreamWork->pStream->pdb == pPdbFile || !pResult->pRefPDB) {
+		if (pStreamWork->pStream->pdb == pPdbFile || !pResult->pRefPDB) {
 			memset( pFloats, 0, iNumFloats*sizeof(float) );
 			bInitialFrame = true;
 		} else {
@@ -1317,13 +1391,13 @@ static void fn_BuildStreamData_ResidueBased( MDTRA_StreamWorkResult *pResult, MD
 		if (!bAligned) {
 			//align PDB file with first file in stream
 			pPdbFile->move_to_centroid();
-			pPdbFile->align_kabsch( pLocalStreamWork->pStream->pdb );
+			pPdbFile->align_kabsch( pStreamWork->pStream->pdb );
 			bAligned = true;
 		}
-		pPdbFile->get_rmsf_of_atoms( pLocalStreamWork->averagePDB, pFloats );
+		pPdbFile->get_rmsf_of_atoms( pStreamWork->averagePDB, pFloats );
 		break;
 	case MDTRA_DT_RMSF_SEL:
-		if (pLocalStreamWork->pStream->pdb == pPdbFile || !pResult->pRefPDB) {
+		if (pStreamWork->pStream->pdb == pPdbFile || !pResult->pRefPDB) {
 			memset( pFloats, 0, iNumFloats*sizeof(float) );
 			bInitialFrame = true;
 		} else {
@@ -1331,7 +1405,7 @@ static void fn_BuildStreamData_ResidueBased( MDTRA_StreamWorkResult *pResult, MD
 			pPdbFile->set_flag( pResult->pDataSource->selection.size, pResult->pDataSource->selection.data, PDB_FLAG_RMSF );
 			pPdbFile->move_to_centroid2();
 			pPdbFile->align_kabsch2( pResult->pRefPDB );
-			pPdbFile->get_rmsf2_of_atoms( pLocalStreamWork->averagePDB, pFloats );
+			pPdbFile->get_rmsf2_of_atoms( pStreamWork->averagePDB, pFloats );
 		}
 		break;
 	case MDTRA_DT_SAS:
@@ -1408,7 +1482,7 @@ static void fn_BuildStreamData_ResidueBased( MDTRA_StreamWorkResult *pResult, MD
 			flCurrentFloat /= (float)numfiles;
 
 			//increment some statistic parameters
-			pResult->threadStat[MDTRA_TSP_ARITHMETIC_MEAN][threadnum] += flCurrentFloat;
+			pResult->pThreadStat[threadnum].stat[MDTRA_TSP_ARITHMETIC_MEAN] += flCurrentFloat;
 
 			//write residue-based output
 			pResult->pDSRef->pData[iNumFloats*threadnum+i] += flCurrentFloat;
@@ -1419,7 +1493,7 @@ static void fn_BuildStreamData_ResidueBased( MDTRA_StreamWorkResult *pResult, MD
 	}
 }
 
-static void fn_BuildStreamData_TimeBased( MDTRA_StreamWorkResult *pResult, MDTRA_PDB_File *pPdbFile, bool &bAligned, int threadnum, int num )
+static void fn_BuildStreamData_TimeBased( const MDTRA_StreamWork *pStreamWork, MDTRA_StreamWorkResult *pResult, MDTRA_PDB_File *pPdbFile, bool &bAligned, int threadnum, int num )
 {
 	float flResultData = 0.0f;
 		
@@ -1429,13 +1503,13 @@ static void fn_BuildStreamData_TimeBased( MDTRA_StreamWorkResult *pResult, MDTRA
 		if (!bAligned) {
 			//align PDB file with first file in stream
 			pPdbFile->move_to_centroid();
-			pPdbFile->align_kabsch( pLocalStreamWork->pStream->pdb );
+			pPdbFile->align_kabsch( pStreamWork->pStream->pdb );
 			bAligned = true;
 		}
-		flResultData = pPdbFile->get_rmsd( pLocalStreamWork->pStream->pdb );
+		flResultData = pPdbFile->get_rmsd( pStreamWork->pStream->pdb );
 		break;
 	case MDTRA_DT_RMSD_SEL:
-		if (pLocalStreamWork->pStream->pdb == pPdbFile || !pResult->pRefPDB) {
+		if (pStreamWork->pStream->pdb == pPdbFile || !pResult->pRefPDB) {
 			flResultData = 0.0f;
 		} else {
 			//align both current PDB file and first file in stream
@@ -1545,26 +1619,26 @@ static void fn_BuildStreamData_TimeBased( MDTRA_StreamWorkResult *pResult, MDTRA
 
 	//check if we have negative
 	if (flResultData <= 0.0f)
-		pResult->threadAllPositive[threadnum] = false;
+		pResult->pThreadStat[threadnum].allPositive = false;
 	if (flResultData == 0.0f)
-		pResult->threadHasZero[threadnum] = true;
+		pResult->pThreadStat[threadnum].hasZero = true;
 
 	//increment some statistic parameters
-	pResult->threadStat[MDTRA_TSP_ARITHMETIC_MEAN][threadnum] += flResultData;
-	pResult->threadStat[MDTRA_TSP_HARMONIC_MEAN][threadnum] += (1.0f / flResultData);
-	pResult->threadStat[MDTRA_TSP_QUADRATIC_MEAN][threadnum] += (flResultData*flResultData);
+	pResult->pThreadStat[threadnum].stat[MDTRA_TSP_ARITHMETIC_MEAN] += flResultData;
+	pResult->pThreadStat[threadnum].stat[MDTRA_TSP_HARMONIC_MEAN] += (1.0f / flResultData);
+	pResult->pThreadStat[threadnum].stat[MDTRA_TSP_QUADRATIC_MEAN] += (flResultData*flResultData);
 	
-	if (pResult->threadStatInit[threadnum]) {
-		pResult->threadStat[MDTRA_TSP_GEOMETRIC_MEAN][threadnum] *= flResultData;
-		if (flResultData > pResult->threadStat[MDTRA_SP_MAX_VALUE][threadnum]) 
-			pResult->threadStat[MDTRA_TSP_MAX_VALUE][threadnum] = flResultData;
-		if (flResultData < pResult->threadStat[MDTRA_SP_MIN_VALUE][threadnum]) 
-			pResult->threadStat[MDTRA_TSP_MIN_VALUE][threadnum] = flResultData;
+	if (pResult->pThreadStat[threadnum].statInit) {
+		pResult->pThreadStat[threadnum].stat[MDTRA_TSP_GEOMETRIC_MEAN] *= flResultData;
+		if (flResultData > pResult->pThreadStat[threadnum].stat[MDTRA_SP_MAX_VALUE]) 
+			pResult->pThreadStat[threadnum].stat[MDTRA_TSP_MAX_VALUE] = flResultData;
+		if (flResultData < pResult->pThreadStat[threadnum].stat[MDTRA_SP_MIN_VALUE]) 
+			pResult->pThreadStat[threadnum].stat[MDTRA_TSP_MIN_VALUE] = flResultData;
 	} else {
-		pResult->threadStat[MDTRA_TSP_GEOMETRIC_MEAN][threadnum] = flResultData;
-		pResult->threadStat[MDTRA_TSP_MAX_VALUE][threadnum] = flResultData;
-		pResult->threadStat[MDTRA_TSP_MIN_VALUE][threadnum] = flResultData;
-		pResult->threadStatInit[threadnum] = true;
+		pResult->pThreadStat[threadnum].stat[MDTRA_TSP_GEOMETRIC_MEAN] = flResultData;
+		pResult->pThreadStat[threadnum].stat[MDTRA_TSP_MAX_VALUE] = flResultData;
+		pResult->pThreadStat[threadnum].stat[MDTRA_TSP_MIN_VALUE] = flResultData;
+		pResult->pThreadStat[threadnum].statInit = true;
 	}
 
 	//write time-based output
@@ -1573,34 +1647,26 @@ static void fn_BuildStreamData_TimeBased( MDTRA_StreamWorkResult *pResult, MDTRA
 		pResult->pDSRef->iActualDataSize = num + 1;
 }
 
-static void fn_BuildStreamData( int threadnum, int num )
+static void fn_BuildStreamData( int threadnum, int num, MDTRA_PDB_File *pPdbFile, void *pContext )
 {
 	//this function handles a single stream file
-	//num = stream file index in stream's file list
+	//num = snapshot in the stream build window
 	//this function MUST be thread-safe
-
-	//Load PDB file
-	MDTRA_PDB_File *pPdbFile;
-	bool bAligned;
-	bool bLoadFailed = false;
-	if (num == 0) {
-		pPdbFile = pLocalStreamWork->pStream->pdb;
-		bAligned = true;
-	} else {
-		pPdbFile = pLocalStreamWork->tempPDB[threadnum];
-		if (!pPdbFile->load( threadnum, pLocalStreamWork->pStream->format_identifier, pLocalStreamWork->pStream->files.at(num).toAscii(), pLocalStreamWork->pStream->flags) )
-			bLoadFailed = true;
-		bAligned = false;
-	}
+	MDTRA_StreamWork *pStreamWork = (MDTRA_StreamWork*)pContext;
+	int frame = pStreamWork->workStart + num * pStreamWork->workStride;
+	bool bAligned = (frame == 0);
+	bool bLoadFailed = (pPdbFile == NULL);
 
 #ifdef _DEBUG
-	OutputDebugString( QString("Using: %1\n").arg(pLocalStreamWork->pStream->files.at(num)).toAscii() );
+	OutputDebugString( QString("Using: %1 snapshot %2\n").arg(pStreamWork->pStream->name).arg(frame).toAscii() );
 #endif
 
 	//Get all results
-	int iNumResults = pLocalStreamWork->pResults.count();
+	int iNumResults = pStreamWork->pResults.count();
 	for (int i = 0; i < iNumResults; i++) {
-		MDTRA_StreamWorkResult *pResult = const_cast<MDTRA_StreamWorkResult*>(&pLocalStreamWork->pResults.at(i));
+		MDTRA_StreamWorkResult *pResult = const_cast<MDTRA_StreamWorkResult*>(&pStreamWork->pResults.at(i));
+		MDTRA_PROF_SCOPE( "data source", MDTRA_PROF_COMPUTE );
+		double startTime = ThreadMicroseconds();
 
 		switch (pResult->pResult->layout) {
 		default:
@@ -1608,65 +1674,44 @@ static void fn_BuildStreamData( int threadnum, int num )
 			if (bLoadFailed)
 				pResult->pDSRef->pData[num] = 0.0f;
 			else
-				fn_BuildStreamData_TimeBased( pResult, pPdbFile, bAligned, threadnum, num );
+				fn_BuildStreamData_TimeBased( pStreamWork, pResult, pPdbFile, bAligned, threadnum, num );
 			break;
 		case MDTRA_LAYOUT_RESIDUE:
 			if (!bLoadFailed)
-				fn_BuildStreamData_ResidueBased( pResult, pPdbFile, bAligned, threadnum, num, pLocalStreamWork->pStream->files.count() );
+				fn_BuildStreamData_ResidueBased( pStreamWork, pResult, pPdbFile, bAligned, threadnum, num, pStreamWork->workCount );
 			break;
 		}
-	}
 
-	if (pProgressDialog) {
-		pProgressDialog->advanceCurrentFile( pLocalStreamWork->workBase+num+1 );
-		if (pProgressDialog->checkInterrupt()) {
-			InterruptThreads();
-		}
+		//the frame alignment is charged to the first source that needs it
+		pResult->pThreadStat[threadnum].buildTime += ThreadMicroseconds() - startTime;
 	}
 }
 
-static void fn_BuildStreamAverage( int threadnum, int num )
+static void fn_BuildStreamAverage( int threadnum, int num, MDTRA_PDB_File *pPdbFile, void *pContext )
 {
 	//this function handles a single stream file
-	//num = stream file index in stream's file list
+	//num = snapshot in the stream build window
 	//this function MUST be thread-safe
-
-	//Load PDB file
-	MDTRA_PDB_File *pPdbFile;
-	bool bAligned;
-	bool bLoadFailed = false;
-	if (num == 0) {
-		pPdbFile = pLocalStreamWork->pStream->pdb;
-		bAligned = true;
-	} else {
-		pPdbFile = pLocalStreamWork->tempPDB[threadnum];
-		if (!pPdbFile->load( threadnum, pLocalStreamWork->pStream->format_identifier, pLocalStreamWork->pStream->files.at(num).toAscii(), pLocalStreamWork->pStream->flags ) )
-			bLoadFailed = true;
-		bAligned = false;
-	}
+	MDTRA_StreamWork *pStreamWork = (MDTRA_StreamWork*)pContext;
+	int frame = pStreamWork->workStart + num * pStreamWork->workStride;
+	if (!pPdbFile)
+		return;
 
 #ifdef _DEBUG
-	OutputDebugString( QString("Averaging: %1\n").arg(pLocalStreamWork->pStream->files.at(num)).toAscii() );
+	OutputDebugString( QString("Averaging: %1 snapshot %2\n").arg(pStreamWork->pStream->name).arg(frame).toAscii() );
 #endif
 
-	if (!bAligned) {
+	if (frame != 0) {
 		//align PDB file with first file in stream
 		pPdbFile->move_to_centroid();
-		pPdbFile->align_kabsch( pLocalStreamWork->pStream->pdb );
-		bAligned = true;
+		pPdbFile->align_kabsch( pStreamWork->pStream->pdb );
 	}
 
 	//make average
+	MDTRA_PROF_SCOPE( "average coordinates", MDTRA_PROF_REDUCE );
 	ThreadLock();
-	pLocalStreamWork->averagePDB->average_coords( pPdbFile, 1.0f / (float)pLocalStreamWork->workCount );
+	pStreamWork->averagePDB->average_coords( pPdbFile, 1.0f / (float)pStreamWork->workCount );
 	ThreadUnlock();
-
-	if (pProgressDialog) {
-		pProgressDialog->advanceCurrentFile( pLocalStreamWork->workBase+num+1 );
-		if (pProgressDialog->checkInterrupt()) {
-			InterruptThreads();
-		}
-	}
 }
 
 static void fn_FinalizeRMSF( MDTRA_StreamWork *pStreamWork, MDTRA_StreamWorkResult *pWorkResult, int atomFlags )
@@ -1735,6 +1780,8 @@ static void fn_BuildCorrelationTable( int threadnum, int num )
 	if (!pResult->sourceList.at(0).pCorrelation)
 		return;
 
+	MDTRA_PROF_SCOPE( "correlation table", MDTRA_PROF_REDUCE );
+
 	int iNumSrc = pResult->sourceList.count();
 	for (int i = 0; i < iNumSrc; i++) {
 		MDTRA_DSRef *pRef = const_cast<MDTRA_DSRef*>(&pResult->sourceList.at(i));
@@ -1785,10 +1832,15 @@ void MDTRA_Project :: profileStart()
 	gettimeofday(&tp, NULL);
 	m_profStart = tp.tv_sec*1000 + tp.tv_usec/1000;
 #endif
+	ProfilerStart();
+	ProfilerBegin( "build", MDTRA_PROF_BUILD );
 }
 
 void MDTRA_Project :: profileEnd()
 {
+	ProfilerEnd();
+	ProfilerStop();
+
 	dword totalTime;
 #if defined(WIN32)
 	totalTime = timeGetTime() - m_profStart;
@@ -1797,10 +1849,24 @@ void MDTRA_Project :: profileEnd()
 	gettimeofday(&tp, NULL);
 	totalTime = tp.tv_sec*1000 + tp.tv_usec/1000 - m_profStart;
 #endif
-	QMessageBox::information( pProgressDialog, QObject::tr("Profiler"), QString("Stream build time: %1 ms").arg(totalTime) );
+	QString profText = QString("Build time: %1 ms").arg(totalTime);
+
+	MDTRA_PrefetchTuning tuning;
+	if (PrefetchGetLastTuning( &tuning )) {
+		profText += QString("\nReader threads: %1, compute threads: %2").arg(tuning.readers).arg(tuning.workers);
+		profText += QString("\nPer frame: load %1 ms (%2 ms with all readers), compute %3 ms")
+			.arg(tuning.loadUsec * 0.001, 0, 'f', 2).arg(tuning.parallelLoadUsec * 0.001, 0, 'f', 2).arg(tuning.computeUsec * 0.001, 0, 'f', 2);
+	}
+
+	profText += "\n\n" + ProfilerSummary();
+	QString traceFile = ProfilerTraceFile();
+	if (ProfilerWriteTrace( traceFile ))
+		profText += QString("\nTrace written to %1").arg(QDir::toNativeSeparators( traceFile ));
+
+	BatchInformation( m_pMainWindow, QObject::tr("Profiler"), profText );
 }
 
-bool MDTRA_Project :: build( bool rebuildAll )
+bool MDTRA_Project :: build( bool rebuildAll, MDTRA_FrameSweep *pBatch )
 {
 	QList<MDTRA_StreamWork> streamWorkList;
 	QList<float> dataList;
@@ -1808,7 +1874,17 @@ bool MDTRA_Project :: build( bool rebuildAll )
 	MDTRA_StreamWorkResult streamWorkResult;
 	int worksize = 0;
 	int calcSAS = 0;
-	bool profiling = m_pMainWindow->allowProfiling();
+	int maxFloats = 0;
+	bool profiling = m_bProfiling;
+	MDTRA_FrameWindow buildWindow;
+
+	buildWindow.first = m_iBuildFirst;
+	buildWindow.last = m_iBuildLast;
+	buildWindow.stride = m_iBuildStride;
+	if (m_pMainWindow) {
+		profiling = m_pMainWindow->allowProfiling();
+		m_pMainWindow->getBuildWindow( &buildWindow );
+	}
 
 	//Collect work per stream
 	for (int i = 0; i < m_StreamList.count(); i++) {
@@ -1816,12 +1892,12 @@ bool MDTRA_Project :: build( bool rebuildAll )
 		if (!streamWork.pStream->pdb)
 			continue;
 
-		streamWork.workCount = streamWork.pStream->files.count();
+		streamWork.workCount = MDTRA_GetStreamWindowFrames( streamWork.pStream, &buildWindow, &streamWork.workStart, &streamWork.workStride );
+		if (streamWork.workCount <= 0)
+			continue;
+
 		streamWork.pResults.clear();
 		streamWork.averagePDB = NULL;
-		for (int j = 0; j < CountThreads(); j++) {
-			streamWork.tempPDB[j] = new MDTRA_PDB_File;
-		}
 
 		int iAllocateFloats = 0;
 		int calcRMSF = 0;
@@ -1884,7 +1960,9 @@ bool MDTRA_Project :: build( bool rebuildAll )
 						pDS->type == MDTRA_DT_RMSF_SEL)
 						calcRMSF = 1;
 					
-					pRef->xscale = streamWork.pStream->xscale;
+					pRef->xscale = streamWork.pStream->xscale * streamWork.workStride;
+					pRef->windowStart = streamWork.workStart;
+					pRef->windowStride = streamWork.workStride;
 					pRef->iDataSize = localDataCount;
 					pRef->iActualDataSize = 0;
 					worksize += localDataSize;
@@ -1899,7 +1977,7 @@ bool MDTRA_Project :: build( bool rebuildAll )
 
 					if (pDS->type == MDTRA_DT_RMSD_SEL) {
 						streamWorkResult.pRefPDB = new MDTRA_PDB_File;
-						if (!streamWorkResult.pRefPDB->load( 0, m_StreamList.at(i).format_identifier, m_StreamList.at(i).files.at(0).toAscii(), m_StreamList.at(i).flags )) {
+						if (!MDTRA_LoadStreamFrame( 0, &m_StreamList.at(i), 0, streamWorkResult.pRefPDB )) {
 							delete streamWorkResult.pRefPDB;
 							streamWorkResult.pRefPDB = NULL;
 						} else {
@@ -1909,7 +1987,7 @@ bool MDTRA_Project :: build( bool rebuildAll )
 					}
 					else if (pDS->type == MDTRA_DT_RMSF_SEL) {
 						streamWorkResult.pRefPDB = new MDTRA_PDB_File;
-						if (!streamWorkResult.pRefPDB->load( 0, m_StreamList.at(i).format_identifier, m_StreamList.at(i).files.at(0).toAscii(), m_StreamList.at(i).flags )) {
+						if (!MDTRA_LoadStreamFrame( 0, &m_StreamList.at(i), 0, streamWorkResult.pRefPDB )) {
 							delete streamWorkResult.pRefPDB;
 							streamWorkResult.pRefPDB = NULL;
 						} else {
@@ -1918,11 +1996,10 @@ bool MDTRA_Project :: build( bool rebuildAll )
 						}
 					}
 
-					memset( streamWorkResult.threadStatInit, 0, sizeof(streamWorkResult.threadStatInit) );
-					memset( streamWorkResult.threadStat, 0, sizeof(streamWorkResult.threadStat) );
-					memset( streamWorkResult.threadHasZero, 0, sizeof(streamWorkResult.threadHasZero) );
-					for (int c = 0; c < MDTRA_MAX_THREADS; c++)
-						streamWorkResult.threadAllPositive[c] = true;
+					streamWorkResult.pThreadStat = new MDTRA_ThreadStat[CountThreads()];
+					memset( streamWorkResult.pThreadStat, 0, sizeof(MDTRA_ThreadStat) * CountThreads() );
+					for (int c = 0; c < CountThreads(); c++)
+						streamWorkResult.pThreadStat[c].allPositive = true;
 					streamWork.pResults << streamWorkResult;
 				}
 			}
@@ -1930,9 +2007,8 @@ bool MDTRA_Project :: build( bool rebuildAll )
 
 		if (iAllocateFloats > 0) {
 			streamWork.pStream->pdb->alloc_floats( iAllocateFloats );
-			for (int j = 0; j < CountThreads(); j++) {
-				streamWork.tempPDB[j]->alloc_floats( iAllocateFloats );
-			}
+			if (iAllocateFloats > maxFloats)
+				maxFloats = iAllocateFloats;
 		}
 
 		if ( calcRMSF ) {
@@ -1948,7 +2024,9 @@ bool MDTRA_Project :: build( bool rebuildAll )
 			streamWorkList << streamWork;
 	}
 
-	if (!worksize)
+	//queued analyses still need their sweep when there is nothing to build
+	int batchConsumers = pBatch ? pBatch->getConsumerCount() : 0;
+	if (!worksize && !batchConsumers)
 		return false;
 
 	worksize *= sizeof(float);
@@ -1956,53 +2034,83 @@ bool MDTRA_Project :: build( bool rebuildAll )
 	OutputDebugString( QString("Stream work size: %1 kb\n").arg(worksize / 1024.0f).toAscii() );
 #endif
 
-	MDTRA_ProgressDialog dlgProgress( m_pMainWindow );
-	dlgProgress.setStreamCount( streamWorkList.count() );
-	dlgProgress.show();
-
-	pProgressDialog = &dlgProgress;
+	//averaging sweep of the RMSF streams, then data sweep of all streams;
+	//the data sweep also feeds the queued analyses, which are registered first
+	//so that they see the snapshots before the build aligns them
+	MDTRA_FrameSweep averageSweep;
+	MDTRA_FrameSweep localSweep;
+	MDTRA_FrameSweep *pDataSweep = pBatch ? pBatch : &localSweep;
 
-	if ( calcSAS )
-		MDTRA_InitSAS();
-
-	//build each stream
 	for (int i = 0; i < streamWorkList.count(); i++) {
-		pLocalStreamWork = const_cast< MDTRA_StreamWork*>(&streamWorkList.at(i));
+		MDTRA_StreamWork *pStreamWork = const_cast<MDTRA_StreamWork*>(&streamWorkList.at(i));
 #ifdef _DEBUG
-		OutputDebugString( QString("pLocalStreamWork: %1 results (stream %2)\n").arg(pLocalStreamWork->pResults.count()).arg(pLocalStreamWork->pStream->index).toAscii() );
+		OutputDebugString( QString("pStreamWork: %1 results (stream %2)\n").arg(pStreamWork->pResults.count()).arg(pStreamWork->pStream->index).toAscii() );
 #endif
-		if ( pLocalStreamWork->averagePDB ) {
-			dlgProgress.setFileCount( pLocalStreamWork->workCount * 2 );
-		} else {
-			dlgProgress.setFileCount( pLocalStreamWork->workCount );
-		}
-		dlgProgress.setCurrentStream( i );
-		dlgProgress.setCurrentFile( 0 );
+		if ( pStreamWork->averagePDB )
+			averageSweep.addConsumer( pStreamWork->pStream, pStreamWork->workStart, pStreamWork->workStride, pStreamWork->workCount, fn_BuildStreamAverage, pStreamWork );
+		pDataSweep->addConsumer( pStreamWork->pStream, pStreamWork->workStart, pStreamWork->workStride, pStreamWork->workCount, fn_BuildStreamData, pStreamWork );
+	}
+	pDataSweep->alloc_floats( maxFloats );
 
-		if (profiling)
-			profileStart();
+	int averageCount = averageSweep.getWorkCount();
 
-		pLocalStreamWork->workBase = 0;
+	//headless builds have no dialog and drive the progress channel directly
+	MDTRA_ProgressDialog *pDlgProgress = NULL;
+	if (m_pMainWindow) {
+		pDlgProgress = new MDTRA_ProgressDialog( m_pMainWindow );
+		pDlgProgress->setStreamCount( pDataSweep->getSegmentCount() );
+		pDlgProgress->show();
+	} else {
+		ProgressReset();
+		ProgressSetStreamCount( pDataSweep->getSegmentCount() );
+	}
 
-		if ( pLocalStreamWork->averagePDB ) {
-			RunThreadsOnIndividual( pLocalStreamWork->workCount, fn_BuildStreamAverage );
-			if (dlgProgress.checkInterrupt())
-				break;
-			pLocalStreamWork->workBase = pLocalStreamWork->workCount;
-			pLocalStreamWork->averagePDB->finalize_coords();
-		} 
+	pProgressDialog = pDlgProgress;
+
+	if ( calcSAS )
+		MDTRA_InitSAS();
+
+	if (pDlgProgress) {
+		pDlgProgress->setFileCount( averageCount + pDataSweep->getWorkCount() );
+		pDlgProgress->setCurrentStream( 0 );
+		pDlgProgress->setCurrentFile( 0 );
+	} else {
+		ProgressSetFileCount( averageCount + pDataSweep->getWorkCount() );
+	}
 
-		RunThreadsOnIndividual( pLocalStreamWork->workCount, fn_BuildStreamData );
+	if (profiling)
+		profileStart();
+
+	if ( averageCount > 0 ) {
+		MDTRA_PROF_SCOPE( "average sweep", MDTRA_PROF_BUILD );
+		averageSweep.run( false );
+		for (int i = 0; i < streamWorkList.count(); i++) {
+			if (streamWorkList.at(i).averagePDB)
+				streamWorkList.at(i).averagePDB->finalize_coords();
+		}
+	}
+
+	if (!ProgressInterrupted()) {
+		MDTRA_PROF_SCOPE( "data sweep", MDTRA_PROF_BUILD );
+		pDataSweep->run( true );
+	}
 
-		if (profiling)
-			profileEnd();
+	//finalize results of each stream
+	ProfilerBegin( "finalize results", MDTRA_PROF_REDUCE );
+	for (int i = 0; i < streamWorkList.count() && !ProgressInterrupted(); i++) {
+		MDTRA_StreamWork *pStreamWork = const_cast<MDTRA_StreamWork*>(&streamWorkList.at(i));
 
-		for (int j = 0; j < pLocalStreamWork->pResults.count(); j++) {
-			MDTRA_StreamWorkResult *pWorkResult = const_cast<MDTRA_StreamWorkResult*>(&pLocalStreamWork->pResults.at(j));
+		for (int j = 0; j < pStreamWork->pResults.count(); j++) {
+			MDTRA_StreamWorkResult *pWorkResult = const_cast<MDTRA_StreamWorkResult*>(&pStreamWork->pResults.at(j));
 
 			bool geomMeanValid = true;
 			bool harmMeanValid = true;
 
+			double buildTime = 0.0;
+			for (int k = 0; k < CountThreads(); k++)
+				buildTime += pWorkResult->pThreadStat[k].buildTime;
+			pWorkResult->pDSRef->buildTime = (float)(buildTime * 0.001);
+
 			if (pWorkResult->pResult->layout == MDTRA_LAYOUT_RESIDUE) {
 				//collapse thread results for residue-based layout
 				for (int k = 1; k < CountThreads(); k++) {
@@ -2018,14 +2126,14 @@ bool MDTRA_Project :: build( bool rebuildAll )
 						finalFlags = PDB_FLAG_BACKBONE;
 					} else {
 						finalFlags = PDB_FLAG_RMSF;
-						pLocalStreamWork->averagePDB->set_flag( pWorkResult->pDataSource->selection.size, pWorkResult->pDataSource->selection.data, finalFlags );
+						pStreamWork->averagePDB->set_flag( pWorkResult->pDataSource->selection.size, pWorkResult->pDataSource->selection.data, finalFlags );
 					}
-					fn_FinalizeRMSF( pLocalStreamWork, pWorkResult, finalFlags );
+					fn_FinalizeRMSF( pStreamWork, pWorkResult, finalFlags );
 					pWorkResult->pDSRef->stat[MDTRA_SP_ARITHMETIC_MEAN] = 0.0f;
 				} else {
 					//finalize statistic parameters
 					for (int k = 0; k < CountThreads(); k++) {
-						pWorkResult->pDSRef->stat[MDTRA_SP_ARITHMETIC_MEAN] += pWorkResult->threadStat[MDTRA_TSP_ARITHMETIC_MEAN][k];
+						pWorkResult->pDSRef->stat[MDTRA_SP_ARITHMETIC_MEAN] += pWorkResult->pThreadStat[k].stat[MDTRA_TSP_ARITHMETIC_MEAN];
 					}
 				}
 
@@ -2051,21 +2159,21 @@ bool MDTRA_Project :: build( bool rebuildAll )
 			} else {
 				//finalize statistic parameters
 				for (int k = 0; k < CountThreads(); k++) {
-					pWorkResult->pDSRef->stat[MDTRA_SP_ARITHMETIC_MEAN] += pWorkResult->threadStat[MDTRA_TSP_ARITHMETIC_MEAN][k];
-					pWorkResult->pDSRef->stat[MDTRA_SP_HARMONIC_MEAN] += pWorkResult->threadStat[MDTRA_TSP_HARMONIC_MEAN][k];
-					pWorkResult->pDSRef->stat[MDTRA_SP_QUADRATIC_MEAN] += pWorkResult->threadStat[MDTRA_TSP_QUADRATIC_MEAN][k];
+					pWorkResult->pDSRef->stat[MDTRA_SP_ARITHMETIC_MEAN] += pWorkResult->pThreadStat[k].stat[MDTRA_TSP_ARITHMETIC_MEAN];
+					pWorkResult->pDSRef->stat[MDTRA_SP_HARMONIC_MEAN] += pWorkResult->pThreadStat[k].stat[MDTRA_TSP_HARMONIC_MEAN];
+					pWorkResult->pDSRef->stat[MDTRA_SP_QUADRATIC_MEAN] += pWorkResult->pThreadStat[k].stat[MDTRA_TSP_QUADRATIC_MEAN];
 					if (k == 0) {
-						pWorkResult->pDSRef->stat[MDTRA_SP_GEOMETRIC_MEAN] = pWorkResult->threadStat[MDTRA_TSP_GEOMETRIC_MEAN][k];
-						pWorkResult->pDSRef->stat[MDTRA_SP_MIN_VALUE] = pWorkResult->threadStat[MDTRA_TSP_MIN_VALUE][k];
-						pWorkResult->pDSRef->stat[MDTRA_SP_MAX_VALUE] = pWorkResult->threadStat[MDTRA_TSP_MAX_VALUE][k];
+						pWorkResult->pDSRef->stat[MDTRA_SP_GEOMETRIC_MEAN] = pWorkResult->pThreadStat[k].stat[MDTRA_TSP_GEOMETRIC_MEAN];
+						pWorkResult->pDSRef->stat[MDTRA_SP_MIN_VALUE] = pWorkResult->pThreadStat[k].stat[MDTRA_TSP_MIN_VALUE];
+						pWorkResult->pDSRef->stat[MDTRA_SP_MAX_VALUE] = pWorkResult->pThreadStat[k].stat[MDTRA_TSP_MAX_VALUE];
 					} else {
-						pWorkResult->pDSRef->stat[MDTRA_SP_GEOMETRIC_MEAN] *= pWorkResult->threadStat[MDTRA_TSP_GEOMETRIC_MEAN][k];
-						if (pWorkResult->threadStat[MDTRA_TSP_MIN_VALUE][k] < pWorkResult->pDSRef->stat[MDTRA_SP_MIN_VALUE] ) pWorkResult->pDSRef->stat[MDTRA_SP_MIN_VALUE] = pWorkResult->threadStat[MDTRA_TSP_MIN_VALUE][k];
-						if (pWorkResult->threadStat[MDTRA_TSP_MAX_VALUE][k] > pWorkResult->pDSRef->stat[MDTRA_SP_MAX_VALUE] ) pWorkResult->pDSRef->stat[MDTRA_SP_MAX_VALUE] = pWorkResult->threadStat[MDTRA_TSP_MAX_VALUE][k];
+						pWorkResult->pDSRef->stat[MDTRA_SP_GEOMETRIC_MEAN] *= pWorkResult->pThreadStat[k].stat[MDTRA_TSP_GEOMETRIC_MEAN];
+						if (pWorkResult->pThreadStat[k].stat[MDTRA_TSP_MIN_VALUE] < pWorkResult->pDSRef->stat[MDTRA_SP_MIN_VALUE] ) pWorkResult->pDSRef->stat[MDTRA_SP_MIN_VALUE] = pWorkResult->pThreadStat[k].stat[MDTRA_TSP_MIN_VALUE];
+						if (pWorkResult->pThreadStat[k].stat[MDTRA_TSP_MAX_VALUE] > pWorkResult->pDSRef->stat[MDTRA_SP_MAX_VALUE] ) pWorkResult->pDSRef->stat[MDTRA_SP_MAX_VALUE] = pWorkResult->pThreadStat[k].stat[MDTRA_TSP_MAX_VALUE];
 					}
-					if (!pWorkResult->threadAllPositive[k])
+					if (!pWorkResult->pThreadStat[k].allPositive)
 						geomMeanValid = false;
-					if (pWorkResult->threadHasZero[k])
+					if (pWorkResult->pThreadStat[k].hasZero)
 						harmMeanValid = false;
 				}
 			}
@@ -2117,14 +2225,13 @@ bool MDTRA_Project :: build( bool rebuildAll )
 			//mark result as actual
 			pWorkResult->pResult->status = 1;
 		}
-
-		if (dlgProgress.checkInterrupt())
-			break;
 	}
+	ProfilerEnd();
 
 	pProgressDialog = NULL;
 
-	dlgProgress.setProgressAtMax();
+	if (pDlgProgress)
+		pDlgProgress->setProgressAtMax();
 
 	//build correlation table
 	int iNumSrc = m_ResultList.count();
@@ -2151,10 +2258,14 @@ bool MDTRA_Project :: build( bool rebuildAll )
 	RunThreadsOnIndividual( pLocalResultList->count(), fn_BuildCorrelationTable );
 	pLocalResultList = NULL;
 
+	if (profiling)
+		profileEnd();
+
 	//mark all streams built as actual and clear
 	for (int i = 0; i < streamWorkList.count(); i++) {
 		MDTRA_StreamWork *pWork = const_cast<MDTRA_StreamWork*>(&streamWorkList.at(i));
 		pWork->pStream->pdb->free_floats();
+		MDTRA_FinishStreamFrames( pWork->pStream );
 		for (int j = 0; j < pWork->pResults.count(); j++) {
 			if (pWork->pResults.at(j).pRefPDB)
 				delete pWork->pResults.at(j).pRefPDB;
@@ -2162,18 +2273,21 @@ bool MDTRA_Project :: build( bool rebuildAll )
 				MDTRA_Program_Interpreter* pInterpreter = (MDTRA_Program_Interpreter*)(pWork->pResults.at(j).pProgInterpreter);
 				delete pInterpreter;
 			}
+			delete [] pWork->pResults.at(j).pThreadStat;
 		}
 		pWork->pResults.clear();
-		for (int j = 0; j < CountThreads(); j++)
-			delete pWork->tempPDB[j];
 		if (pWork->averagePDB)
 			delete pWork->averagePDB;
 	}
 	streamWorkList.clear();
 
+	updateDataSourceList();
 	updateResultList();
 
-	dlgProgress.close();
+	if (pDlgProgress) {
+		pDlgProgress->close();
+		delete pDlgProgress;
+	}
 	dataList.clear();
 	return true;
 }
\ No newline at end of file
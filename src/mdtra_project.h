@@ -23,10 +23,14 @@
 
 #define MDTRA_PROJECT_FILE_MAGIC				0xDEFECEED
 #define MDTRA_PROJECT_FILE_VERSION_OLD			108
-#define MDTRA_PROJECT_FILE_VERSION				109
+#define MDTRA_PROJECT_FILE_VERSION_NOWINDOW		109		//results have no build window
+#define MDTRA_PROJECT_FILE_VERSION				110
 
 class MDTRA_MainWindow;
 class MDTRA_PDB_File;
+class MDTRA_FrameSweep;
+class MDTRA_StreamCache;
+class MDTRA_TrajectoryReader;
 class QTextStream;
 
 typedef struct stMDTRA_DataArg
@@ -40,6 +44,8 @@ typedef struct stMDTRA_Stream
 	QString			name;
 	QStringList		files;
 	MDTRA_PDB_File* pdb;
+	MDTRA_StreamCache* cache;
+	MDTRA_TrajectoryReader* trajectory;
 	float			xscale;
 	unsigned int	format_identifier;
 	unsigned int	flags;
@@ -110,6 +116,16 @@ typedef struct stMDTRA_Result
 	char				reserved[32];
 } MDTRA_Result;
 
+//per-thread partial statistics of a result, merged after the stream is built
+typedef struct stMDTRA_ThreadStat
+{
+	float					stat[MDTRA_TSP_MAX];
+	bool					statInit;
+	bool					hasZero;
+	bool					allPositive;
+	double					buildTime;			//microseconds
+} MDTRA_ThreadStat;
+
 typedef struct stMDTRA_StreamWorkResult
 {
 	const MDTRA_DataSource*	pDataSource;
@@ -117,33 +133,35 @@ typedef struct stMDTRA_StreamWorkResult
 	MDTRA_DSRef*			pDSRef;
 	MDTRA_PDB_File*			pRefPDB;
 	void*					pProgInterpreter;
-	bool					threadHasZero[MDTRA_MAX_THREADS];
-	bool					threadAllPositive[MDTRA_MAX_THREADS];
-	float					threadStat[MDTRA_TSP_MAX][MDTRA_MAX_THREADS];
-	bool					threadStatInit[MDTRA_MAX_THREADS];
+	MDTRA_ThreadStat*		pThreadStat;		//CountThreads() entries
 } MDTRA_StreamWorkResult;
 
 typedef struct stMDTRA_StreamWork
 {
 	const MDTRA_Stream*		pStream;
-	int						workBase;
+	int						workStart;
+	int						workStride;
 	int						workCount;
-	MDTRA_PDB_File*			tempPDB[MDTRA_MAX_THREADS];
 	MDTRA_PDB_File*			averagePDB;
 	QList<MDTRA_StreamWorkResult> pResults;
 } MDTRA_StreamWork;
 
+//pMainWindow is NULL for a headless (batch) project: it can be loaded, built
+//and exported, and takes its build window from setBuildWindow
 class MDTRA_Project
 {
 public:
     MDTRA_Project( MDTRA_MainWindow *pMainWindow );
 	~MDTRA_Project();
 
+	void setBuildWindow( int first, int last, int stride ) { m_iBuildFirst = first; m_iBuildLast = last; m_iBuildStride = stride; }
+	void setProfiling( bool enable ) { m_bProfiling = enable; }
+
 	bool loadFile( const QString &projectPath, QDataStream *stream );
 	bool saveFile( const QString &projectPath, QDataStream *stream );
 
 	void clear( void );
-	bool build( bool rebuildAll );
+	bool build( bool rebuildAll, MDTRA_FrameSweep *pBatch );
 
 	bool checkUniqueStreamName( const QString &name );
 	int getStreamCount( void ) const { return m_StreamList.count(); }
@@ -172,6 +190,8 @@ public:
 	int getResultCountByType( MDTRA_DataType type ) const;
 	int getResultDataSourceCountByStreamIndex( int index );
 	int getResultDataSourceCountByDataSourceIndex( int index );
+	float getDataSourceBuildTime( int index ) const;
+	float getResultBuildTime( const MDTRA_Result *pResult ) const;
 	int registerResult( const QString &name, MDTRA_DataType type, MDTRA_YScaleUnits scaleUnits, MDTRA_Layout layout, const QList<MDTRA_DSRef> &dsref, bool updateGUI );
 	void unregisterResult( int index );
 	void modifyResult( int index, const QString &name, MDTRA_DataType type, MDTRA_YScaleUnits scaleUnits, MDTRA_Layout layout, const QList<MDTRA_DSRef> &dsref );
@@ -193,6 +213,7 @@ private:
 	void profileEnd( void );
 
 	float sampleData( const float *pDataPtr, int iSample, int iMaxSample, int iFilterSize, MDTRA_YScaleUnits ysu );
+	int exportRowLabel( const MDTRA_Result *pResult, int row ) const;
 	void exportResultToTXT( const MDTRA_Result *pResult, QTextStream *stream, int dataFilter );
 	void exportResultToCSV( const MDTRA_Result *pResult, QTextStream *stream, int dataFilter );
 	void exportStatsToTXT( const MDTRA_Result *pResult, QTextStream *stream );
@@ -204,6 +225,13 @@ private:
 	QList<MDTRA_DataSource> m_DataSourceList;
 	QList<MDTRA_Result> m_ResultList;
 	dword m_profStart;
+	int m_iBuildFirst;
+	int m_iBuildLast;
+	int m_iBuildStride;
+	bool m_bProfiling;
 };
 
+//stream snapshot (0-based) the value at index was built from
+extern int MDTRA_GetDSRefSnapshot( const MDTRA_DSRef *pDSRef, int index );
+
 #endif //MDTRA_PROJECT_H
\ No newline at end of file
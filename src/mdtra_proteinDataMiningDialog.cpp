@@ -25,6 +25,7 @@
 #include "mdtra_main.h"
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
+#include "mdtra_stream.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb.h"
 #include "mdtra_utils.h"
@@ -91,7 +92,7 @@ MDTRA_ProteinDataMiningDialog :: MDTRA_ProteinDataMiningDialog( QWidget *parent
 	for (int i = 0; i < m_pMainWindow->getProject()->getStreamCount(); i++) {
 		MDTRA_Stream *pStream = m_pMainWindow->getProject()->fetchStream( i );
 		if (pStream && pStream->pdb) {
-			QListWidgetItem *pItem = new QListWidgetItem( tr("STREAM %1: %2 (%3 files)").arg(pStream->index).arg(pStream->name).arg(pStream->files.count()), 
+			QListWidgetItem *pItem = new QListWidgetItem( tr("STREAM %1: %2 (%3 snapshots)").arg(pStream->index).arg(pStream->name).arg(MDTRA_GetStreamFrameCount( pStream )), 
 														  sList );
 			pItem->setIcon( QIcon(":/png/16x16/stream.png") );
 			pItem->setData( Qt::UserRole, pStream->index );
@@ -25,10 +25,12 @@
 #include "mdtra_main.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_pdb_format.h"
+#include "mdtra_pdb.h"
 #include "mdtra_render_pdb.h"
 #include "mdtra_cpuid.h"
 #include "mdtra_math.h"
 #include "mdtra_utils.h"
+#include "mdtra_inputFile.h"
 #include "mdtra_select.h"
 #include "mdtra_sse.h"
 #include "mdtra_SAS.h"
@@ -207,12 +209,12 @@ bool MDTRA_Render_PDB_File :: read_atom( int threadnum, unsigned int format, con
 
 bool MDTRA_Render_PDB_File :: load( int threadnum, unsigned int format, const char *filename, int streamFlags )
 {
-	FILE *fp = NULL;
+	MDTRA_InputFile file;
 	char linebuf[82];
 	int line_c = 0;
 	int residue_c = 0;
 
-	if (fopen_s( &fp, filename, "r" )) {
+	if (!file.open( threadnum, filename )) {
 		return false;
 	}
 
@@ -222,31 +224,33 @@ bool MDTRA_Render_PDB_File :: load( int threadnum, unsigned int format, const ch
 	int fIgnoreSolvent = streamFlags & STREAM_FLAG_IGNORE_SOLVENT;
 
 	//count ATOM lines
-	while ( !feof(fp) ) {
+	while ( !file.eof() ) {
 		linebuf[0] = 0;
-		if (!fgets( linebuf, 82, fp )) break;
+		if (!file.gets( linebuf, 82 )) break;
+		if (!_strnicmp( linebuf, "ENDMDL", 6 )) break;	//only the first model of multi-model files
 		if (!_strnicmp( linebuf, "ATOM  ", 6 ) || ( !fIgnoreHetatm && !_strnicmp( linebuf, "HETATM", 6 ) )) line_c++;
 	}
 
 	//allocate atoms
 	m_pAtoms = (MDTRA_Render_PDB_Atom*)UTIL_AlignedMalloc(line_c * sizeof(MDTRA_Render_PDB_Atom));
 	if (!m_pAtoms) {
-		fclose( fp );
+		file.close();
 		reset();
 		return false;
 	}
 	memset( m_pAtoms, 0, line_c * sizeof(MDTRA_Render_PDB_Atom) );
 
 	//load ATOM lines
-	rewind(fp);
-	while ( !feof(fp) ) {
+	file.rewind();
+	while ( !file.eof() ) {
 		linebuf[0] = 0;
-		if (!fgets( linebuf, 82, fp )) break;
+		if (!file.gets( linebuf, 82 )) break;
+		if (!_strnicmp( linebuf, "ENDMDL", 6 )) break;	//only the first model of multi-model files
 		if (!_strnicmp( linebuf, "ATOM  ", 6 ) || 
 			( !fIgnoreHetatm && !_strnicmp( linebuf, "HETATM", 6 )) ) {
 			//parse atom
 			if (!read_atom( threadnum, format, linebuf, m_pAtoms + m_iNumAtoms, residue_c )) {
-				fclose( fp );
+				file.close();
 				reset();
 				return false;
 			}
@@ -255,13 +259,37 @@ bool MDTRA_Render_PDB_File :: load( int threadnum, unsigned int format, const ch
 			m_iNumAtoms++;
 		}
 	}
-	fclose( fp );
+	file.close();
 
 	set_flags();
 
 	return true;
 }
 
+bool MDTRA_Render_PDB_File :: load_coords( const MDTRA_PDB_File *pSource )
+{
+	//replace coordinates of the loaded topology with the snapshot ones
+	//both atom lists are in the file order, so matching is done in a single pass
+	int j = 0;
+	int numSourceAtoms = pSource->getAtomCount();
+	MDTRA_Render_PDB_Atom *pAtom = m_pAtoms;
+
+	for (int i = 0; i < m_iNumAtoms; i++, pAtom++) {
+		while (j < numSourceAtoms && pSource->fetchAtomByIndex( j )->serialnumber != pAtom->serialnumber)
+			j++;
+		if (j >= numSourceAtoms)
+			return false;
+		const MDTRA_PDB_Atom *pSrc = pSource->fetchAtomByIndex( j++ );
+		pAtom->original_xyz[0] = pSrc->original_xyz[0];
+		pAtom->original_xyz[1] = pSrc->original_xyz[1];
+		pAtom->original_xyz[2] = pSrc->original_xyz[2];
+		pAtom->original_xyz[3] = 0.0f;
+		memcpy( pAtom->modified_xyz, pAtom->original_xyz, sizeof(pAtom->original_xyz) );
+	}
+
+	return true;
+}
+
 const MDTRA_Render_PDB_Atom* MDTRA_Render_PDB_File :: fetchAtomByIndex( int index ) const
 {
 	return &m_pAtoms[index];
@@ -32,6 +32,7 @@ typedef struct stMDTRA_Render_PDB_Atom
 } MDTRA_Render_PDB_Atom;
 
 template<typename T> class MDTRA_SelectionSet;
+class MDTRA_PDB_File;
 
 class MDTRA_Render_PDB_File
 {
@@ -40,6 +41,7 @@ public:
 	~MDTRA_Render_PDB_File();
 
 	bool load( int threadnum, unsigned int format, const char *filename, int streamFlags );
+	bool load_coords( const MDTRA_PDB_File *pSource );
 	void unload( void );
 	void reset( void );
 
@@ -0,0 +1,212 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Stream frame access
+//	All stream snapshots are loaded through these functions
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include "mdtra_main.h"
+#include "mdtra_project.h"
+#include "mdtra_pdb.h"
+#include "mdtra_streamCache.h"
+#include "mdtra_trajectory.h"
+#include "mdtra_pdbModels.h"
+#include "mdtra_stream.h"
+#include "mdtra_frameCache.h"
+#include "mdtra_profiler.h"
+
+static bool MDTRA_IsTrajectoryFileStream( const MDTRA_Stream *pStream )
+{
+	return (pStream->files.count() == 2 && MDTRA_IsTrajectoryFile( pStream->files.at(1).toAscii() ));
+}
+
+static void MDTRA_InitTrajectoryStream( MDTRA_Stream *pStream, MDTRA_TrajectoryReader *pReader )
+{
+	//topology is taken from the first stream file, coordinates from the opened trajectory
+	pStream->pdb = new MDTRA_PDB_File;
+	if (!pStream->pdb->load( 0, pStream->format_identifier, pStream->files.at(0).toAscii(), pStream->flags )) {
+		delete pStream->pdb;
+		pStream->pdb = NULL;
+		delete pReader;
+		return;
+	}
+
+	//trajectory contains all atoms, filtered topology is mapped onto the full one
+	MDTRA_PDB_File *pFullTopology = pStream->pdb;
+	if (pStream->flags & (STREAM_FLAG_IGNORE_HETATM | STREAM_FLAG_IGNORE_SOLVENT)) {
+		pFullTopology = new MDTRA_PDB_File;
+		if (!pFullTopology->load( 0, pStream->format_identifier, pStream->files.at(0).toAscii(), pStream->flags & ~(STREAM_FLAG_IGNORE_HETATM | STREAM_FLAG_IGNORE_SOLVENT) )) {
+			delete pFullTopology;
+			pFullTopology = NULL;
+		}
+	}
+
+	bool bSuccess = pFullTopology &&
+					pReader->attachTopology( pFullTopology, pStream->pdb ) &&
+					pReader->loadFrame( 0, 0, pStream->pdb, pStream->pdb );
+
+	if (pFullTopology && pFullTopology != pStream->pdb)
+		delete pFullTopology;
+
+	if (!bSuccess) {
+		delete pReader;
+		delete pStream->pdb;
+		pStream->pdb = NULL;
+		return;
+	}
+
+	pReader->closeFiles();
+	pStream->trajectory = pReader;
+	pStream->pdb->move_to_centroid();
+}
+
+void MDTRA_InitStream( MDTRA_Stream *pStream )
+{
+	pStream->pdb = NULL;
+	pStream->cache = NULL;
+	pStream->trajectory = NULL;
+
+	if (pStream->files.count() <= 0)
+		return;
+
+	//topology PDB followed by a trajectory file
+	if (MDTRA_IsTrajectoryFileStream( pStream )) {
+		MDTRA_TrajectoryReader *pReader = MDTRA_CreateTrajectoryReader( pStream->files.at(1).toAscii() );
+		if (pReader && pReader->open( pStream->files.at(1).toAscii() ))
+			MDTRA_InitTrajectoryStream( pStream, pReader );
+		else
+			delete pReader;
+		return;
+	}
+
+	//single PDB file with multiple models
+	if (pStream->files.count() == 1) {
+		MDTRA_PDB_Model_Reader *pReader = new MDTRA_PDB_Model_Reader( pStream->format_identifier );
+		if (pReader->open( pStream->files.at(0).toAscii() ) && pReader->getFrameCount() > 1) {
+			MDTRA_InitTrajectoryStream( pStream, pReader );
+			return;
+		}
+		delete pReader;
+	}
+
+	pStream->pdb = new MDTRA_PDB_File;
+	if (!pStream->pdb->load( 0, pStream->format_identifier, pStream->files.at(0).toAscii(), pStream->flags )) {
+		delete pStream->pdb;
+		pStream->pdb = NULL;
+		return;
+	}
+
+	//cache stores original coordinates, so it can be attached before centering
+	if (pStream->flags & STREAM_FLAG_USE_CACHE)
+		pStream->cache = new MDTRA_StreamCache( pStream );
+
+	pStream->pdb->move_to_centroid();
+}
+
+void MDTRA_FreeStream( MDTRA_Stream *pStream )
+{
+	MDTRA_InvalidateCachedFrames( pStream );
+	if (pStream->trajectory) {
+		delete pStream->trajectory;
+		pStream->trajectory = NULL;
+	}
+	if (pStream->cache) {
+		delete pStream->cache;
+		pStream->cache = NULL;
+	}
+	if (pStream->pdb) {
+		delete pStream->pdb;
+		pStream->pdb = NULL;
+	}
+}
+
+bool MDTRA_LoadStreamFrame( int threadnum, const MDTRA_Stream *pStream, int frame, MDTRA_PDB_File *pPdbFile )
+{
+	//this function MUST be thread-safe
+	MDTRA_PROF_SCOPE( "load frame", MDTRA_PROF_IO );
+
+	//frame cache may hold quantized coordinates, so frames missing from the stream cache
+	//are parsed and stored there before the frame cache is allowed to serve them
+	bool bNeedsCacheWrite = (pStream->cache && pStream->cache->needsFrame( frame ));
+	if (!bNeedsCacheWrite && MDTRA_LookupCachedFrame( threadnum, pStream, frame, pPdbFile ))
+		return true;
+
+	if (pStream->trajectory) {
+		if (!pStream->trajectory->loadFrame( threadnum, frame, pStream->pdb, pPdbFile ))
+			return false;
+	} else if (!pStream->cache || !pStream->cache->readFrame( threadnum, frame, pPdbFile )) {
+		if (!pPdbFile->loadCoordinates( threadnum, pStream->format_identifier, pStream->files.at(frame).toAscii(), pStream->flags, pStream->pdb ))
+			return false;
+		if (pStream->cache)
+			pStream->cache->writeFrame( threadnum, frame, pPdbFile );
+	}
+
+	MDTRA_StoreCachedFrame( threadnum, pStream, frame, pPdbFile );
+	return true;
+}
+
+void MDTRA_FinishStreamFrames( const MDTRA_Stream *pStream )
+{
+	if (pStream->cache)
+		pStream->cache->closeFiles();
+	if (pStream->trajectory)
+		pStream->trajectory->closeFiles();
+}
+
+bool MDTRA_IsTrajectoryStream( const MDTRA_Stream *pStream )
+{
+	return (pStream->trajectory != NULL);
+}
+
+int MDTRA_GetStreamFrameCount( const MDTRA_Stream *pStream )
+{
+	if (pStream->trajectory)
+		return pStream->trajectory->getFrameCount();
+	if (MDTRA_IsTrajectoryFileStream( pStream ))
+		return 0;
+	return pStream->files.count();
+}
+
+int MDTRA_GetStreamWindowFrames( const MDTRA_Stream *pStream, const MDTRA_FrameWindow *pWindow, int *pWorkStart, int *pWorkStride )
+{
+	//returns number of snapshots in the window, work item N maps to stream frame
+	//(*pWorkStart + N * *pWorkStride); skipped snapshots are never loaded
+	int frameCount = MDTRA_GetStreamFrameCount( pStream );
+	int first = 1;
+	int last = frameCount;
+	int stride = 1;
+
+	if (pWindow) {
+		first = MDTRA_MAX( first, pWindow->first );
+		if (pWindow->last > 0)
+			last = MDTRA_MIN( last, pWindow->last );
+		stride = MDTRA_MAX( stride, pWindow->stride );
+	}
+
+	*pWorkStart = first - 1;
+	*pWorkStride = stride;
+
+	if (last < first)
+		return 0;
+	return (last - first) / stride + 1;
+}
@@ -0,0 +1,43 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_STREAM_H
+#define MDTRA_STREAM_H
+
+typedef struct stMDTRA_Stream MDTRA_Stream;
+class MDTRA_PDB_File;
+
+//snapshot window of a stream, indices are 1-based as in the trajectory range controls
+typedef struct stMDTRA_FrameWindow
+{
+	int		first;		//first snapshot
+	int		last;		//last snapshot, 0 = end of stream
+	int		stride;		//take every stride-th snapshot
+} MDTRA_FrameWindow;
+
+extern void MDTRA_InitStream( MDTRA_Stream *pStream );
+extern void MDTRA_FreeStream( MDTRA_Stream *pStream );
+extern bool MDTRA_LoadStreamFrame( int threadnum, const MDTRA_Stream *pStream, int frame, MDTRA_PDB_File *pPdbFile );
+extern void MDTRA_FinishStreamFrames( const MDTRA_Stream *pStream );
+extern int MDTRA_GetStreamFrameCount( const MDTRA_Stream *pStream );
+extern bool MDTRA_IsTrajectoryStream( const MDTRA_Stream *pStream );
+extern int MDTRA_GetStreamWindowFrames( const MDTRA_Stream *pStream, const MDTRA_FrameWindow *pWindow, int *pWorkStart, int *pWorkStride );
+
+#endif //MDTRA_STREAM_H
@@ -0,0 +1,430 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of MDTRA_StreamCache
+//	Binary snapshot cache for stream coordinates
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QDateTime>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include "mdtra_main.h"
+#include "mdtra_project.h"
+#include "mdtra_pdb.h"
+#include "mdtra_pdb_format.h"
+#include "mdtra_utils.h"
+#include "mdtra_streamCache.h"
+
+#define FNV64_OFFSET_BASIS		0xCBF29CE484222325ULL
+#define FNV64_PRIME				0x100000001B3ULL
+
+static qword FNV64_Hash( qword hash, const void *data, size_t size )
+{
+	const byte *p = (const byte*)data;
+	for (size_t i = 0; i < size; i++, p++) {
+		hash ^= *p;
+		hash *= FNV64_PRIME;
+	}
+	return hash;
+}
+
+static void CacheAtomFromPDBAtom( const MDTRA_PDB_Atom *pAtom, MDTRA_StreamCacheAtom *pOut )
+{
+	memset( pOut, 0, sizeof(*pOut) );
+	pOut->serialnumber = pAtom->serialnumber;
+	pOut->residuenumber = pAtom->residuenumber;
+	pOut->chain = pAtom->chain;
+	memcpy( pOut->title, pAtom->title, sizeof(pOut->title) );
+	memcpy( pOut->residue, pAtom->residue, sizeof(pOut->residue) );
+}
+
+#if defined(USE_WIN32_THREADS)
+
+struct stMDTRA_StreamCacheSync
+{
+	CRITICAL_SECTION		crit;
+};
+
+static void StreamCacheInitSync( MDTRA_StreamCacheSync *pSync ) { InitializeCriticalSection( &pSync->crit ); }
+static void StreamCacheFreeSync( MDTRA_StreamCacheSync *pSync ) { DeleteCriticalSection( &pSync->crit ); }
+static void StreamCacheLock( MDTRA_StreamCacheSync *pSync ) { EnterCriticalSection( &pSync->crit ); }
+static void StreamCacheUnlock( MDTRA_StreamCacheSync *pSync ) { LeaveCriticalSection( &pSync->crit ); }
+
+#elif defined(USE_POSIX_THREADS)
+
+struct stMDTRA_StreamCacheSync
+{
+	pthread_mutex_t			mutex;
+};
+
+static void StreamCacheInitSync( MDTRA_StreamCacheSync *pSync ) { pthread_mutex_init( &pSync->mutex, NULL ); }
+static void StreamCacheFreeSync( MDTRA_StreamCacheSync *pSync ) { pthread_mutex_destroy( &pSync->mutex ); }
+static void StreamCacheLock( MDTRA_StreamCacheSync *pSync ) { pthread_mutex_lock( &pSync->mutex ); }
+static void StreamCacheUnlock( MDTRA_StreamCacheSync *pSync ) { pthread_mutex_unlock( &pSync->mutex ); }
+
+#else
+
+struct stMDTRA_StreamCacheSync
+{
+	int						dummy;
+};
+
+static void StreamCacheInitSync( MDTRA_StreamCacheSync *pSync ) {}
+static void StreamCacheFreeSync( MDTRA_StreamCacheSync *pSync ) {}
+static void StreamCacheLock( MDTRA_StreamCacheSync *pSync ) {}
+static void StreamCacheUnlock( MDTRA_StreamCacheSync *pSync ) {}
+
+#endif
+
+MDTRA_StreamCache :: MDTRA_StreamCache( const MDTRA_Stream *pStream )
+{
+	assert( pStream->pdb != NULL );
+	assert( pStream->files.count() > 0 );
+
+	m_pTopology = pStream->pdb;
+	m_Files = pStream->files;
+	m_FileName = pStream->files.at(0) + MDTRA_STREAM_CACHE_EXTENSION;
+	m_bValid = false;
+	m_bWriteFailed = false;
+	m_pWriteFile = NULL;
+	m_iNumPresentFrames = 0;
+	m_pSync = new MDTRA_StreamCacheSync;
+	StreamCacheInitSync( m_pSync );
+	m_pReadFile = new FILE*[CountThreadSlots()];
+	memset( m_pReadFile, 0, sizeof(FILE*) * CountThreadSlots() );
+	m_pFrameBuffer = new float*[CountThreadSlots()];
+	memset( m_pFrameBuffer, 0, sizeof(float*) * CountThreadSlots() );
+
+	bool bHasForce = g_PDBFormatManager.checkFormat( pStream->format_identifier, PDB_FS_FORCE_X ) &&
+					 g_PDBFormatManager.checkFormat( pStream->format_identifier, PDB_FS_FORCE_Y ) &&
+					 g_PDBFormatManager.checkFormat( pStream->format_identifier, PDB_FS_FORCE_Z );
+
+	memset( &m_Header, 0, sizeof(m_Header) );
+	m_Header.magic = MDTRA_STREAM_CACHE_MAGIC;
+	m_Header.version = MDTRA_STREAM_CACHE_VERSION;
+	m_Header.formatIdentifier = pStream->format_identifier;
+	m_Header.streamFlags = pStream->flags & (STREAM_FLAG_IGNORE_HETATM | STREAM_FLAG_IGNORE_SOLVENT);
+	m_Header.numFrames = pStream->files.count();
+	m_Header.numAtoms = m_pTopology->getAtomCount();
+	m_Header.hasForce = bHasForce ? 1 : 0;
+	m_Header.frameStride = m_Header.numAtoms * 3 * sizeof(float) * (bHasForce ? 2 : 1);
+	m_Header.sourceHash = calcSourceHash();
+
+	m_pPresentFrames = (byte*)malloc( m_Header.numFrames );
+	if (!m_pPresentFrames) {
+		m_bWriteFailed = true;
+		return;
+	}
+	memset( (void*)m_pPresentFrames, 0, m_Header.numFrames );
+
+	m_bValid = validate();
+}
+
+MDTRA_StreamCache :: ~MDTRA_StreamCache()
+{
+	//partially written cache is kept, missing frames are parsed next time
+	closeFiles();
+	for (int i = 0; i < CountThreadSlots(); i++) {
+		if (m_pFrameBuffer[i]) {
+			UTIL_AlignedFree( m_pFrameBuffer[i] );
+			m_pFrameBuffer[i] = NULL;
+		}
+	}
+	delete [] m_pFrameBuffer;
+	delete [] m_pReadFile;
+	if (m_pPresentFrames)
+		free( (void*)m_pPresentFrames );
+	StreamCacheFreeSync( m_pSync );
+	delete m_pSync;
+}
+
+qword MDTRA_StreamCache :: calcSourceHash( void ) const
+{
+	//any change in file list, file size or modification time invalidates the cache
+	qword hash = FNV64_OFFSET_BASIS;
+	for (int i = 0; i < m_Files.count(); i++) {
+		QFileInfo fi( m_Files.at(i) );
+		QByteArray path = fi.absoluteFilePath().toLocal8Bit();
+		qint64 fileSize = fi.size();
+		uint fileTime = fi.lastModified().toTime_t();
+		hash = FNV64_Hash( hash, path.constData(), path.size() );
+		hash = FNV64_Hash( hash, &fileSize, sizeof(fileSize) );
+		hash = FNV64_Hash( hash, &fileTime, sizeof(fileTime) );
+	}
+
+	//user formats can be edited, so field layout is also a part of the key
+	const PDBFormat_t *pFormat = g_PDBFormatManager.fetchFormat( m_Header.formatIdentifier );
+	if (pFormat)
+		hash = FNV64_Hash( hash, pFormat->fields, sizeof(pFormat->fields) );
+
+	return hash;
+}
+
+qword MDTRA_StreamCache :: presenceOffset( void ) const
+{
+	return (qword)sizeof(MDTRA_StreamCacheHeader) + 
+		   (qword)m_Header.numAtoms * sizeof(MDTRA_StreamCacheAtom);
+}
+
+qword MDTRA_StreamCache :: frameOffset( int frame ) const
+{
+	return presenceOffset() + 
+		   (qword)m_Header.numFrames + 
+		   (qword)frame * m_Header.frameStride;
+}
+
+bool MDTRA_StreamCache :: checkTopology( FILE *fp ) const
+{
+	const int iChunkSize = 1024;
+	MDTRA_StreamCacheAtom cacheAtoms[iChunkSize];
+	MDTRA_StreamCacheAtom refAtom;
+	int numAtoms = m_Header.numAtoms;
+
+	for (int i = 0; i < numAtoms; i += iChunkSize) {
+		int count = MDTRA_MIN( iChunkSize, numAtoms - i );
+		if (fread( cacheAtoms, sizeof(MDTRA_StreamCacheAtom), count, fp ) != (size_t)count)
+			return false;
+		for (int j = 0; j < count; j++) {
+			CacheAtomFromPDBAtom( m_pTopology->fetchAtomByIndex( i + j ), &refAtom );
+			if (memcmp( &refAtom, &cacheAtoms[j], sizeof(refAtom) ))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool MDTRA_StreamCache :: validate( void )
+{
+	FILE *fp = NULL;
+	if (fopen_s( &fp, m_FileName.toLocal8Bit(), "rb" ))
+		return false;
+
+	MDTRA_StreamCacheHeader header;
+	bool bValid = (fread( &header, sizeof(header), 1, fp ) == 1);
+
+	if (bValid) {
+		bValid = (header.magic == m_Header.magic) &&
+				 (header.version == m_Header.version) &&
+				 (header.formatIdentifier == m_Header.formatIdentifier) &&
+				 (header.streamFlags == m_Header.streamFlags) &&
+				 (header.numFrames == m_Header.numFrames) &&
+				 (header.numAtoms == m_Header.numAtoms) &&
+				 (header.frameStride == m_Header.frameStride) &&
+				 (header.hasForce == m_Header.hasForce) &&
+				 (header.sourceHash == m_Header.sourceHash);
+	}
+
+	if (bValid)
+		bValid = checkTopology( fp );
+
+	//incomplete cache is still usable: present frames are read, the rest are parsed and appended
+	byte *pPresent = (byte*)m_pPresentFrames;
+	if (bValid)
+		bValid = (fread( pPresent, 1, m_Header.numFrames, fp ) == m_Header.numFrames);
+
+	if (bValid) {
+		int lastFrame = -1;
+		m_iNumPresentFrames = 0;
+		for (int i = 0; i < (int)m_Header.numFrames; i++) {
+			if (pPresent[i]) {
+				pPresent[i] = 1;
+				lastFrame = i;
+				m_iNumPresentFrames++;
+			}
+		}
+		bValid = !UTIL_FileSeek( fp, 0, SEEK_END ) && (UTIL_FileTell( fp ) >= frameOffset( lastFrame + 1 ));
+		m_Header.complete = header.complete;
+	}
+
+	if (!bValid) {
+		memset( pPresent, 0, m_Header.numFrames );
+		m_iNumPresentFrames = 0;
+	}
+
+	fclose( fp );
+	return bValid;
+}
+
+bool MDTRA_StreamCache :: beginWrite( void )
+{
+	//must be called under cache lock
+	if (m_bValid) {
+		//append missing frames to the existing cache
+		if (fopen_s( &m_pWriteFile, m_FileName.toLocal8Bit(), "r+b" )) {
+			m_pWriteFile = NULL;
+			m_bWriteFailed = true;
+			return false;
+		}
+		return true;
+	}
+
+	if (fopen_s( &m_pWriteFile, m_FileName.toLocal8Bit(), "wb" )) {
+		m_pWriteFile = NULL;
+		m_bWriteFailed = true;
+		return false;
+	}
+
+	//write incomplete header, topology and empty presence map
+	m_Header.complete = 0;
+	bool bWriteOK = (fwrite( &m_Header, sizeof(m_Header), 1, m_pWriteFile ) == 1);
+
+	MDTRA_StreamCacheAtom cacheAtom;
+	for (int i = 0; bWriteOK && i < (int)m_Header.numAtoms; i++) {
+		CacheAtomFromPDBAtom( m_pTopology->fetchAtomByIndex( i ), &cacheAtom );
+		bWriteOK = (fwrite( &cacheAtom, sizeof(cacheAtom), 1, m_pWriteFile ) == 1);
+	}
+
+	memset( (void*)m_pPresentFrames, 0, m_Header.numFrames );
+	m_iNumPresentFrames = 0;
+	if (bWriteOK)
+		bWriteOK = (fwrite( (const void*)m_pPresentFrames, 1, m_Header.numFrames, m_pWriteFile ) == m_Header.numFrames);
+
+	if (!bWriteOK) {
+		endWrite();
+		m_bWriteFailed = true;
+		return false;
+	}
+
+	m_bValid = true;
+	return true;
+}
+
+void MDTRA_StreamCache :: endWrite( void )
+{
+	//must be called under cache lock
+	if (!m_pWriteFile)
+		return;
+
+	if (!m_Header.complete && m_iNumPresentFrames == (int)m_Header.numFrames) {
+		m_Header.complete = 1;
+		if (UTIL_FileSeek( m_pWriteFile, 0, SEEK_SET ) || 
+			fwrite( &m_Header, sizeof(m_Header), 1, m_pWriteFile ) != 1)
+			m_Header.complete = 0;
+	}
+
+	fclose( m_pWriteFile );
+	m_pWriteFile = NULL;
+}
+
+float* MDTRA_StreamCache :: frameBuffer( int threadnum )
+{
+	if (!m_pFrameBuffer[threadnum])
+		m_pFrameBuffer[threadnum] = (float*)UTIL_AlignedMalloc( m_Header.frameStride );
+	return m_pFrameBuffer[threadnum];
+}
+
+bool MDTRA_StreamCache :: needsFrame( int frame ) const
+{
+	if (m_bWriteFailed)
+		return false;
+	if (frame < 0 || frame >= (int)m_Header.numFrames)
+		return false;
+	return !m_pPresentFrames[frame];
+}
+
+void MDTRA_StreamCache :: writeFrame( int threadnum, int frame, const MDTRA_PDB_File *pPdbFile )
+{
+	if (!needsFrame( frame ))
+		return;
+
+	if (pPdbFile->getAtomCount() != (int)m_Header.numAtoms) {
+		//frames do not share the topology, cache cannot be used for this stream
+		m_bWriteFailed = true;
+		return;
+	}
+
+	//coordinates are gathered outside the lock, only the file access is serialized
+	float *pBuffer = frameBuffer( threadnum );
+	if (!pBuffer)
+		return;
+	pPdbFile->get_coords( pBuffer, m_Header.hasForce ? (pBuffer + m_Header.numAtoms * 3) : NULL );
+
+	StreamCacheLock( m_pSync );
+
+	if (m_bWriteFailed || m_pPresentFrames[frame]) {
+		StreamCacheUnlock( m_pSync );
+		return;
+	}
+
+	if (!m_pWriteFile && !beginWrite()) {
+		StreamCacheUnlock( m_pSync );
+		return;
+	}
+
+	//frame data must reach the file before it is marked present
+	static const byte present = 1;
+	if (UTIL_FileSeek( m_pWriteFile, frameOffset( frame ), SEEK_SET ) ||
+		fwrite( pBuffer, m_Header.frameStride, 1, m_pWriteFile ) != 1 ||
+		fflush( m_pWriteFile ) ||
+		UTIL_FileSeek( m_pWriteFile, presenceOffset() + frame, SEEK_SET ) ||
+		fwrite( &present, 1, 1, m_pWriteFile ) != 1) {
+		endWrite();
+		m_bWriteFailed = true;
+		StreamCacheUnlock( m_pSync );
+		return;
+	}
+
+	m_pPresentFrames[frame] = 1;
+	m_iNumPresentFrames++;
+
+	StreamCacheUnlock( m_pSync );
+}
+
+bool MDTRA_StreamCache :: readFrame( int threadnum, int frame, MDTRA_PDB_File *pPdbFile )
+{
+	if (frame < 0 || frame >= (int)m_Header.numFrames)
+		return false;
+	if (!m_pPresentFrames || !m_pPresentFrames[frame])
+		return false;
+
+	if (!m_pReadFile[threadnum]) {
+		if (fopen_s( &m_pReadFile[threadnum], m_FileName.toLocal8Bit(), "rb" )) {
+			m_pReadFile[threadnum] = NULL;
+			return false;
+		}
+	}
+
+	FILE *fp = m_pReadFile[threadnum];
+	float *pBuffer = frameBuffer( threadnum );
+	if (!pBuffer)
+		return false;
+	if (UTIL_FileSeek( fp, frameOffset( frame ), SEEK_SET ) ||
+		fread( pBuffer, m_Header.frameStride, 1, fp ) != 1)
+		return false;
+
+	return pPdbFile->load_coords( m_pTopology, pBuffer, m_Header.hasForce ? (pBuffer + m_Header.numAtoms * 3) : NULL );
+}
+
+void MDTRA_StreamCache :: closeFiles( void )
+{
+	for (int i = 0; i < CountThreadSlots(); i++) {
+		if (m_pReadFile[i]) {
+			fclose( m_pReadFile[i] );
+			m_pReadFile[i] = NULL;
+		}
+	}
+
+	StreamCacheLock( m_pSync );
+	endWrite();
+	StreamCacheUnlock( m_pSync );
+}
@@ -0,0 +1,100 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_STREAMCACHE_H
+#define MDTRA_STREAMCACHE_H
+
+#define MDTRA_STREAM_CACHE_MAGIC			0x4352544D		//"MTRC"
+#define MDTRA_STREAM_CACHE_VERSION			2
+#define MDTRA_STREAM_CACHE_EXTENSION		".mdtracache"
+
+//Binary snapshot cache file layout:
+//	header
+//	topology block (one MDTRA_StreamCacheAtom per atom)
+//	frame presence map (numFrames bytes, non-zero if the frame is stored)
+//	frames (numFrames * frameStride bytes: float32 xyz per atom, then float32 force per atom if hasForce)
+
+typedef struct stMDTRA_StreamCacheHeader
+{
+	dword	magic;
+	dword	version;
+	dword	formatIdentifier;
+	dword	streamFlags;
+	dword	numFrames;
+	dword	numAtoms;
+	dword	frameStride;
+	dword	hasForce;
+	qword	sourceHash;
+	dword	complete;
+	dword	reserved[5];
+} MDTRA_StreamCacheHeader;
+
+typedef struct stMDTRA_StreamCacheAtom
+{
+	int		serialnumber;
+	int		residuenumber;
+	short	chain;
+	char	title[6];
+	char	residue[5];
+	char	padding[3];
+} MDTRA_StreamCacheAtom;
+
+typedef struct stMDTRA_Stream MDTRA_Stream;
+typedef struct stMDTRA_StreamCacheSync MDTRA_StreamCacheSync;
+class MDTRA_PDB_File;
+
+class MDTRA_StreamCache
+{
+public:
+	MDTRA_StreamCache( const MDTRA_Stream *pStream );
+	~MDTRA_StreamCache();
+
+	bool isValid( void ) const { return m_bValid; }
+	bool needsFrame( int frame ) const;
+	bool readFrame( int threadnum, int frame, MDTRA_PDB_File *pPdbFile );
+	void writeFrame( int threadnum, int frame, const MDTRA_PDB_File *pPdbFile );
+	void closeFiles( void );
+
+private:
+	qword calcSourceHash( void ) const;
+	bool checkTopology( FILE *fp ) const;
+	bool validate( void );
+	bool beginWrite( void );
+	void endWrite( void );
+	float* frameBuffer( int threadnum );
+	qword presenceOffset( void ) const;
+	qword frameOffset( int frame ) const;
+
+private:
+	const MDTRA_PDB_File* m_pTopology;
+	QStringList			m_Files;
+	QString				m_FileName;
+	MDTRA_StreamCacheHeader m_Header;
+	bool				m_bValid;
+	volatile bool		m_bWriteFailed;
+	FILE*				m_pWriteFile;
+	volatile byte*		m_pPresentFrames;
+	int					m_iNumPresentFrames;
+	MDTRA_StreamCacheSync* m_pSync;
+	FILE**				m_pReadFile;
+	float**				m_pFrameBuffer;
+};
+
+#endif //MDTRA_STREAMCACHE_H
@@ -26,6 +26,7 @@
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
 #include "mdtra_pdb_format.h"
+#include "mdtra_trajectory.h"
 #include "mdtra_streamDialog.h"
 #include "mdtra_streamMaskDialog.h"
 
@@ -69,6 +70,7 @@ MDTRA_StreamDialog :: MDTRA_StreamDialog( int index, QWidget *parent )
 			relativeCb->setChecked( (pStream->flags & STREAM_FLAG_RELATIVE_PATHS) != 0 );
 			hetatmCb->setChecked( (pStream->flags & STREAM_FLAG_IGNORE_HETATM) != 0 );
 			solventCb->setChecked( (pStream->flags & STREAM_FLAG_IGNORE_SOLVENT) != 0 );
+			cacheCb->setChecked( (pStream->flags & STREAM_FLAG_USE_CACHE) != 0 );
 			currentFormat = pStream->format_identifier;
 		}
 	}
@@ -101,8 +103,22 @@ void MDTRA_StreamDialog :: exec_on_accept( void )
 	}
 
 	QStringList fileList;
-	for (int i = 0; i < sList->count(); i++)
-		fileList << sList->item(i)->text();
+	QStringList trajectoryList;
+	for (int i = 0; i < sList->count(); i++) {
+		if (MDTRA_IsTrajectoryFile( sList->item(i)->text().toAscii() ))
+			trajectoryList << sList->item(i)->text();
+		else
+			fileList << sList->item(i)->text();
+	}
+
+	//trajectory stream is a topology PDB followed by a single trajectory file
+	if (!trajectoryList.isEmpty()) {
+		if (trajectoryList.count() != 1 || fileList.count() != 1) {
+			QMessageBox::warning(this, tr(APPLICATION_TITLE_SMALL), tr("Trajectory stream must consist of exactly one topology PDB file and one trajectory file!"));
+			return;
+		}
+		fileList << trajectoryList.at(0);
+	}
 
 	unsigned int format = formatCombo->itemData( formatCombo->currentIndex(), Qt::UserRole ).toUInt();
 	unsigned int flags = 0;
@@ -114,6 +130,8 @@ void MDTRA_StreamDialog :: exec_on_accept( void )
 		flags |= STREAM_FLAG_IGNORE_HETATM;
 	if (solventCb->isChecked())
 		flags |= STREAM_FLAG_IGNORE_SOLVENT;
+	if (cacheCb->isChecked())
+		flags |= STREAM_FLAG_USE_CACHE;
 
 	if (m_iStreamIndex < 0) {
 		m_pMainWindow->getProject()->registerStream( lineEdit->text(), fileList, timestep->value(), format, flags );
@@ -126,9 +144,15 @@ void MDTRA_StreamDialog :: exec_on_accept( void )
 
 void MDTRA_StreamDialog :: add_stream_files( void )
 {
+	//only offer compressed files the input layer can decode
+#if defined(MDTRA_ALLOW_ZLIB)
+	const char *pdbFilter = "PDB Files (*.pdb *.pdb.gz)";
+#else
+	const char *pdbFilter = "PDB Files (*.pdb)";
+#endif
 
 	QStringList fileList = QFileDialog::getOpenFileNames( this, tr("Add Files to Stream"), 
-							m_currentFileDir, "PDB Files (*.pdb);;All Files (*.*)" );
+							m_currentFileDir, QString("%1;;Trajectory Files (*.dcd *.xtc);;All Files (*.*)").arg(pdbFilter) );
 	if (fileList.isEmpty()) {
 		return;
 	}
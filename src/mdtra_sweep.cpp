@@ -0,0 +1,209 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of MDTRA_FrameSweep
+
+#include "mdtra_main.h"
+#include "mdtra_project.h"
+#include "mdtra_pdb.h"
+#include "mdtra_stream.h"
+#include "mdtra_prefetch.h"
+#include "mdtra_sweep.h"
+#include "mdtra_progress.h"
+
+static MDTRA_FrameSweep *pLocalSweep = NULL;
+
+MDTRA_FrameSweep :: MDTRA_FrameSweep()
+{
+	m_iNumConsumers = 0;
+	m_iNumFloats = 0;
+	m_bShowSegments = false;
+	m_bComplete = false;
+	m_pPrefetch = NULL;
+	m_pTempPDB = NULL;
+}
+
+MDTRA_FrameSweep :: ~MDTRA_FrameSweep()
+{
+	clear();
+}
+
+void MDTRA_FrameSweep :: clear( void )
+{
+	m_Segments.clear();
+	m_iNumConsumers = 0;
+	m_iNumFloats = 0;
+	m_bComplete = false;
+}
+
+void MDTRA_FrameSweep :: addConsumer( const MDTRA_Stream *pStream, int workStart, int workStride, int workCount, MDTRA_SweepFunc func, void *pContext )
+{
+	if (!pStream || workCount <= 0)
+		return;
+
+	MDTRA_SweepConsumer consumer;
+	consumer.func = func;
+	consumer.pContext = pContext;
+	m_iNumConsumers++;
+
+	//consumers of the same window share the snapshot loads
+	for (int i = 0; i < m_Segments.count(); i++) {
+		MDTRA_SweepSegment *pSeg = &m_Segments[i];
+		if (pSeg->pStream == pStream && pSeg->workStart == workStart && pSeg->workStride == workStride && pSeg->workCount == workCount) {
+			pSeg->consumers << consumer;
+			return;
+		}
+	}
+
+	MDTRA_SweepSegment seg;
+	seg.pStream = pStream;
+	seg.workStart = workStart;
+	seg.workStride = workStride;
+	seg.workCount = workCount;
+	seg.workBase = 0;
+	seg.consumers << consumer;
+	m_Segments << seg;
+}
+
+void MDTRA_FrameSweep :: alloc_floats( int count )
+{
+	if (count > m_iNumFloats)
+		m_iNumFloats = count;
+}
+
+int MDTRA_FrameSweep :: getWorkCount( void ) const
+{
+	int workCount = 0;
+	for (int i = 0; i < m_Segments.count(); i++)
+		workCount += m_Segments.at(i).workCount;
+	return workCount;
+}
+
+//returns index of the segment owning work item num
+int MDTRA_FrameSweep :: findSegment( int num ) const
+{
+	int lo = 0;
+	int hi = m_Segments.count() - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) >> 1;
+		if (m_Segments.at(mid).workBase <= num)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return lo;
+}
+
+void MDTRA_FrameSweep :: processFrame( int threadnum, int num )
+{
+	//this function MUST be thread-safe
+	int segnum = findSegment( num );
+	const MDTRA_SweepSegment *pSeg = &m_Segments.at( segnum );
+	int item = num - pSeg->workBase;
+	int frame = pSeg->workStart + item * pSeg->workStride;
+
+	//Load PDB file
+	MDTRA_PDB_File *pPdbFile;
+	if (m_pPrefetch) {
+		if (!m_pPrefetch->acquireFrame( threadnum, num, &pPdbFile ))
+			pPdbFile = NULL;
+	} else if (frame == 0) {
+		pPdbFile = pSeg->pStream->pdb;
+	} else {
+		pPdbFile = m_pTempPDB[threadnum];
+		if (!MDTRA_LoadStreamFrame( threadnum, pSeg->pStream, frame, pPdbFile ))
+			pPdbFile = NULL;
+	}
+
+	for (int i = 0; i < pSeg->consumers.count(); i++) {
+		const MDTRA_SweepConsumer &consumer = pSeg->consumers.at(i);
+		consumer.func( threadnum, item, pPdbFile, consumer.pContext );
+	}
+
+	if (m_pPrefetch)
+		m_pPrefetch->releaseFrame( num );
+
+	if (m_bShowSegments)
+		ProgressAdvanceStream( segnum );
+	ProgressStepFile();
+	if (ProgressInterrupted())
+		InterruptThreads();
+}
+
+static void fn_SweepFrame( int threadnum, int num )
+{
+	pLocalSweep->processFrame( threadnum, num );
+}
+
+bool MDTRA_FrameSweep :: run( bool showSegments )
+{
+	m_bComplete = false;
+	if (!m_Segments.count()) {
+		m_bComplete = true;
+		return true;
+	}
+
+	//lay out the segments in one work queue and chain their snapshots into a single prefetch ring
+	int workCount = 0;
+	m_pPrefetch = NULL;
+	for (int i = 0; i < m_Segments.count(); i++) {
+		MDTRA_SweepSegment *pSeg = &m_Segments[i];
+		pSeg->workBase = workCount;
+		if (i == 0)
+			m_pPrefetch = MDTRA_CreateFramePrefetcher( pSeg->pStream, NULL, pSeg->workStart, pSeg->workStride );
+		else if (m_pPrefetch)
+			m_pPrefetch->appendStream( pSeg->pStream, pSeg->workStart, pSeg->workStride, pSeg->workBase );
+		workCount += pSeg->workCount;
+	}
+
+	if (m_pPrefetch) {
+		if (m_iNumFloats > 0)
+			m_pPrefetch->alloc_floats( m_iNumFloats );
+	} else {
+		m_pTempPDB = new MDTRA_PDB_File*[CountThreads()];
+		for (int i = 0; i < CountThreads(); i++) {
+			m_pTempPDB[i] = new MDTRA_PDB_File;
+			if (m_iNumFloats > 0)
+				m_pTempPDB[i]->alloc_floats( m_iNumFloats );
+		}
+	}
+
+	m_bShowSegments = showSegments;
+
+	pLocalSweep = this;
+	RunThreadsOnPrefetched( workCount, fn_SweepFrame, m_pPrefetch );
+	pLocalSweep = NULL;
+
+	if (m_pPrefetch) {
+		delete m_pPrefetch;
+		m_pPrefetch = NULL;
+	}
+	if (m_pTempPDB) {
+		for (int i = 0; i < CountThreads(); i++)
+			delete m_pTempPDB[i];
+		delete [] m_pTempPDB;
+		m_pTempPDB = NULL;
+	}
+
+	m_bComplete = !ProgressInterrupted();
+	return m_bComplete;
+}
@@ -0,0 +1,89 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_SWEEP_H
+#define MDTRA_SWEEP_H
+
+#include <QtCore/QVector>
+
+typedef struct stMDTRA_Stream MDTRA_Stream;
+class MDTRA_PDB_File;
+class MDTRA_FramePrefetcher;
+
+//called once per snapshot of the consumer window, num = item in that window;
+//pPdbFile is NULL if the snapshot failed to load
+//consumers of a snapshot run in registration order and MUST be thread-safe; a consumer
+//may move the snapshot rigidly (e.g. align it), so consumers that need absolute
+//coordinates must be registered before it
+typedef void (*MDTRA_SweepFunc)( int threadnum, int num, MDTRA_PDB_File *pPdbFile, void *pContext );
+
+typedef struct stMDTRA_SweepConsumer
+{
+	MDTRA_SweepFunc		func;
+	void*				pContext;
+} MDTRA_SweepConsumer;
+
+typedef struct stMDTRA_SweepSegment
+{
+	const MDTRA_Stream*				pStream;
+	int								workStart;
+	int								workStride;
+	int								workCount;
+	int								workBase;	//first work item of the segment in the sweep
+	QVector<MDTRA_SweepConsumer>	consumers;
+} MDTRA_SweepSegment;
+
+//Loads every snapshot once and hands it to all analyses registered on its
+//stream window; windows of all streams run from one work queue
+class MDTRA_FrameSweep
+{
+public:
+	MDTRA_FrameSweep();
+	~MDTRA_FrameSweep();
+
+	void clear( void );
+	void addConsumer( const MDTRA_Stream *pStream, int workStart, int workStride, int workCount, MDTRA_SweepFunc func, void *pContext );
+	void alloc_floats( int count );
+
+	int getConsumerCount( void ) const { return m_iNumConsumers; }
+	int getSegmentCount( void ) const { return m_Segments.count(); }
+	int getWorkCount( void ) const;
+	bool isComplete( void ) const { return m_bComplete; }
+
+	//runs the sweep, every snapshot steps the progress channel (and the stream
+	//progress if showSegments is set); returns false if the sweep was interrupted
+	bool run( bool showSegments );
+
+	void processFrame( int threadnum, int num );
+
+private:
+	int findSegment( int num ) const;
+
+private:
+	QVector<MDTRA_SweepSegment>	m_Segments;
+	int							m_iNumConsumers;
+	int							m_iNumFloats;
+	bool						m_bShowSegments;
+	bool						m_bComplete;
+	MDTRA_FramePrefetcher*		m_pPrefetch;
+	MDTRA_PDB_File**			m_pTempPDB;
+};
+
+#endif //MDTRA_SWEEP_H
@@ -20,6 +20,10 @@
 ***************************************************************************/
 #include "mdtra_main.h"
 #include "mdtra_threads.h"
+#include "mdtra_dispatch.h"
+#include "mdtra_prefetch.h"
+#include "mdtra_affinity.h"
+#include "mdtra_profiler.h"
 #include "mdtra_progressDialog.h"
 
 #include <QtGui/QApplication>
@@ -27,10 +31,6 @@
 MDTRA_ProgressDialog *pProgressDialog = NULL;
 MDTRA_ProgressBarWrapper gProgressBarWrapper;
 
-static int dispatch = 0;
-static int workcount = 0;
-static bool thread_interrupt = false;
-
 #ifdef _DEBUG
 #define THREAD_DEBUG
 #endif
@@ -42,70 +42,202 @@ void OutputDebugString( const char *s )
 }
 #endif
 
-int GetThreadWork( void )
+//Persistent worker pool
+//Workers are created once and sleep between tasks. Submitted tasks are queued
+//in FIFO order; an idle worker joins the oldest task that still has work and
+//claims chunks of it through the lock-free dispatcher. The submitting thread
+//waits on the task completion barrier and keeps the GUI alive meanwhile.
+
+#define MDTRA_THREAD_GUI_INTERVAL	200		//msec between GUI updates while waiting for a task
+#define MDTRA_FRAME_BLOCK_USEC		4000	//target run time of one block of frame items
+
+struct stMDTRA_ThreadTask
 {
-    ThreadLock();
+	MDTRA_ThreadFunc		func;
+	MDTRA_FramePrefetcher*	pPrefetch;
+	MDTRA_WorkDispatch		dispatch;
+	bool					perThread;		//func runs once on every worker (legacy RunThreadsOn)
+	MDTRA_RangeFunc			rangeFunc;		//range subtask: items are blocks of rangeGrain
+	void*					pContext;
+	int						rangeCount;
+	int						rangeGrain;
+	int						blockLimit;		//frame tasks: largest block of items, 0 if not tuned
+	int						workerLimit;	//prefetched tasks: workers kept once tuned, 0 for all
+	volatile double			itemUsec;		//frame tasks: smoothed run time of one item
+	int						serial;
+	volatile int			running;		//workers currently inside the task
+	bool					done;
+	MDTRA_ThreadTask*		pNext;
+};
+
+//the progress channel is sampled by the GUI thread, workers never touch widgets
+static void ThreadUpdateGUI( void )
+{
+	bool bPendingEvents = QApplication::hasPendingEvents();
+	bool bUpdateDialogGUI = pProgressDialog ? pProgressDialog->needUpdateGUI() : false;
+	bool bUpdateWrapperGUI = gProgressBarWrapper.needUpdateGUI();
 
-	if (thread_interrupt) {
+	if (bUpdateDialogGUI || bUpdateWrapperGUI || bPendingEvents) {
+		MDTRA_PROF_SCOPE( "update GUI", MDTRA_PROF_GUI );
+		ThreadLock();
 #ifdef THREAD_DEBUG
-        OutputDebugString("GetThreadWork: thread interrupted\n");
+		OutputDebugString("Timeout lock: QApplication::processEvents\n");
 #endif
-        ThreadUnlock();
-        return -1;
+		//update progress bars
+		if (bUpdateDialogGUI) {
+			pProgressDialog->updateGUI();
+			QApplication::processEvents();
+		}
+		if (bUpdateWrapperGUI) {
+			gProgressBarWrapper.updateGUI();
+			QApplication::processEvents();
+		}
+
+		if (bPendingEvents)
+			QApplication::processEvents();
+
+		ThreadUnlock();
 	}
-    if (dispatch > workcount) {
-#ifdef THREAD_DEBUG
-        OutputDebugString("GetThreadWork: dispatch > workcount!\n");
-#endif
-        ThreadUnlock();
-        return -1;
-    }
-    if (dispatch == workcount) {
-#ifdef THREAD_DEBUG
-        OutputDebugString("GetThreadWork: dispatch == workcount, work is complete\n");
+}
+
+//single-threaded: the GUI is refreshed whenever the sampled progress changes
+static void ThreadPollGUI( void )
+{
+	if ((pProgressDialog && pProgressDialog->needUpdateGUI()) || gProgressBarWrapper.needUpdateGUI())
+		ThreadUpdateGUI();
+}
+
+double ThreadMicroseconds( void )
+{
+#if defined(WIN32)
+	LARGE_INTEGER freq, counter;
+	QueryPerformanceFrequency( &freq );
+	QueryPerformanceCounter( &counter );
+	return (double)counter.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+	struct timeval tp;
+	gettimeofday( &tp, NULL );
+	return (double)tp.tv_sec * 1e6 + (double)tp.tv_usec;
 #endif
-        ThreadUnlock();
-        return -1;
-    }
-    if (dispatch < 0) {
+}
+
+//Frame tasks hand out blocks of consecutive items sized from the measured time per
+//item: cheap frames amortize the dispatch and the worker keeps its temporary PDB and
+//the reference data hot across the block. Workers update the estimate without a lock,
+//a lost sample only delays the next resize.
+static void ThreadTaskTuneBlock( MDTRA_ThreadTask *pTask, int count, double usec )
+{
+	double itemUsec = usec / count;
+	if (pTask->itemUsec > 0.0)
+		itemUsec = (pTask->itemUsec * 3.0 + itemUsec) * 0.25;
+	pTask->itemUsec = itemUsec;
+
+	double block = MDTRA_FRAME_BLOCK_USEC / MDTRA_MAX( itemUsec, 0.001 );
+	if (block > pTask->blockLimit)
+		block = pTask->blockLimit;
+	pTask->dispatch.maxChunk = MDTRA_MAX( (long)block, 1L );
+}
+
+static void ThreadTaskItems( MDTRA_ThreadTask *pTask, int threadnum, bool pollGUI )
+{
+	int work, count;
+
+	while ((work = DispatchNext( &pTask->dispatch, &count )) != -1) {
+		double blockStart = (pTask->blockLimit > 1) ? ThreadMicroseconds() : 0.0;
+		for (int i = 0; i < count; i++) {
+			//prefetched frames of a claimed block must all be acquired and released, so an
+			//interrupted block is walked to the end; aborted acquires fail at once
+			if (pTask->dispatch.interrupt && !pTask->pPrefetch)
+				break;
 #ifdef THREAD_DEBUG
-        OutputDebugString("GetThreadWork: negative dispatch!\n");
+			char msgBuf[256];
+			memset( msgBuf, 0, sizeof(msgBuf) );
+			sprintf_s(msgBuf, sizeof(msgBuf), "Thread %i: work %i\n", threadnum, work + i);
+			OutputDebugString(msgBuf);
 #endif
-        ThreadUnlock();
-        return -1;
-    }
-
-    int r = dispatch;
-    dispatch++;
+			if (pTask->rangeFunc) {
+				int first = (work + i) * pTask->rangeGrain;
+				int last = first + pTask->rangeGrain;
+				pTask->rangeFunc( threadnum, first, (last < pTask->rangeCount) ? last : pTask->rangeCount, pTask->pContext );
+			} else {
+				pTask->func( threadnum, work + i );
+			}
+			if (pollGUI)
+				ThreadPollGUI();
+		}
+		if (pTask->blockLimit > 1 && !pTask->dispatch.interrupt)
+			ThreadTaskTuneBlock( pTask, count, ThreadMicroseconds() - blockStart );
+
+		//workers over the tuned concurrency leave between blocks; the count is read
+		//without a lock, the pool lets the surplus rejoin if too many left at once
+		if (pTask->pPrefetch && !pollGUI) {
+			pTask->workerLimit = pTask->pPrefetch->getWorkerLimit();
+			if (pTask->workerLimit && pTask->running > pTask->workerLimit)
+				return;
+		}
+	}
+}
 
-    ThreadUnlock();
-    return r;
+static bool ThreadTaskExhausted( const MDTRA_ThreadTask *pTask )
+{
+	return (pTask->dispatch.interrupt || pTask->dispatch.next >= pTask->dispatch.count);
 }
 
-static MDTRA_ThreadFunc workfunction;
+static MDTRA_ThreadTask *ThreadTaskAlloc( int workcnt, MDTRA_ThreadFunc func, MDTRA_FramePrefetcher *pPrefetch, bool perThread )
+{
+	static int taskserial = 0;
+
+	MDTRA_ThreadTask *pTask = new MDTRA_ThreadTask;
+	pTask->func = func;
+	pTask->pPrefetch = pPrefetch;
+	pTask->perThread = perThread;
+	pTask->rangeFunc = NULL;
+	pTask->pContext = NULL;
+	pTask->rangeCount = 0;
+	pTask->rangeGrain = 0;
+	pTask->blockLimit = perThread ? 0 : MDTRA_DISPATCH_MAX_CHUNK;
+	pTask->workerLimit = 0;
+	pTask->itemUsec = 0.0;
+	pTask->serial = perThread ? ++taskserial : 0;	//per-thread tasks are only submitted by the main thread
+	pTask->running = 0;
+	pTask->done = false;
+	pTask->pNext = NULL;
+
+	//frame tasks start with single items until the first blocks are measured
+	DispatchReset( &pTask->dispatch, workcnt, CountThreads(), 1 );
+	return pTask;
+}
 
-static void ThreadWorkerFunction( int threadnum, int unused )
+//range subtasks may be created on workers; blocks are already coarse, so they are claimed one at a time
+static MDTRA_ThreadTask *ThreadRangeTaskAlloc( int count, int grain, MDTRA_RangeFunc func, void *pContext )
 {
-    int work;
+	MDTRA_ThreadTask *pTask = ThreadTaskAlloc( (count + grain - 1) / grain, NULL, NULL, false );
+	pTask->rangeFunc = func;
+	pTask->pContext = pContext;
+	pTask->rangeCount = count;
+	pTask->rangeGrain = grain;
+	pTask->blockLimit = 0;
+	return pTask;
+}
 
-    while ((work = GetThreadWork()) != -1) {
-#ifdef THREAD_DEBUG
-		char msgBuf[256];
-		memset( msgBuf, 0, sizeof(msgBuf) );
-		sprintf_s(msgBuf, sizeof(msgBuf), "Thread %i: work %i\n", threadnum, work);
-		OutputDebugString(msgBuf);
-#endif
-		workfunction(threadnum, work);
-    }
+static MDTRA_ThreadTask *currenttask = NULL;
+static bool threadpinning = false;
 
-#ifdef THREAD_DEBUG
-        OutputDebugString("ThreadWorkerFunction: exit!\n");
-#endif
+void ThreadSetAffinity( bool pin )
+{
+	//workers are pinned when they start, so the pool is restarted on change
+	if (pin != threadpinning)
+		ThreadPoolShutdown();
+	threadpinning = pin;
 }
 
-void InterruptThreads( void )
+//single-threaded: items run right here on the submitting thread
+static void ThreadTaskRunHere( MDTRA_ThreadTask *pTask )
 {
-	thread_interrupt = true;
+	currenttask = pTask;
+	ThreadTaskItems( pTask, 0, true );
+	currenttask = NULL;
+	pTask->done = true;
 }
 
 #if defined(USE_WIN32_THREADS)
@@ -115,21 +247,33 @@ static int threadpriority = 1;
 static int oldpriority = 0;
 static bool threaded = false;
 
+static int CountProcessors( void )
+{
+#if (_WIN32_WINNT >= 0x0601)
+	//processors of all groups, GetSystemInfo reports only the current group
+	return GetActiveProcessorCount( ALL_PROCESSOR_GROUPS );
+#else
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#endif
+}
+
 void ThreadSetDefault( int count, int priority )
 {
+	//the pool is restarted with the new size on the next submission
+	ThreadPoolShutdown();
+
  	threadpriority = priority;
 	numthreads = count;
 
-    if (numthreads == -1) {
-		SYSTEM_INFO info;
-        GetSystemInfo(&info);
-        numthreads = info.dwNumberOfProcessors;
-    }
+	if (numthreads == -1)
+		numthreads = CountProcessors();
 
 	if (numthreads < 1)
 		numthreads = 1;
-	else if (numthreads > MDTRA_MAX_THREADS)
-		numthreads = MDTRA_MAX_THREADS;
+	else if (numthreads > CountThreadSlots())
+		numthreads = CountThreadSlots();
 }
 
 int CountThreads( void )
@@ -161,8 +305,17 @@ void ThreadResetPriority( void )
 }
 
 static CRITICAL_SECTION crit;
+static bool critinit = false;
 static int enter;
 
+static void ThreadInitLock( void )
+{
+	if (!critinit) {
+		InitializeCriticalSection(&crit);
+		critinit = true;
+	}
+}
+
 void ThreadLock( void )
 {
 	if (!threaded)
@@ -190,105 +343,59 @@ void ThreadUnlock( void )
     LeaveCriticalSection(&crit);
 }
 
-MDTRA_ThreadFunc thread_entry;
+static CRITICAL_SECTION poolcrit;
+static CONDITION_VARIABLE poolwork;
+static CONDITION_VARIABLE pooldone;
+static HANDLE *poolhandle = NULL;
+
+static void ThreadPoolWorker( int threadnum );
 
 static DWORD WINAPI ThreadEntryStub(LPVOID pParam)
 {
-    thread_entry((int)pParam, 0);
+    ThreadPoolWorker( (int)pParam );
     return 0;
 }
 
-void RunThreadsOn( int workcnt, MDTRA_ThreadFunc func )
+static void PoolInitSync( int count )
 {
-	DWORD threadid[MDTRA_MAX_THREADS];
-    HANDLE threadhandle[MDTRA_MAX_THREADS];
-
-	dispatch = 0;
-    workcount = workcnt;
-	thread_interrupt = false;
-
-	ThreadSetPriority();
-
-	if (CountThreads() <= 1) {
-		//single-threaded
-		func(0, 0);
-		ThreadResetPriority();
-		return;
-	}
-
-	threaded = true;
-	thread_entry = func;
-
-	QApplication::flush();
-	QApplication::processEvents();
-
-	InitializeCriticalSection(&crit);
-
-	for (int i = 0; i < numthreads; i++) {
-        HANDLE hThread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE) ThreadEntryStub, (LPVOID) i, CREATE_SUSPENDED, &threadid[i]);
-        if (hThread != NULL) {
-            threadhandle[i] = hThread;
-        } else {
-#ifdef THREAD_DEBUG
-		OutputDebugString("Unable to create thread!\n");
-#endif
-        }
-    }
+	InitializeCriticalSection( &poolcrit );
+	InitializeConditionVariable( &poolwork );
+	InitializeConditionVariable( &pooldone );
+	poolhandle = new HANDLE[count];
+}
 
-	 // Start all the threads
-    for (int i = 0; i < numthreads; i++)
-    {
-        if (ResumeThread(threadhandle[i]) == 0xFFFFFFFF) {
-#ifdef THREAD_DEBUG
-			OutputDebugString("Unable to resume thread!\n");
-#endif
-        }
-    }
+static void PoolFreeSync( void )
+{
+	DeleteCriticalSection( &poolcrit );
+	delete [] poolhandle;
+	poolhandle = NULL;
+}
 
-#ifdef THREAD_DEBUG
-	char msgBuf[256];
-	memset( msgBuf, 0, sizeof(msgBuf) );
-	sprintf_s(msgBuf, sizeof(msgBuf), "Started %i threads\n", numthreads);
-	OutputDebugString(msgBuf);
-#endif
+static void PoolLock( void ) { EnterCriticalSection( &poolcrit ); }
+static void PoolUnlock( void ) { LeaveCriticalSection( &poolcrit ); }
+static void PoolWaitWork( void ) { SleepConditionVariableCS( &poolwork, &poolcrit, INFINITE ); }
+static void PoolSignalWork( void ) { WakeAllConditionVariable( &poolwork ); }
+static void PoolSignalDone( void ) { WakeAllConditionVariable( &pooldone ); }
 
-	// Wait for threads to complete
-	while (1) {
-		DWORD dwWaitResult = WaitForMultipleObjects( numthreads, threadhandle, TRUE, 200 );
-		if (dwWaitResult == WAIT_TIMEOUT) {
-			bool bPendingEvents = QApplication::hasPendingEvents();
-			bool bUpdateDialogGUI = pProgressDialog ? pProgressDialog->needUpdateGUI() : false;
-			bool bUpdateWrapperGUI = gProgressBarWrapper.needUpdateGUI();
-
-			if (bUpdateDialogGUI || bUpdateWrapperGUI || bPendingEvents) {
-				ThreadLock();
-#ifdef THREAD_DEBUG
-				OutputDebugString("Timeout lock: QApplication::processEvents\n");
-#endif
-				//update progress bar
-				if (bUpdateDialogGUI) {
-					pProgressDialog->updateGUI();
-					QApplication::processEvents();
-				} 
-				if (bUpdateWrapperGUI) {
-					gProgressBarWrapper.updateGUI();
-					QApplication::processEvents();
-				} 
-				
-				if (bPendingEvents) {
-					QApplication::processEvents();
-				}
-
-				ThreadUnlock();
-			}
-		} else break;
-	}
+//returns false on timeout
+static bool PoolWaitDone( int msec )
+{
+	return (SleepConditionVariableCS( &pooldone, &poolcrit, msec ) != 0);
+}
 
-	DeleteCriticalSection(&crit);
+static bool PoolStartThread( int i )
+{
+	poolhandle[i] = CreateThread( NULL, 0, (LPTHREAD_START_ROUTINE)ThreadEntryStub, (LPVOID)i, 0, NULL );
+	return (poolhandle[i] != NULL);
+}
 
-	thread_entry = NULL;
-    threaded = false;
-	ThreadResetPriority();
+static void PoolJoinThreads( int count )
+{
+	if (count <= 0)
+		return;
+	WaitForMultipleObjects( count, poolhandle, TRUE, INFINITE );
+	for (int i = 0; i < count; i++)
+		CloseHandle( poolhandle[i] );
 }
 
 #elif defined(USE_POSIX_THREADS)
@@ -297,34 +404,41 @@ static int numthreads = -1;
 static int threadpriority = 1;
 static bool threaded = false;
 
+static int CountProcessors( void )
+{
+	//poll /proc/cpuinfo
+	FILE *fp = NULL;
+	if (fopen_s( &fp, "/proc/cpuinfo", "r" ))
+		return 1;
+
+	char buf[1024];
+	memset(buf,0,sizeof(buf));
+	int count = 0;
+	while (!feof(fp)) {
+		if (!fgets(buf, 1023, fp))
+			break;
+		if (!_strnicmp(buf, "processor", 9))
+			count++;
+	}
+	fclose(fp);
+	return count;
+}
+
 void ThreadSetDefault( int count, int priority )
 {
+	//the pool is restarted with the new size on the next submission
+	ThreadPoolShutdown();
+
 	threadpriority = priority;
 	numthreads = count;
 
-    if (numthreads == -1) {
-        //poll /proc/cpuinfo
-		FILE *fp = NULL;
-		if (fopen_s( &fp, "/proc/cpuinfo", "r" )) {
-			numthreads = 1;
-		} else {
-			char buf[1024];
-			memset(buf,0,sizeof(buf));
-			numthreads = 0;
-			while (!feof(fp)) {
-				if (!fgets(buf, 1023, fp))
-					break;
-				if (!_strnicmp(buf, "processor", 9))
-					numthreads++;
-			}
-			fclose(fp);
-		}
-    }
+	if (numthreads == -1)
+		numthreads = CountProcessors();
 
 	if (numthreads < 1)
 		numthreads = 1;
-	else if (numthreads > MDTRA_MAX_THREADS)
-		numthreads = MDTRA_MAX_THREADS;
+	else if (numthreads > CountThreadSlots())
+		numthreads = CountThreadSlots();
 }
 
 int CountThreads( void )
@@ -356,15 +470,19 @@ void ThreadResetPriority( void )
 	setpriority( PRIO_PROCESS, 0, 0 );
 }
 
-pthread_mutex_t* pth_mutex = NULL;
+static pthread_mutex_t pth_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int enter;
 
+static void ThreadInitLock( void )
+{
+}
+
 void ThreadLock( void )
 {
 	if (!threaded)
         return;
 
-	pthread_mutex_lock(pth_mutex);
+	pthread_mutex_lock(&pth_mutex);
 
 #ifdef THREAD_DEBUG
 	if (enter)
@@ -383,139 +501,423 @@ void ThreadUnlock( void )
         OutputDebugString("ThreadUnlock: no lock!\n");
 #endif
     enter--;
-	pthread_mutex_unlock(pth_mutex);
+	pthread_mutex_unlock(&pth_mutex);
 }
 
-MDTRA_ThreadFunc thread_entry;
+static pthread_mutex_t poolmutex;
+static pthread_cond_t poolwork;
+static pthread_cond_t pooldone;
+static pthread_t *poolhandle = NULL;
+
+static void ThreadPoolWorker( int threadnum );
 
 static void* ThreadEntryStub(void* pParam)
 {
-    thread_entry((int)pParam, 0);
+    ThreadPoolWorker( (int)(intptr_t)pParam );
     return NULL;
 }
 
-static unsigned long sys_timeBase = 0;
-static int curtime;
+static void PoolInitSync( int count )
+{
+	pthread_mutex_init( &poolmutex, NULL );
+	pthread_cond_init( &poolwork, NULL );
+	pthread_cond_init( &pooldone, NULL );
+	poolhandle = new pthread_t[count];
+}
 
-int ThreadMilliseconds( void )
+static void PoolFreeSync( void )
 {
-	struct timeval tp;
+	pthread_cond_destroy( &pooldone );
+	pthread_cond_destroy( &poolwork );
+	pthread_mutex_destroy( &poolmutex );
+	delete [] poolhandle;
+	poolhandle = NULL;
+}
+
+static void PoolLock( void ) { pthread_mutex_lock( &poolmutex ); }
+static void PoolUnlock( void ) { pthread_mutex_unlock( &poolmutex ); }
+static void PoolWaitWork( void ) { pthread_cond_wait( &poolwork, &poolmutex ); }
+static void PoolSignalWork( void ) { pthread_cond_broadcast( &poolwork ); }
+static void PoolSignalDone( void ) { pthread_cond_broadcast( &pooldone ); }
 
-	gettimeofday(&tp, NULL);
-	
-	if (!sys_timeBase) {
-		sys_timeBase = tp.tv_sec;
-		return tp.tv_usec/1000;
+//returns false on timeout
+static bool PoolWaitDone( int msec )
+{
+	struct timeval tp;
+	struct timespec ts;
+
+	gettimeofday( &tp, NULL );
+	ts.tv_sec = tp.tv_sec + msec / 1000;
+	ts.tv_nsec = tp.tv_usec * 1000 + (msec % 1000) * 1000000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
 	}
 
-	curtime = (tp.tv_sec - sys_timeBase)*1000 + tp.tv_usec/1000;
-	return curtime;
+	return (pthread_cond_timedwait( &pooldone, &poolmutex, &ts ) == 0);
 }
 
-void RunThreadsOn( int workcnt, MDTRA_ThreadFunc func )
+static bool PoolStartThread( int i )
 {
-    pthread_t threadhandle[MDTRA_MAX_THREADS];
-	pthread_attr_t threadattrib;
+	return (pthread_create( &poolhandle[i], NULL, ThreadEntryStub, (void*)(intptr_t)i ) == 0);
+}
 
-	dispatch = 0;
-    workcount = workcnt;
-	thread_interrupt = false;
+static void PoolJoinThreads( int count )
+{
+	for (int i = 0; i < count; i++)
+		pthread_join( poolhandle[i], NULL );
+}
 
-	ThreadSetPriority();
+#endif
 
-	if (CountThreads() <= 1) {
-		//single-threaded
-		func(0, 0);
-		ThreadResetPriority();
-		return;
+#if defined(USE_WIN32_THREADS) || defined(USE_POSIX_THREADS)
+
+int CountThreadSlots( void )
+{
+	static int threadslots = 0;
+
+	//may be called during static initialization, before ThreadSetDefault
+	if (!threadslots) {
+		threadslots = CountProcessors();
+		if (threadslots < MDTRA_MIN_THREAD_SLOTS)
+			threadslots = MDTRA_MIN_THREAD_SLOTS;
 	}
+	return threadslots;
+}
 
-	threaded = true;
-	thread_entry = func;
+static int poolthreads = 0;
+static bool poolquit = false;
+static MDTRA_ThreadTask *poolqueue = NULL;
+static MDTRA_THREAD_LOCAL bool poolworker = false;	//set on pool worker threads
 
-	QApplication::flush();
-	QApplication::processEvents();
+//called with pool locked
+static void ThreadPoolUnlinkTask( MDTRA_ThreadTask *pTask )
+{
+	MDTRA_ThreadTask **ppTask = &poolqueue;
+	while (*ppTask && *ppTask != pTask)
+		ppTask = &(*ppTask)->pNext;
+	if (*ppTask)
+		*ppTask = pTask->pNext;
+	pTask->pNext = NULL;
+}
+
+//called with pool locked
+static void ThreadPoolFinishTask( MDTRA_ThreadTask *pTask )
+{
+	ThreadPoolUnlinkTask( pTask );
+	pTask->done = true;
+	PoolSignalDone();
+}
+
+//called with pool locked; per-thread tasks are claimed here, so every worker joins them once
+static MDTRA_ThreadTask *ThreadPoolPickTask( int lastSerial )
+{
+	for (MDTRA_ThreadTask *pTask = poolqueue; pTask; pTask = pTask->pNext) {
+		if (ThreadTaskExhausted( pTask ))
+			continue;
+		if (pTask->workerLimit && pTask->running >= pTask->workerLimit)
+			continue;
+		if (pTask->perThread) {
+			int count;
+			if (pTask->serial == lastSerial || DispatchNext( &pTask->dispatch, &count ) == -1)
+				continue;
+		}
+		return pTask;
+	}
+	return NULL;
+}
+
+static void ThreadPoolWorker( int threadnum )
+{
+	int lastSerial = 0;
+
+	poolworker = true;
+	ProfilerNameThread( MDTRA_PROF_THREAD_WORKER, threadnum );
+	if (threadpinning)
+		AffinityPinCurrentThread( threadnum );
+	PoolLock();
+	while (1) {
+		MDTRA_ThreadTask *pTask = ThreadPoolPickTask( lastSerial );
+		if (!pTask) {
+			if (poolquit)
+				break;
+			PoolWaitWork();
+			continue;
+		}
 
-	pthread_mutexattr_t pth_mutex_attr;
-	if (!pth_mutex) {
-		pth_mutex = (pthread_mutex_t*)malloc(sizeof(*pth_mutex));
-		pthread_mutexattr_init(&pth_mutex_attr);
-        pthread_mutex_init(pth_mutex, &pth_mutex_attr);
+		pTask->running++;
+		PoolUnlock();
+
+		if (pTask->perThread) {
+			lastSerial = pTask->serial;
+			pTask->func( threadnum, 0 );
+		} else {
+			ThreadTaskItems( pTask, threadnum, false );
+		}
+
+		PoolLock();
+		pTask->running--;
+		if (!pTask->running && !pTask->done && ThreadTaskExhausted( pTask ))
+			ThreadPoolFinishTask( pTask );
 	}
+	PoolUnlock();
 
-	pthread_attr_init(&threadattrib);
+#ifdef THREAD_DEBUG
+	OutputDebugString("ThreadPoolWorker: exit!\n");
+#endif
+}
+
+static void ThreadPoolStart( void )
+{
+	if (poolthreads > 0)
+		return;
+
+	ThreadInitLock();
+	PoolInitSync( numthreads );
+	poolquit = false;
+
+	//the process mask is read here, before workers narrow their own ones
+	if (threadpinning)
+		AffinityCountProcessors();
 
 	for (int i = 0; i < numthreads; i++) {
-		if (pthread_create(&threadhandle[i], &threadattrib, ThreadEntryStub, (void*)i) == -1) {
+		if (!PoolStartThread( i )) {
 #ifdef THREAD_DEBUG
 			OutputDebugString("Unable to create thread!\n");
 #endif
+			break;
 		}
-    }
+		poolthreads++;
+	}
 
 #ifdef THREAD_DEBUG
 	char msgBuf[256];
 	memset( msgBuf, 0, sizeof(msgBuf) );
-	sprintf_s(msgBuf, sizeof(msgBuf), "Started %i threads\n", numthreads);
+	sprintf_s(msgBuf, sizeof(msgBuf), "Started %i pool threads\n", poolthreads);
 	OutputDebugString(msgBuf);
 #endif
 
-	// Wait for threads to complete
-	int starttime = ThreadMilliseconds();
+	threaded = (poolthreads > 0);
+	if (!threaded)
+		PoolFreeSync();
+}
 
-	while (1) {
-		//check timeout 200ms
-		int newtime = ThreadMilliseconds();
-		if (newtime - starttime >= 200)	{
-			starttime = newtime;
-
-			//check if threads completed
-			bool threads_done = true;
-			for (int i = 0; i < numthreads; i++) {
-				if (!pthread_kill(threadhandle[i], 0)) {
-					//thread alive
-					threads_done = false;
-					break;
-				}
-			}
+void ThreadPoolShutdown( void )
+{
+	if (poolthreads <= 0)
+		return;
 
-			if (threads_done)
-				break;
-		
-			bool bPendingEvents = QApplication::hasPendingEvents();
-			bool bUpdateDialogGUI = pProgressDialog ? pProgressDialog->needUpdateGUI() : false;
-			bool bUpdateWrapperGUI = gProgressBarWrapper.needUpdateGUI();
+	//workers drain the queue before they exit
+	PoolLock();
+	poolquit = true;
+	PoolSignalWork();
+	PoolUnlock();
 
-			if (bUpdateDialogGUI || bUpdateWrapperGUI || bPendingEvents) {
-				ThreadLock();
-#ifdef THREAD_DEBUG
-				OutputDebugString("Timeout lock: QApplication::processEvents\n");
-#endif
-				//update progress bars
-				if (bUpdateDialogGUI) {
-					pProgressDialog->updateGUI();
-					QApplication::processEvents();
-				}
-				if (bUpdateWrapperGUI) {
-					gProgressBarWrapper.updateGUI();
-					QApplication::processEvents();
-				}
-
-				if (bPendingEvents)
-					QApplication::processEvents();
-
-				ThreadUnlock();
+	PoolJoinThreads( poolthreads );
+	PoolFreeSync();
+
+	poolthreads = 0;
+	threaded = false;
+}
+
+MDTRA_ThreadTask *SubmitThreadTask( int workcnt, MDTRA_ThreadFunc func, MDTRA_FramePrefetcher *pPrefetch )
+{
+	if (CountThreads() > 1)
+		ThreadPoolStart();
+
+	MDTRA_ThreadTask *pTask = ThreadTaskAlloc( workcnt, func, pPrefetch, false );
+
+	//readers are started after the pool, so ThreadLock is valid for them
+	if (pPrefetch) {
+		if (!threaded) {
+			ThreadInitLock();
+			threaded = true;
+		}
+		pPrefetch->start( workcnt );
+		pTask->blockLimit = pPrefetch->getBlockLimit();
+	}
+
+	if (poolthreads <= 0) {
+		ThreadTaskRunHere( pTask );
+		return pTask;
+	}
+
+	PoolLock();
+	if (ThreadTaskExhausted( pTask )) {
+		pTask->done = true;
+	} else {
+		MDTRA_ThreadTask **ppTask = &poolqueue;
+		while (*ppTask)
+			ppTask = &(*ppTask)->pNext;
+		*ppTask = pTask;
+		PoolSignalWork();
+	}
+	PoolUnlock();
+
+	return pTask;
+}
+
+//subtasks jump the queue, so idle workers steal them before starting new frames
+static void ThreadPoolPushFront( MDTRA_ThreadTask *pTask )
+{
+	PoolLock();
+	pTask->pNext = poolqueue;
+	poolqueue = pTask;
+	PoolSignalWork();
+	PoolUnlock();
+}
+
+void RunThreadsOnRange( int threadnum, int count, int grain, MDTRA_RangeFunc func, void *pContext )
+{
+	if (count <= 0)
+		return;
+	if (grain < 1)
+		grain = 1;
+	if (!poolworker && CountThreads() > 1)
+		ThreadPoolStart();
+
+	MDTRA_ThreadTask *pTask = ThreadRangeTaskAlloc( count, grain, func, pContext );
+
+	if (poolthreads <= 0 || count <= grain) {
+		ThreadTaskItems( pTask, threadnum, false );
+		delete pTask;
+		return;
+	}
+
+	if (!poolworker) {
+		//submitted from the main thread, which keeps the GUI alive while workers run the blocks
+		ThreadPoolPushFront( pTask );
+		WaitThreadTask( pTask );
+		return;
+	}
+
+	//help first: the owning worker runs blocks of its subtask alongside the thieves,
+	//but never picks up other tasks, its per-thread scratch still belongs to the current item
+	pTask->running = 1;
+	ThreadPoolPushFront( pTask );
+
+	ThreadTaskItems( pTask, threadnum, false );
+
+	PoolLock();
+	pTask->running--;
+	if (!pTask->running && !pTask->done && ThreadTaskExhausted( pTask ))
+		ThreadPoolFinishTask( pTask );
+	while (!pTask->done)
+		PoolWaitDone( MDTRA_THREAD_GUI_INTERVAL );
+	PoolUnlock();
+
+	delete pTask;
+}
+
+static MDTRA_ThreadTask *SubmitPerThreadTask( MDTRA_ThreadFunc func )
+{
+	ThreadPoolStart();
+
+	MDTRA_ThreadTask *pTask = ThreadTaskAlloc( poolthreads, func, NULL, true );
+
+	PoolLock();
+	MDTRA_ThreadTask **ppTask = &poolqueue;
+	while (*ppTask)
+		ppTask = &(*ppTask)->pNext;
+	*ppTask = pTask;
+	PoolSignalWork();
+	PoolUnlock();
+
+	return pTask;
+}
+
+bool ThreadTaskDone( MDTRA_ThreadTask *pTask )
+{
+	if (poolthreads <= 0)
+		return pTask->done;
+
+	PoolLock();
+	bool done = pTask->done;
+	PoolUnlock();
+	return done;
+}
+
+void CancelThreadTask( MDTRA_ThreadTask *pTask )
+{
+	DispatchInterrupt( &pTask->dispatch );
+	if (pTask->pPrefetch)
+		pTask->pPrefetch->abort();
+
+	if (poolthreads <= 0)
+		return;
+
+	//nobody has joined the task yet, so nobody else would finish it
+	PoolLock();
+	if (!pTask->running && !pTask->done)
+		ThreadPoolFinishTask( pTask );
+	PoolUnlock();
+}
+
+void InterruptThreads( void )
+{
+	//workers and readers blocked on the prefetch ring are woken as well
+	if (currenttask) {
+		DispatchInterrupt( &currenttask->dispatch );
+		if (currenttask->pPrefetch)
+			currenttask->pPrefetch->abort();
+	}
+
+	if (poolthreads <= 0)
+		return;
+
+	//tasks nobody has joined yet are finished here, the rest by their last worker
+	PoolLock();
+	MDTRA_ThreadTask *pTask = poolqueue;
+	while (pTask) {
+		MDTRA_ThreadTask *pNext = pTask->pNext;
+		DispatchInterrupt( &pTask->dispatch );
+		if (pTask->pPrefetch)
+			pTask->pPrefetch->abort();
+		if (!pTask->running)
+			ThreadPoolFinishTask( pTask );
+		pTask = pNext;
+	}
+	PoolUnlock();
+}
+
+void WaitThreadTask( MDTRA_ThreadTask *pTask )
+{
+	if (poolthreads > 0) {
+		MDTRA_PROF_SCOPE( "wait for workers", MDTRA_PROF_WAIT );
+		PoolLock();
+		while (!pTask->done) {
+			if (!PoolWaitDone( MDTRA_THREAD_GUI_INTERVAL ) && !pTask->done) {
+				PoolUnlock();
+				ThreadUpdateGUI();
+				PoolLock();
 			}
 		}
+		PoolUnlock();
 	}
 
-	if (pth_mutex) {
-		free(pth_mutex);
-		pth_mutex = NULL;
+	if (pTask->pPrefetch)
+		pTask->pPrefetch->stop();
+	if (poolthreads <= 0)
+		threaded = false;
+
+	delete pTask;
+}
+
+void RunThreadsOn( int workcnt, MDTRA_ThreadFunc func )
+{
+	ThreadSetPriority();
+
+	if (CountThreads() <= 1) {
+		//single-threaded
+		func(0, 0);
+		ThreadResetPriority();
+		return;
 	}
 
-	thread_entry = NULL;
-    threaded = false;
+	QApplication::flush();
+	QApplication::processEvents();
+
+	WaitThreadTask( SubmitPerThreadTask( func ) );
 	ThreadResetPriority();
 }
 
@@ -530,6 +932,11 @@ int CountThreads( void )
 	return 1;
 }
 
+int CountThreadSlots( void )
+{
+	return 1;
+}
+
 void ThreadLock( void )
 {
 }
@@ -538,18 +945,114 @@ void ThreadUnlock( void )
 {
 }
 
+void ThreadPoolShutdown( void )
+{
+}
+
+MDTRA_ThreadTask *SubmitThreadTask( int workcnt, MDTRA_ThreadFunc func, MDTRA_FramePrefetcher *pPrefetch )
+{
+	MDTRA_ThreadTask *pTask = ThreadTaskAlloc( workcnt, func, pPrefetch, false );
+	if (pPrefetch) {
+		pPrefetch->start( workcnt );
+		pTask->blockLimit = pPrefetch->getBlockLimit();
+	}
+	ThreadTaskRunHere( pTask );
+	return pTask;
+}
+
+bool ThreadTaskDone( MDTRA_ThreadTask *pTask )
+{
+	return pTask->done;
+}
+
+void CancelThreadTask( MDTRA_ThreadTask *pTask )
+{
+	DispatchInterrupt( &pTask->dispatch );
+	if (pTask->pPrefetch)
+		pTask->pPrefetch->abort();
+}
+
+void InterruptThreads( void )
+{
+	if (currenttask) {
+		DispatchInterrupt( &currenttask->dispatch );
+		if (currenttask->pPrefetch)
+			currenttask->pPrefetch->abort();
+	}
+}
+
+void WaitThreadTask( MDTRA_ThreadTask *pTask )
+{
+	if (pTask->pPrefetch)
+		pTask->pPrefetch->stop();
+	delete pTask;
+}
+
 void RunThreadsOn( int workcnt, MDTRA_ThreadFunc func )
 {
-	dispatch = 0;
-    workcount = workcnt;
-	thread_interrupt = false;
 	func(0, 0);
 }
 
+void RunThreadsOnRange( int threadnum, int count, int grain, MDTRA_RangeFunc func, void *pContext )
+{
+	if (count <= 0)
+		return;
+	if (grain < 1)
+		grain = 1;
+
+	MDTRA_ThreadTask *pTask = ThreadRangeTaskAlloc( count, grain, func, pContext );
+	ThreadTaskItems( pTask, threadnum, false );
+	delete pTask;
+}
+
 #endif
 
+static void **firsttouchbuffers = NULL;
+static size_t firsttouchsize = 0;
+static bool *firsttouchdone = NULL;
+
+static void ThreadFirstTouchFunc( int threadnum, int num )
+{
+	memset( firsttouchbuffers[threadnum], 0, firsttouchsize );
+	firsttouchdone[threadnum] = true;
+}
+
+void ThreadFirstTouch( void **ppBuffers, size_t size )
+{
+	int count = CountThreads();
+	firsttouchbuffers = ppBuffers;
+	firsttouchsize = size;
+	firsttouchdone = new bool[count];
+	memset( firsttouchdone, 0, sizeof(bool) * count );
+
+	if (count > 1)
+		RunThreadsOn( 0, ThreadFirstTouchFunc );
+
+	//buffers of workers that did not start are zeroed here
+	for (int i = 0; i < count; i++) {
+		if (!firsttouchdone[i])
+			memset( ppBuffers[i], 0, size );
+	}
+
+	delete [] firsttouchdone;
+	firsttouchdone = NULL;
+	firsttouchbuffers = NULL;
+}
+
 void RunThreadsOnIndividual( int workcnt, MDTRA_ThreadFunc func )
 {
-    workfunction = func;
-    RunThreadsOn(workcnt, ThreadWorkerFunction);
-}
\ No newline at end of file
+	RunThreadsOnPrefetched( workcnt, func, NULL );
+}
+
+void RunThreadsOnPrefetched( int workcnt, MDTRA_ThreadFunc func, MDTRA_FramePrefetcher *pPrefetch )
+{
+	ThreadSetPriority();
+
+	if (CountThreads() > 1) {
+		QApplication::flush();
+		QApplication::processEvents();
+	}
+
+	WaitThreadTask( SubmitThreadTask( workcnt, func, pPrefetch ) );
+	ThreadResetPriority();
+}
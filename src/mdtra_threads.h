@@ -21,6 +21,8 @@
 #ifndef MDTRA_THREADS_H
 #define MDTRA_THREADS_H
 
+#include <stddef.h>
+
 #if defined(WIN32)
 #define USE_WIN32_THREADS
 #elif defined(LINUX)
@@ -29,17 +31,50 @@
 //single-threaded otherwise
 #endif
 
-#define MDTRA_MAX_THREADS	16
+//thread slots bound every threadnum, long-lived per-thread resources are sized by
+//CountThreadSlots() which never changes: all processors, but at least this many
+#define MDTRA_MIN_THREAD_SLOTS	16
+
+#if defined(_MSC_VER)
+#define MDTRA_THREAD_LOCAL	__declspec(thread)
+#else
+#define MDTRA_THREAD_LOCAL	__thread
+#endif
 
 typedef void (*MDTRA_ThreadFunc)(int, int);
+typedef void (*MDTRA_RangeFunc)( int threadnum, int first, int last, void *pContext );
+typedef struct stMDTRA_ThreadTask MDTRA_ThreadTask;
+
+class MDTRA_FramePrefetcher;
 
 extern void ThreadSetDefault( int count, int priority );
+extern void ThreadSetAffinity( bool pin );
 extern void ThreadLock( void );
 extern void ThreadUnlock( void );
 
 extern void RunThreadsOn(int workcnt, MDTRA_ThreadFunc func);
 extern void RunThreadsOnIndividual( int workcnt, MDTRA_ThreadFunc func );
+extern void RunThreadsOnPrefetched( int workcnt, MDTRA_ThreadFunc func, MDTRA_FramePrefetcher *pPrefetch );
 extern void InterruptThreads( void );
 extern int  CountThreads( void );
+extern int  CountThreadSlots( void );
+extern double ThreadMicroseconds( void );
+
+//persistent worker pool: func(threadnum, item) is called once for every item,
+//WaitThreadTask is the completion barrier and must be called for every task
+extern MDTRA_ThreadTask *SubmitThreadTask( int workcnt, MDTRA_ThreadFunc func, MDTRA_FramePrefetcher *pPrefetch );
+extern bool ThreadTaskDone( MDTRA_ThreadTask *pTask );
+extern void CancelThreadTask( MDTRA_ThreadTask *pTask );
+extern void WaitThreadTask( MDTRA_ThreadTask *pTask );
+extern void ThreadPoolShutdown( void );
+
+//splits [0, count) into blocks of grain items that idle workers may steal;
+//called on a worker, the caller runs blocks too and returns when all are done,
+//so a frame-level item can parallelize its own inner loop
+extern void RunThreadsOnRange( int threadnum, int count, int grain, MDTRA_RangeFunc func, void *pContext );
+
+//zeroes ppBuffers[threadnum] (size bytes each) on the worker that owns it, so with
+//first-touch placement the pages of per-thread buffers land on the worker's NUMA node
+extern void ThreadFirstTouch( void **ppBuffers, size_t size );
 
 #endif //MDTRA_THREADS_H
@@ -26,6 +26,8 @@
 #include "mdtra_mainWindow.h"
 #include "mdtra_project.h"
 #include "mdtra_pdb.h"
+#include "mdtra_stream.h"
+#include "mdtra_sweep.h"
 #include "mdtra_pdb_flags.h"
 #include "mdtra_progressDialog.h"
 #include "mdtra_waitDialog.h"
@@ -39,7 +41,7 @@ static const MDTRA_TorsionSearchData *pLocalTorsionSearchData = NULL;
 static int iLocalTorsionSearchDataIndex = 0;
 extern MDTRA_ProgressDialog *pProgressDialog;
 static MDTRA_WaitDialog *pWaitDialog = NULL;
-static bool s_threadStarted[MDTRA_MAX_THREADS];
+static bool *s_threadStarted = NULL;
 
 MDTRA_TorsionSearchData s_ltsd[2];
 static MDTRA_MainWindow *s_pMainWindow;
@@ -301,39 +303,39 @@ static bool TSGetAllTorsionAngles( void )
 	return ( s_TorsionsList.count() > 0 );
 }
 
-static void fn_TorsionSearch( int threadnum, int num )
+static void fn_TorsionSearch( int threadnum, int num, MDTRA_PDB_File *pPdbFile, void *pContext )
 {
-	//Load PDB file
-	MDTRA_PDB_File *pPdbFile;
-	if ( (pLocalTorsionSearchData->workStart + num) == 0) {
-		pPdbFile = pLocalTorsionSearchData->pStream->pdb;
-	} else {
-		pPdbFile = pLocalTorsionSearchData->tempPDB[threadnum];
-		pPdbFile->load( threadnum, pLocalTorsionSearchData->pStream->format_identifier, pLocalTorsionSearchData->pStream->files.at(pLocalTorsionSearchData->workStart + num).toAscii(), pLocalTorsionSearchData->pStream->flags );
-	}
+	//pContext = search data of one of the streams
+	//torsion angles only depend on internal geometry, so the snapshot
+	//may come in any orientation
+	const MDTRA_TorsionSearchData *pSearchData = (const MDTRA_TorsionSearchData*)pContext;
+	int iSearchDataIndex = (int)(pSearchData - s_ltsd);
+	if (!pPdbFile)
+		return;
 
 	bool firstStep = false;
-	if (!s_threadStarted[threadnum]) {
-		s_threadStarted[threadnum] = true;
+	bool *pThreadStarted = s_threadStarted + iSearchDataIndex * CountThreads() + threadnum;
+	if (!*pThreadStarted) {
+		*pThreadStarted = true;
 		firstStep = true;
 	}
 
 	//Calculate all torsion angles
 	for ( int i = 0; i < s_TorsionsList.count(); i++ ) {
 		const MDTRA_TorsionSearchDef *pTSD = &s_TorsionsList.at( i );
-		float *pflCell = pLocalTorsionSearchData->pResults[threadnum] + i * s_bufferDim;
+		float *pflCell = pSearchData->pResults[threadnum] + i * s_bufferDim;
 
-		float flAngle = pPdbFile->get_torsion( pTSD->atom1[iLocalTorsionSearchDataIndex],
-											 pTSD->atom2[iLocalTorsionSearchDataIndex],
-											 pTSD->atom3[iLocalTorsionSearchDataIndex],
-											 pTSD->atom4[iLocalTorsionSearchDataIndex], 
+		float flAngle = pPdbFile->get_torsion( pTSD->atom1[iSearchDataIndex],
+											 pTSD->atom2[iSearchDataIndex],
+											 pTSD->atom3[iSearchDataIndex],
+											 pTSD->atom4[iSearchDataIndex], 
 											 false );
 
-		if ( pTSD->atom4alt[iLocalTorsionSearchDataIndex] > 0 ) {
-			float flAngle2 = pPdbFile->get_torsion( pTSD->atom1[iLocalTorsionSearchDataIndex],
-												  pTSD->atom2[iLocalTorsionSearchDataIndex],
-												  pTSD->atom3[iLocalTorsionSearchDataIndex],
-												  pTSD->atom4alt[iLocalTorsionSearchDataIndex], 
+		if ( pTSD->atom4alt[iSearchDataIndex] > 0 ) {
+			float flAngle2 = pPdbFile->get_torsion( pTSD->atom1[iSearchDataIndex],
+												  pTSD->atom2[iSearchDataIndex],
+												  pTSD->atom3[iSearchDataIndex],
+												  pTSD->atom4alt[iSearchDataIndex], 
 												  false );
 			if ( flAngle2 < flAngle )
 				flAngle = flAngle2;
@@ -342,7 +344,7 @@ static void fn_TorsionSearch( int threadnum, int num )
 		flAngle = UTIL_rad2deg( flAngle );
 		if ( flAngle > 180 ) flAngle = 360 - flAngle;
 
-		switch (pLocalTorsionSearchData->statParm) {
+		switch (pSearchData->statParm) {
 		case MDTRA_SP_ARITHMETIC_MEAN:
 			*pflCell += flAngle;
 			break;
@@ -381,13 +383,6 @@ static void fn_TorsionSearch( int threadnum, int num )
 			break;
 		}
 	}
-
-	if (pProgressDialog) {
-		pProgressDialog->advanceCurrentFile( num+1 );
-		if (pProgressDialog->checkInterrupt()) {
-			InterruptThreads();
-		}
-	}
 }
 
 static void fn_TorsionSearchJoin( int threadnum )
@@ -587,18 +582,19 @@ bool SetupTorsionSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_TorsionSearc
 
 	int numAngles = s_TorsionsList.count();
 
+	s_threadStarted = new bool[2 * CountThreads()];
+	memset( s_threadStarted, 0, sizeof(bool) * 2 * CountThreads() );
+
 	for (int i = 0; i < 2; i++) {
+		s_ltsd[i].pResults = new float*[CountThreads()];
+		memset( s_ltsd[i].pResults, 0, sizeof(float*) * CountThreads() );
+
 		for (int j = 0; j < CountThreads(); j++) {
 			s_ltsd[i].pResults[j] = new float[numAngles*s_bufferDim];
 			if (!s_ltsd[i].pResults[j])
 				return false;
-
-			memset( s_ltsd[i].pResults[j], 0, sizeof(float)*numAngles*s_bufferDim );
-
-			s_ltsd[i].tempPDB[j] = new MDTRA_PDB_File;
-			if (!s_ltsd[i].tempPDB[j])
-				return false;
 		}
+		ThreadFirstTouch( (void**)s_ltsd[i].pResults, sizeof(float)*numAngles*s_bufferDim );
 	}
 
 	pWaitDialog = NULL;
@@ -608,43 +604,29 @@ bool SetupTorsionSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_TorsionSearc
 	return true;
 }
 
-bool PerformTorsionSearch( void )
+void QueueTorsionSearch( MDTRA_FrameSweep *pSweep )
 {
-	MDTRA_ProgressDialog dlgProgress( s_pMainWindow );
-	dlgProgress.setStreamCount( 2 );
-	dlgProgress.show();
+	for (int i = 0; i < 2; i++)
+		pSweep->addConsumer( s_ltsd[i].pStream, s_ltsd[i].workStart, 1, s_ltsd[i].workCount, fn_TorsionSearch, &s_ltsd[i] );
+}
 
-	pProgressDialog = &dlgProgress;
+bool FinishTorsionSearch( void )
+{
+	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+	QApplication::processEvents();
 
 	for (int i = 0; i < 2; i++) {
 		pLocalTorsionSearchData = &s_ltsd[i];
 		iLocalTorsionSearchDataIndex = i;
-
-		dlgProgress.setFileCount( pLocalTorsionSearchData->workCount );
-		dlgProgress.setCurrentStream( i );
-		dlgProgress.setCurrentFile( 0 );
-
-		memset( s_threadStarted, 0, sizeof(bool) * CountThreads() );
-
-		RunThreadsOnIndividual( pLocalTorsionSearchData->workCount, fn_TorsionSearch );
 		for (int j = 1; j < CountThreads(); j++) fn_TorsionSearchJoin( j );
 		fn_TorsionSearchFinalize();
-
-		if (dlgProgress.checkInterrupt())
-			return false;
 	}
-
-	dlgProgress.setProgressAtMax();
-
-	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-	QApplication::processEvents();
+	pLocalTorsionSearchData = NULL;
 
 	//now check against criterion and add to result list
 	TorsionSearchCheckAgainstCriterion( s_flReference );
 
 	QApplication::restoreOverrideCursor();
-	dlgProgress.hide();
-	QApplication::processEvents();
 
 	if (!s_TorsionListValidCount) {
 		QMessageBox::warning(s_pMainWindow, "Torsion Search Results", "No significantly different torsion angles were found!\nPlease specify another atom set or different significance criterion.");
@@ -654,21 +636,48 @@ bool PerformTorsionSearch( void )
 	return true;
 }
 
+bool PerformTorsionSearch( void )
+{
+	MDTRA_ProgressDialog dlgProgress( s_pMainWindow );
+	dlgProgress.setStreamCount( 2 );
+	dlgProgress.show();
+
+	pProgressDialog = &dlgProgress;
+
+	//both streams run in one sweep
+	MDTRA_FrameSweep sweep;
+	QueueTorsionSearch( &sweep );
+
+	dlgProgress.setFileCount( sweep.getWorkCount() );
+	dlgProgress.setCurrentStream( 0 );
+	dlgProgress.setCurrentFile( 0 );
+
+	if (!sweep.run( true ))
+		return false;
+
+	dlgProgress.setProgressAtMax();
+	dlgProgress.hide();
+	QApplication::processEvents();
+
+	return FinishTorsionSearch();
+}
+
 void FreeTorsionSearch( void )
 {
 	for (int i = 0; i < 2; i++) {
-		for (int j = 0; j < CountThreads(); j++) {
-			if (s_ltsd[i].pResults[j]) {
+		if (s_ltsd[i].pResults) {
+			for (int j = 0; j < CountThreads(); j++)
 				delete [] s_ltsd[i].pResults[j];
-				s_ltsd[i].pResults[j] = NULL;
-			}
-			if (s_ltsd[i].tempPDB[j]) {
-				delete s_ltsd[i].tempPDB[j];
-				s_ltsd[i].tempPDB[j] = NULL;
-			}
+			delete [] s_ltsd[i].pResults;
+			s_ltsd[i].pResults = NULL;
 		}
 	}
 
+	if (s_threadStarted) {
+		delete [] s_threadStarted;
+		s_threadStarted = NULL;
+	}
+
 	s_pMainWindow = NULL;
 	s_TorsionsList.clear();
 }
\ No newline at end of file
@@ -59,9 +59,8 @@ typedef struct stMDTRA_TorsionSearchData
 	const MDTRA_Stream*		pStream;
 	int						selectionSize;
 	const int*				selectionData;
-	MDTRA_PDB_File*			tempPDB[MDTRA_MAX_THREADS];
 	MDTRA_StatParm			statParm;
-	float*					pResults[MDTRA_MAX_THREADS];
+	float**					pResults;
 } MDTRA_TorsionSearchData;
 
 #define TSDF_VALID			(1<<0)
@@ -81,9 +80,12 @@ typedef struct stMDTRA_TorsionSearchDef
 } MDTRA_TorsionSearchDef;
 
 class MDTRA_MainWindow;
+class MDTRA_FrameSweep;
 
 extern bool SetupTorsionSearch( MDTRA_MainWindow *pMainWindow, const MDTRA_TorsionSearchInfo *pSearchInfo );
 extern bool PerformTorsionSearch( void );
+extern void QueueTorsionSearch( MDTRA_FrameSweep *pSweep );
+extern bool FinishTorsionSearch( void );
 extern void FreeTorsionSearch( void );
 
 #endif //MDTRA_TORSIONSEARCH_H
\ No newline at end of file
@@ -0,0 +1,188 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of MDTRA_TrajectoryReader
+
+#include "mdtra_main.h"
+#include "mdtra_pdb.h"
+#include "mdtra_utils.h"
+#include "mdtra_trajectory.h"
+#include "mdtra_dcd.h"
+#include "mdtra_xtc.h"
+
+MDTRA_TrajectoryReader :: MDTRA_TrajectoryReader()
+{
+	m_pszFileName = NULL;
+	m_iNumFrames = 0;
+	m_iNumAtoms = 0;
+	m_iNumMappedAtoms = 0;
+	m_pAtomMap = NULL;
+	m_bIdentityMap = true;
+	m_pFile = new FILE*[CountThreadSlots()];
+	memset( m_pFile, 0, sizeof(FILE*) * CountThreadSlots() );
+	m_pFrameBuffer = new float*[CountThreadSlots()];
+	memset( m_pFrameBuffer, 0, sizeof(float*) * CountThreadSlots() );
+	m_pCoordBuffer = new float*[CountThreadSlots()];
+	memset( m_pCoordBuffer, 0, sizeof(float*) * CountThreadSlots() );
+}
+
+MDTRA_TrajectoryReader :: ~MDTRA_TrajectoryReader()
+{
+	closeFiles();
+	for (int i = 0; i < CountThreadSlots(); i++) {
+		if (m_pFrameBuffer[i]) UTIL_AlignedFree( m_pFrameBuffer[i] );
+		if (m_pCoordBuffer[i]) UTIL_AlignedFree( m_pCoordBuffer[i] );
+	}
+	delete [] m_pFile;
+	delete [] m_pFrameBuffer;
+	delete [] m_pCoordBuffer;
+	if (m_pAtomMap)
+		UTIL_AlignedFree( m_pAtomMap );
+	if (m_pszFileName)
+		free( m_pszFileName );
+}
+
+void MDTRA_TrajectoryReader :: setFileName( const char *filename )
+{
+	if (m_pszFileName)
+		free( m_pszFileName );
+	m_pszFileName = UTIL_Strdup( filename );
+}
+
+FILE *MDTRA_TrajectoryReader :: getFile( int threadnum )
+{
+	//every thread reads the trajectory through its own handle
+	if (!m_pFile[threadnum] && m_pszFileName) {
+		if (fopen_s( &m_pFile[threadnum], m_pszFileName, "rb" ))
+			m_pFile[threadnum] = NULL;
+	}
+	return m_pFile[threadnum];
+}
+
+void MDTRA_TrajectoryReader :: closeFiles( void )
+{
+	for (int i = 0; i < CountThreadSlots(); i++) {
+		if (m_pFile[i]) {
+			fclose( m_pFile[i] );
+			m_pFile[i] = NULL;
+		}
+	}
+}
+
+bool MDTRA_TrajectoryReader :: attachTopology( const MDTRA_PDB_File *pFullTopology, const MDTRA_PDB_File *pTopology )
+{
+	//pFullTopology contains all atoms of the trajectory,
+	//pTopology may have HETATM records and solvent filtered out
+	if (pFullTopology->getAtomCount() != m_iNumAtoms)
+		return false;
+
+	m_iNumMappedAtoms = pTopology->getAtomCount();
+	if (m_pAtomMap)
+		UTIL_AlignedFree( m_pAtomMap );
+	m_pAtomMap = (int*)UTIL_AlignedMalloc( MDTRA_MAX( m_iNumMappedAtoms, 1 ) * sizeof(int) );
+	if (!m_pAtomMap)
+		return false;
+
+	m_bIdentityMap = (m_iNumMappedAtoms == m_iNumAtoms);
+
+	int j = 0;
+	for (int i = 0; i < m_iNumMappedAtoms; i++, j++) {
+		int serialnumber = pTopology->fetchAtomByIndex( i )->serialnumber;
+		while (j < m_iNumAtoms && pFullTopology->fetchAtomByIndex( j )->serialnumber != serialnumber)
+			j++;
+		if (j >= m_iNumAtoms)
+			return false;
+		m_pAtomMap[i] = j;
+		if (i != j)
+			m_bIdentityMap = false;
+	}
+
+	return true;
+}
+
+bool MDTRA_TrajectoryReader :: readCoords( int threadnum, int frame, float *pOutCoords )
+{
+	//this function MUST be thread-safe
+	if (frame < 0 || frame >= m_iNumFrames || !m_pAtomMap)
+		return false;
+
+	if (m_bIdentityMap)
+		return readFrame( threadnum, frame, pOutCoords );
+
+	if (!m_pFrameBuffer[threadnum]) {
+		m_pFrameBuffer[threadnum] = (float*)UTIL_AlignedMalloc( m_iNumAtoms * 3 * sizeof(float) );
+		if (!m_pFrameBuffer[threadnum])
+			return false;
+	}
+
+	const float *pFrame = m_pFrameBuffer[threadnum];
+	if (!readFrame( threadnum, frame, m_pFrameBuffer[threadnum] ))
+		return false;
+
+	for (int i = 0; i < m_iNumMappedAtoms; i++, pOutCoords += 3) {
+		const float *pSrc = pFrame + m_pAtomMap[i] * 3;
+		pOutCoords[0] = pSrc[0];
+		pOutCoords[1] = pSrc[1];
+		pOutCoords[2] = pSrc[2];
+	}
+
+	return true;
+}
+
+bool MDTRA_TrajectoryReader :: loadFrame( int threadnum, int frame, const MDTRA_PDB_File *pTopology, MDTRA_PDB_File *pOut )
+{
+	//this function MUST be thread-safe
+	if (!m_pCoordBuffer[threadnum]) {
+		m_pCoordBuffer[threadnum] = (float*)UTIL_AlignedMalloc( MDTRA_MAX( m_iNumMappedAtoms, 1 ) * 3 * sizeof(float) );
+		if (!m_pCoordBuffer[threadnum])
+			return false;
+	}
+
+	if (!readCoords( threadnum, frame, m_pCoordBuffer[threadnum] ))
+		return false;
+
+	return pOut->load_coords( pTopology, m_pCoordBuffer[threadnum], NULL );
+}
+
+static const char *TrajectoryFileExtension( const char *filename )
+{
+	const char *ext = strrchr( filename, '.' );
+	return ext ? ext : "";
+}
+
+bool MDTRA_IsTrajectoryFile( const char *filename )
+{
+	const char *ext = TrajectoryFileExtension( filename );
+	if (!_stricmp( ext, ".dcd" ) || !_stricmp( ext, ".xtc" ))
+		return true;
+	return false;
+}
+
+MDTRA_TrajectoryReader *MDTRA_CreateTrajectoryReader( const char *filename )
+{
+	const char *ext = TrajectoryFileExtension( filename );
+	if (!_stricmp( ext, ".dcd" ))
+		return new MDTRA_DCD_Reader;
+	if (!_stricmp( ext, ".xtc" ))
+		return new MDTRA_XTC_Reader;
+	return NULL;
+}
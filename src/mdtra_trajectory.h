@@ -0,0 +1,68 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_TRAJECTORY_H
+#define MDTRA_TRAJECTORY_H
+
+class MDTRA_PDB_File;
+
+//Base class for multi-frame trajectory readers
+//Topology of such streams is taken from a PDB file,
+//trajectory file provides coordinates only
+class MDTRA_TrajectoryReader
+{
+public:
+	MDTRA_TrajectoryReader();
+	virtual ~MDTRA_TrajectoryReader();
+
+	virtual bool open( const char *filename ) = 0;
+
+	int getFrameCount( void ) const { return m_iNumFrames; }
+	int getAtomCount( void ) const { return m_iNumAtoms; }
+
+	bool attachTopology( const MDTRA_PDB_File *pFullTopology, const MDTRA_PDB_File *pTopology );
+	bool readCoords( int threadnum, int frame, float *pOutCoords );
+	bool loadFrame( int threadnum, int frame, const MDTRA_PDB_File *pTopology, MDTRA_PDB_File *pOut );
+	void closeFiles( void );
+
+protected:
+	//read interleaved xyz of all trajectory atoms, this MUST be thread-safe
+	virtual bool readFrame( int threadnum, int frame, float *pOutXYZ ) = 0;
+	FILE *getFile( int threadnum );
+	void setFileName( const char *filename );
+
+protected:
+	char*	m_pszFileName;
+	int		m_iNumFrames;
+	int		m_iNumAtoms;
+
+private:
+	int		m_iNumMappedAtoms;
+	int*	m_pAtomMap;
+	bool	m_bIdentityMap;
+	FILE**	m_pFile;
+	float**	m_pFrameBuffer;
+	float**	m_pCoordBuffer;
+};
+
+extern bool MDTRA_IsTrajectoryFile( const char *filename );
+extern MDTRA_TrajectoryReader *MDTRA_CreateTrajectoryReader( const char *filename );
+
+#endif //MDTRA_TRAJECTORY_H
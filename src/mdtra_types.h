@@ -158,6 +158,9 @@ typedef struct stMDTRA_DSRef
 	int					iActualDataSize;
 	float*				pData;
 	float*				pCorrelation;
+	int					windowStart;	//stream snapshot of the first value (0-based), time layout only
+	int					windowStride;	//stream snapshots between values
+	float				buildTime;		//milliseconds spent on this source in the last build, not saved
 	char				reserved[32];
 } MDTRA_DSRef;
 
@@ -166,5 +169,6 @@ typedef struct stMDTRA_DSRef
 #define STREAM_FLAG_RELATIVE_PATHS		( 1 << 0 )
 #define STREAM_FLAG_IGNORE_HETATM		( 1 << 1 )
 #define STREAM_FLAG_IGNORE_SOLVENT		( 1 << 2 )
+#define STREAM_FLAG_USE_CACHE			( 1 << 3 )
 
 #endif //MDTRA_TYPES_H
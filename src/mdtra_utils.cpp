@@ -895,23 +895,6 @@ int UTIL_ExtractFilePath( char *dest, size_t size, const char *src )
 	return maxsize;
 }
 
-void Prof_Log( const char *func, qword cycles )
-{
-	FILE* fp = NULL;
-	if ( fopen_s( &fp, "profiler.log", "a" ) )
-		return;
-	
-	dword hi = cycles >> 32;
-	dword lo = cycles & ~dword(0);
-
-	if ( hi )
-		fprintf( fp, "%s: %u%u\n", func, hi, lo );
-	else
-		fprintf( fp, "%s: %u\n", func, lo );
-
-	fclose( fp );
-}
-
 typedef struct stMDTRA_AtomColorInfo {
 	const char* symbol;
 	float color[4];
@@ -1093,4 +1076,21 @@ void UTIL_FreeFileList( char **list )
 	for ( int i = 0; list[i]; ++i )
 		free( list[i] );
 	free( list );
-}
\ No newline at end of file
+}
+int UTIL_FileSeek( FILE *fp, qword offset, int origin )
+{
+#if defined(WIN32)
+	return _fseeki64( fp, (__int64)offset, origin );
+#else
+	return fseeko( fp, (off_t)offset, origin );
+#endif
+}
+
+qword UTIL_FileTell( FILE *fp )
+{
+#if defined(WIN32)
+	return (qword)_ftelli64( fp );
+#else
+	return (qword)ftello( fp );
+#endif
+}
@@ -57,6 +57,97 @@ extern unsigned char UTIL_FloatToColor( int channel, float v );
 extern int UTIL_Atoi( const char *str );
 extern float UTIL_Atof( const char *str );
 
+// Fast decoders for fixed-width numeric columns
+// The field is not required to be null-terminated, result is the same as UTIL_Atoi/UTIL_Atof
+// of the field contents; hexadecimal and character notations are passed to them
+#define UTIL_FIXED_MAX_DIGITS	18
+
+inline int UTIL_ParseFixedInt( const char *str, int length )
+{
+	const char *end = str + length;
+	const char *start = str;
+	while ( str < end && *str && (byte)(*str) <= 32 ) str++;
+
+	int sign = 1;
+	if (str < end && *str == '-') {
+		sign = -1;
+		str++;
+	}
+
+	if (str < end && (*str == '\'' || (*str == '0' && str + 1 < end && (str[1] == 'x' || str[1] == 'X')))) {
+		char localbuffer[81];
+		int size = MDTRA_MIN( length, (int)sizeof(localbuffer) - 1 );
+		memcpy( localbuffer, start, size );
+		localbuffer[size] = 0;
+		return UTIL_Atoi( localbuffer );
+	}
+
+	int val = 0;
+	while (str < end) {
+		int c = *str++;
+		if (c < '0' || c > '9')
+			break;
+		val = val*10 + c - '0';
+	}
+	return val*sign;
+}
+
+inline float UTIL_ParseFixedFloat( const char *str, int length )
+{
+	static const double s_Pow10[UTIL_FIXED_MAX_DIGITS+1] = { 
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 
+		1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+
+	const char *end = str + length;
+	const char *start = str;
+	while ( str < end && *str && (byte)(*str) <= 32 ) str++;
+
+	int sign = 1;
+	if (str < end && *str == '-') {
+		sign = -1;
+		str++;
+	}
+
+	bool bSlowPath = (str < end && (*str == '\'' || (*str == '0' && str + 1 < end && (str[1] == 'x' || str[1] == 'X'))));
+
+	qword mantissa = 0;
+	int total = 0;
+	int decimal = -1;
+	while (!bSlowPath && str < end) {
+		int c = *str++;
+		if (c == '.') {
+			decimal = total;
+			continue;
+		}
+		if (c < '0' || c > '9')
+			break;
+		if (total >= UTIL_FIXED_MAX_DIGITS) {
+			bSlowPath = true;
+			break;
+		}
+		mantissa = mantissa*10 + c - '0';
+		total++;
+	}
+
+	if (bSlowPath) {
+		char localbuffer[81];
+		int size = MDTRA_MIN( length, (int)sizeof(localbuffer) - 1 );
+		memcpy( localbuffer, start, size );
+		localbuffer[size] = 0;
+		return UTIL_Atof( localbuffer );
+	}
+
+	double val = (double)mantissa;
+	if (decimal >= 0)
+		val /= s_Pow10[total - decimal];
+	return (float)val*sign;
+}
+
+inline dword UTIL_ByteSwap32( dword x )
+{
+	return (x >> 24) | ((x >> 8) & 0x0000FF00) | ((x << 8) & 0x00FF0000) | (x << 24);
+}
+
 // Simple profiler
 inline qword MDTRA_AppCycles( void )
 {
@@ -78,17 +169,15 @@ inline qword MDTRA_AppCycles( void )
 #endif
 	return result;
 }
-extern void Prof_Log( const char *func, qword cycles );
 
 #define MDTRA_PROF_CLOCK(x)					{ x = MDTRA_AppCycles(); }
 #define MDTRA_PROF_UNCLOCK(x)				{ x = MDTRA_AppCycles() - x; }
 
-#define MDTRA_PROF_START(f)					{ const char *__func_name__ = #f; qword __prof_time__ = MDTRA_AppCycles(); 
-#define MDTRA_PROF_END()					 __prof_time__ = MDTRA_AppCycles() - __prof_time__; Prof_Log( __func_name__, __prof_time__ ); }
-
 extern const float *UTIL_Color4Sym( const char* symbol );
 extern int UTIL_GetMainDirectory( char *out, size_t outSize );
 extern char **UTIL_ListFiles( const char *directory, const char *extension, int *numfiles );
 extern void UTIL_FreeFileList( char **list );
+extern int UTIL_FileSeek( FILE *fp, qword offset, int origin );
+extern qword UTIL_FileTell( FILE *fp );
 
 #endif //MDTRA_UTILS_H
\ No newline at end of file
@@ -0,0 +1,437 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+
+// Purpose:
+//	Implementation of MDTRA_XTC_Reader
+//	Coordinate decompression follows the xdr3dfcoord algorithm of the GROMACS xdrfile library
+
+#include "mdtra_main.h"
+#include "mdtra_utils.h"
+#include "mdtra_xtc.h"
+
+#define XTC_MAGIC				1995
+#define XTC_HEADER_SIZE			56		//magic, natoms, step, time, box[9], natoms
+#define XTC_COMPRESSED_SIZE		36		//precision, minint[3], maxint[3], smallidx, bytecount
+#define XTC_MAX_UNCOMPRESSED	9		//small systems are stored without compression
+#define XTC_NM_TO_ANGSTROM		10.0f
+
+static const int s_XTCMagicInts[] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0,
+	8, 10, 12, 16, 20, 25, 32, 40, 50, 64,
+	80, 101, 128, 161, 203, 256, 322, 406, 512, 645,
+	812, 1024, 1290, 1625, 2048, 2580, 3250, 4096, 5060, 6501,
+	8192, 10321, 13003, 16384, 20642, 26007, 32768, 41285, 52015, 65536,
+	82570, 104031, 131072, 165140, 208063, 262144, 330280, 416127, 524287, 660561,
+	832255, 1048576, 1321122, 1664510, 2097152, 2642245, 3329021, 4194304, 5284491, 6658042,
+	8388607, 10568983, 13316085, 16777216
+};
+
+#define XTC_FIRSTIDX			9
+#define XTC_LASTIDX				(int)(sizeof(s_XTCMagicInts) / sizeof(s_XTCMagicInts[0]))
+
+//XDR stores everything in big-endian byte order
+static inline int XDR_GetInt( const byte *p )
+{
+	return (int)(((dword)p[0] << 24) | ((dword)p[1] << 16) | ((dword)p[2] << 8) | (dword)p[3]);
+}
+
+static inline float XDR_GetFloat( const byte *p )
+{
+	int i = XDR_GetInt( p );
+	float f;
+	memcpy( &f, &i, sizeof(f) );
+	return f;
+}
+
+//-------------------------------------------------------------------
+//Bit stream decoder
+
+typedef struct stXTCBitReader
+{
+	const byte	*data;
+	int			size;
+	int			count;
+	unsigned int lastbits;
+	unsigned int lastbyte;
+	bool		overrun;
+} XTCBitReader;
+
+static int XTC_ReceiveBits( XTCBitReader *br, int nbits )
+{
+	int mask = (nbits < 32) ? ((1 << nbits) - 1) : -1;
+	int num = 0;
+
+	while (nbits >= 8) {
+		if (br->count >= br->size) {
+			br->overrun = true;
+			return 0;
+		}
+		br->lastbyte = (br->lastbyte << 8) | br->data[br->count++];
+		num |= (br->lastbyte >> br->lastbits) << (nbits - 8);
+		nbits -= 8;
+	}
+	if (nbits > 0) {
+		if ((int)br->lastbits < nbits) {
+			if (br->count >= br->size) {
+				br->overrun = true;
+				return 0;
+			}
+			br->lastbits += 8;
+			br->lastbyte = (br->lastbyte << 8) | br->data[br->count++];
+		}
+		br->lastbits -= nbits;
+		num |= (br->lastbyte >> br->lastbits) & ((1 << nbits) - 1);
+	}
+	return num & mask;
+}
+
+static void XTC_ReceiveInts( XTCBitReader *br, int num_of_bits, const unsigned int sizes[3], int nums[3] )
+{
+	int bytes[32];
+	int num_of_bytes = 0;
+
+	bytes[0] = bytes[1] = bytes[2] = bytes[3] = 0;
+	while (num_of_bits > 8) {
+		bytes[num_of_bytes++] = XTC_ReceiveBits( br, 8 );
+		num_of_bits -= 8;
+	}
+	if (num_of_bits > 0)
+		bytes[num_of_bytes++] = XTC_ReceiveBits( br, num_of_bits );
+
+	for (int i = 2; i > 0; i--) {
+		unsigned int num = 0;
+		for (int j = num_of_bytes - 1; j >= 0; j--) {
+			num = (num << 8) | bytes[j];
+			unsigned int p = num / sizes[i];
+			bytes[j] = p;
+			num = num - p * sizes[i];
+		}
+		nums[i] = num;
+	}
+	nums[0] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+}
+
+static int XTC_SizeOfInt( unsigned int size )
+{
+	unsigned int num = 1;
+	int num_of_bits = 0;
+	while (size >= num && num_of_bits < 32) {
+		num_of_bits++;
+		num <<= 1;
+	}
+	return num_of_bits;
+}
+
+static int XTC_SizeOfInts( const unsigned int sizes[3] )
+{
+	unsigned int bytes[32];
+	unsigned int num_of_bytes = 1;
+	unsigned int bytecnt, tmp;
+	int num_of_bits = 0;
+
+	bytes[0] = 1;
+	for (int i = 0; i < 3; i++) {
+		tmp = 0;
+		for (bytecnt = 0; bytecnt < num_of_bytes; bytecnt++) {
+			tmp = bytes[bytecnt] * sizes[i] + tmp;
+			bytes[bytecnt] = tmp & 0xff;
+			tmp >>= 8;
+		}
+		while (tmp != 0) {
+			bytes[bytecnt++] = tmp & 0xff;
+			tmp >>= 8;
+		}
+		num_of_bytes = bytecnt;
+	}
+
+	unsigned int num = 1;
+	num_of_bytes--;
+	while (bytes[num_of_bytes] >= num) {
+		num_of_bits++;
+		num *= 2;
+	}
+	return num_of_bits + num_of_bytes * 8;
+}
+
+//-------------------------------------------------------------------
+
+MDTRA_XTC_Reader :: MDTRA_XTC_Reader()
+{
+	m_pFrameOffsets = NULL;
+	m_iMaxFrameSize = 0;
+	m_pRawBuffer = new byte*[CountThreadSlots()];
+	memset( m_pRawBuffer, 0, sizeof(byte*) * CountThreadSlots() );
+}
+
+MDTRA_XTC_Reader :: ~MDTRA_XTC_Reader()
+{
+	for (int i = 0; i < CountThreadSlots(); i++) {
+		if (m_pRawBuffer[i]) UTIL_AlignedFree( m_pRawBuffer[i] );
+	}
+	delete [] m_pRawBuffer;
+	if (m_pFrameOffsets)
+		free( m_pFrameOffsets );
+}
+
+bool MDTRA_XTC_Reader :: buildFrameIndex( FILE *fp, qword fileSize )
+{
+	//single pass over frame headers, compressed data is skipped
+	int numAllocated = 0;
+	qword offset = 0;
+	byte header[XTC_HEADER_SIZE + XTC_COMPRESSED_SIZE];
+
+	m_iNumFrames = 0;
+	m_iMaxFrameSize = 0;
+
+	while (offset + XTC_HEADER_SIZE <= fileSize) {
+		if (UTIL_FileSeek( fp, offset, SEEK_SET ) ||
+			fread( header, XTC_HEADER_SIZE, 1, fp ) != 1)
+			break;
+		if (XDR_GetInt( header ) != XTC_MAGIC)
+			break;
+
+		int natoms = XDR_GetInt( header + 4 );
+		if (natoms <= 0 || natoms != XDR_GetInt( header + 52 ))
+			break;
+		if (!m_iNumFrames)
+			m_iNumAtoms = natoms;
+		else if (natoms != m_iNumAtoms)
+			break;
+
+		qword frameSize;
+		if (natoms <= XTC_MAX_UNCOMPRESSED) {
+			frameSize = XTC_HEADER_SIZE + natoms * 3 * sizeof(float);
+		} else {
+			if (fread( header + XTC_HEADER_SIZE, XTC_COMPRESSED_SIZE, 1, fp ) != 1)
+				break;
+			int bytecnt = XDR_GetInt( header + XTC_HEADER_SIZE + 32 );
+			if (bytecnt < 0)
+				break;
+			frameSize = XTC_HEADER_SIZE + XTC_COMPRESSED_SIZE + ((bytecnt + 3) & ~3);
+		}
+
+		//truncated last frame is dropped
+		if (offset + frameSize > fileSize)
+			break;
+
+		if (m_iNumFrames + 1 >= numAllocated) {
+			numAllocated = MDTRA_MAX( numAllocated * 2, 1024 );
+			qword *pNewOffsets = (qword*)realloc( m_pFrameOffsets, numAllocated * sizeof(qword) );
+			if (!pNewOffsets)
+				return false;
+			m_pFrameOffsets = pNewOffsets;
+		}
+
+		m_pFrameOffsets[m_iNumFrames++] = offset;
+		m_iMaxFrameSize = MDTRA_MAX( m_iMaxFrameSize, (int)frameSize );
+		offset += frameSize;
+	}
+
+	if (!m_iNumFrames)
+		return false;
+
+	//end offset of the last frame
+	m_pFrameOffsets[m_iNumFrames] = offset;
+	return true;
+}
+
+bool MDTRA_XTC_Reader :: open( const char *filename )
+{
+	FILE *fp = NULL;
+	if (fopen_s( &fp, filename, "rb" ))
+		return false;
+
+	if (UTIL_FileSeek( fp, 0, SEEK_END )) {
+		fclose( fp );
+		return false;
+	}
+	qword fileSize = UTIL_FileTell( fp );
+
+	bool bResult = buildFrameIndex( fp, fileSize );
+	fclose( fp );
+
+	if (!bResult)
+		return false;
+
+	setFileName( filename );
+	return true;
+}
+
+bool MDTRA_XTC_Reader :: readFrame( int threadnum, int frame, float *pOutXYZ )
+{
+	//this function MUST be thread-safe
+	FILE *fp = getFile( threadnum );
+	if (!fp)
+		return false;
+
+	if (!m_pRawBuffer[threadnum]) {
+		m_pRawBuffer[threadnum] = (byte*)UTIL_AlignedMalloc( m_iMaxFrameSize );
+		if (!m_pRawBuffer[threadnum])
+			return false;
+	}
+
+	int frameSize = (int)(m_pFrameOffsets[frame+1] - m_pFrameOffsets[frame]);
+	if (UTIL_FileSeek( fp, m_pFrameOffsets[frame], SEEK_SET ) ||
+		fread( m_pRawBuffer[threadnum], frameSize, 1, fp ) != 1)
+		return false;
+
+	return decodeFrame( m_pRawBuffer[threadnum], frameSize, pOutXYZ );
+}
+
+bool MDTRA_XTC_Reader :: decodeFrame( const byte *pData, int dataSize, float *pOutXYZ )
+{
+	const int natoms = m_iNumAtoms;
+	const byte *p = pData + XTC_HEADER_SIZE;
+
+	if (natoms <= XTC_MAX_UNCOMPRESSED) {
+		for (int i = 0; i < natoms * 3; i++, p += 4)
+			pOutXYZ[i] = XDR_GetFloat( p ) * XTC_NM_TO_ANGSTROM;
+		return true;
+	}
+
+	float precision = XDR_GetFloat( p );
+	int minint[3], maxint[3];
+	for (int i = 0; i < 3; i++) {
+		minint[i] = XDR_GetInt( p + 4 + i * 4 );
+		maxint[i] = XDR_GetInt( p + 16 + i * 4 );
+	}
+	int smallidx = XDR_GetInt( p + 28 );
+	int bytecnt = XDR_GetInt( p + 32 );
+	p += XTC_COMPRESSED_SIZE;
+
+	if (precision <= 0.0f || smallidx < XTC_FIRSTIDX || smallidx >= XTC_LASTIDX ||
+		bytecnt > dataSize - XTC_HEADER_SIZE - XTC_COMPRESSED_SIZE)
+		return false;
+
+	unsigned int sizeint[3];
+	int bitsizeint[3];
+	int bitsize;
+	for (int i = 0; i < 3; i++)
+		sizeint[i] = maxint[i] - minint[i] + 1;
+
+	if ((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff) {
+		//large sizes are stored separately
+		bitsizeint[0] = XTC_SizeOfInt( sizeint[0] );
+		bitsizeint[1] = XTC_SizeOfInt( sizeint[1] );
+		bitsizeint[2] = XTC_SizeOfInt( sizeint[2] );
+		bitsize = 0;
+	} else {
+		bitsizeint[0] = bitsizeint[1] = bitsizeint[2] = 0;
+		bitsize = XTC_SizeOfInts( sizeint );
+	}
+
+	int smaller = s_XTCMagicInts[MDTRA_MAX( XTC_FIRSTIDX, smallidx - 1 )] / 2;
+	int smallnum = s_XTCMagicInts[smallidx] / 2;
+	unsigned int sizesmall[3];
+	sizesmall[0] = sizesmall[1] = sizesmall[2] = s_XTCMagicInts[smallidx];
+
+	XTCBitReader br;
+	br.data = p;
+	br.size = bytecnt;
+	br.count = 0;
+	br.lastbits = 0;
+	br.lastbyte = 0;
+	br.overrun = false;
+
+	const float scale = XTC_NM_TO_ANGSTROM / precision;
+	float *pOut = pOutXYZ;
+	float *pOutEnd = pOutXYZ + natoms * 3;
+	int thiscoord[3], prevcoord[3];
+	int run = 0;
+	int i = 0;
+
+	while (i < natoms) {
+		if (bitsize == 0) {
+			thiscoord[0] = XTC_ReceiveBits( &br, bitsizeint[0] );
+			thiscoord[1] = XTC_ReceiveBits( &br, bitsizeint[1] );
+			thiscoord[2] = XTC_ReceiveBits( &br, bitsizeint[2] );
+		} else {
+			XTC_ReceiveInts( &br, bitsize, sizeint, thiscoord );
+		}
+		i++;
+		thiscoord[0] += minint[0];
+		thiscoord[1] += minint[1];
+		thiscoord[2] += minint[2];
+		prevcoord[0] = thiscoord[0];
+		prevcoord[1] = thiscoord[1];
+		prevcoord[2] = thiscoord[2];
+
+		int is_smaller = 0;
+		if (XTC_ReceiveBits( &br, 1 ) == 1) {
+			run = XTC_ReceiveBits( &br, 5 );
+			is_smaller = run % 3;
+			run -= is_smaller;
+			is_smaller--;
+		}
+
+		if (run > 0) {
+			if (pOut + run + 3 > pOutEnd)
+				return false;
+			for (int k = 0; k < run; k += 3) {
+				XTC_ReceiveInts( &br, smallidx, sizesmall, thiscoord );
+				i++;
+				thiscoord[0] += prevcoord[0] - smallnum;
+				thiscoord[1] += prevcoord[1] - smallnum;
+				thiscoord[2] += prevcoord[2] - smallnum;
+				if (k == 0) {
+					//first and second atoms are interchanged for better compression of water molecules
+					int tmp;
+					tmp = thiscoord[0]; thiscoord[0] = prevcoord[0]; prevcoord[0] = tmp;
+					tmp = thiscoord[1]; thiscoord[1] = prevcoord[1]; prevcoord[1] = tmp;
+					tmp = thiscoord[2]; thiscoord[2] = prevcoord[2]; prevcoord[2] = tmp;
+					*pOut++ = prevcoord[0] * scale;
+					*pOut++ = prevcoord[1] * scale;
+					*pOut++ = prevcoord[2] * scale;
+				} else {
+					prevcoord[0] = thiscoord[0];
+					prevcoord[1] = thiscoord[1];
+					prevcoord[2] = thiscoord[2];
+				}
+				*pOut++ = thiscoord[0] * scale;
+				*pOut++ = thiscoord[1] * scale;
+				*pOut++ = thiscoord[2] * scale;
+			}
+		} else {
+			if (pOut + 3 > pOutEnd)
+				return false;
+			*pOut++ = thiscoord[0] * scale;
+			*pOut++ = thiscoord[1] * scale;
+			*pOut++ = thiscoord[2] * scale;
+		}
+
+		smallidx += is_smaller;
+		if (smallidx < XTC_FIRSTIDX || smallidx >= XTC_LASTIDX)
+			return false;
+		if (is_smaller < 0) {
+			smallnum = smaller;
+			smaller = (smallidx > XTC_FIRSTIDX) ? (s_XTCMagicInts[smallidx - 1] / 2) : 0;
+		} else if (is_smaller > 0) {
+			smaller = smallnum;
+			smallnum = s_XTCMagicInts[smallidx] / 2;
+		}
+		sizesmall[0] = sizesmall[1] = sizesmall[2] = s_XTCMagicInts[smallidx];
+
+		if (br.overrun)
+			return false;
+	}
+
+	return (pOut == pOutEnd);
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+* Copyright (C) 2011-2017 Alexander V. Popov.
+* 
+* This file is part of Molecular Dynamics Trajectory 
+* Reader & Analyzer (MDTRA) source code.
+* 
+* MDTRA source code is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public License as 
+* published by the Free Software Foundation; either version 2 of 
+* the License, or (at your option) any later version.
+* 
+* MDTRA source code is distributed in the hope that it will be 
+* useful, but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+* See the GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software 
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+***************************************************************************/
+#ifndef MDTRA_XTC_H
+#define MDTRA_XTC_H
+
+#include "mdtra_trajectory.h"
+
+//GROMACS compressed XTC trajectory reader
+//Frames have variable size, so byte offset of every frame is indexed once on open,
+//after that different threads may decode different frames concurrently
+class MDTRA_XTC_Reader : public MDTRA_TrajectoryReader
+{
+public:
+	MDTRA_XTC_Reader();
+	virtual ~MDTRA_XTC_Reader();
+
+	virtual bool open( const char *filename );
+
+protected:
+	virtual bool readFrame( int threadnum, int frame, float *pOutXYZ );
+
+private:
+	bool buildFrameIndex( FILE *fp, qword fileSize );
+	bool decodeFrame( const byte *pData, int dataSize, float *pOutXYZ );
+
+private:
+	qword*	m_pFrameOffsets;
+	int		m_iMaxFrameSize;
+	byte**	m_pRawBuffer;
+};
+
+#endif //MDTRA_XTC_H
@@ -23,7 +23,7 @@ static const uint qt_meta_data_MDTRA_MainWindow[] = {
        5,       // revision
        0,       // classname
        0,    0, // classinfo
-      54,   14, // methods
+      55,   14, // methods
        0,    0, // properties
        0,    0, // enums/sets
        0,    0, // constructors
@@ -72,19 +72,20 @@ static const uint qt_meta_data_MDTRA_MainWindow[] = {
      770,   17,   17,   17, 0x08,
      789,   17,   17,   17, 0x08,
      805,   17,   17,   17, 0x08,
-     816,   17,   17,   17, 0x08,
-     830,   17,   17,   17, 0x08,
-     841,   17,   17,   17, 0x08,
-     852,   17,   17,   17, 0x08,
-     869,   17,   17,   17, 0x08,
-     897,  886,   17,   17, 0x08,
-     930,   17,   17,   17, 0x08,
-     954,   17,   17,   17, 0x08,
-     971,   17,   17,   17, 0x08,
-     988,   17,   17,   17, 0x08,
-    1013,   17,   17,   17, 0x08,
-    1035,   17,   17,   17, 0x08,
-    1062, 1055,   17,   17, 0x08,
+     823,   17,   17,   17, 0x08,
+     834,   17,   17,   17, 0x08,
+     848,   17,   17,   17, 0x08,
+     859,   17,   17,   17, 0x08,
+     870,   17,   17,   17, 0x08,
+     887,   17,   17,   17, 0x08,
+     915,  904,   17,   17, 0x08,
+     948,   17,   17,   17, 0x08,
+     972,   17,   17,   17, 0x08,
+     989,   17,   17,   17, 0x08,
+    1006,   17,   17,   17, 0x08,
+    1031,   17,   17,   17, 0x08,
+    1053,   17,   17,   17, 0x08,
+    1080, 1073,   17,   17, 0x08,
 
        0        // eod
 };
@@ -112,7 +113,8 @@ static const char qt_meta_stringdata_MDTRA_MainWindow[] = {
     "plotToggleDataVisibility()\0"
     "toolsSelectAtoms()\0toolsDistanceSearch()\0"
     "toolsTorsionSearch()\0toolsForceSearch()\0"
-    "toolsHBSearch()\0toolsPCA()\0tools2DRMSD()\0"
+    "toolsHBSearch()\0toolsBatchSweep()\0toolsPCA()\0"
+    "tools2DRMSD()\0"
     "toolsDDM()\0toolsPDM()\0toolsHistogram()\0"
     "prepWaterShell()\0row,column\0"
     "exec_on_cell_dblclicked(int,int)\0"
@@ -196,23 +198,24 @@ int MDTRA_MainWindow::qt_metacall(QMetaObject::Call _c, int _id, void **_a)
         case 37: toolsTorsionSearch(); break;
         case 38: toolsForceSearch(); break;
         case 39: toolsHBSearch(); break;
-        case 40: toolsPCA(); break;
-        case 41: tools2DRMSD(); break;
-        case 42: toolsDDM(); break;
-        case 43: toolsPDM(); break;
-        case 44: toolsHistogram(); break;
-        case 45: prepWaterShell(); break;
-        case 46: exec_on_cell_dblclicked((*reinterpret_cast< int(*)>(_a[1])),(*reinterpret_cast< int(*)>(_a[2]))); break;
-        case 47: updatePanelVisibility(); break;
-        case 48: toggle_toolbar(); break;
-        case 49: switch_to_plot(); break;
-        case 50: switch_to_pdb_renderer(); break;
-        case 51: toggle_pdb_renderer(); break;
-        case 52: messageClickEvent(); break;
-        case 53: iconActivateEvent((*reinterpret_cast< QSystemTrayIcon::ActivationReason(*)>(_a[1]))); break;
+        case 40: toolsBatchSweep(); break;
+        case 41: toolsPCA(); break;
+        case 42: tools2DRMSD(); break;
+        case 43: toolsDDM(); break;
+        case 44: toolsPDM(); break;
+        case 45: toolsHistogram(); break;
+        case 46: prepWaterShell(); break;
+        case 47: exec_on_cell_dblclicked((*reinterpret_cast< int(*)>(_a[1])),(*reinterpret_cast< int(*)>(_a[2]))); break;
+        case 48: updatePanelVisibility(); break;
+        case 49: toggle_toolbar(); break;
+        case 50: switch_to_plot(); break;
+        case 51: switch_to_pdb_renderer(); break;
+        case 52: toggle_pdb_renderer(); break;
+        case 53: messageClickEvent(); break;
+        case 54: iconActivateEvent((*reinterpret_cast< QSystemTrayIcon::ActivationReason(*)>(_a[1]))); break;
         default: ;
         }
-        _id -= 54;
+        _id -= 55;
     }
     return _id;
 }
@@ -38,6 +38,8 @@ public:
     QSpinBox *eIndex;
     QSpinBox *sIndex;
     QLabel *label_5;
+    QLabel *label_6;
+    QSpinBox *sbStride;
     QGroupBox *groupBox_2;
     QCheckBox *cbEnergyTreshold;
     QDoubleSpinBox *spinEnergy;
@@ -76,21 +78,29 @@ public:
         trajectoryRange->setChecked(false);
         label_4 = new QLabel(trajectoryRange);
         label_4->setObjectName(QString::fromUtf8("label_4"));
-        label_4->setGeometry(QRect(240, 30, 121, 21));
+        label_4->setGeometry(QRect(165, 30, 71, 21));
         eIndex = new QSpinBox(trajectoryRange);
         eIndex->setObjectName(QString::fromUtf8("eIndex"));
-        eIndex->setGeometry(QRect(360, 30, 61, 22));
+        eIndex->setGeometry(QRect(235, 30, 61, 22));
         eIndex->setMinimum(1);
         eIndex->setMaximum(999999);
         eIndex->setValue(9999);
         sIndex = new QSpinBox(trajectoryRange);
         sIndex->setObjectName(QString::fromUtf8("sIndex"));
-        sIndex->setGeometry(QRect(150, 30, 61, 22));
+        sIndex->setGeometry(QRect(90, 30, 61, 22));
         sIndex->setMinimum(1);
         sIndex->setMaximum(999999);
         label_5 = new QLabel(trajectoryRange);
         label_5->setObjectName(QString::fromUtf8("label_5"));
-        label_5->setGeometry(QRect(30, 30, 121, 21));
+        label_5->setGeometry(QRect(10, 30, 81, 21));
+        label_6 = new QLabel(trajectoryRange);
+        label_6->setObjectName(QString::fromUtf8("label_6"));
+        label_6->setGeometry(QRect(310, 30, 61, 21));
+        sbStride = new QSpinBox(trajectoryRange);
+        sbStride->setObjectName(QString::fromUtf8("sbStride"));
+        sbStride->setGeometry(QRect(370, 30, 61, 22));
+        sbStride->setMinimum(1);
+        sbStride->setMaximum(999999);
         groupBox_2 = new QGroupBox(hbSearchDialog);
         groupBox_2->setObjectName(QString::fromUtf8("groupBox_2"));
         groupBox_2->setGeometry(QRect(10, 230, 491, 171));
@@ -132,11 +142,13 @@ public:
         label_2->setBuddy(sCombo);
         label_4->setBuddy(eIndex);
         label_5->setBuddy(sIndex);
+        label_6->setBuddy(sbStride);
 #endif // QT_NO_SHORTCUT
         QWidget::setTabOrder(sCombo, trajectoryRange);
         QWidget::setTabOrder(trajectoryRange, sIndex);
         QWidget::setTabOrder(sIndex, eIndex);
-        QWidget::setTabOrder(eIndex, buttonBox);
+        QWidget::setTabOrder(eIndex, sbStride);
+        QWidget::setTabOrder(sbStride, buttonBox);
 
         retranslateUi(hbSearchDialog);
         QObject::connect(buttonBox, SIGNAL(rejected()), hbSearchDialog, SLOT(reject()));
@@ -156,6 +168,7 @@ public:
         trajectoryRange->setTitle(QApplication::translate("hbSearchDialog", "Trajectory Range", 0, QApplication::UnicodeUTF8));
         label_4->setText(QApplication::translate("hbSearchDialog", "&End Index:", 0, QApplication::UnicodeUTF8));
         label_5->setText(QApplication::translate("hbSearchDialog", "&Start Index:", 0, QApplication::UnicodeUTF8));
+        label_6->setText(QApplication::translate("hbSearchDialog", "S&tride:", 0, QApplication::UnicodeUTF8));
         groupBox_2->setTitle(QApplication::translate("hbSearchDialog", "Significance Criterion", 0, QApplication::UnicodeUTF8));
         cbEnergyTreshold->setText(QApplication::translate("hbSearchDialog", "Ignore Bonds with Absolute Energy Value Less Than:", 0, QApplication::UnicodeUTF8));
         label->setText(QApplication::translate("hbSearchDialog", "kcal/mol", 0, QApplication::UnicodeUTF8));
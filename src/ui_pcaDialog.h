@@ -44,6 +44,8 @@ public:
     QSpinBox *eIndex;
     QSpinBox *sIndex;
     QLabel *label_5;
+    QLabel *label_3;
+    QSpinBox *sbStride;
     QDialogButtonBox *buttonBox;
     QGroupBox *groupBox_3;
     QLabel *label;
@@ -97,21 +99,29 @@ public:
         trajectoryRange->setChecked(false);
         label_4 = new QLabel(trajectoryRange);
         label_4->setObjectName(QString::fromUtf8("label_4"));
-        label_4->setGeometry(QRect(290, 20, 101, 21));
+        label_4->setGeometry(QRect(190, 20, 91, 21));
         eIndex = new QSpinBox(trajectoryRange);
         eIndex->setObjectName(QString::fromUtf8("eIndex"));
-        eIndex->setGeometry(QRect(390, 20, 61, 22));
+        eIndex->setGeometry(QRect(280, 20, 61, 22));
         eIndex->setMinimum(1);
         eIndex->setMaximum(999999);
         eIndex->setValue(9999);
         sIndex = new QSpinBox(trajectoryRange);
         sIndex->setObjectName(QString::fromUtf8("sIndex"));
-        sIndex->setGeometry(QRect(150, 20, 61, 22));
+        sIndex->setGeometry(QRect(110, 20, 61, 22));
         sIndex->setMinimum(1);
         sIndex->setMaximum(999999);
         label_5 = new QLabel(trajectoryRange);
         label_5->setObjectName(QString::fromUtf8("label_5"));
-        label_5->setGeometry(QRect(50, 20, 101, 21));
+        label_5->setGeometry(QRect(20, 20, 91, 21));
+        label_3 = new QLabel(trajectoryRange);
+        label_3->setObjectName(QString::fromUtf8("label_3"));
+        label_3->setGeometry(QRect(360, 20, 71, 21));
+        sbStride = new QSpinBox(trajectoryRange);
+        sbStride->setObjectName(QString::fromUtf8("sbStride"));
+        sbStride->setGeometry(QRect(430, 20, 61, 22));
+        sbStride->setMinimum(1);
+        sbStride->setMaximum(999999);
         buttonBox = new QDialogButtonBox(pcaDialog);
         buttonBox->setObjectName(QString::fromUtf8("buttonBox"));
         buttonBox->setGeometry(QRect(10, 330, 551, 32));
@@ -135,11 +145,13 @@ public:
         label_2->setBuddy(sCombo);
         label_4->setBuddy(eIndex);
         label_5->setBuddy(sIndex);
+        label_3->setBuddy(sbStride);
 #endif // QT_NO_SHORTCUT
         QWidget::setTabOrder(sCombo, trajectoryRange);
         QWidget::setTabOrder(trajectoryRange, sIndex);
         QWidget::setTabOrder(sIndex, eIndex);
-        QWidget::setTabOrder(eIndex, sel_string);
+        QWidget::setTabOrder(eIndex, sbStride);
+        QWidget::setTabOrder(sbStride, sel_string);
         QWidget::setTabOrder(sel_string, sel_parse);
 
         retranslateUi(pcaDialog);
@@ -165,6 +177,7 @@ public:
         trajectoryRange->setTitle(QApplication::translate("pcaDialog", "Trajectory Range", 0, QApplication::UnicodeUTF8));
         label_4->setText(QApplication::translate("pcaDialog", "&End Index:", 0, QApplication::UnicodeUTF8));
         label_5->setText(QApplication::translate("pcaDialog", "&Start Index:", 0, QApplication::UnicodeUTF8));
+        label_3->setText(QApplication::translate("pcaDialog", "S&tride:", 0, QApplication::UnicodeUTF8));
         groupBox_3->setTitle(QApplication::translate("pcaDialog", "PCA Options", 0, QApplication::UnicodeUTF8));
         label->setText(QApplication::translate("pcaDialog", "Number of principal components to display:", 0, QApplication::UnicodeUTF8));
     } // retranslateUi
@@ -44,9 +44,18 @@ public:
     QWidget *inputTab;
     QLabel *label;
     QComboBox *mtCombo;
+    QCheckBox *cbPinThreads;
     QCheckBox *cbSSE;
     QCheckBox *cbLowPriority;
     QCheckBox *cbUseCUDA;
+    QLabel *label_10;
+    QSpinBox *sbPrefetchDepth;
+    QLabel *label_11;
+    QSpinBox *sbBuildFirst;
+    QLabel *label_12;
+    QSpinBox *sbBuildLast;
+    QLabel *label_13;
+    QSpinBox *sbBuildStride;
     QWidget *tab;
     QLabel *label_2;
     QComboBox *xsuCombo;
@@ -66,6 +75,9 @@ public:
     QLabel *label_7;
     QComboBox *sasAccuracy;
     QCheckBox *cbSasNoWater;
+    QLabel *label_14;
+    QSpinBox *sbFrameCache;
+    QCheckBox *cbFrameCacheQuantize;
     QWidget *formatsTab;
     QListWidget *formatList;
     QWidget *verticalLayoutWidget;
@@ -117,6 +129,9 @@ public:
         mtCombo = new QComboBox(inputTab);
         mtCombo->setObjectName(QString::fromUtf8("mtCombo"));
         mtCombo->setGeometry(QRect(130, 20, 221, 22));
+        cbPinThreads = new QCheckBox(inputTab);
+        cbPinThreads->setObjectName(QString::fromUtf8("cbPinThreads"));
+        cbPinThreads->setGeometry(QRect(365, 22, 145, 17));
         cbSSE = new QCheckBox(inputTab);
         cbSSE->setObjectName(QString::fromUtf8("cbSSE"));
         cbSSE->setGeometry(QRect(20, 60, 341, 17));
@@ -126,6 +141,38 @@ public:
         cbUseCUDA = new QCheckBox(inputTab);
         cbUseCUDA->setObjectName(QString::fromUtf8("cbUseCUDA"));
         cbUseCUDA->setGeometry(QRect(20, 120, 341, 17));
+        label_10 = new QLabel(inputTab);
+        label_10->setObjectName(QString::fromUtf8("label_10"));
+        label_10->setGeometry(QRect(20, 150, 221, 21));
+        sbPrefetchDepth = new QSpinBox(inputTab);
+        sbPrefetchDepth->setObjectName(QString::fromUtf8("sbPrefetchDepth"));
+        sbPrefetchDepth->setGeometry(QRect(240, 150, 71, 22));
+        sbPrefetchDepth->setMinimum(0);
+        sbPrefetchDepth->setMaximum(64);
+        label_11 = new QLabel(inputTab);
+        label_11->setObjectName(QString::fromUtf8("label_11"));
+        label_11->setGeometry(QRect(20, 180, 221, 21));
+        sbBuildFirst = new QSpinBox(inputTab);
+        sbBuildFirst->setObjectName(QString::fromUtf8("sbBuildFirst"));
+        sbBuildFirst->setGeometry(QRect(240, 180, 71, 22));
+        sbBuildFirst->setMinimum(1);
+        sbBuildFirst->setMaximum(999999);
+        label_12 = new QLabel(inputTab);
+        label_12->setObjectName(QString::fromUtf8("label_12"));
+        label_12->setGeometry(QRect(320, 180, 31, 21));
+        sbBuildLast = new QSpinBox(inputTab);
+        sbBuildLast->setObjectName(QString::fromUtf8("sbBuildLast"));
+        sbBuildLast->setGeometry(QRect(350, 180, 71, 22));
+        sbBuildLast->setMinimum(0);
+        sbBuildLast->setMaximum(999999);
+        label_13 = new QLabel(inputTab);
+        label_13->setObjectName(QString::fromUtf8("label_13"));
+        label_13->setGeometry(QRect(20, 210, 221, 21));
+        sbBuildStride = new QSpinBox(inputTab);
+        sbBuildStride->setObjectName(QString::fromUtf8("sbBuildStride"));
+        sbBuildStride->setGeometry(QRect(240, 210, 71, 22));
+        sbBuildStride->setMinimum(1);
+        sbBuildStride->setMaximum(999999);
         tabWidget->addTab(inputTab, QString());
         tab = new QWidget();
         tab->setObjectName(QString::fromUtf8("tab"));
@@ -172,7 +219,7 @@ public:
         calcTab->setObjectName(QString::fromUtf8("calcTab"));
         groupBox = new QGroupBox(calcTab);
         groupBox->setObjectName(QString::fromUtf8("groupBox"));
-        groupBox->setGeometry(QRect(10, 10, 491, 211));
+        groupBox->setGeometry(QRect(10, 10, 491, 131));
         label_5 = new QLabel(groupBox);
         label_5->setObjectName(QString::fromUtf8("label_5"));
         label_5->setGeometry(QRect(20, 30, 161, 21));
@@ -196,6 +243,18 @@ public:
         cbSasNoWater->setObjectName(QString::fromUtf8("cbSasNoWater"));
         cbSasNoWater->setGeometry(QRect(20, 100, 311, 21));
         cbSasNoWater->setChecked(false);
+        label_14 = new QLabel(calcTab);
+        label_14->setObjectName(QString::fromUtf8("label_14"));
+        label_14->setGeometry(QRect(20, 150, 221, 21));
+        sbFrameCache = new QSpinBox(calcTab);
+        sbFrameCache->setObjectName(QString::fromUtf8("sbFrameCache"));
+        sbFrameCache->setGeometry(QRect(240, 150, 81, 22));
+        sbFrameCache->setMinimum(0);
+        sbFrameCache->setMaximum(65536);
+        sbFrameCache->setSingleStep(64);
+        cbFrameCacheQuantize = new QCheckBox(calcTab);
+        cbFrameCacheQuantize->setObjectName(QString::fromUtf8("cbFrameCacheQuantize"));
+        cbFrameCacheQuantize->setGeometry(QRect(20, 180, 471, 21));
         tabWidget->addTab(calcTab, QString());
         formatsTab = new QWidget();
         formatsTab->setObjectName(QString::fromUtf8("formatsTab"));
@@ -310,6 +369,11 @@ public:
         tabWidget->addTab(viewerTab, QString());
 #ifndef QT_NO_SHORTCUT
         label->setBuddy(mtCombo);
+        label_10->setBuddy(sbPrefetchDepth);
+        label_11->setBuddy(sbBuildFirst);
+        label_12->setBuddy(sbBuildLast);
+        label_13->setBuddy(sbBuildStride);
+        label_14->setBuddy(sbFrameCache);
         label_2->setBuddy(xsuCombo);
         label_8->setBuddy(sbDataFilter);
         label_5->setBuddy(sasProbeRadius);
@@ -318,10 +382,15 @@ public:
         label_4->setBuddy(strVMD);
 #endif // QT_NO_SHORTCUT
         QWidget::setTabOrder(tabWidget, mtCombo);
-        QWidget::setTabOrder(mtCombo, cbSSE);
+        QWidget::setTabOrder(mtCombo, cbPinThreads);
+        QWidget::setTabOrder(cbPinThreads, cbSSE);
         QWidget::setTabOrder(cbSSE, cbLowPriority);
         QWidget::setTabOrder(cbLowPriority, cbUseCUDA);
-        QWidget::setTabOrder(cbUseCUDA, cbDataFilter);
+        QWidget::setTabOrder(cbUseCUDA, sbPrefetchDepth);
+        QWidget::setTabOrder(sbPrefetchDepth, sbBuildFirst);
+        QWidget::setTabOrder(sbBuildFirst, sbBuildLast);
+        QWidget::setTabOrder(sbBuildLast, sbBuildStride);
+        QWidget::setTabOrder(sbBuildStride, cbDataFilter);
         QWidget::setTabOrder(cbDataFilter, sbDataFilter);
         QWidget::setTabOrder(sbDataFilter, cbMultisampleAA);
         QWidget::setTabOrder(cbMultisampleAA, cbPlotPolarAngles);
@@ -330,7 +399,9 @@ public:
         QWidget::setTabOrder(xsuCombo, sasProbeRadius);
         QWidget::setTabOrder(sasProbeRadius, sasAccuracy);
         QWidget::setTabOrder(sasAccuracy, cbSasNoWater);
-        QWidget::setTabOrder(cbSasNoWater, formatList);
+        QWidget::setTabOrder(cbSasNoWater, sbFrameCache);
+        QWidget::setTabOrder(sbFrameCache, cbFrameCacheQuantize);
+        QWidget::setTabOrder(cbFrameCacheQuantize, formatList);
         QWidget::setTabOrder(formatList, btnFormatAdd);
         QWidget::setTabOrder(btnFormatAdd, btnFormatEdit);
         QWidget::setTabOrder(btnFormatEdit, btnFormatDelete);
@@ -367,9 +438,16 @@ public:
     {
         preferencesDialog->setWindowTitle(QApplication::translate("preferencesDialog", "Preferences", 0, QApplication::UnicodeUTF8));
         label->setText(QApplication::translate("preferencesDialog", "&Multithreading:", 0, QApplication::UnicodeUTF8));
-        cbSSE->setText(QApplication::translate("preferencesDialog", "Use &SSE instruction set if available", 0, QApplication::UnicodeUTF8));
+        cbPinThreads->setText(QApplication::translate("preferencesDialog", "Pin &threads to cores", 0, QApplication::UnicodeUTF8));
+        cbSSE->setText(QApplication::translate("preferencesDialog", "Use &SSE/AVX2 instruction sets if available", 0, QApplication::UnicodeUTF8));
         cbLowPriority->setText(QApplication::translate("preferencesDialog", "&Yield resources to other programs", 0, QApplication::UnicodeUTF8));
         cbUseCUDA->setText(QApplication::translate("preferencesDialog", "Use &GPU computing if possible (NVIDIA CUDA)", 0, QApplication::UnicodeUTF8));
+        label_10->setText(QApplication::translate("preferencesDialog", "Snapshot &prefetch depth:", 0, QApplication::UnicodeUTF8));
+        sbPrefetchDepth->setSpecialValueText(QApplication::translate("preferencesDialog", "Off", 0, QApplication::UnicodeUTF8));
+        label_11->setText(QApplication::translate("preferencesDialog", "&Build snapshots from:", 0, QApplication::UnicodeUTF8));
+        label_12->setText(QApplication::translate("preferencesDialog", "t&o:", 0, QApplication::UnicodeUTF8));
+        sbBuildLast->setSpecialValueText(QApplication::translate("preferencesDialog", "End", 0, QApplication::UnicodeUTF8));
+        label_13->setText(QApplication::translate("preferencesDialog", "Build snapshot st&ride:", 0, QApplication::UnicodeUTF8));
         tabWidget->setTabText(tabWidget->indexOf(inputTab), QApplication::translate("preferencesDialog", "&General", 0, QApplication::UnicodeUTF8));
         label_2->setText(QApplication::translate("preferencesDialog", "&Time Scale Units:", 0, QApplication::UnicodeUTF8));
         cbDataFilter->setTitle(QApplication::translate("preferencesDialog", "Trajectory Smoothing", 0, QApplication::UnicodeUTF8));
@@ -390,6 +468,9 @@ public:
          << QApplication::translate("preferencesDialog", "Very High", 0, QApplication::UnicodeUTF8)
         );
         cbSasNoWater->setText(QApplication::translate("preferencesDialog", "E&xclude water molecules from calculation", 0, QApplication::UnicodeUTF8));
+        label_14->setText(QApplication::translate("preferencesDialog", "Snapshot ca&che size, MB:", 0, QApplication::UnicodeUTF8));
+        sbFrameCache->setSpecialValueText(QApplication::translate("preferencesDialog", "Off", 0, QApplication::UnicodeUTF8));
+        cbFrameCacheQuantize->setText(QApplication::translate("preferencesDialog", "Keep cached snapshots in 16-bit &quantized form", 0, QApplication::UnicodeUTF8));
         tabWidget->setTabText(tabWidget->indexOf(calcTab), QApplication::translate("preferencesDialog", "&Analysis", 0, QApplication::UnicodeUTF8));
         btnFormatAdd->setText(QApplication::translate("preferencesDialog", "&Add...", 0, QApplication::UnicodeUTF8));
         btnFormatEdit->setText(QApplication::translate("preferencesDialog", "&Edit...", 0, QApplication::UnicodeUTF8));
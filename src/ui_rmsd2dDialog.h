@@ -47,6 +47,8 @@ public:
     QSpinBox *eIndex;
     QSpinBox *sIndex;
     QLabel *label_5;
+    QLabel *label_7;
+    QSpinBox *sbStride;
     QGroupBox *groupBox_3;
     QLabel *progressBarMsg;
     QProgressBar *progressBar;
@@ -114,21 +116,29 @@ public:
         trajectoryRange->setChecked(false);
         label_4 = new QLabel(trajectoryRange);
         label_4->setObjectName(QString::fromUtf8("label_4"));
-        label_4->setGeometry(QRect(310, 20, 101, 21));
+        label_4->setGeometry(QRect(220, 20, 101, 21));
         eIndex = new QSpinBox(trajectoryRange);
         eIndex->setObjectName(QString::fromUtf8("eIndex"));
-        eIndex->setGeometry(QRect(410, 20, 61, 22));
+        eIndex->setGeometry(QRect(320, 20, 61, 22));
         eIndex->setMinimum(1);
         eIndex->setMaximum(999999);
         eIndex->setValue(9999);
         sIndex = new QSpinBox(trajectoryRange);
         sIndex->setObjectName(QString::fromUtf8("sIndex"));
-        sIndex->setGeometry(QRect(150, 20, 61, 22));
+        sIndex->setGeometry(QRect(130, 20, 61, 22));
         sIndex->setMinimum(1);
         sIndex->setMaximum(999999);
         label_5 = new QLabel(trajectoryRange);
         label_5->setObjectName(QString::fromUtf8("label_5"));
-        label_5->setGeometry(QRect(50, 20, 101, 21));
+        label_5->setGeometry(QRect(30, 20, 101, 21));
+        label_7 = new QLabel(trajectoryRange);
+        label_7->setObjectName(QString::fromUtf8("label_7"));
+        label_7->setGeometry(QRect(410, 20, 71, 21));
+        sbStride = new QSpinBox(trajectoryRange);
+        sbStride->setObjectName(QString::fromUtf8("sbStride"));
+        sbStride->setGeometry(QRect(480, 20, 61, 22));
+        sbStride->setMinimum(1);
+        sbStride->setMaximum(999999);
         groupBox_3 = new QGroupBox(rmsd2dDialog);
         groupBox_3->setObjectName(QString::fromUtf8("groupBox_3"));
         groupBox_3->setGeometry(QRect(10, 350, 601, 441));
@@ -202,13 +212,15 @@ public:
         label_2->setBuddy(sCombo);
         label_4->setBuddy(eIndex);
         label_5->setBuddy(sIndex);
+        label_7->setBuddy(sbStride);
         label_3->setBuddy(plotTitle);
         label_6->setBuddy(spinPlotMin);
 #endif // QT_NO_SHORTCUT
         QWidget::setTabOrder(sCombo, trajectoryRange);
         QWidget::setTabOrder(trajectoryRange, sIndex);
         QWidget::setTabOrder(sIndex, eIndex);
-        QWidget::setTabOrder(eIndex, sel_string);
+        QWidget::setTabOrder(eIndex, sbStride);
+        QWidget::setTabOrder(sbStride, sel_string);
         QWidget::setTabOrder(sel_string, sel_parse);
         QWidget::setTabOrder(sel_parse, optGray);
         QWidget::setTabOrder(optGray, optRGB);
@@ -242,6 +254,7 @@ public:
         trajectoryRange->setTitle(QApplication::translate("rmsd2dDialog", "Trajectory Range", 0, QApplication::UnicodeUTF8));
         label_4->setText(QApplication::translate("rmsd2dDialog", "&End Index:", 0, QApplication::UnicodeUTF8));
         label_5->setText(QApplication::translate("rmsd2dDialog", "&Start Index:", 0, QApplication::UnicodeUTF8));
+        label_7->setText(QApplication::translate("rmsd2dDialog", "S&tride:", 0, QApplication::UnicodeUTF8));
         groupBox_3->setTitle(QApplication::translate("rmsd2dDialog", "2D RMSD Map", 0, QApplication::UnicodeUTF8));
         progressBarMsg->setText(QString());
 #ifndef QT_NO_STATUSTIP
@@ -45,6 +45,7 @@ public:
     QCheckBox *relativeCb;
     QCheckBox *hetatmCb;
     QCheckBox *solventCb;
+    QCheckBox *cacheCb;
     QGroupBox *groupBox_3;
     QLabel *label_2;
     QDoubleSpinBox *timestep;
@@ -54,10 +55,10 @@ public:
     {
         if (streamDialog->objectName().isEmpty())
             streamDialog->setObjectName(QString::fromUtf8("streamDialog"));
-        streamDialog->resize(569, 604);
+        streamDialog->resize(569, 624);
         buttonBox = new QDialogButtonBox(streamDialog);
         buttonBox->setObjectName(QString::fromUtf8("buttonBox"));
-        buttonBox->setGeometry(QRect(10, 570, 551, 32));
+        buttonBox->setGeometry(QRect(10, 590, 551, 32));
         buttonBox->setOrientation(Qt::Horizontal);
         buttonBox->setStandardButtons(QDialogButtonBox::Cancel|QDialogButtonBox::Ok);
         buttonBox->setCenterButtons(true);
@@ -72,7 +73,7 @@ public:
         label->setGeometry(QRect(20, 30, 111, 21));
         groupBox_2 = new QGroupBox(streamDialog);
         groupBox_2->setObjectName(QString::fromUtf8("groupBox_2"));
-        groupBox_2->setGeometry(QRect(10, 90, 551, 371));
+        groupBox_2->setGeometry(QRect(10, 90, 551, 391));
         sList = new QListWidget(groupBox_2);
         sList->setObjectName(QString::fromUtf8("sList"));
         sList->setGeometry(QRect(20, 30, 421, 231));
@@ -104,9 +105,13 @@ public:
         solventCb->setObjectName(QString::fromUtf8("solventCb"));
         solventCb->setGeometry(QRect(20, 340, 421, 21));
         solventCb->setChecked(false);
+        cacheCb = new QCheckBox(groupBox_2);
+        cacheCb->setObjectName(QString::fromUtf8("cacheCb"));
+        cacheCb->setGeometry(QRect(20, 360, 421, 21));
+        cacheCb->setChecked(false);
         groupBox_3 = new QGroupBox(streamDialog);
         groupBox_3->setObjectName(QString::fromUtf8("groupBox_3"));
-        groupBox_3->setGeometry(QRect(10, 470, 551, 91));
+        groupBox_3->setGeometry(QRect(10, 490, 551, 91));
         label_2 = new QLabel(groupBox_3);
         label_2->setObjectName(QString::fromUtf8("label_2"));
         label_2->setGeometry(QRect(20, 30, 191, 21));
@@ -154,6 +159,7 @@ public:
         relativeCb->setText(QApplication::translate("streamDialog", "Use &Relative Path Names", 0, QApplication::UnicodeUTF8));
         hetatmCb->setText(QApplication::translate("streamDialog", "Ignore &HETATM Records", 0, QApplication::UnicodeUTF8));
         solventCb->setText(QApplication::translate("streamDialog", "Ignore &Solvent Groups", 0, QApplication::UnicodeUTF8));
+        cacheCb->setText(QApplication::translate("streamDialog", "Use Binary &Coordinate Cache", 0, QApplication::UnicodeUTF8));
         groupBox_3->setTitle(QApplication::translate("streamDialog", "Trajectory Information", 0, QApplication::UnicodeUTF8));
         label_2->setText(QApplication::translate("streamDialog", "Trajectory &Time Step, ps:", 0, QApplication::UnicodeUTF8));
         timestep->setPrefix(QString());